@@ -21,6 +21,11 @@
 #include "../unicode/unicode.cpp"
 #include "../data_io/image_dataset_metadata.cpp"
 #include "../data_io/mnist.cpp"
+#include "../simd/cpu_dispatch.cpp"
+#include "../image_transforms/fhog_kernels.cpp"
+#include "../image_transforms/spatial_filtering_kernels.cpp"
+#include "../image_transforms/interpolation_kernels.cpp"
+#include "../image_transforms/image_pyramid_kernels.cpp"
 
 // Stuff that requires C++11
 #if __cplusplus >= 201103
@@ -43,6 +48,7 @@
 #include "../logger/extra_logger_headers.cpp"
 #include "../logger/logger_kernel_1.cpp"
 #include "../logger/logger_config_file.cpp"
+#include "../mapped_file/mapped_file.cpp"
 #include "../misc_api/misc_api_kernel_1.cpp"
 #include "../misc_api/misc_api_kernel_2.cpp"
 #include "../sockets/sockets_extensions.cpp"
@@ -27,7 +27,12 @@ namespace dlib
     jpeg_loader::
     jpeg_loader( const char* filename ) : height_( 0 ), width_( 0 ), output_components_(0)
     {
-        read_image( filename );
+        if ( filename == NULL )
+        {
+            throw image_load_error("jpeg_loader: invalid filename, it is NULL");
+        }
+        impl::jpeg_decompressor decoder( filename, jpeg_decode_options() );
+        read_image( decoder );
     }
 
 // ----------------------------------------------------------------------------------------
@@ -35,7 +40,8 @@ namespace dlib
     jpeg_loader::
     jpeg_loader( const std::string& filename ) : height_( 0 ), width_( 0 ), output_components_(0)
     {
-        read_image( filename.c_str() );
+        impl::jpeg_decompressor decoder( filename, jpeg_decode_options() );
+        read_image( decoder );
     }
 
 // ----------------------------------------------------------------------------------------
@@ -43,7 +49,35 @@ namespace dlib
     jpeg_loader::
     jpeg_loader( const dlib::file& f ) : height_( 0 ), width_( 0 ), output_components_(0)
     {
-        read_image( f.full_name().c_str() );
+        impl::jpeg_decompressor decoder( f.full_name(), jpeg_decode_options() );
+        read_image( decoder );
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    jpeg_loader::
+    jpeg_loader( const unsigned char* imgbuffer, size_t imgbuffersize ) : height_( 0 ), width_( 0 ), output_components_(0)
+    {
+        impl::jpeg_decompressor decoder( imgbuffer, imgbuffersize, jpeg_decode_options() );
+        read_image( decoder );
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    jpeg_loader::
+    jpeg_loader( const std::string& filename, const jpeg_decode_options& options ) : height_( 0 ), width_( 0 ), output_components_(0)
+    {
+        impl::jpeg_decompressor decoder( filename, options );
+        read_image( decoder );
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    jpeg_loader::
+    jpeg_loader( const unsigned char* imgbuffer, size_t imgbuffersize, const jpeg_decode_options& options ) : height_( 0 ), width_( 0 ), output_components_(0)
+    {
+        impl::jpeg_decompressor decoder( imgbuffer, imgbuffersize, options );
+        read_image( decoder );
     }
 
 // ----------------------------------------------------------------------------------------
@@ -60,6 +94,33 @@ namespace dlib
         return (output_components_ == 3);
     }
 
+// ----------------------------------------------------------------------------------------
+
+    void jpeg_loader::read_image( impl::jpeg_decompressor& decoder )
+    {
+        height_ = decoder.nr();
+        width_ = decoder.nc();
+        output_components_ = decoder.num_components();
+
+        std::vector<unsigned char*> rows;
+        rows.resize(height_);
+
+        // size the image buffer
+        data.resize(height_*width_*output_components_);
+
+        // setup pointers to each row
+        for (unsigned long i = 0; i < rows.size(); ++i)
+            rows[i] = &data[i*width_*output_components_];
+
+        // read the data into the buffer
+        while (decoder.next_row() < height_)
+        {
+            decoder.read_rows(&rows[decoder.next_row()], 100);
+        }
+
+        decoder.finish();
+    }
+
 // ----------------------------------------------------------------------------------------
 
     struct jpeg_loader_error_mgr 
@@ -79,79 +140,234 @@ namespace dlib
 
 // ----------------------------------------------------------------------------------------
 
-    void jpeg_loader::read_image( const char* filename )
+    // The whole JPEG stream is handed to libjpeg up front by jpeg_loader_memory_src(), so
+    // there is never anything to refill.  If libjpeg asks for more data the stream is
+    // truncated, in which case we feed it a fake EOI marker just like jpeg_stdio_src() does.
+    void jpeg_loader_init_source (j_decompress_ptr) {}
+    void jpeg_loader_term_source (j_decompress_ptr) {}
+
+    boolean jpeg_loader_fill_input_buffer (j_decompress_ptr cinfo)
     {
-        if ( filename == NULL )
+        static const JOCTET fake_eoi[2] = { 0xFF, JPEG_EOI };
+        cinfo->src->next_input_byte = fake_eoi;
+        cinfo->src->bytes_in_buffer = 2;
+        return TRUE;
+    }
+
+    void jpeg_loader_skip_input_data (j_decompress_ptr cinfo, long num_bytes)
+    {
+        if (num_bytes <= 0)
+            return;
+
+        if ((size_t)num_bytes > cinfo->src->bytes_in_buffer)
         {
-            throw image_load_error("jpeg_loader: invalid filename, it is NULL");
+            jpeg_loader_fill_input_buffer(cinfo);
         }
-        FILE *fp = fopen( filename, "rb" );
-        if ( !fp )
+        else
         {
-            throw image_load_error(std::string("jpeg_loader: unable to open file ") + filename);
+            cinfo->src->next_input_byte += num_bytes;
+            cinfo->src->bytes_in_buffer -= num_bytes;
         }
+    }
 
-        jpeg_decompress_struct cinfo;
-        jpeg_loader_error_mgr jerr;
-
-        cinfo.err = jpeg_std_error(&jerr.pub);
+    // Equivalent of jpeg_mem_src(), which only exists in libjpeg 8 and newer.
+    void jpeg_loader_memory_src (
+        j_decompress_ptr cinfo,
+        jpeg_source_mgr& src,
+        const unsigned char* imgbuffer,
+        size_t imgbuffersize
+    )
+    {
+        src.init_source = jpeg_loader_init_source;
+        src.fill_input_buffer = jpeg_loader_fill_input_buffer;
+        src.skip_input_data = jpeg_loader_skip_input_data;
+        src.resync_to_restart = jpeg_resync_to_restart;
+        src.term_source = jpeg_loader_term_source;
+        src.next_input_byte = imgbuffer;
+        src.bytes_in_buffer = imgbuffersize;
+        cinfo->src = &src;
+    }
 
-        jerr.pub.error_exit = jpeg_loader_error_exit;
+// ----------------------------------------------------------------------------------------
 
-        /* Establish the setjmp return context for my_error_exit to use. */
-        if (setjmp(jerr.setjmp_buffer)) 
+    namespace impl
+    {
+        struct jpeg_decompressor_state
+        {
+            jpeg_decompressor_state() : fp(NULL), imgbuffer(NULL), imgbuffersize(0), started(false), finished(false) {}
+
+            // This runs even when a jpeg_decompressor constructor throws, which is when
+            // most decoding errors (e.g. a corrupt header) are found.
+            ~jpeg_decompressor_state()
+            {
+                if ( started )
+                    jpeg_destroy_decompress(&cinfo);
+                if ( fp )
+                    fclose( fp );
+            }
+
+            jpeg_decompress_struct cinfo;
+            jpeg_loader_error_mgr jerr;
+            jpeg_source_mgr memory_src;
+            FILE* fp;
+            const unsigned char* imgbuffer;
+            size_t imgbuffersize;
+            bool started;
+            bool finished;
+        };
+
+    // ------------------------------------------------------------------------------------
+
+        jpeg_decompressor::
+        jpeg_decompressor( const std::string& filename_, const jpeg_decode_options& options ) :
+            state(new jpeg_decompressor_state), filename(filename_)
         {
-            /* If we get here, the JPEG code has signaled an error.
-             * We need to clean up the JPEG object, close the input file, and return.
-             */
-            jpeg_destroy_decompress(&cinfo);
-            fclose(fp);
-            throw image_load_error(std::string("jpeg_loader: error while reading ") + filename);
+            state->fp = fopen( filename.c_str(), "rb" );
+            if ( !state->fp )
+            {
+                throw image_load_error(std::string("jpeg_loader: unable to open file ") + filename);
+            }
+            start( options );
         }
 
+    // ------------------------------------------------------------------------------------
 
-        jpeg_create_decompress(&cinfo);
+        jpeg_decompressor::
+        jpeg_decompressor( const unsigned char* imgbuffer, size_t imgbuffersize, const jpeg_decode_options& options ) :
+            state(new jpeg_decompressor_state)
+        {
+            if ( imgbuffer == NULL )
+            {
+                throw image_load_error("jpeg_loader: invalid image buffer, it is NULL");
+            }
+            state->imgbuffer = imgbuffer;
+            state->imgbuffersize = imgbuffersize;
+            start( options );
+        }
 
-        jpeg_stdio_src(&cinfo, fp);
+    // ------------------------------------------------------------------------------------
 
-        jpeg_read_header(&cinfo, TRUE);
+        jpeg_decompressor::
+        ~jpeg_decompressor()
+        {
+            // state cleans up the JPEG object and the file
+        }
 
-        jpeg_start_decompress(&cinfo);
+    // ------------------------------------------------------------------------------------
 
-        height_ = cinfo.output_height;
-        width_ = cinfo.output_width;
-        output_components_ = cinfo.output_components;
+        void jpeg_decompressor::
+        fail( const std::string& message )
+        {
+            if ( filename.size() != 0 )
+                throw image_load_error(message + " in file " + filename);
+            throw image_load_error(message);
+        }
 
-        if (output_components_ != 1 && 
-            output_components_ != 3)
+    // ------------------------------------------------------------------------------------
+
+        void jpeg_decompressor::
+        start( const jpeg_decode_options& options )
         {
-            fclose( fp );
-            jpeg_destroy_decompress(&cinfo);
-            std::ostringstream sout;
-            sout << "jpeg_loader: Unsupported number of colors (" << output_components_ << ") in file " << filename;
-            throw image_load_error(sout.str());
+            // make sure requires clause is not broken
+            DLIB_ASSERT(options.scale_denom == 1 || options.scale_denom == 2 ||
+                        options.scale_denom == 4 || options.scale_denom == 8,
+                "\t jpeg_loader::jpeg_loader()"
+                << "\n\t the scale_denom must be 1, 2, 4 or 8"
+                << "\n\t options.scale_denom: " << options.scale_denom
+                );
+
+            jpeg_decompress_struct& cinfo = state->cinfo;
+
+            cinfo.err = jpeg_std_error(&state->jerr.pub);
+
+            state->jerr.pub.error_exit = jpeg_loader_error_exit;
+
+            /* Establish the setjmp return context for my_error_exit to use. */
+            if (setjmp(state->jerr.setjmp_buffer)) 
+            {
+                /* If we get here, the JPEG code has signaled an error.
+                 * The destructor of the state cleans up the JPEG object.
+                 */
+                fail("jpeg_loader: error while decoding the image");
+            }
+
+            jpeg_create_decompress(&cinfo);
+            state->started = true;
+
+            if (state->fp)
+                jpeg_stdio_src(&cinfo, state->fp);
+            else
+                jpeg_loader_memory_src(&cinfo, state->memory_src, state->imgbuffer, state->imgbuffersize);
+
+            jpeg_read_header(&cinfo, TRUE);
+
+            // Decoding only the luma channel skips upsampling the chroma channels and the
+            // color conversion, and scaling in the DCT domain skips most of the inverse DCT
+            // work.  libjpeg can only give grayscale output for YCbCr and grayscale images.
+            if (options.grayscale &&
+                (cinfo.jpeg_color_space == JCS_YCbCr || cinfo.jpeg_color_space == JCS_GRAYSCALE))
+            {
+                cinfo.out_color_space = JCS_GRAYSCALE;
+            }
+            cinfo.scale_num = 1;
+            cinfo.scale_denom = options.scale_denom;
+
+            jpeg_start_decompress(&cinfo);
+
+            if (cinfo.output_components != 1 && 
+                cinfo.output_components != 3)
+            {
+                std::ostringstream sout;
+                sout << "jpeg_loader: Unsupported number of colors (" << cinfo.output_components << ")";
+                fail(sout.str());
+            }
         }
 
-        std::vector<unsigned char*> rows;
-        rows.resize(height_);
+    // ------------------------------------------------------------------------------------
 
-        // size the image buffer
-        data.resize(height_*width_*output_components_);
+        unsigned long jpeg_decompressor::
+        nr() const { return state->cinfo.output_height; }
 
-        // setup pointers to each row
-        for (unsigned long i = 0; i < rows.size(); ++i)
-            rows[i] = &data[i*width_*output_components_];
+        unsigned long jpeg_decompressor::
+        nc() const { return state->cinfo.output_width; }
 
-        // read the data into the buffer
-        while (cinfo.output_scanline < cinfo.output_height)
+        unsigned long jpeg_decompressor::
+        num_components() const { return state->cinfo.output_components; }
+
+        unsigned long jpeg_decompressor::
+        next_row() const { return state->cinfo.output_scanline; }
+
+    // ------------------------------------------------------------------------------------
+
+        unsigned long jpeg_decompressor::
+        read_rows( unsigned char** rows, unsigned long max_rows )
         {
-            jpeg_read_scanlines(&cinfo, &rows[cinfo.output_scanline], 100);
+            // libjpeg reports errors by longjmp()ing, so the jump target has to be set up
+            // in every function that calls into it after start().
+            if (setjmp(state->jerr.setjmp_buffer)) 
+            {
+                fail("jpeg_loader: error while decoding the image");
+            }
+
+            return jpeg_read_scanlines(&state->cinfo, rows, max_rows);
         }
 
-        jpeg_finish_decompress(&cinfo);
-        jpeg_destroy_decompress(&cinfo);
+    // ------------------------------------------------------------------------------------
 
-        fclose( fp );
+        void jpeg_decompressor::
+        finish()
+        {
+            if (state->finished)
+                return;
+            state->finished = true;
+
+            if (setjmp(state->jerr.setjmp_buffer)) 
+            {
+                fail("jpeg_loader: error while decoding the image");
+            }
+
+            jpeg_finish_decompress(&state->cinfo);
+        }
     }
 
 // ----------------------------------------------------------------------------------------
@@ -8,11 +8,186 @@
 #include "image_loader.h"
 #include "../pixel.h"
 #include "../dir_nav.h"
+#include "../image_processing/generic_image.h"
+#include <algorithm>
 #include <vector>
+#include <stdio.h>
 
 namespace dlib
 {
 
+    struct jpeg_decode_options
+    {
+        jpeg_decode_options() : grayscale(false), scale_denom(1) {}
+
+        bool grayscale;
+        unsigned long scale_denom;
+    };
+
+// ----------------------------------------------------------------------------------------
+
+    namespace impl
+    {
+        struct jpeg_decompressor_state;
+
+        class jpeg_decompressor : noncopyable
+        {
+            /*!
+                This object is a thin wrapper around a libjpeg decompressor that has read
+                the image header and is ready to hand out scanlines.  It keeps libjpeg's
+                types out of this header so that jpeg_row_reader can decode straight into
+                the rows of whatever image the caller gave it.
+                Decoding errors are reported by throwing image_load_error.
+            !*/
+        public:
+            jpeg_decompressor( const std::string& filename, const jpeg_decode_options& options );
+            jpeg_decompressor( const unsigned char* imgbuffer, size_t imgbuffersize, const jpeg_decode_options& options );
+            ~jpeg_decompressor();
+
+            unsigned long nr() const;
+            unsigned long nc() const;
+            unsigned long num_components() const;
+
+            // the index of the next row read_rows() will return
+            unsigned long next_row() const;
+
+            // Decodes at most max_rows rows into rows[0], rows[1], ... and returns how many
+            // were decoded.  Each row is nc()*num_components() bytes.
+            unsigned long read_rows( unsigned char** rows, unsigned long max_rows );
+
+            // must be called once all the rows have been read.  Calling it again does nothing.
+            void finish();
+
+        private:
+            void start( const jpeg_decode_options& options );
+            void fail( const std::string& message );
+
+            scoped_ptr<jpeg_decompressor_state> state;
+            std::string filename;
+        };
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    class jpeg_row_reader : noncopyable
+    {
+    public:
+
+        jpeg_row_reader( 
+            const std::string& filename,
+            const jpeg_decode_options& options = jpeg_decode_options()
+        ) : decoder( filename, options ) {}
+
+        jpeg_row_reader( 
+            const unsigned char* imgbuffer,
+            size_t imgbuffersize,
+            const jpeg_decode_options& options = jpeg_decode_options()
+        ) : decoder( imgbuffer, imgbuffersize, options ) {}
+
+        long nr() const { return decoder.nr(); }
+        long nc() const { return decoder.nc(); }
+        bool is_gray() const { return decoder.num_components() == 1; }
+        bool is_rgb() const { return decoder.num_components() == 3; }
+        long next_row() const { return decoder.next_row(); }
+
+        template <typename image_type>
+        unsigned long read_rows (
+            image_type& img_,
+            long first_row,
+            unsigned long num_rows
+        )
+        {
+#ifndef DLIB_JPEG_SUPPORT
+            /* !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+                You are getting this error because you are trying to use the jpeg_row_reader
+                object but you haven't defined DLIB_JPEG_SUPPORT.  You must do so to use
+                this object.   You must also make sure you set your build environment
+                to link against the libjpeg library.
+            !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!*/
+            COMPILE_TIME_ASSERT(sizeof(image_type) == 0);
+#endif
+            typedef typename image_traits<image_type>::pixel_type pixel_type;
+            image_view<image_type> img(img_);
+
+            // make sure requires clause is not broken
+            DLIB_ASSERT(img.nc() == nc() && 0 <= first_row && first_row + (long)num_rows <= img.nr(),
+                "\t unsigned long jpeg_row_reader::read_rows()"
+                << "\n\t the rows must fit inside img"
+                << "\n\t img.nr(): " << img.nr()
+                << "\n\t img.nc(): " << img.nc()
+                << "\n\t nc():     " << nc()
+                << "\n\t first_row: " << first_row
+                << "\n\t num_rows:  " << num_rows
+                );
+
+            num_rows = std::min<unsigned long>(num_rows, nr() - next_row());
+            const long nc = this->nc();
+            const bool same_layout =
+                (is_gray() && is_same_type<pixel_type,unsigned char>::value) ||
+                (is_rgb() && is_same_type<pixel_type,rgb_pixel>::value && sizeof(rgb_pixel) == 3);
+
+            unsigned long done = 0;
+            if (same_layout)
+            {
+                // libjpeg's output already has the layout of the image's pixels, so let it
+                // write each row in place.
+                std::vector<unsigned char*> rows(num_rows);
+                for (unsigned long i = 0; i < num_rows; ++i)
+                    rows[i] = reinterpret_cast<unsigned char*>(&img[first_row+i][0]);
+                while (done < num_rows)
+                    done += decoder.read_rows(&rows[done], num_rows - done);
+            }
+            else
+            {
+                // Otherwise decode a few rows at a time into a small buffer and convert
+                // them from there.
+                const unsigned long buffer_rows = 16;
+                const unsigned long row_size = nc*decoder.num_components();
+                buffer.resize(buffer_rows*row_size);
+                unsigned char* rows[buffer_rows];
+                for (unsigned long i = 0; i < buffer_rows; ++i)
+                    rows[i] = &buffer[i*row_size];
+
+                while (done < num_rows)
+                {
+                    const unsigned long count = decoder.read_rows(rows, std::min(buffer_rows, num_rows - done));
+                    for (unsigned long i = 0; i < count; ++i)
+                    {
+                        const unsigned char* v = rows[i];
+                        pixel_type* out = &img[first_row+done+i][0];
+                        if (is_gray())
+                        {
+                            for (long c = 0; c < nc; ++c)
+                                assign_pixel(out[c], v[c]);
+                        }
+                        else
+                        {
+                            for (long c = 0; c < nc; ++c)
+                            {
+                                rgb_pixel p;
+                                p.red = v[c*3];
+                                p.green = v[c*3+1];
+                                p.blue = v[c*3+2];
+                                assign_pixel(out[c], p);
+                            }
+                        }
+                    }
+                    done += count;
+                }
+            }
+
+            if (next_row() == nr())
+                decoder.finish();
+            return done;
+        }
+
+    private:
+        impl::jpeg_decompressor decoder;
+        std::vector<unsigned char> buffer;
+    };
+
+// ----------------------------------------------------------------------------------------
+
     class jpeg_loader : noncopyable
     {
     public:
@@ -20,6 +195,9 @@ namespace dlib
         jpeg_loader( const char* filename );
         jpeg_loader( const std::string& filename );
         jpeg_loader( const dlib::file& f );
+        jpeg_loader( const unsigned char* imgbuffer, size_t imgbuffersize );
+        jpeg_loader( const std::string& filename, const jpeg_decode_options& options );
+        jpeg_loader( const unsigned char* imgbuffer, size_t imgbuffersize, const jpeg_decode_options& options );
 
         bool is_gray() const;
         bool is_rgb() const;
@@ -39,17 +217,23 @@ namespace dlib
             image_view<T> t(t_);
 
             t.set_size( height_, width_ );
-            for ( unsigned n = 0; n < height_;n++ )
+            if ( is_gray() )
             {
-                const unsigned char* v = get_row( n );
-                for ( unsigned m = 0; m < width_;m++ )
+                for ( unsigned n = 0; n < height_;n++ )
                 {
-                    if ( is_gray() )
+                    const unsigned char* v = get_row( n );
+                    for ( unsigned m = 0; m < width_;m++ )
                     {
-                        unsigned char p = v[m];
-                        assign_pixel( t[n][m], p );
+                        assign_pixel( t[n][m], v[m] );
                     }
-                    else // if ( is_rgb() )
+                }
+            }
+            else // if ( is_rgb() )
+            {
+                for ( unsigned n = 0; n < height_;n++ )
+                {
+                    const unsigned char* v = get_row( n );
+                    for ( unsigned m = 0; m < width_;m++ )
                     {
                         rgb_pixel p;
                         p.red = v[m*3];
@@ -67,7 +251,7 @@ namespace dlib
             return &data[i*width_*output_components_];
         }
 
-        void read_image( const char* filename );
+        void read_image( impl::jpeg_decompressor& decoder );
         unsigned long height_; 
         unsigned long width_;
         unsigned long output_components_;
@@ -84,7 +268,58 @@ namespace dlib
         const std::string& file_name
     )
     {
-        jpeg_loader(file_name).get_image(image);
+        jpeg_row_reader reader(file_name);
+        image_view<image_type>(image).set_size(reader.nr(), reader.nc());
+        reader.read_rows(image, 0, reader.nr());
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename image_type
+        >
+    void load_jpeg (
+        image_type& image,
+        const unsigned char* imgbuffer,
+        size_t imgbuffersize
+    )
+    {
+        jpeg_row_reader reader(imgbuffer, imgbuffersize);
+        image_view<image_type>(image).set_size(reader.nr(), reader.nc());
+        reader.read_rows(image, 0, reader.nr());
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename image_type
+        >
+    void load_jpeg (
+        image_type& image,
+        const std::string& file_name,
+        const jpeg_decode_options& options
+    )
+    {
+        jpeg_row_reader reader(file_name, options);
+        image_view<image_type>(image).set_size(reader.nr(), reader.nc());
+        reader.read_rows(image, 0, reader.nr());
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename image_type
+        >
+    void load_jpeg (
+        image_type& image,
+        const unsigned char* imgbuffer,
+        size_t imgbuffersize,
+        const jpeg_decode_options& options
+    )
+    {
+        jpeg_row_reader reader(imgbuffer, imgbuffersize, options);
+        image_view<image_type>(image).set_size(reader.nr(), reader.nc());
+        reader.read_rows(image, 0, reader.nr());
     }
 
 // ----------------------------------------------------------------------------------------
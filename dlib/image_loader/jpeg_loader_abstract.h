@@ -12,6 +12,42 @@
 namespace dlib
 {
 
+    struct jpeg_decode_options
+    {
+        /*!
+            WHAT THIS OBJECT REPRESENTS
+                This object tells the jpeg_loader to skip decoding work the caller doesn't
+                need.  It's meant for callers that end up converting the image to
+                grayscale and/or shrinking it anyway, e.g. before running a HOG based
+                object detector on it.
+
+                - grayscale: if true, images stored in the YCbCr or grayscale color spaces
+                  (which is nearly all of them) are decoded straight to their luma
+                  channel, so libjpeg skips upsampling the chroma channels and converting
+                  to RGB.  Note that luma is the weighted sum 0.299*R + 0.587*G + 0.114*B,
+                  not the plain average assign_pixel() uses to convert rgb_pixels to
+                  grayscale.  Images in other color spaces are still decoded to RGB.
+                - scale_denom: the image is decoded at 1/scale_denom of its size (rounded
+                  up) by scaling it in the DCT domain, which is much cheaper than decoding
+                  it at full size and downsampling it.  Must be 1, 2, 4 or 8.
+        !*/
+
+        jpeg_decode_options(
+        );
+        /*!
+            ensures
+                - #grayscale == false
+                - #scale_denom == 1
+                  (i.e. the image is decoded the same way jpeg_loader decodes it without
+                  any options)
+        !*/
+
+        bool grayscale;
+        unsigned long scale_denom;
+    };
+
+// ----------------------------------------------------------------------------------------
+
     class jpeg_loader : noncopyable
     {
         /*!
@@ -65,6 +101,63 @@ namespace dlib
                   us from loading the given JPEG file.
         !*/
 
+        jpeg_loader( 
+            const unsigned char* imgbuffer,
+            size_t imgbuffersize
+        );
+        /*!
+            requires
+                - imgbuffer points to imgbuffersize bytes of JPEG encoded data
+            ensures
+                - loads the JPEG image contained in imgbuffer into this object.  The
+                  buffer is only read during construction, so it doesn't need to outlive
+                  this object.
+            throws
+                - std::bad_alloc
+                - image_load_error
+                  This exception is thrown if there is some error that prevents
+                  us from decoding the given JPEG data.
+        !*/
+
+        jpeg_loader( 
+            const std::string& filename,
+            const jpeg_decode_options& options
+        );
+        /*!
+            requires
+                - options.scale_denom is 1, 2, 4 or 8
+            ensures
+                - loads the JPEG file with the given file name into this object, decoded
+                  as described by options.  In particular, the image is
+                  ceil(width/options.scale_denom) pixels wide and
+                  ceil(height/options.scale_denom) pixels tall.
+            throws
+                - std::bad_alloc
+                - image_load_error
+                  This exception is thrown if there is some error that prevents
+                  us from loading the given JPEG file.
+        !*/
+
+        jpeg_loader( 
+            const unsigned char* imgbuffer,
+            size_t imgbuffersize,
+            const jpeg_decode_options& options
+        );
+        /*!
+            requires
+                - imgbuffer points to imgbuffersize bytes of JPEG encoded data
+                - options.scale_denom is 1, 2, 4 or 8
+            ensures
+                - loads the JPEG image contained in imgbuffer into this object, decoded as
+                  described by options.  The buffer is only read during construction, so
+                  it doesn't need to outlive this object.
+            throws
+                - std::bad_alloc
+                - image_load_error
+                  This exception is thrown if there is some error that prevents
+                  us from decoding the given JPEG data.
+        !*/
+
         ~jpeg_loader(
         );
         /*!
@@ -108,6 +201,120 @@ namespace dlib
 
     };
 
+// ----------------------------------------------------------------------------------------
+
+    class jpeg_row_reader : noncopyable
+    {
+        /*!
+            WHAT THIS OBJECT REPRESENTS
+                This object decodes a JPEG image from top to bottom, a few rows at a time,
+                into rows of images you supply.  Unlike jpeg_loader, it never holds the
+                whole decoded image, so it lets you process images that are too big to
+                decode in one go (e.g. by running a detector over horizontal strips of
+                them) with memory bounded by the size of those strips.
+        !*/
+
+    public:
+
+        jpeg_row_reader( 
+            const std::string& filename,
+            const jpeg_decode_options& options = jpeg_decode_options()
+        );
+        /*!
+            requires
+                - options.scale_denom is 1, 2, 4 or 8
+            ensures
+                - opens the given JPEG file and reads its header.  The image is decoded
+                  as described by options.
+                - #next_row() == 0
+            throws
+                - std::bad_alloc
+                - image_load_error
+        !*/
+
+        jpeg_row_reader( 
+            const unsigned char* imgbuffer,
+            size_t imgbuffersize,
+            const jpeg_decode_options& options = jpeg_decode_options()
+        );
+        /*!
+            requires
+                - imgbuffer points to imgbuffersize bytes of JPEG encoded data, which
+                  must stay valid for the lifetime of this object
+                - options.scale_denom is 1, 2, 4 or 8
+            ensures
+                - reads the header of the JPEG image in imgbuffer.  The image is decoded
+                  as described by options.
+                - #next_row() == 0
+            throws
+                - std::bad_alloc
+                - image_load_error
+        !*/
+
+        long nr(
+        ) const;
+        /*!
+            ensures
+                - returns the number of rows in the (possibly scaled) image
+        !*/
+
+        long nc(
+        ) const;
+        /*!
+            ensures
+                - returns the number of columns in the (possibly scaled) image
+        !*/
+
+        bool is_gray(
+        ) const;
+        /*!
+            ensures
+                - returns true if the rows are decoded as grayscale pixels
+        !*/
+
+        bool is_rgb(
+        ) const;
+        /*!
+            ensures
+                - returns true if the rows are decoded as RGB pixels
+        !*/
+
+        long next_row(
+        ) const;
+        /*!
+            ensures
+                - returns the index of the image row the next call to read_rows() will
+                  decode first.  All the rows have been read once next_row() == nr().
+        !*/
+
+        template <
+            typename image_type
+            >
+        unsigned long read_rows (
+            image_type& img,
+            long first_row,
+            unsigned long num_rows
+        );
+        /*!
+            requires
+                - image_type == an image object that implements the interface defined in
+                  dlib/image_processing/generic_image.h 
+                - num_columns(img) == nc()
+                - 0 <= first_row
+                - first_row + num_rows <= num_rows(img)
+            ensures
+                - decodes the next min(num_rows, nr()-next_row()) rows of the image into
+                  rows first_row, first_row+1, ... of img and returns how many rows that
+                  was.  The pixels are the same ones jpeg_loader would give.
+                - #next_row() == next_row() + the returned number of rows
+                - unsigned char images (for grayscale output) and rgb_pixel images (for
+                  RGB output) are written in place, any other pixel type is converted
+                  through a small internal buffer.
+            throws
+                - image_load_error
+        !*/
+    };
+
 // ----------------------------------------------------------------------------------------
 
     template <
@@ -122,7 +329,88 @@ namespace dlib
             - image_type == an image object that implements the interface defined in
               dlib/image_processing/generic_image.h 
         ensures
-            - performs: jpeg_loader(file_name).get_image(image);
+            - #image == the image you would get from: jpeg_loader(file_name).get_image(image);
+            - The image is decoded straight into the rows of image (or a few rows at
+              a time into a small buffer when image's pixels don't have the layout
+              of the decoded JPEG data) rather than into a jpeg_loader first.  So
+              only one copy of the pixels is ever held in memory.
+        throws
+            - std::bad_alloc
+            - image_load_error
+    !*/
+
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename image_type
+        >
+    void load_jpeg (
+        image_type& image,
+        const unsigned char* imgbuffer,
+        size_t imgbuffersize
+    );
+    /*!
+        requires
+            - image_type == an image object that implements the interface defined in
+              dlib/image_processing/generic_image.h 
+            - imgbuffer points to imgbuffersize bytes of JPEG encoded data
+        ensures
+            - #image == the image you would get from: jpeg_loader(imgbuffer, imgbuffersize).get_image(image);
+            - like the load_jpeg() above, decodes straight into image without an
+              intermediate copy.
+        throws
+            - std::bad_alloc
+            - image_load_error
+    !*/
+
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename image_type
+        >
+    void load_jpeg (
+        image_type& image,
+        const std::string& file_name,
+        const jpeg_decode_options& options
+    );
+    /*!
+        requires
+            - image_type == an image object that implements the interface defined in
+              dlib/image_processing/generic_image.h 
+            - options.scale_denom is 1, 2, 4 or 8
+        ensures
+            - #image == the image you would get from: jpeg_loader(file_name, options).get_image(image);
+            - like the load_jpeg() above, decodes straight into image without an
+              intermediate copy.
+        throws
+            - std::bad_alloc
+            - image_load_error
+    !*/
+
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename image_type
+        >
+    void load_jpeg (
+        image_type& image,
+        const unsigned char* imgbuffer,
+        size_t imgbuffersize,
+        const jpeg_decode_options& options
+    );
+    /*!
+        requires
+            - image_type == an image object that implements the interface defined in
+              dlib/image_processing/generic_image.h 
+            - imgbuffer points to imgbuffersize bytes of JPEG encoded data
+            - options.scale_denom is 1, 2, 4 or 8
+        ensures
+            - #image == the image you would get from: jpeg_loader(imgbuffer, imgbuffersize, options).get_image(image);
+            - like the load_jpeg() above, decodes straight into image without an
+              intermediate copy.
+        throws
+            - std::bad_alloc
+            - image_load_error
     !*/
 
 // ----------------------------------------------------------------------------------------
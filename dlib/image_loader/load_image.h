@@ -10,6 +10,14 @@
 #include "image_loader.h"
 #include <fstream>
 #include <sstream>
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+#include <streambuf>
+#include <vector>
+#ifndef DLIB_ISO_CPP_ONLY
+#include "../mapped_file.h"
+#endif
 #ifdef DLIB_GIF_SUPPORT
 #include <gif_lib.h>
 #endif
@@ -28,15 +36,10 @@ namespace dlib
             UNKNOWN
         };
 
-        inline type read_type(const std::string& file_name) 
+        inline type read_type(const unsigned char* data, size_t size) 
         {
-            std::ifstream file(file_name.c_str(), std::ios::in|std::ios::binary);
-            if (!file)
-                throw image_load_error("Unable to open file: " + file_name);
-
-            char buffer[9];
-            file.read((char*)buffer, 8);
-            buffer[8] = 0;
+            char buffer[9] = {0};
+            std::copy(data, data + std::min<size_t>(size, 8), buffer);
 
             // Determine the true image type using link:
             // http://en.wikipedia.org/wiki/List_of_file_signatures
@@ -54,8 +57,88 @@ namespace dlib
 
             return UNKNOWN;
         }
+
+        inline type read_type(const std::string& file_name) 
+        {
+            std::ifstream file(file_name.c_str(), std::ios::in|std::ios::binary);
+            if (!file)
+                throw image_load_error("Unable to open file: " + file_name);
+
+            unsigned char buffer[8];
+            file.read((char*)buffer, 8);
+            return read_type(buffer, file.gcount());
+        }
     };
 
+// ----------------------------------------------------------------------------------------
+
+    namespace impl
+    {
+        class image_file_bytes : noncopyable
+        {
+            /*!
+                This object opens an image file once and gives access to all of its bytes,
+                so that sniffing the type of the file and decoding it don't each open the
+                file again.  The file is memory mapped, or read into memory when
+                DLIB_ISO_CPP_ONLY is defined since dlib can't map files then.
+            !*/
+        public:
+            explicit image_file_bytes (
+                const std::string& file_name
+            )
+            {
+#ifndef DLIB_ISO_CPP_ONLY
+                try
+                {
+                    file.open(file_name);
+                }
+                catch (mapped_file_error&)
+                {
+                    throw image_load_error("Unable to open file: " + file_name);
+                }
+#else
+                std::ifstream file(file_name.c_str(), std::ios::in|std::ios::binary);
+                if (!file)
+                    throw image_load_error("Unable to open file: " + file_name);
+                bytes.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+#endif
+            }
+
+#ifndef DLIB_ISO_CPP_ONLY
+            const unsigned char* data() const { return file.data(); }
+            size_t size() const { return static_cast<size_t>(file.size()); }
+#else
+            const unsigned char* data() const { return bytes.empty() ? 0 : &bytes[0]; }
+            size_t size() const { return bytes.size(); }
+#endif
+
+        private:
+#ifndef DLIB_ISO_CPP_ONLY
+            mapped_file file;
+#else
+            std::vector<unsigned char> bytes;
+#endif
+        };
+
+        class memory_streambuf : public std::streambuf
+        {
+            /*!
+                A read only streambuf over bytes that are already in memory, so that the
+                stream based loaders (i.e. load_bmp() and load_dng()) can read them without
+                copying them first.
+            !*/
+        public:
+            memory_streambuf (
+                const unsigned char* data,
+                size_t size
+            )
+            {
+                char* begin = const_cast<char*>(reinterpret_cast<const char*>(data));
+                setg(begin, begin, begin + size);
+            }
+        };
+    }
+
 // ----------------------------------------------------------------------------------------
 
 // handle the differences in API between libgif v5 and older.
@@ -71,16 +154,49 @@ namespace dlib
         const std::string& file_name
     )
     {
-        const image_file_type::type im_type = image_file_type::read_type(file_name);
+        // Open the file only once: its type is sniffed from the same bytes the decoders
+        // then read.
+        const impl::image_file_bytes file(file_name);
+        const image_file_type::type im_type = image_file_type::read_type(file.data(), file.size());
         switch (im_type)
         {
-            case image_file_type::BMP: load_bmp(image, file_name); return;
-            case image_file_type::DNG: load_dng(image, file_name); return;
+            case image_file_type::BMP: 
+            {
+                impl::memory_streambuf buf(file.data(), file.size());
+                std::istream sin(&buf);
+                load_bmp(image, sin); 
+                return;
+            }
+            case image_file_type::DNG: 
+            {
+                impl::memory_streambuf buf(file.data(), file.size());
+                std::istream sin(&buf);
+                load_dng(image, sin); 
+                return;
+            }
 #ifdef DLIB_PNG_SUPPORT
-            case image_file_type::PNG: load_png(image, file_name); return;
+            case image_file_type::PNG: 
+                try
+                {
+                    load_png(image, file.data(), file.size()); 
+                }
+                catch (image_load_error& e)
+                {
+                    throw image_load_error(e.info + " in file " + file_name);
+                }
+                return;
 #endif
 #ifdef DLIB_JPEG_SUPPORT
-            case image_file_type::JPG: load_jpeg(image, file_name); return;
+            case image_file_type::JPG: 
+                try
+                {
+                    load_jpeg(image, file.data(), file.size()); 
+                }
+                catch (image_load_error& e)
+                {
+                    throw image_load_error(e.info + " in file " + file_name);
+                }
+                return;
 #endif
 #ifdef DLIB_GIF_SUPPORT
             case image_file_type::GIF: 
@@ -218,6 +334,51 @@ namespace dlib
         }
     }
 
+// ----------------------------------------------------------------------------------------
+
+    template <typename image_type>
+    void load_image (
+        image_type& image,
+        const unsigned char* data,
+        size_t size
+    )
+    {
+        const image_file_type::type im_type = image_file_type::read_type(data, size);
+        switch (im_type)
+        {
+#ifdef DLIB_PNG_SUPPORT
+            case image_file_type::PNG: load_png(image, data, size); return;
+#endif
+#ifdef DLIB_JPEG_SUPPORT
+            case image_file_type::JPG: load_jpeg(image, data, size); return;
+#endif
+            case image_file_type::BMP: 
+            {
+                impl::memory_streambuf buf(data, size);
+                std::istream sin(&buf);
+                load_bmp(image, sin); 
+                return;
+            }
+            case image_file_type::DNG: 
+            {
+                impl::memory_streambuf buf(data, size);
+                std::istream sin(&buf);
+                load_dng(image, sin); 
+                return;
+            }
+            default:  ;
+        }
+
+        if (im_type == image_file_type::JPG)
+            throw image_load_error("Unable to load JPEG image from memory. You must #define DLIB_JPEG_SUPPORT and link to libjpeg to read JPEG images.");
+        else if (im_type == image_file_type::PNG)
+            throw image_load_error("Unable to load PNG image from memory. You must #define DLIB_PNG_SUPPORT and link to libpng to read PNG images.");
+        else if (im_type == image_file_type::GIF)
+            throw image_load_error("Unable to load GIF image from memory. Loading GIF images is only supported from files.");
+        else
+            throw image_load_error("Unknown image format: Unable to load image from memory");
+    }
+
 // ----------------------------------------------------------------------------------------
 
 }
@@ -24,12 +24,38 @@ namespace dlib
               GIF you must #define DLIB_PNG_SUPPORT, DLIB_JPEG_SUPPORT, and
               DLIB_GIF_SUPPORT respectively and link your program to libpng, libjpeg, and
               libgif respectively.
+            - The file is opened only once (it is memory mapped unless DLIB_ISO_CPP_ONLY
+              is defined): its type is determined from the same bytes the PNG, JPEG, BMP,
+              and DNG decoders then read.  GIF files are opened again by libgif.
         throws
             - image_load_error
                 This exception is thrown if there is some error that prevents
                 us from loading the given image file.
     !*/
 
+    template <typename image_type>
+    void load_image (
+        image_type& image,
+        const unsigned char* data,
+        size_t size
+    );
+    /*!
+        requires
+            - image_type == an image object that implements the interface defined in
+              dlib/image_processing/generic_image.h 
+            - data points to size bytes containing an encoded image
+        ensures
+            - This function decodes the image stored in memory at data (e.g. the contents
+              of an image file) and writes it to the indicated image object.
+            - It is capable of reading the PNG, JPEG, BMP, and DNG image formats, with the
+              same requirements as the file based version of load_image().  GIF images
+              can only be loaded from files.
+        throws
+            - image_load_error
+                This exception is thrown if there is some error that prevents
+                us from decoding the given image data.
+    !*/
+
 }
 
 #endif // DLIB_LOAd_IMAGE_ABSTRACT_ 
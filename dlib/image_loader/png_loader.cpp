@@ -11,6 +11,8 @@
 #include "../dir_nav.h"
 #include "png_loader.h"
 #include <png.h>
+#include <string.h>
+#include <vector>
 #include "../string.h"
 #include "../byte_orderer.h"
 
@@ -51,6 +53,18 @@ namespace dlib
         read_image( f.full_name().c_str() );
     }
 
+// ----------------------------------------------------------------------------------------
+
+    png_loader::
+    png_loader( const unsigned char* image_buffer, size_t buffer_size ) : height_( 0 ), width_( 0 )
+    {
+        if ( image_buffer == NULL )
+        {
+            throw image_load_error("png_loader: invalid image buffer, it is NULL");
+        }
+        read_image( NULL, image_buffer, buffer_size );
+    }
+
 // ----------------------------------------------------------------------------------------
 
     const unsigned char* png_loader::get_row( unsigned i ) const
@@ -106,9 +120,28 @@ namespace dlib
     {
     }
 
+    // The read position within an in-memory PNG stream
+    struct png_loader_buffer
+    {
+        const unsigned char* data;
+        size_t size;
+        size_t pos;
+    };
+
+    void png_loader_read_from_buffer(png_structp png_struct, png_bytep out, png_size_t length)
+    {
+        png_loader_buffer* buffer = (png_loader_buffer*)png_get_io_ptr(png_struct);
+        if (length > buffer->size - buffer->pos)
+            png_error(png_struct, "unexpected end of data");
+
+        memcpy(out, buffer->data + buffer->pos, length);
+        buffer->pos += length;
+    }
+
+// ----------------------------------------------------------------------------------------
+
     void png_loader::read_image( const char* filename )
     {
-        ld_.reset(new LibpngData);
         if ( filename == NULL )
         {
             throw image_load_error("png_loader: invalid filename, it is NULL");
@@ -118,49 +151,80 @@ namespace dlib
         {
             throw image_load_error(std::string("png_loader: unable to open file ") + filename);
         }
-        png_byte sig[8];
-        if (fread( sig, 1, 8, fp ) != 8)
+
+        try
+        {
+            read_image( fp, NULL, 0 );
+        }
+        catch (image_load_error& e)
         {
             fclose( fp );
-            throw image_load_error(std::string("png_loader: error reading file ") + filename);
+            throw image_load_error(e.info + " in file " + filename);
+        }
+
+        fclose( fp );
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    void png_loader::read_image( FILE* fp, const unsigned char* image_buffer, size_t buffer_size )
+    {
+        ld_.reset(new LibpngData);
+        png_byte sig[8];
+        png_loader_buffer buffer;
+        if (fp)
+        {
+            if (fread( sig, 1, 8, fp ) != 8)
+            {
+                throw image_load_error("png_loader: error reading data");
+            }
+        }
+        else
+        {
+            if (buffer_size < 8)
+            {
+                throw image_load_error("png_loader: error reading data");
+            }
+            memcpy(sig, image_buffer, 8);
+            buffer.data = image_buffer;
+            buffer.size = buffer_size;
+            buffer.pos = 8;
         }
         if ( png_sig_cmp( sig, 0, 8 ) != 0 )
         {
-            fclose( fp );
-            throw image_load_error(std::string("png_loader: format error in file ") + filename);
+            throw image_load_error("png_loader: format error");
         }
         ld_->png_ptr_ = png_create_read_struct( PNG_LIBPNG_VER_STRING, NULL, &png_loader_user_error_fn_silent, &png_loader_user_warning_fn_silent );
         if ( ld_->png_ptr_ == NULL )
         {
-            fclose( fp );
-            throw image_load_error(std::string("png_loader: parse error in file ") + filename);
+            throw image_load_error("png_loader: parse error");
         }
         ld_->info_ptr_ = png_create_info_struct( ld_->png_ptr_ );
         if ( ld_->info_ptr_ == NULL )
         {
-            fclose( fp );
             png_destroy_read_struct( &( ld_->png_ptr_ ), ( png_infopp )NULL, ( png_infopp )NULL );
-            throw image_load_error(std::string("png_loader: parse error in file ") + filename);
+            throw image_load_error("png_loader: parse error");
         }
         ld_->end_info_ = png_create_info_struct( ld_->png_ptr_ );
         if ( ld_->end_info_ == NULL )
         {
-            fclose( fp );
             png_destroy_read_struct( &( ld_->png_ptr_ ), &( ld_->info_ptr_ ), ( png_infopp )NULL );
-            throw image_load_error(std::string("png_loader: parse error in file ") + filename);
+            throw image_load_error("png_loader: parse error");
         }
 
         if (setjmp(png_jmpbuf(ld_->png_ptr_)))
         {
-            // If we get here, we had a problem writing the file 
-            fclose(fp);
+            // If we get here, we had a problem reading the file 
             png_destroy_read_struct( &( ld_->png_ptr_ ), &( ld_->info_ptr_ ), &( ld_->end_info_ ) );
-            throw image_load_error(std::string("png_loader: parse error in file ") + filename);
+            throw image_load_error("png_loader: parse error");
         }
 
         png_set_palette_to_rgb(ld_->png_ptr_);
 
-        png_init_io( ld_->png_ptr_, fp );
+        if (fp)
+            png_init_io( ld_->png_ptr_, fp );
+        else
+            png_set_read_fn( ld_->png_ptr_, &buffer, png_loader_read_from_buffer );
         png_set_sig_bytes( ld_->png_ptr_, 8 );
         // flags force one byte per channel output
         byte_orderer bo;
@@ -179,26 +243,179 @@ namespace dlib
             color_type_ != PNG_COLOR_TYPE_RGB_ALPHA &&
             color_type_ != PNG_COLOR_TYPE_GRAY_ALPHA)
         {
-            fclose( fp );
             png_destroy_read_struct( &( ld_->png_ptr_ ), &( ld_->info_ptr_ ), &( ld_->end_info_ ) );
-            throw image_load_error(std::string("png_loader: unsupported color type in file ") + filename);
+            throw image_load_error("png_loader: unsupported color type");
         }
 
         if (bit_depth_ != 8 && bit_depth_ != 16)
         {
-            fclose( fp );
             png_destroy_read_struct( &( ld_->png_ptr_ ), &( ld_->info_ptr_ ), &( ld_->end_info_ ) );
-            throw image_load_error("png_loader: unsupported bit depth of " + cast_to_string(bit_depth_) + " in file " + std::string(filename));
+            throw image_load_error("png_loader: unsupported bit depth of " + cast_to_string(bit_depth_));
         }
 
         ld_->row_pointers_ = png_get_rows( ld_->png_ptr_, ld_->info_ptr_ );
 
-        fclose( fp );
         if ( ld_->row_pointers_ == NULL )
         {
             png_destroy_read_struct( &( ld_->png_ptr_ ), &( ld_->info_ptr_ ), &( ld_->end_info_ ) );
-            throw image_load_error(std::string("png_loader: parse error in file ") + filename);
+            throw image_load_error("png_loader: parse error");
+        }
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    struct png_row_reader_state
+    {
+        png_row_reader_state() : fp(NULL), png_ptr(NULL), info_ptr(NULL) {}
+
+        // This runs even when a png_row_reader constructor throws, which is where a
+        // corrupt header is found.
+        ~png_row_reader_state()
+        {
+            if ( png_ptr )
+                png_destroy_read_struct( &png_ptr, &info_ptr, ( png_infopp )NULL );
+            if ( fp )
+                fclose( fp );
+        }
+
+        FILE* fp;
+        png_loader_buffer buffer;
+        png_structp png_ptr;
+        png_infop info_ptr;
+        std::vector<unsigned char> row;
+        // Interlaced images only have their final rows after the last pass over the
+        // whole image, so those get decoded in one go into here.
+        std::vector<unsigned char> whole_image;
+    };
+
+// ----------------------------------------------------------------------------------------
+
+    png_row_reader::
+    png_row_reader( const std::string& filename ) : 
+        height_( 0 ), width_( 0 ), channels_( 0 ), next_row_( 0 ), filename_( filename ), 
+        state_( new png_row_reader_state )
+    {
+        state_->fp = fopen( filename.c_str(), "rb" );
+        if ( !state_->fp )
+        {
+            throw image_load_error(std::string("png_loader: unable to open file ") + filename);
+        }
+        read_header( state_->fp, NULL, 0 );
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    png_row_reader::
+    png_row_reader( const unsigned char* image_buffer, size_t buffer_size ) : 
+        height_( 0 ), width_( 0 ), channels_( 0 ), next_row_( 0 ), state_( new png_row_reader_state )
+    {
+        if ( image_buffer == NULL )
+        {
+            throw image_load_error("png_loader: invalid image buffer, it is NULL");
+        }
+        read_header( NULL, image_buffer, buffer_size );
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    png_row_reader::
+    ~png_row_reader()
+    {
+        // state_ cleans up libpng's structures and the file
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    void png_row_reader::
+    fail( const std::string& message )
+    {
+        if ( filename_.size() != 0 )
+            throw image_load_error(message + " in file " + filename_);
+        throw image_load_error(message);
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    void png_row_reader::
+    read_header( FILE* fp, const unsigned char* image_buffer, size_t buffer_size )
+    {
+        png_byte sig[8];
+        if (fp)
+        {
+            if (fread( sig, 1, 8, fp ) != 8)
+                fail("png_loader: error reading data");
         }
+        else
+        {
+            if (buffer_size < 8)
+                fail("png_loader: error reading data");
+            memcpy(sig, image_buffer, 8);
+            state_->buffer.data = image_buffer;
+            state_->buffer.size = buffer_size;
+            state_->buffer.pos = 8;
+        }
+        if ( png_sig_cmp( sig, 0, 8 ) != 0 )
+            fail("png_loader: format error");
+
+        state_->png_ptr = png_create_read_struct( PNG_LIBPNG_VER_STRING, NULL, &png_loader_user_error_fn_silent, &png_loader_user_warning_fn_silent );
+        if ( state_->png_ptr == NULL )
+            fail("png_loader: parse error");
+        state_->info_ptr = png_create_info_struct( state_->png_ptr );
+        if ( state_->info_ptr == NULL )
+            fail("png_loader: parse error");
+
+        // libpng reports errors by longjmp()ing here, the destructor of the state cleans up
+        if (setjmp(png_jmpbuf(state_->png_ptr)))
+            fail("png_loader: parse error");
+
+        if (fp)
+            png_init_io( state_->png_ptr, fp );
+        else
+            png_set_read_fn( state_->png_ptr, &state_->buffer, png_loader_read_from_buffer );
+        png_set_sig_bytes( state_->png_ptr, 8 );
+        png_read_info( state_->png_ptr, state_->info_ptr );
+
+        // Always hand out 8 bits per channel, without palettes
+        png_set_palette_to_rgb( state_->png_ptr );
+        png_set_expand_gray_1_2_4_to_8( state_->png_ptr );
+        png_set_strip_16( state_->png_ptr );
+        const int passes = png_set_interlace_handling( state_->png_ptr );
+        png_read_update_info( state_->png_ptr, state_->info_ptr );
+
+        height_ = png_get_image_height( state_->png_ptr, state_->info_ptr );
+        width_ = png_get_image_width( state_->png_ptr, state_->info_ptr );
+        channels_ = png_get_channels( state_->png_ptr, state_->info_ptr );
+        if (channels_ < 1 || channels_ > 4)
+            fail("png_loader: unsupported color type");
+
+        state_->row.resize( png_get_rowbytes( state_->png_ptr, state_->info_ptr ) );
+
+        if (passes > 1)
+        {
+            const size_t row_size = state_->row.size();
+            state_->whole_image.resize( row_size*height_ );
+            std::vector<png_bytep> rows( height_ );
+            for (unsigned i = 0; i < height_; ++i)
+                rows[i] = &state_->whole_image[i*row_size];
+            if (height_ != 0)
+                png_read_image( state_->png_ptr, &rows[0] );
+        }
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    const unsigned char* png_row_reader::
+    read_row()
+    {
+        const unsigned row = next_row_++;
+        if (state_->whole_image.size() != 0)
+            return &state_->whole_image[row*state_->row.size()];
+
+        if (setjmp(png_jmpbuf(state_->png_ptr)))
+            fail("png_loader: parse error");
+
+        png_read_row( state_->png_ptr, &state_->row[0], NULL );
+        return &state_->row[0];
     }
 
 // ----------------------------------------------------------------------------------------
@@ -8,6 +8,9 @@
 #include "image_loader.h"
 #include "../pixel.h"
 #include "../dir_nav.h"
+#include "../image_processing/generic_image.h"
+#include <algorithm>
+#include <stdio.h>
 
 namespace dlib
 {
@@ -20,6 +23,7 @@ namespace dlib
         png_loader( const char* filename );
         png_loader( const std::string& filename );
         png_loader( const dlib::file& f );
+        png_loader( const unsigned char* image_buffer, size_t buffer_size );
         ~png_loader();
 
         bool is_gray() const;
@@ -190,12 +194,131 @@ namespace dlib
     private:
         const unsigned char* get_row( unsigned i ) const;
         void read_image( const char* filename );
+        void read_image( FILE* file, const unsigned char* image_buffer, size_t buffer_size );
         unsigned height_, width_;
         unsigned bit_depth_;
         int color_type_;
         scoped_ptr<LibpngData> ld_;
     };
 
+// ----------------------------------------------------------------------------------------
+
+    struct png_row_reader_state;
+    class png_row_reader : noncopyable
+    {
+    public:
+
+        png_row_reader( const std::string& filename );
+        png_row_reader( const unsigned char* image_buffer, size_t buffer_size );
+        ~png_row_reader();
+
+        long nr() const { return height_; }
+        long nc() const { return width_; }
+        bool is_gray() const { return channels_ == 1; }
+        bool is_graya() const { return channels_ == 2; }
+        bool is_rgb() const { return channels_ == 3; }
+        bool is_rgba() const { return channels_ == 4; }
+        long next_row() const { return next_row_; }
+
+        template <typename image_type>
+        unsigned long read_rows (
+            image_type& img_,
+            long first_row,
+            unsigned long num_rows
+        )
+        {
+#ifndef DLIB_PNG_SUPPORT
+            /* !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+                You are getting this error because you are trying to use the png_row_reader
+                object but you haven't defined DLIB_PNG_SUPPORT.  You must do so to use
+                this object.   You must also make sure you set your build environment
+                to link against the libpng library.
+            !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!*/
+            COMPILE_TIME_ASSERT(sizeof(image_type) == 0);
+#endif
+            typedef typename image_traits<image_type>::pixel_type pixel_type;
+            image_view<image_type> img(img_);
+
+            // make sure requires clause is not broken
+            DLIB_ASSERT(img.nc() == nc() && 0 <= first_row && first_row + (long)num_rows <= img.nr(),
+                "\t unsigned long png_row_reader::read_rows()"
+                << "\n\t the rows must fit inside img"
+                << "\n\t img.nr(): " << img.nr()
+                << "\n\t img.nc(): " << img.nc()
+                << "\n\t nc():     " << nc()
+                << "\n\t first_row: " << first_row
+                << "\n\t num_rows:  " << num_rows
+                );
+
+            num_rows = std::min<unsigned long>(num_rows, height_ - next_row_);
+            for (unsigned long i = 0; i < num_rows; ++i)
+            {
+                const unsigned char* v = read_row();
+                pixel_type* out = &img[first_row+i][0];
+                if (is_gray())
+                {
+                    for (unsigned m = 0; m < width_; ++m)
+                        assign_pixel(out[m], v[m]);
+                }
+                else if (is_graya())
+                {
+                    for (unsigned m = 0; m < width_; ++m)
+                    {
+                        if (!pixel_traits<pixel_type>::has_alpha)
+                        {
+                            assign_pixel(out[m], v[m*2]);
+                        }
+                        else
+                        {
+                            rgb_alpha_pixel pix;
+                            assign_pixel(pix, v[m*2]);
+                            assign_pixel(pix.alpha, v[m*2+1]);
+                            assign_pixel(out[m], pix);
+                        }
+                    }
+                }
+                else if (is_rgb())
+                {
+                    for (unsigned m = 0; m < width_; ++m)
+                    {
+                        rgb_pixel p;
+                        p.red = v[m*3];
+                        p.green = v[m*3+1];
+                        p.blue = v[m*3+2];
+                        assign_pixel(out[m], p);
+                    }
+                }
+                else // if (is_rgba())
+                {
+                    for (unsigned m = 0; m < width_; ++m)
+                    {
+                        // like png_loader, blend onto black for pixel types without alpha
+                        if (!pixel_traits<pixel_type>::has_alpha)
+                            assign_pixel(out[m], 0);
+                        rgb_alpha_pixel p;
+                        p.red = v[m*4];
+                        p.green = v[m*4+1];
+                        p.blue = v[m*4+2];
+                        p.alpha = v[m*4+3];
+                        assign_pixel(out[m], p);
+                    }
+                }
+            }
+            return num_rows;
+        }
+
+    private:
+        const unsigned char* read_row();
+        void read_header( FILE* file, const unsigned char* image_buffer, size_t buffer_size );
+        void fail( const std::string& message );
+
+        unsigned height_, width_;
+        unsigned channels_;
+        unsigned next_row_;
+        std::string filename_;
+        scoped_ptr<png_row_reader_state> state_;
+    };
+
 // ----------------------------------------------------------------------------------------
 
     template <
@@ -209,6 +332,20 @@ namespace dlib
         png_loader(file_name).get_image(image);
     }
 
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename image_type
+        >
+    void load_png (
+        image_type& image,
+        const unsigned char* image_buffer,
+        size_t buffer_size
+    )
+    {
+        png_loader(image_buffer, buffer_size).get_image(image);
+    }
+
 // ----------------------------------------------------------------------------------------
 
 }
@@ -65,6 +65,24 @@ namespace dlib
                   us from loading the given PNG file.
         !*/
 
+        png_loader( 
+            const unsigned char* image_buffer,
+            size_t buffer_size
+        );
+        /*!
+            requires
+                - image_buffer points to buffer_size bytes of PNG encoded data
+            ensures
+                - loads the PNG image contained in image_buffer into this object.  The
+                  buffer is only read during construction, so it doesn't need to outlive
+                  this object.
+            throws
+                - std::bad_alloc
+                - image_load_error
+                  This exception is thrown if there is some error that prevents
+                  us from decoding the given PNG data.
+        !*/
+
         ~png_loader(
         );
         /*!
@@ -136,6 +154,122 @@ namespace dlib
 
     };
 
+// ----------------------------------------------------------------------------------------
+
+    class png_row_reader : noncopyable
+    {
+        /*!
+            WHAT THIS OBJECT REPRESENTS
+                This object decodes a PNG image from top to bottom, one row at a time,
+                into rows of images you supply.  This is the PNG counterpart of
+                jpeg_row_reader: it lets you process images that are too big to decode
+                in one go with memory bounded by the rows you keep around.
+
+                Rows are always handed out with 8 bits per channel.  Palettes are
+                expanded to RGB, gray images with fewer than 8 bits per pixel are scaled
+                up to 8 bits and 16 bit samples are reduced to their most significant
+                byte.  Interlaced images can't be decoded a row at a time, so for those
+                the whole image is decoded when this object is constructed.
+        !*/
+
+    public:
+
+        png_row_reader( 
+            const std::string& filename
+        );
+        /*!
+            ensures
+                - opens the given PNG file and reads its header
+                - #next_row() == 0
+            throws
+                - std::bad_alloc
+                - image_load_error
+        !*/
+
+        png_row_reader( 
+            const unsigned char* image_buffer,
+            size_t buffer_size
+        );
+        /*!
+            requires
+                - image_buffer points to buffer_size bytes of PNG encoded data, which
+                  must stay valid for the lifetime of this object
+            ensures
+                - reads the header of the PNG image in image_buffer
+                - #next_row() == 0
+            throws
+                - std::bad_alloc
+                - image_load_error
+        !*/
+
+        ~png_row_reader(
+        );
+        /*!
+            ensures
+                - all resources associated with *this has been released
+        !*/
+
+        long nr(
+        ) const;
+        /*!
+            ensures
+                - returns the number of rows in the image
+        !*/
+
+        long nc(
+        ) const;
+        /*!
+            ensures
+                - returns the number of columns in the image
+        !*/
+
+        bool is_gray(
+        ) const;
+        bool is_graya(
+        ) const;
+        bool is_rgb(
+        ) const;
+        bool is_rgba(
+        ) const;
+        /*!
+            ensures
+                - exactly one of these returns true, telling whether the rows hold
+                  gray, gray+alpha, RGB or RGBA pixels
+        !*/
+
+        long next_row(
+        ) const;
+        /*!
+            ensures
+                - returns the index of the image row the next call to read_rows() will
+                  decode first.  All the rows have been read once next_row() == nr().
+        !*/
+
+        template <
+            typename image_type
+            >
+        unsigned long read_rows (
+            image_type& img,
+            long first_row,
+            unsigned long num_rows
+        );
+        /*!
+            requires
+                - image_type == an image object that implements the interface defined in
+                  dlib/image_processing/generic_image.h 
+                - num_columns(img) == nc()
+                - 0 <= first_row
+                - first_row + num_rows <= num_rows(img)
+            ensures
+                - decodes the next min(num_rows, nr()-next_row()) rows of the image into
+                  rows first_row, first_row+1, ... of img and returns how many rows that
+                  was.  For 8 bit images the pixels are the same ones png_loader gives.
+                - #next_row() == next_row() + the returned number of rows
+            throws
+                - image_load_error
+        !*/
+    };
+
 // ----------------------------------------------------------------------------------------
 
     template <
@@ -153,6 +287,25 @@ namespace dlib
             - performs: png_loader(file_name).get_image(image);
     !*/
 
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename image_type
+        >
+    void load_png (
+        image_type& image,
+        const unsigned char* image_buffer,
+        size_t buffer_size
+    );
+    /*!
+        requires
+            - image_type == an image object that implements the interface defined in
+              dlib/image_processing/generic_image.h 
+            - image_buffer points to buffer_size bytes of PNG encoded data
+        ensures
+            - performs: png_loader(image_buffer, buffer_size).get_image(image);
+    !*/
+
 // ----------------------------------------------------------------------------------------
 
 }
@@ -177,6 +177,12 @@ namespace dlib
             double adjust_threshold = 0
         );
 
+        void detect (
+            const image_scanner_type& loaded_scanner,
+            std::vector<rect_detection>& final_dets,
+            double adjust_threshold = 0
+        ) const;
+
         template <typename T>
         friend void serialize (
             const object_detector<T>& item,
@@ -431,12 +437,27 @@ namespace dlib
     ) 
     {
         scanner.load(img);
+        detect(scanner, final_dets, adjust_threshold);
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename image_scanner_type
+        >
+    void object_detector<image_scanner_type>::
+    detect (
+        const image_scanner_type& loaded_scanner,
+        std::vector<rect_detection>& final_dets,
+        double adjust_threshold
+    ) const
+    {
         std::vector<std::pair<double, rectangle> > dets;
         std::vector<rect_detection> dets_accum;
         for (unsigned long i = 0; i < w.size(); ++i)
         {
-            const double thresh = w[i].w(scanner.get_num_dimensions());
-            scanner.detect(w[i].get_detect_argument(), dets, thresh + adjust_threshold);
+            const double thresh = w[i].w(loaded_scanner.get_num_dimensions());
+            loaded_scanner.detect(w[i].get_detect_argument(), dets, thresh + adjust_threshold);
             for (unsigned long j = 0; j < dets.size(); ++j)
             {
                 rect_detection temp;
@@ -278,6 +278,25 @@ namespace dlib
                   simply a convenience function for performing this set of operations.
         !*/
 
+        void detect (
+            const image_scanner_type& loaded_scanner,
+            std::vector<rect_detection>& dets,
+            double adjust_threshold = 0
+        ) const;
+        /*!
+            requires
+                - loaded_scanner.is_loaded_with_image() == true
+                - loaded_scanner has the same configuration as get_scanner().
+            ensures
+                - This function is identical to the above operator() routine taking
+                  std::vector<rect_detection>, except that it runs the detector over the
+                  image loaded_scanner is already loaded with, instead of loading an image
+                  into get_scanner().  E.g. it can test a detector on the scanners of a
+                  prepared_object_detection_dataset.
+                - Since get_scanner() isn't used, several threads can call detect() on
+                  the same object_detector at once.
+        !*/
+
         template <
             typename image_type
             >
@@ -8,7 +8,21 @@
 #include "../image_transforms.h"
 #include "../array.h"
 #include "../array2d.h"
+#include "../threads/parallel_for_extension.h"
+#include "../mapped_file.h"
+#include "../misc_api.h"
+#include "../smart_pointers_thread_safe.h"
+#include "../general_hash/murmur_hash3.h"
 #include "object_detector.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <sstream>
+#include <typeinfo>
 
 namespace dlib
 {
@@ -62,6 +76,487 @@ namespace dlib
     inline void serialize   (const default_fhog_feature_extractor&, std::ostream&) {}
     inline void deserialize (default_fhog_feature_extractor&, std::istream&) {}
 
+// ----------------------------------------------------------------------------------------
+
+    enum fhog_feature_storage
+    {
+        FHOG_STORE_FLOAT,
+        FHOG_STORE_HALF,
+        FHOG_STORE_UINT8
+    };
+
+// ----------------------------------------------------------------------------------------
+
+    namespace impl
+    {
+        inline unsigned long interleaved_fhog_stride (
+            unsigned long num_planes
+        )
+        {
+            // Each cell of an interleaved fHOG image is padded to a multiple of 8 floats so
+            // it can be processed with simd8f.
+            return (num_planes+7)/8*8;
+        }
+
+        struct fhog_level_view
+        {
+            /*!
+                WHAT THIS OBJECT REPRESENTS
+                    A read only view of one level of an fHOG pyramid stored as planes of
+                    floats, half precision floats, or 8 bit values with a scale and offset
+                    per plane.  The planes are stored one after the other, each as rows*cols
+                    values.  The memory is owned by whoever made the view.
+            !*/
+
+            fhog_feature_storage storage;
+            unsigned long planes;
+            long rows;
+            long cols;
+            const void* data;
+            // Only used by FHOG_STORE_UINT8
+            const float* scale;
+            const float* offset;
+
+            float operator() (
+                unsigned long plane,
+                long r,
+                long c
+            ) const
+            {
+                const long idx = (plane*rows + r)*cols + c;
+                if (storage == FHOG_STORE_FLOAT)
+                    return static_cast<const float*>(data)[idx];
+                else if (storage == FHOG_STORE_HALF)
+                    return impl_fhog::half_to_float(static_cast<const uint16*>(data)[idx]);
+                else
+                    return static_cast<const uint8*>(data)[idx]*scale[plane] + offset[plane];
+            }
+
+            void decompress (
+                array<array2d<float> >& feats
+            ) const
+            /*!
+                ensures
+                    - #feats.size() == planes
+                    - #feats[i][r][c] == (*this)(i,r,c)
+            !*/
+            {
+                feats.set_max_size(planes);
+                feats.set_size(planes);
+                for (unsigned long i = 0; i < planes; ++i)
+                {
+                    feats[i].set_size(rows, cols);
+                    for (long r = 0; r < rows; ++r)
+                    {
+                        float* out = &feats[i][r][0];
+                        const long idx = (i*rows + r)*cols;
+                        long c = 0;
+                        if (storage == FHOG_STORE_FLOAT)
+                        {
+                            std::memcpy(out, static_cast<const float*>(data)+idx, cols*sizeof(float));
+                        }
+                        else if (storage == FHOG_STORE_HALF)
+                        {
+                            const uint16* in = static_cast<const uint16*>(data)+idx;
+                            c = impl_fhog::dispatch_half_to_float_row(in, cols, out);
+                            for (; c < cols; ++c)
+                                out[c] = impl_fhog::half_to_float(in[c]);
+                        }
+                        else
+                        {
+                            const uint8* in = static_cast<const uint8*>(data)+idx;
+                            c = impl_fhog::dispatch_dequantize_row(in, cols, scale[i], offset[i], out);
+                            for (; c < cols; ++c)
+                                out[c] = in[c]*scale[i] + offset[i];
+                        }
+                    }
+                }
+            }
+        };
+
+        class compressed_fhog_image
+        {
+            /*!
+                WHAT THIS OBJECT REPRESENTS
+                    One level of an fHOG pyramid, with its planes stored as half precision
+                    floats or as 8 bit values with a scale and offset per plane.  
+            !*/
+        public:
+
+            compressed_fhog_image (
+            ) : storage(FHOG_STORE_HALF), planes(0), rows(0), cols(0) {}
+
+            void compress (
+                const array<array2d<float> >& feats,
+                fhog_feature_storage storage_
+            )
+            {
+                DLIB_ASSERT(storage_ != FHOG_STORE_FLOAT,
+                    "\t void compressed_fhog_image::compress()"
+                    << "\n\t Only the half and 8 bit storage formats are compressed.");
+
+                storage = storage_;
+                planes = feats.size();
+                rows = planes == 0 ? 0 : feats[0].nr();
+                cols = planes == 0 ? 0 : feats[0].nc();
+                const long plane_size = rows*cols;
+
+                halves.clear();
+                bytes.clear();
+                scale.clear();
+                offset.clear();
+                if (storage == FHOG_STORE_HALF)
+                {
+                    halves.resize(planes*plane_size);
+                    for (unsigned long i = 0; i < planes; ++i)
+                    {
+                        uint16* out = &halves[0] + i*plane_size;
+                        for (long r = 0; r < rows; ++r)
+                            for (long c = 0; c < cols; ++c)
+                                *out++ = impl_fhog::float_to_half(feats[i][r][c]);
+                    }
+                }
+                else
+                {
+                    bytes.resize(planes*plane_size);
+                    scale.resize(planes);
+                    offset.resize(planes);
+                    for (unsigned long i = 0; i < planes; ++i)
+                    {
+                        float lo = 0, hi = 0;
+                        if (plane_size != 0)
+                        {
+                            lo = hi = feats[i][0][0];
+                            for (long r = 0; r < rows; ++r)
+                            {
+                                for (long c = 0; c < cols; ++c)
+                                {
+                                    lo = std::min(lo, feats[i][r][c]);
+                                    hi = std::max(hi, feats[i][r][c]);
+                                }
+                            }
+                        }
+                        scale[i] = (hi-lo)/255;
+                        offset[i] = lo;
+
+                        uint8* out = &bytes[0] + i*plane_size;
+                        for (long r = 0; r < rows; ++r)
+                        {
+                            for (long c = 0; c < cols; ++c)
+                            {
+                                const float q = scale[i] == 0 ? 0 : std::floor((feats[i][r][c]-lo)/scale[i] + 0.5f);
+                                *out++ = static_cast<uint8>(put_in_range(0.0f, 255.0f, q));
+                            }
+                        }
+                    }
+                }
+            }
+
+            fhog_feature_storage get_storage (
+            ) const { return storage; }
+
+            unsigned long size (
+            ) const { return planes; }
+
+            long nr (
+            ) const { return rows; }
+
+            long nc (
+            ) const { return cols; }
+
+            fhog_level_view view (
+            ) const
+            {
+                fhog_level_view v;
+                v.storage = storage;
+                v.planes = planes;
+                v.rows = rows;
+                v.cols = cols;
+                v.data = 0;
+                if (storage == FHOG_STORE_HALF && halves.size() != 0)
+                    v.data = &halves[0];
+                else if (storage == FHOG_STORE_UINT8 && bytes.size() != 0)
+                    v.data = &bytes[0];
+                v.scale = scale.size() != 0 ? &scale[0] : 0;
+                v.offset = offset.size() != 0 ? &offset[0] : 0;
+                return v;
+            }
+
+            float operator() (
+                unsigned long plane,
+                long r,
+                long c
+            ) const { return view()(plane,r,c); }
+
+            void decompress (
+                array<array2d<float> >& feats
+            ) const { view().decompress(feats); }
+
+            unsigned long memory_usage (
+            ) const
+            {
+                return halves.size()*sizeof(uint16) + bytes.size() + (scale.size() + offset.size())*sizeof(float);
+            }
+
+        private:
+            fhog_feature_storage storage;
+            unsigned long planes;
+            long rows;
+            long cols;
+            std::vector<uint16> halves;
+            std::vector<uint8> bytes;
+            std::vector<float> scale;
+            std::vector<float> offset;
+        };
+
+        inline const array<array2d<float> >& get_fhog_level (
+            const array<array<array2d<float> > >& feats,
+            unsigned long level,
+            array<array2d<float> >& 
+        ) { return feats[level]; }
+
+        inline const array<array2d<float> >& get_fhog_level (
+            const std::vector<compressed_fhog_image>& feats,
+            unsigned long level,
+            array<array2d<float> >& scratch
+        ) 
+        { 
+            feats[level].decompress(scratch);
+            return scratch;
+        }
+
+    // ------------------------------------------------------------------------------------
+
+        class mapped_fhog_pyramid
+        {
+            /*!
+                WHAT THIS OBJECT REPRESENTS
+                    An fHOG pyramid kept in a feature cache file and memory mapped, so the
+                    operating system decides which parts of it stay in RAM.  Copies share
+                    the same mapping.
+
+                    The file starts with a header and a table of levels, followed by the
+                    levels, each starting on a 64 byte boundary.  It is written in the
+                    native byte order and only meant to be read back on the same machine.
+            !*/
+
+            struct file_header
+            {
+                char magic[8];
+                uint32 version;
+                uint32 storage;
+                uint64 key[2];
+                uint64 num_levels;
+            };
+
+            struct level_header
+            {
+                uint32 planes;
+                uint32 rows;
+                uint32 cols;
+                uint32 reserved;
+                uint64 offset;
+            };
+
+            static uint64 level_bytes (
+                fhog_feature_storage storage,
+                uint64 planes,
+                uint64 rows,
+                uint64 cols
+            )
+            {
+                if (storage == FHOG_STORE_FLOAT)
+                    return planes*rows*cols*sizeof(float);
+                else if (storage == FHOG_STORE_HALF)
+                    return planes*rows*cols*sizeof(uint16);
+                else
+                    return 2*planes*sizeof(float) + planes*rows*cols;
+            }
+
+            static uint64 align_level (
+                uint64 offset
+            ) { return (offset+63)/64*64; }
+
+        public:
+
+            unsigned long size (
+            ) const { return levels.size(); }
+
+            const fhog_level_view& operator[] (
+                unsigned long level
+            ) const { return levels[level]; }
+
+            void clear (
+            )
+            {
+                levels.clear();
+                file.reset();
+            }
+
+            bool open (
+                const std::string& filename,
+                fhog_feature_storage storage,
+                const std::pair<uint64,uint64>& key
+            )
+            /*!
+                ensures
+                    - if (filename is a feature cache file written by write() with the given
+                      storage and key) then
+                        - maps it and returns true
+                    - else
+                        - #size() == 0
+                        - returns false
+            !*/
+            {
+                clear();
+                shared_ptr_thread_safe<mapped_file> mapping(new mapped_file);
+                try { mapping->open(filename); }
+                catch (mapped_file_error&) { return false; }
+
+                const uint64 file_size = mapping->size();
+                if (file_size < sizeof(file_header))
+                    return false;
+                file_header header;
+                std::memcpy(&header, mapping->data(), sizeof(header));
+                if (std::memcmp(header.magic, "DLIBFHOG", 8) != 0 || header.version != 1 ||
+                    header.storage != static_cast<uint32>(storage) ||
+                    header.key[0] != key.first || header.key[1] != key.second ||
+                    header.num_levels > (file_size-sizeof(file_header))/sizeof(level_header))
+                    return false;
+
+                std::vector<fhog_level_view> views(header.num_levels);
+                for (unsigned long l = 0; l < views.size(); ++l)
+                {
+                    level_header lh;
+                    std::memcpy(&lh, mapping->data() + sizeof(file_header) + l*sizeof(level_header), sizeof(lh));
+                    const uint64 bytes = level_bytes(storage, lh.planes, lh.rows, lh.cols);
+                    if (lh.offset%64 != 0 || lh.offset > file_size || bytes > file_size - lh.offset ||
+                        lh.rows > 0x7FFFFFFF || lh.cols > 0x7FFFFFFF)
+                        return false;
+
+                    const unsigned char* level_data = mapping->data() + lh.offset;
+                    fhog_level_view& v = views[l];
+                    v.storage = storage;
+                    v.planes = lh.planes;
+                    v.rows = lh.rows;
+                    v.cols = lh.cols;
+                    v.scale = 0;
+                    v.offset = 0;
+                    if (storage == FHOG_STORE_UINT8)
+                    {
+                        v.scale = reinterpret_cast<const float*>(level_data);
+                        v.offset = v.scale + lh.planes;
+                        level_data += 2*lh.planes*sizeof(float);
+                    }
+                    v.data = level_data;
+                }
+
+                levels.swap(views);
+                file = mapping;
+                return true;
+            }
+
+            static void write (
+                const std::string& filename,
+                fhog_feature_storage storage,
+                const std::pair<uint64,uint64>& key,
+                const array<array<array2d<float> > >& feats
+            )
+            /*!
+                ensures
+                    - writes feats to a feature cache file that open() can map.  The file
+                      is written under a temporary name and then renamed, so readers never
+                      see a partly written file.
+                throws
+                    - dlib::error if the file can't be written.
+            !*/
+            {
+                file_header header;
+                std::memcpy(header.magic, "DLIBFHOG", 8);
+                header.version = 1;
+                header.storage = storage;
+                header.key[0] = key.first;
+                header.key[1] = key.second;
+                header.num_levels = feats.size();
+
+                std::vector<level_header> table(feats.size());
+                uint64 offset = align_level(sizeof(file_header) + table.size()*sizeof(level_header));
+                for (unsigned long l = 0; l < feats.size(); ++l)
+                {
+                    table[l].planes = feats[l].size();
+                    table[l].rows = feats[l].size() == 0 ? 0 : feats[l][0].nr();
+                    table[l].cols = feats[l].size() == 0 ? 0 : feats[l][0].nc();
+                    table[l].reserved = 0;
+                    table[l].offset = offset;
+                    offset = align_level(offset + level_bytes(storage, table[l].planes, table[l].rows, table[l].cols));
+                }
+
+                std::ostringstream sout;
+                sout << filename << ".tmp" << get_thread_id() << "_" << timestamper().get_timestamp();
+                const std::string temp_name = sout.str();
+                std::ofstream fout(temp_name.c_str(), std::ios::binary);
+                fout.write(reinterpret_cast<const char*>(&header), sizeof(header));
+                if (table.size() != 0)
+                    fout.write(reinterpret_cast<const char*>(&table[0]), table.size()*sizeof(level_header));
+
+                const char zeros[64] = {};
+                compressed_fhog_image level;
+                for (unsigned long l = 0; l < feats.size() && fout; ++l)
+                {
+                    fout.write(zeros, table[l].offset - static_cast<uint64>(fout.tellp()));
+                    if (storage == FHOG_STORE_FLOAT)
+                    {
+                        for (unsigned long i = 0; i < feats[l].size(); ++i)
+                            for (long r = 0; r < feats[l][i].nr(); ++r)
+                                fout.write(reinterpret_cast<const char*>(&feats[l][i][r][0]), feats[l][i].nc()*sizeof(float));
+                    }
+                    else
+                    {
+                        level.compress(feats[l], storage);
+                        const fhog_level_view v = level.view();
+                        const uint64 values = v.planes*v.rows*v.cols;
+                        if (storage == FHOG_STORE_UINT8)
+                        {
+                            fout.write(reinterpret_cast<const char*>(v.scale), v.planes*sizeof(float));
+                            fout.write(reinterpret_cast<const char*>(v.offset), v.planes*sizeof(float));
+                            fout.write(static_cast<const char*>(v.data), values);
+                        }
+                        else
+                        {
+                            fout.write(static_cast<const char*>(v.data), values*sizeof(uint16));
+                        }
+                    }
+                }
+                fout.close();
+
+                if (!fout)
+                {
+                    std::remove(temp_name.c_str());
+                    throw error("Unable to write the fHOG feature cache file " + filename);
+                }
+
+                // If another thread or process got there first its file holds the same
+                // features, so either one can win.
+                if (std::rename(temp_name.c_str(), filename.c_str()) != 0)
+                    std::remove(temp_name.c_str());
+            }
+
+        private:
+            shared_ptr_thread_safe<mapped_file> file;
+            std::vector<fhog_level_view> levels;
+        };
+
+        inline const array<array2d<float> >& get_fhog_level (
+            const mapped_fhog_pyramid& feats,
+            unsigned long level,
+            array<array2d<float> >& scratch
+        ) 
+        { 
+            feats[level].decompress(scratch);
+            return scratch;
+        }
+    }
+
 // ----------------------------------------------------------------------------------------
 
     template <
@@ -116,6 +611,8 @@ namespace dlib
             window_width = width;
             window_height = height;
             feats.clear();
+            compressed_feats.clear();
+            mapped_feats.clear();
         }
 
         inline unsigned long get_detection_window_width (
@@ -135,6 +632,8 @@ namespace dlib
         {
             padding = new_padding;
             feats.clear();
+            compressed_feats.clear();
+            mapped_feats.clear();
         }
 
         unsigned long get_padding (
@@ -153,6 +652,8 @@ namespace dlib
 
             cell_size = new_cell_size;
             feats.clear();
+            compressed_feats.clear();
+            mapped_feats.clear();
         }
 
         unsigned long get_cell_size (
@@ -182,6 +683,46 @@ namespace dlib
         inline unsigned long get_min_pyramid_layer_height (
         ) const;
 
+        void set_num_threads (
+            unsigned long num
+        ) { num_threads = num; }
+
+        unsigned long get_num_threads (
+        ) const { return num_threads; }
+
+        void set_interleaved_filtering (
+            bool enabled
+        ) { interleaved_filtering = enabled; }
+
+        bool get_interleaved_filtering (
+        ) const { return interleaved_filtering; }
+
+        void set_feature_storage (
+            fhog_feature_storage storage
+        ) 
+        { 
+            feature_storage = storage; 
+            feats.clear();
+            compressed_feats.clear();
+            mapped_feats.clear();
+        }
+
+        fhog_feature_storage get_feature_storage (
+        ) const { return feature_storage; }
+
+        void set_feature_cache_directory (
+            const std::string& directory
+        )
+        {
+            feature_cache_directory = directory;
+            feats.clear();
+            compressed_feats.clear();
+            mapped_feats.clear();
+        }
+
+        const std::string& get_feature_cache_directory (
+        ) const { return feature_cache_directory; }
+
         void detect (
             const feature_vector_type& w,
             std::vector<std::pair<double, rectangle> >& dets,
@@ -203,6 +744,28 @@ namespace dlib
             detect(temp, dets, thresh);
         }
 
+        void detect (
+            const feature_vector_type& w,
+            std::vector<std::pair<double, rectangle> >& dets,
+            const double thresh,
+            const unsigned long max_dets
+        ) const
+        {
+            // make sure requires clause is not broken
+            DLIB_ASSERT(is_loaded_with_image() &&
+                        w.size() >= get_num_dimensions(), 
+                "\t void scan_fhog_pyramid::detect()"
+                << "\n\t Invalid inputs were given to this function "
+                << "\n\t is_loaded_with_image(): " << is_loaded_with_image()
+                << "\n\t w.size():               " << w.size()
+                << "\n\t get_num_dimensions():   " << get_num_dimensions()
+                << "\n\t this: " << this
+                );
+
+            fhog_filterbank temp = build_fhog_filterbank(w);
+            detect(temp, dets, thresh, max_dets);
+        }
+
         class fhog_filterbank 
         {
             friend class scan_fhog_pyramid;
@@ -231,6 +794,11 @@ namespace dlib
 
             std::vector<matrix<float> > filters;
             std::vector<std::vector<matrix<float,0,1> > > row_filters, col_filters;
+
+            // The filters laid out like an interleaved fHOG image: interleaved_rows rows
+            // of interleaved_cols cells, each cell holding the weights of all the planes.
+            std::vector<float> interleaved_filter;
+            long interleaved_rows, interleaved_cols;
         };
 
         fhog_filterbank build_fhog_filterbank (
@@ -281,6 +849,19 @@ namespace dlib
                 }
             }
 
+            const unsigned long stride = impl::interleaved_fhog_stride(temp.filters.size());
+            temp.interleaved_rows = height;
+            temp.interleaved_cols = width;
+            temp.interleaved_filter.assign(height*width*stride, 0);
+            for (unsigned long i = 0; i < temp.filters.size(); ++i)
+            {
+                for (unsigned long r = 0; r < height; ++r)
+                {
+                    for (unsigned long c = 0; c < width; ++c)
+                        temp.interleaved_filter[(r*width + c)*stride + i] = temp.filters[i](r,c);
+                }
+            }
+
             return temp;
         }
 
@@ -290,6 +871,13 @@ namespace dlib
             const double thresh
         ) const;
 
+        void detect (
+            const fhog_filterbank& w,
+            std::vector<std::pair<double, rectangle> >& dets,
+            const double thresh,
+            const unsigned long max_dets
+        ) const;
+
 
         void get_feature_vector (
             const full_object_detection& obj,
@@ -352,6 +940,13 @@ namespace dlib
         );
 
     private:
+        template <
+            typename image_type
+            >
+        std::pair<uint64,uint64> feature_cache_key (
+            const image_type& img
+        ) const;
+
         inline void compute_fhog_window_size(
             unsigned long& width,
             unsigned long& height
@@ -385,6 +980,8 @@ namespace dlib
 
         feature_extractor_type fe;
         array<fhog_image> feats;
+        std::vector<impl::compressed_fhog_image> compressed_feats;
+        impl::mapped_fhog_pyramid mapped_feats;
         int cell_size;
         unsigned long padding; 
         unsigned long window_width;
@@ -393,6 +990,10 @@ namespace dlib
         unsigned long min_pyramid_layer_width;
         unsigned long min_pyramid_layer_height;
         double nuclear_norm_regularization_strength;
+        unsigned long num_threads;
+        bool interleaved_filtering;
+        fhog_feature_storage feature_storage;
+        std::string feature_cache_directory;
 
         void init()
         {
@@ -404,6 +1005,9 @@ namespace dlib
             min_pyramid_layer_width = 64;
             min_pyramid_layer_height = 64;
             nuclear_norm_regularization_strength = 0;
+            num_threads = 1;
+            interleaved_filtering = false;
+            feature_storage = FHOG_STORE_FLOAT;
         }
 
     };
@@ -416,7 +1020,8 @@ namespace dlib
         rectangle apply_filters_to_fhog (
             const fhog_filterbank& w,
             const array<array2d<float> >& feats,
-            array2d<float>& saliency_image
+            array2d<float>& saliency_image,
+            array2d<float>& scratch
         )
         {
             const unsigned long num_separable_filters = w.num_separable_filters();
@@ -435,7 +1040,6 @@ namespace dlib
             else
             {
                 saliency_image.clear();
-                array2d<float> scratch;
 
                 // find the first filter to apply
                 unsigned long i = 0;
@@ -460,6 +1064,139 @@ namespace dlib
             }
             return area;
         }
+
+        template <typename fhog_filterbank>
+        rectangle apply_filters_to_fhog (
+            const fhog_filterbank& w,
+            const array<array2d<float> >& feats,
+            array2d<float>& saliency_image
+        )
+        {
+            array2d<float> scratch;
+            return apply_filters_to_fhog(w, feats, saliency_image, scratch);
+        }
+
+        inline void interleave_fhog_planes (
+            const array<array2d<float> >& feats,
+            std::vector<float>& cells
+        )
+        /*!
+            ensures
+                - Stores the planar fHOG image feats into cells as feats[0].nr() rows of
+                  feats[0].nc() cells, where each cell holds the values of all the planes
+                  at that location followed by zero padding.  That is,
+                  cells[(r*feats[0].nc() + c)*interleaved_fhog_stride(feats.size()) + i] == feats[i][r][c]
+        !*/
+        {
+            const unsigned long stride = interleaved_fhog_stride(feats.size());
+            const long nr = feats.size() == 0 ? 0 : feats[0].nr();
+            const long nc = feats.size() == 0 ? 0 : feats[0].nc();
+            cells.assign(nr*nc*stride, 0);
+            for (unsigned long i = 0; i < feats.size(); ++i)
+            {
+                for (long r = 0; r < nr; ++r)
+                {
+                    const float* in = &feats[i][r][0];
+                    float* out = &cells[r*nc*stride + i];
+                    for (long c = 0; c < nc; ++c)
+                        out[c*stride] = in[c];
+                }
+            }
+        }
+
+        template <typename fhog_filterbank>
+        rectangle apply_interleaved_filters_to_fhog (
+            const fhog_filterbank& w,
+            const array<array2d<float> >& feats,
+            const std::vector<float>& cells,
+            array2d<float>& saliency_image
+        )
+        /*!
+            requires
+                - cells == the output of interleave_fhog_planes(feats, cells)
+            ensures
+                - Computes the same thing as apply_filters_to_fhog() using the full (not
+                  separable) filters.  But rather than running one filtering pass over the
+                  image for each plane, this function visits each window position once and
+                  correlates all the planes of the filter with it there.
+        !*/
+        {
+            const long nr = feats[0].nr();
+            const long nc = feats[0].nc();
+            const long stride = interleaved_fhog_stride(feats.size());
+            saliency_image.set_size(nr, nc);
+
+            // figure out the range that we should apply the filter to
+            const long first_row = w.interleaved_rows/2;
+            const long first_col = w.interleaved_cols/2;
+            const long last_row = nr - ((w.interleaved_rows-1)/2);
+            const long last_col = nc - ((w.interleaved_cols-1)/2);
+
+            const rectangle non_border = rectangle(first_col, first_row, last_col-1, last_row-1);
+            zero_border_pixels(saliency_image, non_border);
+
+            // Because the cells are interleaved, one row of the filter lines up with a
+            // contiguous run of floats in the fHOG image.
+            const long run = w.interleaved_cols*stride;
+
+            // Work on blocks of columns so the rows of cells a block reads stay in cache
+            // while we move down the image.
+            const long block_size = 32;
+            for (long block = first_col; block < last_col; block += block_size)
+            {
+                const long block_end = std::min(block + block_size, last_col);
+                for (long r = first_row; r < last_row; ++r)
+                {
+                    long c = block;
+                    // do 4 window positions at a time so each load of the filter is
+                    // used 4 times
+                    for (; c+3 < block_end; c += 4)
+                    {
+                        simd8f p0, p1, p2, p3, f;
+                        simd8f temp0 = 0, temp1 = 0, temp2 = 0, temp3 = 0;
+                        for (long m = 0; m < w.interleaved_rows; ++m)
+                        {
+                            const float* in = &cells[((r-first_row+m)*nc + c-first_col)*stride];
+                            const float* filter = &w.interleaved_filter[m*run];
+                            for (long k = 0; k < run; k += 8)
+                            {
+                                f.load(filter+k);
+                                p0.load(in+k);
+                                p1.load(in+k+stride);
+                                p2.load(in+k+2*stride);
+                                p3.load(in+k+3*stride);
+                                temp0 += p0*f;
+                                temp1 += p1*f;
+                                temp2 += p2*f;
+                                temp3 += p3*f;
+                            }
+                        }
+                        saliency_image[r][c] = sum(temp0);
+                        saliency_image[r][c+1] = sum(temp1);
+                        saliency_image[r][c+2] = sum(temp2);
+                        saliency_image[r][c+3] = sum(temp3);
+                    }
+                    for (; c < block_end; ++c)
+                    {
+                        simd8f p, f, temp = 0;
+                        for (long m = 0; m < w.interleaved_rows; ++m)
+                        {
+                            const float* in = &cells[((r-first_row+m)*nc + c-first_col)*stride];
+                            const float* filter = &w.interleaved_filter[m*run];
+                            for (long k = 0; k < run; k += 8)
+                            {
+                                p.load(in+k);
+                                f.load(filter+k);
+                                temp += p*f;
+                            }
+                        }
+                        saliency_image[r][c] = sum(temp);
+                    }
+                }
+            }
+
+            return non_border;
+        }
     }
 
 // ----------------------------------------------------------------------------------------
@@ -473,7 +1210,23 @@ namespace dlib
         int version = 1;
         serialize(version, out);
         serialize(item.fe, out);
-        serialize(item.feats, out);
+        if (item.compressed_feats.size() != 0 || item.mapped_feats.size() != 0)
+        {
+            // always saved as floats, so the format doesn't depend on the storage type
+            array<array<array2d<float> > > temp(item.compressed_feats.size() != 0 ? item.compressed_feats.size() : item.mapped_feats.size());
+            for (unsigned long l = 0; l < temp.size(); ++l)
+            {
+                if (item.compressed_feats.size() != 0)
+                    item.compressed_feats[l].decompress(temp[l]);
+                else
+                    item.mapped_feats[l].decompress(temp[l]);
+            }
+            serialize(temp, out);
+        }
+        else
+        {
+            serialize(item.feats, out);
+        }
         serialize(item.cell_size, out);
         serialize(item.padding, out);
         serialize(item.window_width, out);
@@ -500,6 +1253,8 @@ namespace dlib
 
         deserialize(item.fe, in);
         deserialize(item.feats, in);
+        item.compressed_feats.clear();
+        item.mapped_feats.clear();
         deserialize(item.cell_size, in);
         deserialize(item.padding, in);
         deserialize(item.window_width, in);
@@ -556,24 +1311,16 @@ namespace dlib
     namespace impl
     {
         template <
-            typename pyramid_type,
-            typename image_type,
-            typename feature_extractor_type
+            typename pyramid_type
             >
-        void create_fhog_pyramid (
-            const image_type& img,
-            const feature_extractor_type& fe,
-            array<array<array2d<float> > >& feats,
-            int cell_size,
-            int filter_rows_padding,
-            int filter_cols_padding,
+        unsigned long num_fhog_pyramid_levels (
+            rectangle rect,
             unsigned long min_pyramid_layer_width,
             unsigned long min_pyramid_layer_height,
             unsigned long max_pyramid_levels
         )
         {
             unsigned long levels = 0;
-            rectangle rect = get_rect(img);
 
             // figure out how many pyramid levels we should be using based on the image size
             pyramid_type pyr;
@@ -584,6 +1331,32 @@ namespace dlib
             } while (rect.width() >= min_pyramid_layer_width && rect.height() >= min_pyramid_layer_height &&
                 levels < max_pyramid_levels);
 
+            return levels;
+        }
+
+        template <
+            typename pyramid_type,
+            typename image_type,
+            typename feature_extractor_type
+            >
+        void create_fhog_pyramid (
+            const image_type& img,
+            const feature_extractor_type& fe,
+            array<array<array2d<float> > >& feats,
+            int cell_size,
+            int filter_rows_padding,
+            int filter_cols_padding,
+            unsigned long min_pyramid_layer_width,
+            unsigned long min_pyramid_layer_height,
+            unsigned long max_pyramid_levels,
+            array2d<typename image_traits<image_type>::pixel_type>& temp1,
+            array2d<typename image_traits<image_type>::pixel_type>& temp2
+        )
+        {
+            const unsigned long levels = num_fhog_pyramid_levels<pyramid_type>(get_rect(img),
+                min_pyramid_layer_width, min_pyramid_layer_height, max_pyramid_levels);
+            pyramid_type pyr;
+
             if (feats.max_size() < levels)
                 feats.set_max_size(levels);
             feats.set_size(levels);
@@ -598,8 +1371,6 @@ namespace dlib
 
             if (feats.size() > 1)
             {
-                typedef typename image_traits<image_type>::pixel_type pixel_type;
-                array2d<pixel_type> temp1, temp2;
                 pyr(img, temp1);
                 fe(temp1, feats[1], cell_size,filter_rows_padding,filter_cols_padding);
                 swap(temp1,temp2);
@@ -612,13 +1383,99 @@ namespace dlib
                 }
             }
         }
-    }
-
-// ----------------------------------------------------------------------------------------
 
-    template <
-        typename Pyramid_type,
-        typename feature_extractor_type
+        template <
+            typename pyramid_type,
+            typename image_type,
+            typename feature_extractor_type
+            >
+        void create_fhog_pyramid (
+            const image_type& img,
+            const feature_extractor_type& fe,
+            array<array<array2d<float> > >& feats,
+            int cell_size,
+            int filter_rows_padding,
+            int filter_cols_padding,
+            unsigned long min_pyramid_layer_width,
+            unsigned long min_pyramid_layer_height,
+            unsigned long max_pyramid_levels
+        )
+        {
+            typedef typename image_traits<image_type>::pixel_type pixel_type;
+            array2d<pixel_type> temp1, temp2;
+            create_fhog_pyramid<pyramid_type>(img, fe, feats, cell_size, filter_rows_padding,
+                filter_cols_padding, min_pyramid_layer_width, min_pyramid_layer_height,
+                max_pyramid_levels, temp1, temp2);
+        }
+
+        template <
+            typename pyramid_type,
+            typename image_type,
+            typename feature_extractor_type
+            >
+        void create_fhog_pyramid (
+            const image_type& img,
+            const feature_extractor_type& fe,
+            array<array<array2d<float> > >& feats,
+            int cell_size,
+            int filter_rows_padding,
+            int filter_cols_padding,
+            unsigned long min_pyramid_layer_width,
+            unsigned long min_pyramid_layer_height,
+            unsigned long max_pyramid_levels,
+            unsigned long num_threads
+        )
+        {
+            if (num_threads <= 1)
+            {
+                create_fhog_pyramid<pyramid_type>(img, fe, feats, cell_size, filter_rows_padding,
+                    filter_cols_padding, min_pyramid_layer_width, min_pyramid_layer_height,
+                    max_pyramid_levels);
+                return;
+            }
+
+            const unsigned long levels = num_fhog_pyramid_levels<pyramid_type>(get_rect(img),
+                min_pyramid_layer_width, min_pyramid_layer_height, max_pyramid_levels);
+            pyramid_type pyr;
+
+            if (feats.max_size() < levels)
+                feats.set_max_size(levels);
+            feats.set_size(levels);
+
+            // Each pyramid image is made from the one before it, so the downsampling has
+            // to be done serially.  But it's cheap compared to the fHOG extraction, so we
+            // make all the pyramid images up front and then extract the features of all
+            // the levels in parallel.  images[i] holds pyramid level i+1.
+            typedef typename image_traits<image_type>::pixel_type pixel_type;
+            array<array2d<pixel_type> > images;
+            images.set_max_size(levels-1);
+            images.set_size(levels-1);
+            if (images.size() > 0)
+            {
+                pyr(img, images[0]);
+                for (unsigned long i = 1; i < images.size(); ++i)
+                    pyr(images[i-1], images[i]);
+            }
+
+            parallel_for(num_threads, 0, levels, [&](long i)
+            {
+                if (i == 0)
+                    fe(img, feats[0], cell_size,filter_rows_padding,filter_cols_padding);
+                else
+                    fe(images[i-1], feats[i], cell_size,filter_rows_padding,filter_cols_padding);
+            });
+
+            DLIB_ASSERT(feats[0].size() == fe.get_num_planes(), 
+                "Invalid feature extractor used with dlib::scan_fhog_pyramid.  The output does not have the \n"
+                "indicated number of planes.");
+        }
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename Pyramid_type,
+        typename feature_extractor_type
         >
     template <
         typename image_type
@@ -630,9 +1487,84 @@ namespace dlib
     {
         unsigned long width, height;
         compute_fhog_window_size(width,height);
+
+        compressed_feats.clear();
+        mapped_feats.clear();
+        if (feature_cache_directory.size() != 0)
+        {
+            const std::pair<uint64,uint64> key = feature_cache_key(img);
+            std::ostringstream sout;
+            sout << feature_cache_directory << "/fhog_" << std::hex << std::setfill('0') 
+                 << std::setw(16) << key.first << std::setw(16) << key.second << ".cache";
+            const std::string filename = sout.str();
+
+            feats.clear();
+            if (mapped_feats.open(filename, feature_storage, key))
+                return;
+
+            array<fhog_image> temp;
+            impl::create_fhog_pyramid<Pyramid_type>(img, fe, temp, cell_size, height,
+                width, min_pyramid_layer_width, min_pyramid_layer_height,
+                max_pyramid_levels, num_threads);
+            impl::mapped_fhog_pyramid::write(filename, feature_storage, key, temp);
+            if (!mapped_feats.open(filename, feature_storage, key))
+                throw error("Unable to read the fHOG feature cache file " + filename);
+            return;
+        }
+
         impl::create_fhog_pyramid<Pyramid_type>(img, fe, feats, cell_size, height,
             width, min_pyramid_layer_width, min_pyramid_layer_height,
-            max_pyramid_levels);
+            max_pyramid_levels, num_threads);
+
+        if (feature_storage != FHOG_STORE_FLOAT)
+        {
+            compressed_feats.resize(feats.size());
+            for (unsigned long l = 0; l < feats.size(); ++l)
+                compressed_feats[l].compress(feats[l], feature_storage);
+            feats.clear();
+        }
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename Pyramid_type,
+        typename feature_extractor_type
+        >
+    template <
+        typename image_type
+        >
+    std::pair<uint64,uint64> scan_fhog_pyramid<Pyramid_type,feature_extractor_type>::
+    feature_cache_key (
+        const image_type& img_
+    ) const
+    {
+        // Everything the cached pyramid depends on: the pixels and the settings used by
+        // create_fhog_pyramid().
+        typedef typename image_traits<image_type>::pixel_type pixel_type;
+        const_image_view<image_type> img(img_);
+        std::ostringstream sout;
+        serialize(fe, sout);
+        serialize(cell_size, sout);
+        serialize(padding, sout);
+        serialize(window_width, sout);
+        serialize(window_height, sout);
+        serialize(max_pyramid_levels, sout);
+        serialize(min_pyramid_layer_width, sout);
+        serialize(min_pyramid_layer_height, sout);
+        serialize(static_cast<int>(feature_storage), sout);
+        serialize(std::string(typeid(Pyramid_type).name()), sout);
+        serialize(std::string(typeid(pixel_type).name()), sout);
+        serialize(img.nr(), sout);
+        serialize(img.nc(), sout);
+        for (long r = 0; r < img.nr() && img.nc() != 0; ++r)
+        {
+            const std::pair<uint64,uint64> h = murmur_hash3_128bit(&img[r][0], img.nc()*sizeof(pixel_type));
+            serialize(h.first, sout);
+            serialize(h.second, sout);
+        }
+        const std::string temp = sout.str();
+        return murmur_hash3_128bit(temp.data(), temp.size());
     }
 
 // ----------------------------------------------------------------------------------------
@@ -645,7 +1577,7 @@ namespace dlib
     is_loaded_with_image (
     ) const
     {
-        return feats.size() != 0;
+        return feats.size() != 0 || compressed_feats.size() != 0 || mapped_feats.size() != 0;
     }
 
 // ----------------------------------------------------------------------------------------
@@ -667,6 +1599,10 @@ namespace dlib
         min_pyramid_layer_width = item.min_pyramid_layer_width;
         min_pyramid_layer_height = item.min_pyramid_layer_height;
         nuclear_norm_regularization_strength = item.nuclear_norm_regularization_strength;
+        num_threads = item.num_threads;
+        interleaved_filtering = item.interleaved_filtering;
+        feature_storage = item.feature_storage;
+        feature_cache_directory = item.feature_cache_directory;
         fe = item.fe;
     }
 
@@ -758,6 +1694,70 @@ namespace dlib
             return a.first < b.first;
         }
 
+        template <typename fhog_filterbank>
+        rectangle filter_fhog_level (
+            const array<array2d<float> >& feats,
+            const fhog_filterbank& w,
+            array2d<float>& saliency_image,
+            array2d<float>& scratch,
+            const bool interleaved,
+            std::vector<float>& cells
+        )
+        {
+            if (interleaved)
+            {
+                interleave_fhog_planes(feats, cells);
+                return apply_interleaved_filters_to_fhog(w, feats, cells, saliency_image);
+            }
+            else
+            {
+                return apply_filters_to_fhog(w, feats, saliency_image, scratch);
+            }
+        }
+
+        template <
+            typename pyramid_type,
+            typename feature_extractor_type,
+            typename fhog_filterbank
+            >
+        void detect_from_fhog_level (
+            const array<array2d<float> >& feats,
+            const unsigned long level,
+            const feature_extractor_type& fe,
+            const fhog_filterbank& w,
+            const double thresh,
+            const unsigned long det_box_height,
+            const unsigned long det_box_width,
+            const int cell_size,
+            const int filter_rows_padding,
+            const int filter_cols_padding,
+            std::vector<std::pair<double, rectangle> >& dets,
+            array2d<float>& saliency_image,
+            array2d<float>& scratch,
+            const bool interleaved,
+            std::vector<float>& cells
+        ) 
+        {
+            pyramid_type pyr;
+            const rectangle area = filter_fhog_level(feats, w, saliency_image, scratch, interleaved, cells);
+
+            // now search the saliency image for any detections
+            for (long r = area.top(); r <= area.bottom(); ++r)
+            {
+                for (long c = area.left(); c <= area.right(); ++c)
+                {
+                    // if we found a detection
+                    if (saliency_image[r][c] >= thresh)
+                    {
+                        rectangle rect = fe.feats_to_image(centered_rect(point(c,r),det_box_width,det_box_height), 
+                            cell_size, filter_rows_padding, filter_cols_padding);
+                        rect = pyr.rect_up(rect, level);
+                        dets.push_back(std::make_pair(saliency_image[r][c], rect));
+                    }
+                }
+            }
+        }
+
         template <
             typename pyramid_type,
             typename feature_extractor_type,
@@ -773,37 +1773,369 @@ namespace dlib
             const int cell_size,
             const int filter_rows_padding,
             const int filter_cols_padding,
-            std::vector<std::pair<double, rectangle> >& dets
+            std::vector<std::pair<double, rectangle> >& dets,
+            array2d<float>& saliency_image,
+            array2d<float>& scratch
         ) 
         {
             dets.clear();
-
-            array2d<float> saliency_image;
-            pyramid_type pyr;
+            std::vector<float> cells;
 
             // for all pyramid levels
             for (unsigned long l = 0; l < feats.size(); ++l)
             {
-                const rectangle area = apply_filters_to_fhog(w, feats[l], saliency_image);
+                detect_from_fhog_level<pyramid_type>(feats[l], l, fe, w, thresh, det_box_height,
+                    det_box_width, cell_size, filter_rows_padding, filter_cols_padding, dets,
+                    saliency_image, scratch, false, cells);
+            }
 
-                // now search the saliency image for any detections
-                for (long r = area.top(); r <= area.bottom(); ++r)
+            std::sort(dets.rbegin(), dets.rend(), compare_pair_rect);
+        }
+
+        template <
+            typename pyramid_type,
+            typename fhog_pyramid_type,
+            typename feature_extractor_type,
+            typename fhog_filterbank
+            >
+        void detect_from_fhog_pyramid (
+            const fhog_pyramid_type& feats,
+            const feature_extractor_type& fe,
+            const fhog_filterbank& w,
+            const double thresh,
+            const unsigned long det_box_height,
+            const unsigned long det_box_width,
+            const int cell_size,
+            const int filter_rows_padding,
+            const int filter_cols_padding,
+            std::vector<std::pair<double, rectangle> >& dets,
+            unsigned long num_threads,
+            const bool interleaved
+        ) 
+        /*!
+            requires
+                - fhog_pyramid_type is array<array<array2d<float> > >, 
+                  std::vector<compressed_fhog_image> or mapped_fhog_pyramid.  Compressed
+                  and mapped levels are expanded one at a time, right before they are
+                  filtered.
+        !*/
+        {
+            if (num_threads <= 1)
+            {
+                dets.clear();
+                array2d<float> saliency_image, scratch;
+                std::vector<float> cells;
+                array<array2d<float> > level;
+                for (unsigned long l = 0; l < feats.size(); ++l)
                 {
-                    for (long c = area.left(); c <= area.right(); ++c)
+                    detect_from_fhog_level<pyramid_type>(get_fhog_level(feats, l, level), l, fe, w, thresh, det_box_height,
+                        det_box_width, cell_size, filter_rows_padding, filter_cols_padding, dets,
+                        saliency_image, scratch, interleaved, cells);
+                }
+                std::sort(dets.rbegin(), dets.rend(), compare_pair_rect);
+                return;
+            }
+
+            // Filter the levels in parallel.  The detections are gathered per level and
+            // then concatenated in level order, so the output is the same as the serial
+            // version.
+            std::vector<std::vector<std::pair<double, rectangle> > > level_dets(feats.size());
+            parallel_for(num_threads, 0, feats.size(), [&](long l)
+            {
+                array2d<float> saliency_image, scratch;
+                std::vector<float> cells;
+                array<array2d<float> > level;
+                detect_from_fhog_level<pyramid_type>(get_fhog_level(feats, l, level), l, fe, w, thresh, det_box_height,
+                    det_box_width, cell_size, filter_rows_padding, filter_cols_padding, level_dets[l],
+                    saliency_image, scratch, interleaved, cells);
+            });
+
+            dets.clear();
+            for (unsigned long l = 0; l < level_dets.size(); ++l)
+                dets.insert(dets.end(), level_dets[l].begin(), level_dets[l].end());
+
+            std::sort(dets.rbegin(), dets.rend(), compare_pair_rect);
+        }
+
+        template <
+            typename pyramid_type,
+            typename feature_extractor_type,
+            typename fhog_filterbank
+            >
+        void detect_from_fhog_pyramid (
+            const array<array<array2d<float> > >& feats,
+            const feature_extractor_type& fe,
+            const fhog_filterbank& w,
+            const double thresh,
+            const unsigned long det_box_height,
+            const unsigned long det_box_width,
+            const int cell_size,
+            const int filter_rows_padding,
+            const int filter_cols_padding,
+            std::vector<std::pair<double, rectangle> >& dets
+        ) 
+        {
+            array2d<float> saliency_image, scratch;
+            detect_from_fhog_pyramid<pyramid_type>(feats, fe, w, thresh, det_box_height,
+                det_box_width, cell_size, filter_rows_padding, filter_cols_padding, dets,
+                saliency_image, scratch);
+        }
+
+        struct fhog_detection
+        {
+            double score;
+            unsigned long level;
+            long r, c;
+            rectangle rect;
+        };
+
+        inline bool stronger_fhog_detection (
+            const fhog_detection& a,
+            const fhog_detection& b
+        )
+        /*!
+            ensures
+                - returns true if a comes before b in the output of a bounded detect.
+                  That is, if a has the larger score, with ties going to whichever was
+                  found first.
+        !*/
+        {
+            if (a.score != b.score)
+                return a.score > b.score;
+            if (a.level != b.level)
+                return a.level < b.level;
+            if (a.r != b.r)
+                return a.r < b.r;
+            return a.c < b.c;
+        }
+
+        template <typename fhog_filterbank>
+        double fhog_filterbank_norm (
+            const fhog_filterbank& w
+        )
+        {
+            double norm = 0;
+            for (unsigned long i = 0; i < w.filters.size(); ++i)
+            {
+                const matrix<double> f = matrix_cast<double>(w.filters[i]);
+                norm += sum(dlib::squared(f));
+            }
+            return std::sqrt(norm);
+        }
+
+        inline double fhog_level_score_bound (
+            const array<array2d<float> >& feats,
+            const long filter_rows,
+            const long filter_cols,
+            const double filter_norm
+        )
+        /*!
+            ensures
+                - returns a number at least as large as the score any window of a
+                  filter_rows by filter_cols filter with Frobenius norm filter_norm can
+                  get on feats.  By Cauchy-Schwarz, that is filter_norm times the norm of
+                  the features under the window with the most energy.  The separable
+                  filters used by apply_filters_to_fhog() drop some singular values, so
+                  their norm is no larger than that of the full filters.
+                - returns -infinity if the filter doesn't fit in feats.
+        !*/
+        {
+            const long nr = feats.size() == 0 ? 0 : feats[0].nr();
+            const long nc = feats.size() == 0 ? 0 : feats[0].nc();
+            if (nr < filter_rows || nc < filter_cols)
+                return -std::numeric_limits<double>::infinity();
+
+            // the squared features, summed over the planes
+            std::vector<float> cell_energy(nr*nc, 0);
+            for (unsigned long i = 0; i < feats.size(); ++i)
+            {
+                for (long r = 0; r < nr; ++r)
+                {
+                    const float* in = &feats[i][r][0];
+                    float* out = &cell_energy[r*nc];
+                    for (long c = 0; c < nc; ++c)
+                        out[c] += in[c]*in[c];
+                }
+            }
+
+            // and their integral image
+            std::vector<double> energy((nr+1)*(nc+1), 0);
+            for (long r = 0; r < nr; ++r)
+            {
+                double row_sum = 0;
+                for (long c = 0; c < nc; ++c)
+                {
+                    row_sum += cell_energy[r*nc + c];
+                    energy[(r+1)*(nc+1) + c+1] = energy[r*(nc+1) + c+1] + row_sum;
+                }
+            }
+
+            double best = 0;
+            for (long r = 0; r + filter_rows <= nr; ++r)
+            {
+                const double* top = &energy[r*(nc+1)];
+                const double* bottom = &energy[(r+filter_rows)*(nc+1)];
+                for (long c = 0; c + filter_cols <= nc; ++c)
+                    best = std::max(best, bottom[c+filter_cols] - top[c+filter_cols] - bottom[c] + top[c]);
+            }
+
+            // leave room for the rounding error of the float filtering
+            return 1.001*filter_norm*std::sqrt(best);
+        }
+
+        template <
+            typename pyramid_type,
+            typename feature_extractor_type,
+            typename fhog_filterbank
+            >
+        void detect_strongest_from_fhog_level (
+            const array<array2d<float> >& feats,
+            const unsigned long level,
+            const feature_extractor_type& fe,
+            const fhog_filterbank& w,
+            const double thresh,
+            const unsigned long det_box_height,
+            const unsigned long det_box_width,
+            const int cell_size,
+            const int filter_rows_padding,
+            const int filter_cols_padding,
+            const unsigned long max_dets,
+            std::vector<fhog_detection>& heap,
+            array2d<float>& saliency_image,
+            array2d<float>& scratch,
+            const bool interleaved,
+            std::vector<float>& cells
+        ) 
+        /*!
+            requires
+                - max_dets > 0
+                - heap is a heap, w.r.t. stronger_fhog_detection(), of at most max_dets
+                  detections.  So heap.front() is the weakest of them.
+            ensures
+                - Adds the detections on this level that score >= thresh to heap, keeping
+                  only the max_dets strongest.
+        !*/
+        {
+            pyramid_type pyr;
+            const rectangle area = filter_fhog_level(feats, w, saliency_image, scratch, interleaved, cells);
+
+            fhog_detection det;
+            det.level = level;
+            for (long r = area.top(); r <= area.bottom(); ++r)
+            {
+                for (long c = area.left(); c <= area.right(); ++c)
+                {
+                    if (saliency_image[r][c] < thresh)
+                        continue;
+
+                    det.score = saliency_image[r][c];
+                    det.r = r;
+                    det.c = c;
+                    // Once the heap is full a window only gets in by beating the weakest
+                    // detection found so far.
+                    if (heap.size() == max_dets)
                     {
-                        // if we found a detection
-                        if (saliency_image[r][c] >= thresh)
-                        {
-                            rectangle rect = fe.feats_to_image(centered_rect(point(c,r),det_box_width,det_box_height), 
-                                cell_size, filter_rows_padding, filter_cols_padding);
-                            rect = pyr.rect_up(rect, l);
-                            dets.push_back(std::make_pair(saliency_image[r][c], rect));
-                        }
+                        if (!stronger_fhog_detection(det, heap.front()))
+                            continue;
+                        std::pop_heap(heap.begin(), heap.end(), stronger_fhog_detection);
+                        heap.pop_back();
                     }
+
+                    det.rect = pyr.rect_up(fe.feats_to_image(centered_rect(point(c,r),det_box_width,det_box_height), 
+                        cell_size, filter_rows_padding, filter_cols_padding), level);
+                    heap.push_back(det);
+                    std::push_heap(heap.begin(), heap.end(), stronger_fhog_detection);
                 }
             }
+        }
 
-            std::sort(dets.rbegin(), dets.rend(), compare_pair_rect);
+        template <
+            typename pyramid_type,
+            typename fhog_pyramid_type,
+            typename feature_extractor_type,
+            typename fhog_filterbank
+            >
+        void detect_strongest_from_fhog_pyramid (
+            const fhog_pyramid_type& feats,
+            const feature_extractor_type& fe,
+            const fhog_filterbank& w,
+            const double thresh,
+            const unsigned long det_box_height,
+            const unsigned long det_box_width,
+            const int cell_size,
+            const int filter_rows_padding,
+            const int filter_cols_padding,
+            const unsigned long max_dets,
+            std::vector<std::pair<double, rectangle> >& dets,
+            unsigned long num_threads,
+            const bool interleaved
+        ) 
+        /*!
+            ensures
+                - Finds the same detections as detect_from_fhog_pyramid() but only keeps
+                  the max_dets strongest.  A level is only filtered if the bound from
+                  fhog_level_score_bound() says one of its windows could get into the
+                  output.
+        !*/
+        {
+            dets.clear();
+            if (max_dets == 0)
+                return;
+
+            const double filter_norm = fhog_filterbank_norm(w);
+            const long filter_rows = w.filters[0].nr();
+            const long filter_cols = w.filters[0].nc();
+
+            std::vector<fhog_detection> heap;
+            if (num_threads <= 1)
+            {
+                array2d<float> saliency_image, scratch;
+                std::vector<float> cells;
+                array<array2d<float> > level;
+                for (unsigned long l = 0; l < feats.size(); ++l)
+                {
+                    const array<array2d<float> >& level_feats = get_fhog_level(feats, l, level);
+                    const double bound = fhog_level_score_bound(level_feats, filter_rows, filter_cols, filter_norm);
+                    // Windows on later levels lose ties, so a level that can at best
+                    // match the weakest detection we have can't change the output.
+                    if (bound < thresh || (heap.size() == max_dets && bound <= heap.front().score))
+                        continue;
+
+                    detect_strongest_from_fhog_level<pyramid_type>(level_feats, l, fe, w, thresh, det_box_height,
+                        det_box_width, cell_size, filter_rows_padding, filter_cols_padding, max_dets, heap,
+                        saliency_image, scratch, interleaved, cells);
+                }
+                std::sort_heap(heap.begin(), heap.end(), stronger_fhog_detection);
+            }
+            else
+            {
+                // The levels are filtered in parallel, so each only knows about its own
+                // detections.  Keep the strongest of each and then of all of them.
+                std::vector<std::vector<fhog_detection> > level_heaps(feats.size());
+                parallel_for(num_threads, 0, feats.size(), [&](long l)
+                {
+                    array2d<float> saliency_image, scratch;
+                    std::vector<float> cells;
+                    array<array2d<float> > level;
+                    const array<array2d<float> >& level_feats = get_fhog_level(feats, l, level);
+                    if (fhog_level_score_bound(level_feats, filter_rows, filter_cols, filter_norm) < thresh)
+                        return;
+
+                    detect_strongest_from_fhog_level<pyramid_type>(level_feats, l, fe, w, thresh, det_box_height,
+                        det_box_width, cell_size, filter_rows_padding, filter_cols_padding, max_dets, level_heaps[l],
+                        saliency_image, scratch, interleaved, cells);
+                });
+
+                for (unsigned long l = 0; l < level_heaps.size(); ++l)
+                    heap.insert(heap.end(), level_heaps[l].begin(), level_heaps[l].end());
+                std::sort(heap.begin(), heap.end(), stronger_fhog_detection);
+                if (heap.size() > max_dets)
+                    heap.resize(max_dets);
+            }
+
+            dets.reserve(heap.size());
+            for (unsigned long i = 0; i < heap.size(); ++i)
+                dets.push_back(std::make_pair(heap[i].score, heap[i].rect));
         }
 
         inline bool overlaps_any_box (
@@ -851,8 +2183,72 @@ namespace dlib
         unsigned long width, height;
         compute_fhog_window_size(width,height);
 
+        if (compressed_feats.size() != 0)
+        {
+            impl::detect_from_fhog_pyramid<pyramid_type>(compressed_feats, fe, w, thresh,
+                height-2*padding, width-2*padding, cell_size, height, width, dets, num_threads,
+                interleaved_filtering);
+            return;
+        }
+        if (mapped_feats.size() != 0)
+        {
+            impl::detect_from_fhog_pyramid<pyramid_type>(mapped_feats, fe, w, thresh,
+                height-2*padding, width-2*padding, cell_size, height, width, dets, num_threads,
+                interleaved_filtering);
+            return;
+        }
+
         impl::detect_from_fhog_pyramid<pyramid_type>(feats, fe, w, thresh,
-            height-2*padding, width-2*padding, cell_size, height, width, dets);
+            height-2*padding, width-2*padding, cell_size, height, width, dets, num_threads,
+            interleaved_filtering);
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename Pyramid_type,
+        typename feature_extractor_type
+        >
+    void scan_fhog_pyramid<Pyramid_type,feature_extractor_type>::
+    detect (
+        const fhog_filterbank& w,
+        std::vector<std::pair<double, rectangle> >& dets,
+        const double thresh,
+        const unsigned long max_dets
+    ) const
+    {
+        // make sure requires clause is not broken
+        DLIB_ASSERT(is_loaded_with_image() &&
+                    w.get_num_dimensions() == get_num_dimensions(), 
+            "\t void scan_fhog_pyramid::detect()"
+            << "\n\t Invalid inputs were given to this function "
+            << "\n\t is_loaded_with_image(): " << is_loaded_with_image()
+            << "\n\t w.get_num_dimensions(): " << w.get_num_dimensions()
+            << "\n\t get_num_dimensions():   " << get_num_dimensions()
+            << "\n\t this: " << this
+            );
+
+        unsigned long width, height;
+        compute_fhog_window_size(width,height);
+
+        if (compressed_feats.size() != 0)
+        {
+            impl::detect_strongest_from_fhog_pyramid<pyramid_type>(compressed_feats, fe, w, thresh,
+                height-2*padding, width-2*padding, cell_size, height, width, max_dets, dets,
+                num_threads, interleaved_filtering);
+            return;
+        }
+        if (mapped_feats.size() != 0)
+        {
+            impl::detect_strongest_from_fhog_pyramid<pyramid_type>(mapped_feats, fe, w, thresh,
+                height-2*padding, width-2*padding, cell_size, height, width, max_dets, dets,
+                num_threads, interleaved_filtering);
+            return;
+        }
+
+        impl::detect_strongest_from_fhog_pyramid<pyramid_type>(feats, fe, w, thresh,
+            height-2*padding, width-2*padding, cell_size, height, width, max_dets, dets,
+            num_threads, interleaved_filtering);
     }
 
 // ----------------------------------------------------------------------------------------
@@ -962,6 +2358,30 @@ namespace dlib
         rectangle mapped_rect;
         unsigned long best_level;
         rectangle fhog_rect;
+        if (compressed_feats.size() != 0 || mapped_feats.size() != 0)
+        {
+            const unsigned long num_levels = compressed_feats.size() != 0 ? compressed_feats.size() : mapped_feats.size();
+            get_mapped_rect_and_metadata(num_levels, obj.get_rect(), mapped_rect, fhog_rect, best_level);
+
+            const impl::fhog_level_view level = compressed_feats.size() != 0 ? 
+                compressed_feats[best_level].view() : mapped_feats[best_level];
+            const rectangle rect(level.cols, level.rows);
+            long i = 0;
+            for (unsigned long ii = 0; ii < level.planes; ++ii)
+            {
+                for (long r = fhog_rect.top(); r <= fhog_rect.bottom(); ++r)
+                {
+                    for (long c = fhog_rect.left(); c <= fhog_rect.right(); ++c)
+                    {
+                        if (rect.contains(c,r))
+                            psi(i) += level(ii,r,c);
+                        ++i;
+                    }
+                }
+            }
+            return;
+        }
+
         get_mapped_rect_and_metadata(feats.size(), obj.get_rect(), mapped_rect, fhog_rect, best_level);
 
 
@@ -1214,6 +2634,22 @@ namespace dlib
     };
 
 // ----------------------------------------------------------------------------------------
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename pixel_type
+        >
+    class fhog_scratch_space : noncopyable
+    {
+    public:
+        array<array2d<float> > feats;
+        array2d<pixel_type> pyramid_image1;
+        array2d<pixel_type> pyramid_image2;
+        array2d<float> saliency_image;
+        array2d<float> filter_scratch;
+        std::vector<float> interleaved_feats;
+    };
+
 // ----------------------------------------------------------------------------------------
 
     template <
@@ -1224,6 +2660,7 @@ namespace dlib
         const std::vector<object_detector<scan_fhog_pyramid<pyramid_type> > >& detectors,
         const image_type& img,
         std::vector<rect_detection>& dets,
+        fhog_scratch_space<typename image_traits<image_type>::pixel_type>& scratch,
         const double adjust_threshold = 0
     )
     {
@@ -1254,44 +2691,79 @@ namespace dlib
                 all_cell_sizes_the_same = false;
         }
 
-        std::vector<rect_detection> dets_accum;
-        // Do to the HOG feature extraction to make the fhog pyramid.  Again, note that we
-        // are making a pyramid that will work with any of the detectors.  But only if all
-        // the cell sizes are the same.  If they aren't then we have to calculate the
-        // pyramid for each detector individually.
-        array<array<array2d<float> > > feats;
-        if (all_cell_sizes_the_same)
-        {
-            impl::create_fhog_pyramid<pyramid_type>(img,
-                detectors[0].get_scanner().get_feature_extractor(), feats, cell_size,
-                max_filter_height, max_filter_width, min_pyramid_layer_width,
-                min_pyramid_layer_height, max_pyramid_levels);
-        }
+        // Rather than building the whole fhog pyramid and then running the detectors
+        // over it, we go one pyramid level at a time: make the level's image, extract its
+        // HOG features and run every detector over them right away.  So only the features
+        // of a single level are ever held in memory.  Again, note that the features will
+        // work with any of the detectors.  But only if all the cell sizes are the same.
+        // If they aren't then we have to calculate the features for each detector
+        // individually.
+        const unsigned long levels = impl::num_fhog_pyramid_levels<pyramid_type>(get_rect(img),
+            min_pyramid_layer_width, min_pyramid_layer_height, max_pyramid_levels);
+        pyramid_type pyr;
 
-        std::vector<std::pair<double, rectangle> > temp_dets;
+        // The raw detections of each weight vector, over all the levels.
+        unsigned long num_weight_vectors = 0;
         for (unsigned long i = 0; i < detectors.size(); ++i)
+            num_weight_vectors += detectors[i].num_detectors();
+        std::vector<std::vector<std::pair<double, rectangle> > > raw_dets(num_weight_vectors);
+
+        array<array2d<float> >& feats = scratch.feats;
+        for (unsigned long l = 0; l < levels; ++l)
         {
-            const scanner_type& scanner = detectors[i].get_scanner();
-            if (!all_cell_sizes_the_same)
+            // pyramid_image2 holds the image of level l
+            if (l == 1)
+            {
+                pyr(img, scratch.pyramid_image1);
+                swap(scratch.pyramid_image1, scratch.pyramid_image2);
+            }
+            else if (l > 1)
             {
-                impl::create_fhog_pyramid<pyramid_type>(img,
-                    scanner.get_feature_extractor(), feats, scanner.get_cell_size(),
-                    max_filter_height, max_filter_width, min_pyramid_layer_width,
-                    min_pyramid_layer_height, max_pyramid_levels);
+                pyr(scratch.pyramid_image2, scratch.pyramid_image1);
+                swap(scratch.pyramid_image1, scratch.pyramid_image2);
             }
 
-            const unsigned long det_box_width  = scanner.get_fhog_window_width()  - 2*scanner.get_padding();
-            const unsigned long det_box_height = scanner.get_fhog_window_height() - 2*scanner.get_padding();
-            // A single detector object might itself have multiple weight vectors in it. So
-            // we need to evaluate all of them.
-            for (unsigned d = 0; d < detectors[i].num_detectors(); ++d)
+            unsigned long k = 0;
+            for (unsigned long i = 0; i < detectors.size(); ++i)
             {
-                const double thresh = detectors[i].get_processed_w(d).w(scanner.get_num_dimensions());
+                const scanner_type& scanner = detectors[i].get_scanner();
+                if (i == 0 || !all_cell_sizes_the_same)
+                {
+                    if (l == 0)
+                        scanner.get_feature_extractor()(img, feats, scanner.get_cell_size(),
+                            max_filter_height, max_filter_width);
+                    else
+                        scanner.get_feature_extractor()(scratch.pyramid_image2, feats,
+                            scanner.get_cell_size(), max_filter_height, max_filter_width);
+                }
 
-                impl::detect_from_fhog_pyramid<pyramid_type>(feats, scanner.get_feature_extractor(),
-                    detectors[i].get_processed_w(d).get_detect_argument(), thresh+adjust_threshold,
-                    det_box_height, det_box_width, cell_size, max_filter_height,
-                    max_filter_width, temp_dets);
+                const unsigned long det_box_width  = scanner.get_fhog_window_width()  - 2*scanner.get_padding();
+                const unsigned long det_box_height = scanner.get_fhog_window_height() - 2*scanner.get_padding();
+                // A single detector object might itself have multiple weight vectors in it. So
+                // we need to evaluate all of them.
+                for (unsigned d = 0; d < detectors[i].num_detectors(); ++d, ++k)
+                {
+                    const double thresh = detectors[i].get_processed_w(d).w(scanner.get_num_dimensions());
+
+                    impl::detect_from_fhog_level<pyramid_type>(feats, l, scanner.get_feature_extractor(),
+                        detectors[i].get_processed_w(d).get_detect_argument(), thresh+adjust_threshold,
+                        det_box_height, det_box_width, cell_size, max_filter_height,
+                        max_filter_width, raw_dets[k], scratch.saliency_image, scratch.filter_scratch,
+                        scanner.get_interleaved_filtering(), scratch.interleaved_feats);
+                }
+            }
+        }
+
+        std::vector<rect_detection> dets_accum;
+        unsigned long k = 0;
+        for (unsigned long i = 0; i < detectors.size(); ++i)
+        {
+            const scanner_type& scanner = detectors[i].get_scanner();
+            for (unsigned d = 0; d < detectors[i].num_detectors(); ++d, ++k)
+            {
+                const double thresh = detectors[i].get_processed_w(d).w(scanner.get_num_dimensions());
+                std::vector<std::pair<double, rectangle> >& temp_dets = raw_dets[k];
+                std::sort(temp_dets.rbegin(), temp_dets.rend(), impl::compare_pair_rect);
 
                 for (unsigned long j = 0; j < temp_dets.size(); ++j)
                 {
@@ -1319,6 +2791,23 @@ namespace dlib
         }
     }
 
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename pyramid_type,
+        typename image_type
+        >
+    void evaluate_detectors (
+        const std::vector<object_detector<scan_fhog_pyramid<pyramid_type> > >& detectors,
+        const image_type& img,
+        std::vector<rect_detection>& dets,
+        const double adjust_threshold = 0
+    )
+    {
+        fhog_scratch_space<typename image_traits<image_type>::pixel_type> scratch;
+        evaluate_detectors(detectors, img, dets, scratch, adjust_threshold);
+    }
+
 // ----------------------------------------------------------------------------------------
 
     template <
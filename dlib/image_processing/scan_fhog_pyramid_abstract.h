@@ -191,6 +191,25 @@ namespace dlib
         feature extractor.
     !*/
 
+// ----------------------------------------------------------------------------------------
+
+    enum fhog_feature_storage
+    {
+        FHOG_STORE_FLOAT,
+        FHOG_STORE_HALF,
+        FHOG_STORE_UINT8
+    };
+    /*!
+        WHAT THIS ENUM REPRESENTS
+            How a scan_fhog_pyramid keeps the fHOG pyramid of the image it was loaded with:
+                - FHOG_STORE_FLOAT: 32 bit floats, as extracted.
+                - FHOG_STORE_HALF: IEEE half precision floats.  Uses half the memory and
+                  keeps about 3 significant digits of each feature.
+                - FHOG_STORE_UINT8: 8 bit values, scaled to the range of each plane of
+                  each pyramid level.  Uses a quarter of the memory and each feature is
+                  within (max-min)/510 of its original value.
+    !*/
+
 // ----------------------------------------------------------------------------------------
 
     template <
@@ -218,6 +237,10 @@ namespace dlib
                 - get_min_pyramid_layer_width()  == 64
                 - get_min_pyramid_layer_height() == 64
                 - get_nuclear_norm_regularization_strength() == 0
+                - get_num_threads() == 1
+                - get_interleaved_filtering() == false
+                - get_feature_storage() == FHOG_STORE_FLOAT
+                - get_feature_cache_directory() == ""
 
             WHAT THIS OBJECT REPRESENTS
                 This object is a tool for running a fixed sized sliding window classifier
@@ -276,6 +299,13 @@ namespace dlib
                 - #is_loaded_with_image() == true
                 - This object is ready to run a classifier over img to detect object
                   locations.  Call detect() to do this.
+                - if (get_feature_cache_directory() != "") then
+                    - The fHOG pyramid is memory mapped from a file in that directory
+                      rather than held in RAM.  If no file for img exists yet then the
+                      pyramid is computed and written there first.
+            throws
+                - dlib::error
+                    This exception is thrown if a feature cache file can't be written.
         !*/
 
         const feature_extractor_type& get_feature_extractor(
@@ -501,6 +531,106 @@ namespace dlib
                   value returned by this function.
         !*/
 
+        void set_num_threads (
+            unsigned long num
+        );
+        /*!
+            ensures
+                - #get_num_threads() == num
+        !*/
+
+        unsigned long get_num_threads (
+        ) const;
+        /*!
+            ensures
+                - returns the number of threads load() and detect() use to process a
+                  single image.  When it is larger than 1, the fHOG features of the
+                  pyramid levels are extracted in parallel and the levels are filtered in
+                  parallel.  The results are the same as with a single thread.
+                - This setting is not serialized.  It is copied by copy_configuration().
+        !*/
+
+        void set_interleaved_filtering (
+            bool enabled
+        );
+        /*!
+            ensures
+                - #get_interleaved_filtering() == enabled
+        !*/
+
+        bool get_interleaved_filtering (
+        ) const;
+        /*!
+            ensures
+                - returns true if detect() filters the fHOG images in their interleaved
+                  layout and false if it uses the normal planar layout.
+                - The planar layout runs one filtering pass over the image for each fHOG
+                  plane and, when it is cheaper, uses a separable approximation of the
+                  filters.  The interleaved layout stores the fHOG planes of each cell
+                  next to each other and evaluates all the planes of the full filter at a
+                  window position in one go, which makes much better use of the CPU cache.
+                  Since the interleaved layout always uses the full filters, the detection
+                  scores can differ very slightly from the planar layout when that one uses
+                  separable filters.
+                - This setting is not serialized.  It is copied by copy_configuration().
+                  evaluate_detectors() uses the setting of each detector's scanner.
+        !*/
+
+        void set_feature_storage (
+            fhog_feature_storage storage
+        );
+        /*!
+            ensures
+                - #get_feature_storage() == storage
+                - #is_loaded_with_image() == false
+        !*/
+
+        fhog_feature_storage get_feature_storage (
+        ) const;
+        /*!
+            ensures
+                - returns the format load() keeps the fHOG pyramid in.  detect() expands
+                  one compressed pyramid level at a time, right before filtering it, and
+                  get_feature_vector() reads the compressed values directly, so both see
+                  exactly the same features.
+                - The compressed formats are meant for training, where
+                  structural_object_detection_trainer keeps a loaded scanner for every
+                  training image and these pyramids are most of its memory use.  The
+                  trained object_detector inherits the setting, but its weights work just
+                  as well with a FHOG_STORE_FLOAT scanner, which doesn't spend time
+                  compressing the images it scans.
+                - This setting is not serialized.  It is copied by copy_configuration().
+                  A loaded scanner always serializes its pyramid as floats.
+        !*/
+
+        void set_feature_cache_directory (
+            const std::string& directory
+        );
+        /*!
+            requires
+                - directory == "" or the name of an existing directory 
+            ensures
+                - #get_feature_cache_directory() == directory
+                - #is_loaded_with_image() == false
+        !*/
+
+        const std::string& get_feature_cache_directory (
+        ) const;
+        /*!
+            ensures
+                - returns the directory load() keeps fHOG pyramids in, or "" if they are
+                  kept in memory.
+                - When it isn't "", load() names each cache file after a hash of the
+                  image's pixels and every setting that affects its pyramid, including
+                  get_feature_storage().  Loading the same image again, in this or a later
+                  process, maps the existing file and skips the fHOG extraction.  The
+                  pages of the mapped files are managed by the operating system, so the
+                  pyramids of a training set don't all have to fit in RAM.
+                - The files use the native byte order and are only meant to be read on the
+                  machine that wrote them.  Nothing ever deletes them.
+                - This setting is not serialized.  It is copied by copy_configuration().
+        !*/
+
         fhog_filterbank build_fhog_filterbank (
             const feature_vector_type& weights 
         ) const;
@@ -591,6 +721,43 @@ namespace dlib
                 - performs: detect(build_fhog_filterbank(w), dets, thresh)
         !*/
 
+        void detect (
+            const fhog_filterbank& w,
+            std::vector<std::pair<double, rectangle> >& dets,
+            const double thresh,
+            const unsigned long max_dets
+        ) const;
+        /*!
+            requires
+                - w.get_num_dimensions() == get_num_dimensions()
+                - is_loaded_with_image() == true
+            ensures
+                - Finds the same detections as detect(w,dets,thresh) but only stores the
+                  max_dets highest scoring ones into #dets.  So #dets.size() <= max_dets
+                  and #dets is sorted in descending order of score.  Detections with equal
+                  scores are ordered by pyramid level and then by their position in the
+                  level, top to bottom and left to right, and the earlier ones are kept.
+                - Pyramid levels whose windows can't score high enough to make it into
+                  #dets are not filtered at all.  This makes this function a lot cheaper
+                  than detect(w,dets,thresh) when only the strongest few detections are
+                  needed, e.g. by the separation oracle of
+                  structural_svm_object_detection_problem.
+        !*/
+
+        void detect (
+            const feature_vector_type& w,
+            std::vector<std::pair<double, rectangle> >& dets,
+            const double thresh,
+            const unsigned long max_dets
+        ) const;
+        /*!
+            requires
+                - w.size() >= get_num_dimensions()
+                - is_loaded_with_image() == true
+            ensures
+                - performs: detect(build_fhog_filterbank(w), dets, thresh, max_dets)
+        !*/
+
         void get_feature_vector (
             const full_object_detection& obj,
             feature_vector_type& psi
@@ -723,6 +890,11 @@ namespace dlib
               the same cell_size parameter that determines how HOG features are computed.
               If different cell_size values are used then this function will not be any
               faster than running the detectors individually.
+            - The image pyramid is processed one level at a time: the HOG features of a
+              level are computed, all the detectors are run over them and then they are
+              discarded before moving on to the next level.  So unlike
+              scan_fhog_pyramid::load(), this function never holds the HOG features of the
+              whole pyramid in memory.
             - This function applies non-max suppression individually to the output of each
               detector.  Therefore, the output is the same as if you ran each detector
               individually and then concatenated the results. 
@@ -750,6 +922,61 @@ namespace dlib
               requiring a mutex lock.
     !*/
 
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename pixel_type
+        >
+    class fhog_scratch_space : noncopyable
+    {
+        /*!
+            WHAT THIS OBJECT REPRESENTS
+                This object holds the buffers used by evaluate_detectors() while it scans
+                an image whose pixels are of type pixel_type: the fHOG features of the
+                pyramid level being scanned, the downsampled images of the pyramid and the
+                filter outputs.  Passing
+                the same fhog_scratch_space to many calls of evaluate_detectors() lets
+                them reuse these buffers instead of allocating new ones for every image.
+                The reuse is complete when consecutive images have the same size.
+
+                The contents of the buffers are meaningless between calls.
+
+            THREAD SAFETY
+                A fhog_scratch_space must only be used by one thread at a time.
+        !*/
+    public:
+        array<array2d<float> > feats;
+        array2d<pixel_type> pyramid_image1;
+        array2d<pixel_type> pyramid_image2;
+        array2d<float> saliency_image;
+        array2d<float> filter_scratch;
+        std::vector<float> interleaved_feats;
+    };
+
+    template <
+        typename pyramid_type,
+        typename image_type
+        >
+    void evaluate_detectors (
+        const std::vector<object_detector<scan_fhog_pyramid<pyramid_type>>>& detectors,
+        const image_type& img,
+        std::vector<rect_detection>& dets,
+        fhog_scratch_space<typename image_traits<image_type>::pixel_type>& scratch,
+        const double adjust_threshold = 0
+    );
+    /*!
+        requires
+            - image_type == is an implementation of array2d/array2d_kernel_abstract.h
+            - img contains some kind of pixel type. 
+              (i.e. pixel_traits<typename image_type::type> is defined)
+        ensures
+            - Performs exactly the same detection as the evaluate_detectors() routine
+              defined above, but uses the buffers in scratch instead of allocating its
+              own.  This makes scanning many images in a row faster.
+            - Multiple threads can call this function with the same instances of
+              detectors and img as long as each thread uses its own scratch object.
+    !*/
+
 // ----------------------------------------------------------------------------------------
 
     template <
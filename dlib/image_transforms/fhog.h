@@ -13,6 +13,7 @@
 #include "interpolation.h"
 #include "../simd/simd4i.h"
 #include "../simd/simd4f.h"
+#include "fhog_kernels.h"
 
 namespace dlib
 {
@@ -491,6 +492,42 @@ namespace dlib
             }
         }
 
+    // ------------------------------------------------------------------------------------
+
+        template <typename mm1, typename mm2>
+        inline int dispatch_normalize_hog_row (
+            dlib::array<array2d<float,mm1>,mm2>& hog,
+            int x, 
+            int y,
+            const float* hist,
+            const float* norm_above,
+            const float* norm,
+            const float* norm_below,
+            int n
+        )
+        {
+            float* out[31];
+            for (int o = 0; o < 31; ++o)
+                out[o] = &hog[o][y][x];
+            return dispatch_normalize_row(hist, norm_above, norm, norm_below, n, out);
+        }
+
+        template <typename out_type>
+        inline int dispatch_normalize_hog_row (
+            out_type& ,
+            int , 
+            int ,
+            const float* ,
+            const float* ,
+            const float* ,
+            const float* ,
+            int 
+        )
+        {
+            // Only planar float output has a runtime dispatched kernel
+            return 0;
+        }
+
     // ------------------------------------------------------------------------------------
 
         template <
@@ -803,6 +840,9 @@ namespace dlib
             array2d<float> norm(cells_nr, cells_nc);
             assign_all_pixels(norm, 0);
 
+            // The dispatched kernels read the 18 bins of consecutive cells as one array
+            COMPILE_TIME_ASSERT(sizeof(matrix<float,18,1>) == 18*sizeof(float));
+
             // memory for HOG features
             const int hog_nr = std::max(cells_nr-2, 0);
             const int hog_nc = std::max(cells_nc-2, 0);
@@ -818,6 +858,12 @@ namespace dlib
             const int visible_nr = std::min((long)cells_nr*cell_size,img.nr())-1;
             const int visible_nc = std::min((long)cells_nc*cell_size,img.nc())-1;
 
+            // Gradients of one row, when they come from a runtime dispatched kernel.  It
+            // does the same columns the simd8f loop below would.
+            const int dispatched_nc = visible_nc > 1 ? (visible_nc-1)/8*8 : 0;
+            std::vector<float> row_len(dispatched_nc);
+            std::vector<int32> row_orientation(dispatched_nc);
+
             // First populate the gradient histograms
             for (int y = 1; y < visible_nr; y++) 
             {
@@ -825,8 +871,26 @@ namespace dlib
                 const int iyp = (int)std::floor(yp);
                 const float vy0 = yp - iyp;
                 const float vy1 = 1.0 - vy0;
-                int x;
-                for (x = 1; x < visible_nc - 7; x += 8)
+                int x = 1;
+                if (dispatched_nc != 0 && dispatch_gradient_row(&img[y-1][1], &img[y][1], &img[y+1][1], 
+                                                                dispatched_nc, &row_len[0], &row_orientation[0]))
+                {
+                    for (int i = 0; i < dispatched_nc; ++i, ++x)
+                    {
+                        // Same bilinear interpolation as the simd8f loop
+                        const float xp = ((float)x + 0.5f) / (float)cell_size + 0.5f;
+                        const int ixp = (int)xp;
+                        const float vx0 = (xp - ixp)*row_len[i];
+                        const float vx1 = (1.0f - (xp - ixp))*row_len[i];
+                        const int best_o = row_orientation[i];
+
+                        hist[iyp + 1][ixp](best_o) += vy1*vx1;
+                        hist[iyp + 1 + 1][ixp](best_o) += vy0*vx1;
+                        hist[iyp + 1][ixp + 1](best_o) += vy1*vx0;
+                        hist[iyp + 1 + 1][ixp + 1](best_o) += vy0*vx0;
+                    }
+                }
+                for (; x < visible_nc - 7; x += 8)
                 {
                     simd8f xx(x, x + 1, x + 2, x + 3, x + 4, x + 5, x + 6, x + 7);
                     // v will be the length of the gradient vectors.
@@ -973,7 +1037,9 @@ namespace dlib
             for (int y = 0; y < hog_nr; y++) 
             {
                 const int yy = y+padding_rows_offset; 
-                for (int x = 0; x < hog_nc; x++) 
+                int x = dispatch_normalize_hog_row(hog, padding_cols_offset, yy, &hist[y+1+1][1+1](0),
+                                                   &norm[y][0], &norm[y+1][0], &norm[y+2][0], hog_nc);
+                for (; x < hog_nc; x++) 
                 {
                     const simd4f z1(norm[y+1][x+1],
                                     norm[y][x+1], 
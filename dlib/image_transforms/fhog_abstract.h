@@ -70,6 +70,9 @@ namespace dlib
             - for all valid r and c:
                 - #hog[r][c] == the FHOG vector describing the cell centered at the pixel location 
                   fhog_to_image(point(c,r),cell_size,filter_rows_padding,filter_cols_padding) in img.
+            - When img holds unsigned char or rgb_pixel pixels and the CPU supports AVX2
+              or AVX-512, the gradients are computed by kernels picked at runtime (see
+              dlib/simd/cpu_dispatch_abstract.h).  They give exactly the same results.
     !*/
 
 // ----------------------------------------------------------------------------------------
@@ -104,6 +107,9 @@ namespace dlib
               will have, for all valid r and c:
                 - #hog[i][r][c] == vhog[r][c](i)
                   (where 0 <= i < 31)
+              When T is float and the CPU supports AVX2, the features are normalized by
+              a kernel picked at runtime (see dlib/simd/cpu_dispatch_abstract.h), so the
+              two can differ by float rounding.
             - #hog.size() == 31
             - for all valid i:
                 - #hog[i].nr() == hog[0].nr()
@@ -0,0 +1,520 @@
+// Copyright (C) 2016  Davis E. King (davis@dlib.net)
+// License: Boost Software License   See LICENSE.txt for the full license.
+#ifndef DLIB_fHOG_KERNELS_CPP_
+#define DLIB_fHOG_KERNELS_CPP_
+
+#include "fhog_kernels.h"
+
+#ifdef DLIB_HAVE_CPU_DISPATCH
+#include <immintrin.h>
+#endif
+
+namespace dlib
+{
+    namespace impl_fhog
+    {
+
+#ifdef DLIB_HAVE_CPU_DISPATCH
+
+    // ------------------------------------------------------------------------------------
+
+        // unit vectors used to compute gradient orientation, same as in fhog.h
+        const float kernel_directions_x[9] = { 1.0000f, 0.9397f, 0.7660f, 0.500f, 0.1736f, -0.1736f, -0.5000f, -0.7660f, -0.9397f};
+        const float kernel_directions_y[9] = { 0.0000f, 0.3420f, 0.6428f, 0.8660f, 0.9848f,  0.9848f,  0.8660f,  0.6428f,  0.3420f};
+
+        /*
+            Note that the gradient kernels are not compiled with FMA.  Fusing the dot
+            products would round them differently, which can snap a gradient that lies
+            right between two orientations to the other one.  This way they give exactly
+            the same orientations and lengths as the regular code.
+        */
+
+        DLIB_TARGET_AVX2 inline void store_gradients_avx2 (
+            __m256i grad_x,
+            __m256i grad_y,
+            __m256i len,
+            float* out_len,
+            int32* out_orientation
+        )
+        {
+            const __m256 gx = _mm256_cvtepi32_ps(grad_x);
+            const __m256 gy = _mm256_cvtepi32_ps(grad_y);
+
+            // snap to one of 18 orientations
+            __m256 best_dot = _mm256_setzero_ps();
+            __m256 best_o = _mm256_setzero_ps();
+            for (int o = 0; o < 9; ++o)
+            {
+                __m256 dot = _mm256_add_ps(_mm256_mul_ps(gx, _mm256_set1_ps(kernel_directions_x[o])),
+                                           _mm256_mul_ps(gy, _mm256_set1_ps(kernel_directions_y[o])));
+                __m256 cmp = _mm256_cmp_ps(dot, best_dot, _CMP_GT_OQ);
+                best_dot = _mm256_blendv_ps(best_dot, dot, cmp);
+                best_o = _mm256_blendv_ps(best_o, _mm256_set1_ps((float)o), cmp);
+
+                dot = _mm256_sub_ps(_mm256_setzero_ps(), dot);
+                cmp = _mm256_cmp_ps(dot, best_dot, _CMP_GT_OQ);
+                best_dot = _mm256_blendv_ps(best_dot, dot, cmp);
+                best_o = _mm256_blendv_ps(best_o, _mm256_set1_ps((float)(o+9)), cmp);
+            }
+
+            _mm256_storeu_ps(out_len, _mm256_sqrt_ps(_mm256_cvtepi32_ps(len)));
+            _mm256_storeu_si256((__m256i*)out_orientation, _mm256_cvttps_epi32(best_o));
+        }
+
+        DLIB_TARGET_AVX2 inline __m256i load_u8x8_avx2 (
+            const unsigned char* p
+        )
+        {
+            return _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)p));
+        }
+
+        DLIB_TARGET_AVX2 void gradient_row_avx2 (
+            const unsigned char* above,
+            const unsigned char* row,
+            const unsigned char* below,
+            long n,
+            float* len,
+            int32* orientation
+        )
+        {
+            for (long i = 0; i < n; i += 8)
+            {
+                const __m256i grad_x = _mm256_sub_epi32(load_u8x8_avx2(row+i+1), load_u8x8_avx2(row+i-1));
+                const __m256i grad_y = _mm256_sub_epi32(load_u8x8_avx2(below+i), load_u8x8_avx2(above+i));
+                const __m256i l = _mm256_add_epi32(_mm256_mullo_epi32(grad_x,grad_x), _mm256_mullo_epi32(grad_y,grad_y));
+                store_gradients_avx2(grad_x, grad_y, l, len+i, orientation+i);
+            }
+        }
+
+    // ------------------------------------------------------------------------------------
+
+        DLIB_TARGET_AVX2 inline void load_rgb_x8_avx2 (
+            const rgb_pixel* p,
+            __m256i& red,
+            __m256i& green,
+            __m256i& blue
+        )
+        {
+            // The 8 pixels are 24 bytes.  Pull each channel out of the first 16 and the
+            // last 16 of them.
+            const unsigned char* bytes = &p->red;
+            const __m128i lo = _mm_loadu_si128((const __m128i*)bytes);
+            const __m128i hi = _mm_loadu_si128((const __m128i*)(bytes+8));
+            const __m128i red_lo   = _mm_setr_epi8(0,3,6,9,12,15,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1);
+            const __m128i red_hi   = _mm_setr_epi8(-1,-1,-1,-1,-1,-1,10,13,-1,-1,-1,-1,-1,-1,-1,-1);
+            const __m128i green_lo = _mm_setr_epi8(1,4,7,10,13,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1);
+            const __m128i green_hi = _mm_setr_epi8(-1,-1,-1,-1,-1,8,11,14,-1,-1,-1,-1,-1,-1,-1,-1);
+            const __m128i blue_lo  = _mm_setr_epi8(2,5,8,11,14,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1);
+            const __m128i blue_hi  = _mm_setr_epi8(-1,-1,-1,-1,-1,9,12,15,-1,-1,-1,-1,-1,-1,-1,-1);
+            red   = _mm256_cvtepu8_epi32(_mm_or_si128(_mm_shuffle_epi8(lo,red_lo),   _mm_shuffle_epi8(hi,red_hi)));
+            green = _mm256_cvtepu8_epi32(_mm_or_si128(_mm_shuffle_epi8(lo,green_lo), _mm_shuffle_epi8(hi,green_hi)));
+            blue  = _mm256_cvtepu8_epi32(_mm_or_si128(_mm_shuffle_epi8(lo,blue_lo),  _mm_shuffle_epi8(hi,blue_hi)));
+        }
+
+        DLIB_TARGET_AVX2 void gradient_row_avx2 (
+            const rgb_pixel* above,
+            const rgb_pixel* row,
+            const rgb_pixel* below,
+            long n,
+            float* len,
+            int32* orientation
+        )
+        {
+            for (long i = 0; i < n; i += 8)
+            {
+                __m256i lr, lg, lb, rr, rg, rb, tr, tg, tb, br, bg, bb;
+                load_rgb_x8_avx2(row+i-1, lr, lg, lb);
+                load_rgb_x8_avx2(row+i+1, rr, rg, rb);
+                load_rgb_x8_avx2(above+i, tr, tg, tb);
+                load_rgb_x8_avx2(below+i, br, bg, bb);
+
+                const __m256i grad_x_red = _mm256_sub_epi32(rr, lr);
+                const __m256i grad_y_red = _mm256_sub_epi32(br, tr);
+                const __m256i grad_x_green = _mm256_sub_epi32(rg, lg);
+                const __m256i grad_y_green = _mm256_sub_epi32(bg, tg);
+                const __m256i grad_x_blue = _mm256_sub_epi32(rb, lb);
+                const __m256i grad_y_blue = _mm256_sub_epi32(bb, tb);
+
+                const __m256i rlen = _mm256_add_epi32(_mm256_mullo_epi32(grad_x_red,grad_x_red), _mm256_mullo_epi32(grad_y_red,grad_y_red));
+                const __m256i glen = _mm256_add_epi32(_mm256_mullo_epi32(grad_x_green,grad_x_green), _mm256_mullo_epi32(grad_y_green,grad_y_green));
+                const __m256i blen = _mm256_add_epi32(_mm256_mullo_epi32(grad_x_blue,grad_x_blue), _mm256_mullo_epi32(grad_y_blue,grad_y_blue));
+
+                // pick color with strongest gradient, breaking ties like get_gradient() does
+                __m256i cmp = _mm256_cmpgt_epi32(rlen, glen);
+                const __m256i tgrad_x = _mm256_blendv_epi8(grad_x_green, grad_x_red, cmp);
+                const __m256i tgrad_y = _mm256_blendv_epi8(grad_y_green, grad_y_red, cmp);
+                const __m256i tlen = _mm256_blendv_epi8(glen, rlen, cmp);
+
+                cmp = _mm256_cmpgt_epi32(tlen, blen);
+                store_gradients_avx2(_mm256_blendv_epi8(grad_x_blue, tgrad_x, cmp),
+                                     _mm256_blendv_epi8(grad_y_blue, tgrad_y, cmp),
+                                     _mm256_blendv_epi8(blen, tlen, cmp),
+                                     len+i, orientation+i);
+            }
+        }
+
+    // ------------------------------------------------------------------------------------
+
+        DLIB_TARGET_AVX512 void gradient_row_avx512 (
+            const unsigned char* above,
+            const unsigned char* row,
+            const unsigned char* below,
+            long n,
+            float* len,
+            int32* orientation
+        )
+        {
+            long i = 0;
+            for (; i+16 <= n; i += 16)
+            {
+                const __m512i left   = _mm512_cvtepu8_epi32(_mm_loadu_si128((const __m128i*)(row+i-1)));
+                const __m512i right  = _mm512_cvtepu8_epi32(_mm_loadu_si128((const __m128i*)(row+i+1)));
+                const __m512i top    = _mm512_cvtepu8_epi32(_mm_loadu_si128((const __m128i*)(above+i)));
+                const __m512i bottom = _mm512_cvtepu8_epi32(_mm_loadu_si128((const __m128i*)(below+i)));
+                const __m512i grad_x = _mm512_sub_epi32(right, left);
+                const __m512i grad_y = _mm512_sub_epi32(bottom, top);
+                const __m512 gx = _mm512_cvtepi32_ps(grad_x);
+                const __m512 gy = _mm512_cvtepi32_ps(grad_y);
+                const __m512i l = _mm512_add_epi32(_mm512_mullo_epi32(grad_x,grad_x), _mm512_mullo_epi32(grad_y,grad_y));
+
+                __m512 best_dot = _mm512_setzero_ps();
+                __m512 best_o = _mm512_setzero_ps();
+                for (int o = 0; o < 9; ++o)
+                {
+                    // _mm512_add_round_ps keeps the compiler from contracting this into an FMA
+                    __m512 dot = _mm512_add_round_ps(_mm512_mul_ps(gx, _mm512_set1_ps(kernel_directions_x[o])),
+                                                     _mm512_mul_ps(gy, _mm512_set1_ps(kernel_directions_y[o])),
+                                                     _MM_FROUND_TO_NEAREST_INT|_MM_FROUND_NO_EXC);
+                    __mmask16 cmp = _mm512_cmp_ps_mask(dot, best_dot, _CMP_GT_OQ);
+                    best_dot = _mm512_mask_blend_ps(cmp, best_dot, dot);
+                    best_o = _mm512_mask_blend_ps(cmp, best_o, _mm512_set1_ps((float)o));
+
+                    dot = _mm512_sub_ps(_mm512_setzero_ps(), dot);
+                    cmp = _mm512_cmp_ps_mask(dot, best_dot, _CMP_GT_OQ);
+                    best_dot = _mm512_mask_blend_ps(cmp, best_dot, dot);
+                    best_o = _mm512_mask_blend_ps(cmp, best_o, _mm512_set1_ps((float)(o+9)));
+                }
+
+                _mm512_storeu_ps(len+i, _mm512_sqrt_ps(_mm512_cvtepi32_ps(l)));
+                _mm512_storeu_si512(orientation+i, _mm512_cvttps_epi32(best_o));
+            }
+
+            if (i < n)
+                gradient_row_avx2(above+i, row+i, below+i, n-i, len+i, orientation+i);
+        }
+
+    // ------------------------------------------------------------------------------------
+
+        /*
+            The normalization kernels work on 8 (or 16) cells at once.  For each cell the
+            4 blocks it belongs to give 4 normalizers, the same ones the regular code puts
+            in the 4 lanes of a simd4f.
+        */
+
+        DLIB_TARGET_AVX2_FMA long normalize_row_avx2 (
+            const float* hist,
+            const float* norm_above,
+            const float* norm,
+            const float* norm_below,
+            long n,
+            float* const* out
+        )
+        {
+            const __m256 eps = _mm256_set1_ps(0.0001f);
+            const __m256i cells = _mm256_setr_epi32(0, 18, 36, 54, 72, 90, 108, 126);
+            long x = 0;
+            for (; x+8 <= n; x += 8)
+            {
+                const __m256 a0 = _mm256_loadu_ps(norm_above+x);
+                const __m256 a1 = _mm256_loadu_ps(norm_above+x+1);
+                const __m256 a2 = _mm256_loadu_ps(norm_above+x+2);
+                const __m256 m0 = _mm256_loadu_ps(norm+x);
+                const __m256 m1 = _mm256_loadu_ps(norm+x+1);
+                const __m256 m2 = _mm256_loadu_ps(norm+x+2);
+                const __m256 b0 = _mm256_loadu_ps(norm_below+x);
+                const __m256 b1 = _mm256_loadu_ps(norm_below+x+1);
+                const __m256 b2 = _mm256_loadu_ps(norm_below+x+2);
+
+                // the 4 blocks around each cell, in the order of the simd4f lanes
+                __m256 nn[4];
+                nn[0] = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(m1, m2), b1), b2);
+                nn[1] = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(a1, a2), m1), m2);
+                nn[2] = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(m0, m1), b0), b1);
+                nn[3] = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(a0, a1), m0), m1);
+                __m256 scale[4];
+                for (int k = 0; k < 4; ++k)
+                {
+                    nn[k] = _mm256_mul_ps(_mm256_set1_ps(0.2f), _mm256_sqrt_ps(_mm256_add_ps(nn[k], eps)));
+                    scale[k] = _mm256_div_ps(_mm256_set1_ps(0.1f), nn[k]);
+                }
+
+                __m256 h[18];
+                for (int o = 0; o < 18; ++o)
+                    h[o] = _mm256_i32gather_ps(hist + x*18 + o, cells, 4);
+
+                // contrast-sensitive features
+                __m256 t[4];
+                for (int k = 0; k < 4; ++k)
+                    t[k] = _mm256_setzero_ps();
+                for (int o = 0; o < 18; ++o)
+                {
+                    const __m256 h0 = _mm256_mul_ps(_mm256_min_ps(h[o], nn[0]), scale[0]);
+                    const __m256 h1 = _mm256_mul_ps(_mm256_min_ps(h[o], nn[1]), scale[1]);
+                    const __m256 h2 = _mm256_mul_ps(_mm256_min_ps(h[o], nn[2]), scale[2]);
+                    const __m256 h3 = _mm256_mul_ps(_mm256_min_ps(h[o], nn[3]), scale[3]);
+                    _mm256_storeu_ps(out[o]+x, _mm256_add_ps(_mm256_add_ps(h0, h1), _mm256_add_ps(h2, h3)));
+                    t[0] = _mm256_add_ps(t[0], h0);
+                    t[1] = _mm256_add_ps(t[1], h1);
+                    t[2] = _mm256_add_ps(t[2], h2);
+                    t[3] = _mm256_add_ps(t[3], h3);
+                }
+
+                // contrast-insensitive features
+                for (int o = 0; o < 9; ++o)
+                {
+                    const __m256 temp = _mm256_add_ps(h[o], h[o+9]);
+                    __m256 sum = _mm256_mul_ps(_mm256_min_ps(temp, nn[0]), scale[0]);
+                    sum = _mm256_fmadd_ps(_mm256_min_ps(temp, nn[1]), scale[1], sum);
+                    sum = _mm256_fmadd_ps(_mm256_min_ps(temp, nn[2]), scale[2], sum);
+                    sum = _mm256_fmadd_ps(_mm256_min_ps(temp, nn[3]), scale[3], sum);
+                    _mm256_storeu_ps(out[o+18]+x, sum);
+                }
+
+                // texture features
+                for (int k = 0; k < 4; ++k)
+                    _mm256_storeu_ps(out[27+k]+x, _mm256_mul_ps(t[k], _mm256_set1_ps(2*0.2357f)));
+            }
+            return x;
+        }
+
+        DLIB_TARGET_AVX512 long normalize_row_avx512 (
+            const float* hist,
+            const float* norm_above,
+            const float* norm,
+            const float* norm_below,
+            long n,
+            float* const* out
+        )
+        {
+            const __m512 eps = _mm512_set1_ps(0.0001f);
+            const __m512i cells = _mm512_setr_epi32(0, 18, 36, 54, 72, 90, 108, 126,
+                                                    144, 162, 180, 198, 216, 234, 252, 270);
+            long x = 0;
+            for (; x+16 <= n; x += 16)
+            {
+                const __m512 a0 = _mm512_loadu_ps(norm_above+x);
+                const __m512 a1 = _mm512_loadu_ps(norm_above+x+1);
+                const __m512 a2 = _mm512_loadu_ps(norm_above+x+2);
+                const __m512 m0 = _mm512_loadu_ps(norm+x);
+                const __m512 m1 = _mm512_loadu_ps(norm+x+1);
+                const __m512 m2 = _mm512_loadu_ps(norm+x+2);
+                const __m512 b0 = _mm512_loadu_ps(norm_below+x);
+                const __m512 b1 = _mm512_loadu_ps(norm_below+x+1);
+                const __m512 b2 = _mm512_loadu_ps(norm_below+x+2);
+
+                __m512 nn[4];
+                nn[0] = _mm512_add_ps(_mm512_add_ps(_mm512_add_ps(m1, m2), b1), b2);
+                nn[1] = _mm512_add_ps(_mm512_add_ps(_mm512_add_ps(a1, a2), m1), m2);
+                nn[2] = _mm512_add_ps(_mm512_add_ps(_mm512_add_ps(m0, m1), b0), b1);
+                nn[3] = _mm512_add_ps(_mm512_add_ps(_mm512_add_ps(a0, a1), m0), m1);
+                __m512 scale[4];
+                for (int k = 0; k < 4; ++k)
+                {
+                    nn[k] = _mm512_mul_ps(_mm512_set1_ps(0.2f), _mm512_sqrt_ps(_mm512_add_ps(nn[k], eps)));
+                    scale[k] = _mm512_div_ps(_mm512_set1_ps(0.1f), nn[k]);
+                }
+
+                __m512 h[18];
+                for (int o = 0; o < 18; ++o)
+                    h[o] = _mm512_i32gather_ps(cells, hist + x*18 + o, 4);
+
+                __m512 t[4];
+                for (int k = 0; k < 4; ++k)
+                    t[k] = _mm512_setzero_ps();
+                for (int o = 0; o < 18; ++o)
+                {
+                    const __m512 h0 = _mm512_mul_ps(_mm512_min_ps(h[o], nn[0]), scale[0]);
+                    const __m512 h1 = _mm512_mul_ps(_mm512_min_ps(h[o], nn[1]), scale[1]);
+                    const __m512 h2 = _mm512_mul_ps(_mm512_min_ps(h[o], nn[2]), scale[2]);
+                    const __m512 h3 = _mm512_mul_ps(_mm512_min_ps(h[o], nn[3]), scale[3]);
+                    _mm512_storeu_ps(out[o]+x, _mm512_add_ps(_mm512_add_ps(h0, h1), _mm512_add_ps(h2, h3)));
+                    t[0] = _mm512_add_ps(t[0], h0);
+                    t[1] = _mm512_add_ps(t[1], h1);
+                    t[2] = _mm512_add_ps(t[2], h2);
+                    t[3] = _mm512_add_ps(t[3], h3);
+                }
+
+                for (int o = 0; o < 9; ++o)
+                {
+                    const __m512 temp = _mm512_add_ps(h[o], h[o+9]);
+                    __m512 sum = _mm512_mul_ps(_mm512_min_ps(temp, nn[0]), scale[0]);
+                    sum = _mm512_fmadd_ps(_mm512_min_ps(temp, nn[1]), scale[1], sum);
+                    sum = _mm512_fmadd_ps(_mm512_min_ps(temp, nn[2]), scale[2], sum);
+                    sum = _mm512_fmadd_ps(_mm512_min_ps(temp, nn[3]), scale[3], sum);
+                    _mm512_storeu_ps(out[o+18]+x, sum);
+                }
+
+                for (int k = 0; k < 4; ++k)
+                    _mm512_storeu_ps(out[27+k]+x, _mm512_mul_ps(t[k], _mm512_set1_ps(2*0.2357f)));
+            }
+
+            // finish with the 8 wide kernel
+            float* rest[31];
+            for (int o = 0; o < 31; ++o)
+                rest[o] = out[o]+x;
+            return x + normalize_row_avx2(hist + x*18, norm_above+x, norm+x, norm_below+x, n-x, rest);
+        }
+
+    // ------------------------------------------------------------------------------------
+
+        /*
+            The dequantization kernels are compiled without FMA, so they give exactly the
+            same values as half_to_float() and the scalar u8 loop.
+        */
+
+        DLIB_TARGET_AVX2 long half_to_float_row_avx2 (
+            const uint16* in,
+            long n,
+            float* out
+        )
+        {
+            const __m256i magnitude = _mm256_set1_epi32(0x7fff);
+            const __m256i exponent = _mm256_set1_epi32(0x7c00);
+            const __m256i sign = _mm256_set1_epi32(0x8000);
+            const __m256 rebias = _mm256_set1_ps(5.192296858534828e33f);
+            const __m256i inf = _mm256_set1_epi32(0x7f800000);
+            long i = 0;
+            for (; i+8 <= n; i += 8)
+            {
+                const __m256i h = _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*)(in+i)));
+                __m256i x = _mm256_castps_si256(_mm256_mul_ps(_mm256_castsi256_ps(
+                            _mm256_slli_epi32(_mm256_and_si256(h, magnitude), 13)), rebias));
+                const __m256i special = _mm256_cmpeq_epi32(_mm256_and_si256(h, exponent), exponent);
+                const __m256i inf_nan = _mm256_or_si256(inf, _mm256_slli_epi32(_mm256_and_si256(h, _mm256_set1_epi32(0x3ff)), 13));
+                x = _mm256_blendv_epi8(x, inf_nan, special);
+                x = _mm256_or_si256(x, _mm256_slli_epi32(_mm256_and_si256(h, sign), 16));
+                _mm256_storeu_ps(out+i, _mm256_castsi256_ps(x));
+            }
+            return i;
+        }
+
+        DLIB_TARGET_AVX2 long dequantize_row_avx2 (
+            const uint8* in,
+            long n,
+            float scale,
+            float offset,
+            float* out
+        )
+        {
+            const __m256 s = _mm256_set1_ps(scale);
+            const __m256 o = _mm256_set1_ps(offset);
+            long i = 0;
+            for (; i+8 <= n; i += 8)
+            {
+                const __m128i bytes = _mm_loadl_epi64((const __m128i*)(in+i));
+                const __m256 q = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(bytes));
+                _mm256_storeu_ps(out+i, _mm256_add_ps(_mm256_mul_ps(q, s), o));
+            }
+            return i;
+        }
+
+    // ------------------------------------------------------------------------------------
+
+#endif // DLIB_HAVE_CPU_DISPATCH
+
+        bool dispatch_gradient_row (
+            const unsigned char* above,
+            const unsigned char* row,
+            const unsigned char* below,
+            long n,
+            float* len,
+            int32* orientation
+        )
+        {
+#ifdef DLIB_HAVE_CPU_DISPATCH
+            switch (get_simd_dispatch_level())
+            {
+                case CPU_SIMD_AVX512: gradient_row_avx512(above, row, below, n, len, orientation); return true;
+                case CPU_SIMD_AVX2: gradient_row_avx2(above, row, below, n, len, orientation); return true;
+                default: break;
+            }
+#endif
+            return false;
+        }
+
+        bool dispatch_gradient_row (
+            const rgb_pixel* above,
+            const rgb_pixel* row,
+            const rgb_pixel* below,
+            long n,
+            float* len,
+            int32* orientation
+        )
+        {
+#ifdef DLIB_HAVE_CPU_DISPATCH
+            // There is no AVX-512 version of this one, the AVX2 kernel is bound by
+            // shuffling the channels apart anyway.
+            if (get_simd_dispatch_level() >= CPU_SIMD_AVX2)
+            {
+                gradient_row_avx2(above, row, below, n, len, orientation);
+                return true;
+            }
+#endif
+            return false;
+        }
+
+        long dispatch_normalize_row (
+            const float* hist,
+            const float* norm_above,
+            const float* norm,
+            const float* norm_below,
+            long n,
+            float* const* out
+        )
+        {
+#ifdef DLIB_HAVE_CPU_DISPATCH
+            switch (get_simd_dispatch_level())
+            {
+                case CPU_SIMD_AVX512: return normalize_row_avx512(hist, norm_above, norm, norm_below, n, out);
+                case CPU_SIMD_AVX2: return normalize_row_avx2(hist, norm_above, norm, norm_below, n, out);
+                default: break;
+            }
+#endif
+            return 0;
+        }
+
+
+        long dispatch_half_to_float_row (
+            const uint16* in,
+            long n,
+            float* out
+        )
+        {
+#ifdef DLIB_HAVE_CPU_DISPATCH
+            // bound by memory, so AVX-512 hosts use the AVX2 kernel too
+            if (get_simd_dispatch_level() >= CPU_SIMD_AVX2)
+                return half_to_float_row_avx2(in, n, out);
+#endif
+            return 0;
+        }
+
+        long dispatch_dequantize_row (
+            const uint8* in,
+            long n,
+            float scale,
+            float offset,
+            float* out
+        )
+        {
+#ifdef DLIB_HAVE_CPU_DISPATCH
+            if (get_simd_dispatch_level() >= CPU_SIMD_AVX2)
+                return dequantize_row_avx2(in, n, scale, offset, out);
+#endif
+            return 0;
+        }
+
+    }
+}
+
+#endif // DLIB_fHOG_KERNELS_CPP_
+
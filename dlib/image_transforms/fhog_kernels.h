@@ -0,0 +1,191 @@
+// Copyright (C) 2016  Davis E. King (davis@dlib.net)
+// License: Boost Software License   See LICENSE.txt for the full license.
+#ifndef DLIB_fHOG_KERNELS_Hh_
+#define DLIB_fHOG_KERNELS_Hh_
+
+#include "../pixel.h"
+#include "../uintn.h"
+#include "../simd/cpu_dispatch.h"
+#include <cstring>
+
+namespace dlib
+{
+    namespace impl_fhog
+    {
+
+    // ------------------------------------------------------------------------------------
+
+        /*
+            These are the parts of extract_fhog_features() that have AVX2 and AVX-512
+            versions, which are picked at runtime based on get_simd_dispatch_level().
+            They all return false (or 0) when no kernel applies, in which case the caller
+            does the work with its regular code path.
+        */
+
+        bool dispatch_gradient_row (
+            const unsigned char* above,
+            const unsigned char* row,
+            const unsigned char* below,
+            long n,
+            float* len,
+            int32* orientation
+        );
+        /*
+            requires
+                - n is a multiple of 8
+                - row points at the first of n pixels of an image row.  above and below
+                  point at the same column in the rows above and below it.  The pixels
+                  row[-1] and row[n] must be readable.
+            ensures
+                - if a kernel for the current dispatch level exists then
+                    - for all i in [0,n): #len[i] is the length of the gradient at row[i]
+                      and #orientation[i] is the index (in [0,18)) of the direction it
+                      snaps to, exactly as extract_fhog_features() computes them.
+                    - returns true
+                - else
+                    - returns false
+        */
+
+        bool dispatch_gradient_row (
+            const rgb_pixel* above,
+            const rgb_pixel* row,
+            const rgb_pixel* below,
+            long n,
+            float* len,
+            int32* orientation
+        );
+        /*
+            Same as above, using the channel with the strongest gradient
+        */
+
+        template <typename pixel_type>
+        inline bool dispatch_gradient_row (
+            const pixel_type* ,
+            const pixel_type* ,
+            const pixel_type* ,
+            long ,
+            float* ,
+            int32*
+        ) { return false; }
+
+        long dispatch_normalize_row (
+            const float* hist,
+            const float* norm_above,
+            const float* norm,
+            const float* norm_below,
+            long n,
+            float* const* out
+        );
+        /*
+            requires
+                - hist points at the 18 orientation bins of n consecutive cells (18*n floats)
+                - norm_above, norm and norm_below point at 3 consecutive rows of block
+                  energies, starting one cell left of and above the first cell, with n+2
+                  values each.
+                - out points at 31 pointers to the planes the features are written to.
+            ensures
+                - computes the 31 fhog features of the first k cells, where k is the
+                  number of cells the kernel for the current dispatch level handles (a
+                  multiple of its vector width, at most n), and stores feature o of cell i
+                  in out[o][i].
+                - returns k
+        */
+
+    // ------------------------------------------------------------------------------------
+
+        /*
+            Conversions for fhog features stored as IEEE half precision floats.  Rounding is
+            to nearest even, values too large for a half become infinity.
+        */
+
+        inline uint16 float_to_half (
+            float f
+        )
+        {
+            uint32 x;
+            std::memcpy(&x, &f, sizeof(x));
+            const uint32 sign = (x >> 16) & 0x8000;
+            x &= 0x7fffffff;
+
+            if (x >= 0x47800000)
+                return static_cast<uint16>(sign | (x > 0x7f800000 ? 0x7e00 : 0x7c00));
+
+            if (x < 0x38800000)
+            {
+                // Subnormal halves count in units of 2^-24, and anything below 2^-25
+                // rounds to zero.
+                const uint32 e = x >> 23;
+                if (e < 102)
+                    return static_cast<uint16>(sign);
+                const uint32 m = (x & 0x7fffff) | 0x800000;
+                const uint32 shift = 126 - e;
+                uint32 h = m >> shift;
+                const uint32 rest = m & ((1u << shift) - 1);
+                const uint32 half_way = 1u << (shift-1);
+                if (rest > half_way || (rest == half_way && (h & 1)))
+                    ++h;
+                return static_cast<uint16>(sign | h);
+            }
+
+            uint32 h = (x - 0x38000000) >> 13;
+            const uint32 rest = x & 0x1fff;
+            if (rest > 0x1000 || (rest == 0x1000 && (h & 1)))
+                ++h;
+            return static_cast<uint16>(sign | h);
+        }
+
+        inline float half_to_float (
+            uint16 h
+        )
+        {
+            // Moving the bits into place and scaling by 2^112 rebiases the exponent, and
+            // turns subnormal halves into normal floats.
+            uint32 x = static_cast<uint32>(h & 0x7fff) << 13;
+            float f;
+            std::memcpy(&f, &x, sizeof(f));
+            f *= 5.192296858534828e33f;
+            std::memcpy(&x, &f, sizeof(x));
+            if ((h & 0x7c00) == 0x7c00)
+                x = 0x7f800000 | (static_cast<uint32>(h & 0x3ff) << 13);
+            x |= static_cast<uint32>(h & 0x8000) << 16;
+            std::memcpy(&f, &x, sizeof(f));
+            return f;
+        }
+
+        long dispatch_half_to_float_row (
+            const uint16* in,
+            long n,
+            float* out
+        );
+        /*
+            ensures
+                - Converts the first k values of in with half_to_float() and stores them in
+                  out, where k is the number of values the kernel for the current dispatch
+                  level handles (a multiple of its vector width, at most n).
+                - returns k
+        */
+
+        long dispatch_dequantize_row (
+            const uint8* in,
+            long n,
+            float scale,
+            float offset,
+            float* out
+        );
+        /*
+            ensures
+                - Like dispatch_half_to_float_row(), except that it stores in[i]*scale + offset
+                  (rounded after the multiply and after the add) in out[i].
+        */
+
+    // ------------------------------------------------------------------------------------
+
+    }
+}
+
+#ifdef NO_MAKEFILE
+#include "fhog_kernels.cpp"
+#endif
+
+#endif // DLIB_fHOG_KERNELS_Hh_
+
@@ -61,8 +61,11 @@ namespace dlib
                   be in color.  Otherwise, the downsampling will be performed in a grayscale mode.
                 - The location of a point P in original image will show up at point point_down(P)
                   in the #down image.  
-                - Note that some points on the border of the original image might correspond to 
-                  points outside the #down image.  
+                - Note that some points on the border of the original image might correspond to
+                  points outside the #down image.
+                - When N > 3 and both images hold unsigned char, rgb_pixel, or bgr_pixel
+                  pixels, the bilinear resampling is done in two separable passes, which
+                  can differ from resize_image() by 1 in each channel.
         !*/
 
         template <
@@ -0,0 +1,178 @@
+// Copyright (C) 2016  Davis E. King (davis@dlib.net)
+// License: Boost Software License   See LICENSE.txt for the full license.
+#ifndef DLIB_IMAGE_PYRaMID_KERNELS_CPP_
+#define DLIB_IMAGE_PYRaMID_KERNELS_CPP_
+
+#include "image_pyramid_kernels.h"
+#include "../simd.h"
+#include <cmath>
+
+#ifdef DLIB_HAVE_CPU_DISPATCH
+#include <immintrin.h>
+#endif
+
+namespace dlib
+{
+    namespace impl
+    {
+
+#ifdef DLIB_HAVE_CPU_DISPATCH
+
+    // ------------------------------------------------------------------------------------
+
+        /*
+            These kernels aren't compiled with FMA so they round exactly like the
+            regular code below.
+        */
+
+        DLIB_TARGET_AVX2 long interpolate_columns_avx2 (
+            const column_taps& taps,
+            const unsigned char* row,
+            float* out
+        )
+        {
+            const __m256 one = _mm256_set1_ps(1);
+            const long blocks = taps.block_base.size();
+            for (long k = 0; k < blocks; ++k)
+            {
+                const __m128i bytes = _mm_loadu_si128((const __m128i*)(row+taps.block_base[k]));
+                const __m128i shuffle = _mm_loadu_si128((const __m128i*)(&taps.block_shuffle[16*k]));
+                const __m128i lr = _mm_shuffle_epi8(bytes, shuffle);
+                const __m256 left = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(lr));
+                const __m256 right = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_srli_si128(lr, 8)));
+                const __m256 w = _mm256_loadu_ps(&taps.weights[8*k]);
+                _mm256_storeu_ps(out+8*k, _mm256_add_ps(_mm256_mul_ps(left, _mm256_sub_ps(one, w)), _mm256_mul_ps(right, w)));
+            }
+            return 8*blocks;
+        }
+
+        DLIB_TARGET_AVX2 long interpolate_rows_avx2 (
+            const float* top,
+            const float* bottom,
+            float bottom_weight,
+            long n,
+            unsigned char* out
+        )
+        {
+            const __m256 tw = _mm256_set1_ps(1-bottom_weight);
+            const __m256 bw = _mm256_set1_ps(bottom_weight);
+            long i = 0;
+            for (; i+32 <= n; i += 32)
+            {
+                __m256i p[4];
+                for (int k = 0; k < 4; ++k)
+                {
+                    const __m256 v = _mm256_add_ps(_mm256_mul_ps(_mm256_loadu_ps(top+i+8*k), tw),
+                                                   _mm256_mul_ps(_mm256_loadu_ps(bottom+i+8*k), bw));
+                    p[k] = _mm256_cvttps_epi32(v);
+                }
+                // The packs work within 128 bit lanes, so put the 32 bytes back in order
+                const __m256i words = _mm256_packus_epi32(p[0], p[1]);
+                const __m256i words2 = _mm256_packus_epi32(p[2], p[3]);
+                const __m256i bytes = _mm256_packus_epi16(words, words2);
+                _mm256_storeu_si256((__m256i*)(out+i), _mm256_permutevar8x32_epi32(bytes, _mm256_setr_epi32(0,4,1,5,2,6,3,7)));
+            }
+            return i;
+        }
+
+    // ------------------------------------------------------------------------------------
+
+#endif // DLIB_HAVE_CPU_DISPATCH
+
+        void setup_column_taps (
+            column_taps& taps,
+            long in_nc,
+            long out_nc,
+            int channels
+        )
+        {
+            taps.row_bytes = in_nc*channels;
+            taps.channels = channels;
+            const long n = out_nc*channels;
+            taps.offsets.resize(n);
+            taps.weights.resize(n);
+
+            const double x_scale = (in_nc-1)/(double)(out_nc-1);
+            for (long c = 0; c < out_nc; ++c)
+            {
+                const double x = c*x_scale;
+                long left = static_cast<long>(std::floor(x));
+                if (left >= in_nc-1)
+                    left = in_nc-2;
+                for (int k = 0; k < channels; ++k)
+                {
+                    taps.offsets[c*channels+k] = left*channels + k;
+                    taps.weights[c*channels+k] = x - left;
+                }
+            }
+
+            taps.block_base.clear();
+            taps.block_shuffle.clear();
+            for (long i = 0; i+8 <= n; i += 8)
+            {
+                const int32 base = taps.offsets[i];
+                if (base+16 > taps.row_bytes || taps.offsets[i+7]+channels-base > 15)
+                    break;
+                taps.block_base.push_back(base);
+                for (int j = 0; j < 8; ++j)
+                    taps.block_shuffle.push_back(static_cast<unsigned char>(taps.offsets[i+j]-base));
+                for (int j = 0; j < 8; ++j)
+                    taps.block_shuffle.push_back(static_cast<unsigned char>(taps.offsets[i+j]+channels-base));
+            }
+        }
+
+        void interpolate_columns (
+            const column_taps& taps,
+            const unsigned char* row,
+            float* out
+        )
+        {
+            const long n = taps.offsets.size();
+            long i = 0;
+#ifdef DLIB_HAVE_CPU_DISPATCH
+            if (get_simd_dispatch_level() >= CPU_SIMD_AVX2)
+                i = interpolate_columns_avx2(taps, row, out);
+#endif
+            const int channels = taps.channels;
+            for (; i < n; ++i)
+            {
+                const float w = taps.weights[i];
+                out[i] = row[taps.offsets[i]]*(1-w) + row[taps.offsets[i]+channels]*w;
+            }
+        }
+
+        void interpolate_rows (
+            const float* top,
+            const float* bottom,
+            float bottom_weight,
+            long n,
+            unsigned char* out
+        )
+        {
+            long i = 0;
+#ifdef DLIB_HAVE_CPU_DISPATCH
+            if (get_simd_dispatch_level() >= CPU_SIMD_AVX2)
+                i = interpolate_rows_avx2(top, bottom, bottom_weight, n, out);
+#endif
+            const float top_weight = 1-bottom_weight;
+            const simd8f tw = top_weight;
+            const simd8f bw = bottom_weight;
+            for (; i+8 <= n; i += 8)
+            {
+                simd8f t, b;
+                t.load(top+i);
+                b.load(bottom+i);
+                int32 temp[8];
+                simd8i(t*tw + b*bw).store(temp);
+                for (int k = 0; k < 8; ++k)
+                    out[i+k] = static_cast<unsigned char>(temp[k]);
+            }
+            for (; i < n; ++i)
+                out[i] = static_cast<unsigned char>(static_cast<int>(top[i]*top_weight + bottom[i]*bottom_weight));
+        }
+
+    }
+}
+
+#endif // DLIB_IMAGE_PYRaMID_KERNELS_CPP_
+
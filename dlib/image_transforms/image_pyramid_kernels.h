@@ -0,0 +1,96 @@
+// Copyright (C) 2016  Davis E. King (davis@dlib.net)
+// License: Boost Software License   See LICENSE.txt for the full license.
+#ifndef DLIB_IMAGE_PYRaMID_KERNELS_Hh_
+#define DLIB_IMAGE_PYRaMID_KERNELS_Hh_
+
+#include "../uintn.h"
+#include "../simd/cpu_dispatch.h"
+#include <vector>
+
+namespace dlib
+{
+    namespace impl
+    {
+
+    // ------------------------------------------------------------------------------------
+
+        /*
+            The two passes of the separable bilinear resampler pyramid_down<N> uses for 8
+            bit grayscale and RGB images.  Pixels are handled as interleaved channels, so
+            both passes work on single bytes.  They use AVX2 when get_simd_dispatch_level()
+            allows it, and give exactly the same results either way.
+        */
+
+        struct column_taps
+        {
+            long row_bytes;
+            int channels;
+
+            // Output byte i is row[offsets[i]]*(1-weights[i]) + row[offsets[i]+channels]*weights[i]
+            std::vector<int32> offsets;
+            std::vector<float> weights;
+
+            // For the AVX2 kernel: each group of 8 output bytes only needs the 16 input
+            // bytes starting at block_base[k], and block_shuffle holds the 16 byte shuffle
+            // that picks the 8 left bytes followed by the 8 right bytes out of them.  Only
+            // the first block_base.size() groups qualify.
+            std::vector<int32> block_base;
+            std::vector<unsigned char> block_shuffle;
+        };
+
+        void setup_column_taps (
+            column_taps& taps,
+            long in_nc,
+            long out_nc,
+            int channels
+        );
+        /*
+            requires
+                - in_nc >= 2
+                - out_nc >= 2
+            ensures
+                - #taps resamples a row of in_nc pixels with the given number of 8 bit
+                  channels to out_nc pixels the way resize_image() does, so that the first
+                  and last pixels line up.  The last output pixel uses the second to last
+                  input pixel with a weight of 1, so every tap has a right neighbor.
+        */
+
+        void interpolate_columns (
+            const column_taps& taps,
+            const unsigned char* row,
+            float* out
+        );
+        /*
+            requires
+                - row points at taps.row_bytes bytes
+                - out points at taps.offsets.size() floats
+            ensures
+                - for all valid i:
+                    - #out[i] == row[taps.offsets[i]]*(1-taps.weights[i]) +
+                                 row[taps.offsets[i]+taps.channels]*taps.weights[i]
+        */
+
+        void interpolate_rows (
+            const float* top,
+            const float* bottom,
+            float bottom_weight,
+            long n,
+            unsigned char* out
+        );
+        /*
+            ensures
+                - for all i in [0,n):
+                    - #out[i] == static_cast<int>(top[i]*(1-bottom_weight) + bottom[i]*bottom_weight)
+        */
+
+    // ------------------------------------------------------------------------------------
+
+    }
+}
+
+#ifdef NO_MAKEFILE
+#include "image_pyramid_kernels.cpp"
+#endif
+
+#endif // DLIB_IMAGE_PYRaMID_KERNELS_Hh_
+
@@ -10,6 +10,7 @@
 #include "image_pyramid.h"
 #include "../simd.h"
 #include "../image_processing/full_object_detection.h"
+#include "interpolation_kernels.h"
 
 namespace dlib
 {
@@ -790,7 +791,15 @@ namespace dlib
             const simd4f _inv_tb_frac = 1-tb_frac;
             const simd4f _x_scale = 4*x_scale;
             simd4f _x(x, x+x_scale, x+2*x_scale, x+3*x_scale);
-            long c = 0;
+
+            // Let the runtime dispatched kernel do as many columns as it can, then carry
+            // on from where it stopped.
+            float lanes[4];
+            _x.store(lanes);
+            long c = impl::dispatch_resize_row(&in_img[top][0], &in_img[bottom][0], in_img.nc(), lanes,
+                                               (float)(4*x_scale), (float)tb_frac, (float)(1-tb_frac),
+                                               &out_img[r][0], out_img.nc());
+            _x.load(lanes);
             for (;; c+=4)
             {
                 _x += _x_scale;
@@ -0,0 +1,121 @@
+// Copyright (C) 2016  Davis E. King (davis@dlib.net)
+// License: Boost Software License   See LICENSE.txt for the full license.
+#ifndef DLIB_INTERPOLATION_KERNELS_CPP_
+#define DLIB_INTERPOLATION_KERNELS_CPP_
+
+#include "interpolation_kernels.h"
+#include "../uintn.h"
+#include <cstring>
+
+#ifdef DLIB_HAVE_CPU_DISPATCH
+#include <immintrin.h>
+#endif
+
+namespace dlib
+{
+    namespace impl
+    {
+
+#ifdef DLIB_HAVE_CPU_DISPATCH
+
+    // ------------------------------------------------------------------------------------
+
+        /*
+            This kernel does two iterations of the simd4f loop at once.  The column
+            positions are advanced one step at a time, exactly like that loop does, and it
+            isn't compiled with FMA, so it computes exactly the same pixels.  A single 32
+            bit gather then gives both the left and right pixel of each position.
+        */
+
+        DLIB_TARGET_AVX2 long resize_row_avx2 (
+            const unsigned char* top,
+            const unsigned char* bottom,
+            long in_nc,
+            float* x,
+            float x_step,
+            float tb_frac,
+            float inv_tb_frac,
+            unsigned char* out,
+            long out_nc
+        )
+        {
+            const __m128 step4 = _mm_set1_ps(x_step);
+            __m128 last = _mm_loadu_ps(x);
+            const __m128 first = _mm_add_ps(last, step4);
+            __m256 pos = _mm256_insertf128_ps(_mm256_castps128_ps256(first), _mm_add_ps(first, step4), 1);
+
+            const __m256 step = _mm256_set1_ps(x_step);
+            const __m256 one = _mm256_set1_ps(1);
+            const __m256 tb = _mm256_set1_ps(tb_frac);
+            const __m256 inv_tb = _mm256_set1_ps(inv_tb_frac);
+            const __m256i byte_mask = _mm256_set1_epi32(0xff);
+
+            long c = 0;
+            for (; c+8 <= out_nc; c += 8)
+            {
+                const __m256i left = _mm256_cvttps_epi32(pos);
+                // The gathers read 4 bytes starting at the left pixel
+                if (_mm256_extract_epi32(left, 7) > in_nc-4)
+                    break;
+
+                const __m256 lr_frac = _mm256_sub_ps(pos, _mm256_cvtepi32_ps(left));
+                const __m256 inv_lr_frac = _mm256_sub_ps(one, lr_frac);
+                const __m256 tlf = _mm256_mul_ps(inv_tb, inv_lr_frac);
+                const __m256 trf = _mm256_mul_ps(inv_tb, lr_frac);
+                const __m256 blf = _mm256_mul_ps(tb, inv_lr_frac);
+                const __m256 brf = _mm256_mul_ps(tb, lr_frac);
+
+                const __m256i t = _mm256_i32gather_epi32((const int*)top, left, 1);
+                const __m256i b = _mm256_i32gather_epi32((const int*)bottom, left, 1);
+                const __m256 tl = _mm256_cvtepi32_ps(_mm256_and_si256(t, byte_mask));
+                const __m256 tr = _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srli_epi32(t, 8), byte_mask));
+                const __m256 bl = _mm256_cvtepi32_ps(_mm256_and_si256(b, byte_mask));
+                const __m256 br = _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srli_epi32(b, 8), byte_mask));
+
+                const __m256 value = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(tlf,tl), _mm256_mul_ps(trf,tr)),
+                                                                 _mm256_mul_ps(blf,bl)), _mm256_mul_ps(brf,br));
+                __m256i pixels = _mm256_cvttps_epi32(value);
+                pixels = _mm256_packus_epi32(pixels, pixels);
+                pixels = _mm256_packus_epi16(pixels, pixels);
+                const int32 lo = _mm_cvtsi128_si32(_mm256_castsi256_si128(pixels));
+                const int32 hi = _mm_cvtsi128_si32(_mm256_extracti128_si256(pixels, 1));
+                std::memcpy(out+c, &lo, 4);
+                std::memcpy(out+c+4, &hi, 4);
+
+                last = _mm256_extractf128_ps(pos, 1);
+                pos = _mm256_add_ps(_mm256_add_ps(pos, step), step);
+            }
+
+            _mm_storeu_ps(x, last);
+            return c;
+        }
+
+    // ------------------------------------------------------------------------------------
+
+#endif // DLIB_HAVE_CPU_DISPATCH
+
+        long dispatch_resize_row (
+            const unsigned char* top,
+            const unsigned char* bottom,
+            long in_nc,
+            float* x,
+            float x_step,
+            float tb_frac,
+            float inv_tb_frac,
+            unsigned char* out,
+            long out_nc
+        )
+        {
+#ifdef DLIB_HAVE_CPU_DISPATCH
+            // This one is bound by the gathers, so AVX-512 hosts use the AVX2 kernel too
+            if (get_simd_dispatch_level() >= CPU_SIMD_AVX2)
+                return resize_row_avx2(top, bottom, in_nc, x, x_step, tb_frac, inv_tb_frac, out, out_nc);
+#endif
+            return 0;
+        }
+
+    }
+}
+
+#endif // DLIB_INTERPOLATION_KERNELS_CPP_
+
@@ -0,0 +1,64 @@
+// Copyright (C) 2016  Davis E. King (davis@dlib.net)
+// License: Boost Software License   See LICENSE.txt for the full license.
+#ifndef DLIB_INTERPOLATION_KERNELS_Hh_
+#define DLIB_INTERPOLATION_KERNELS_Hh_
+
+#include "../simd/cpu_dispatch.h"
+
+namespace dlib
+{
+    namespace impl
+    {
+
+    // ------------------------------------------------------------------------------------
+
+        long dispatch_resize_row (
+            const unsigned char* top,
+            const unsigned char* bottom,
+            long in_nc,
+            float* x,
+            float x_step,
+            float tb_frac,
+            float inv_tb_frac,
+            unsigned char* out,
+            long out_nc
+        );
+        /*
+            requires
+                - top and bottom point at rows of in_nc pixels
+                - x points at the 4 lanes of the column positions used by the simd4f loop
+                  of the grayscale resize_image(), and x_step is the amount they advance
+                  by in each iteration.
+            ensures
+                - Computes the same bilinearly interpolated pixels as that loop, for as
+                  many of the leading columns as the runtime dispatched kernel can do
+                  safely (see get_simd_dispatch_level()), and returns how many that is.
+                  It is always a multiple of 4 and 0 when no kernel applies.
+                - #x is the position the simd4f loop would have reached after those
+                  columns, so it can carry on from there.
+        */
+
+        template <typename pixel_type>
+        inline long dispatch_resize_row (
+            const pixel_type* ,
+            const pixel_type* ,
+            long ,
+            float* ,
+            float ,
+            float ,
+            float ,
+            pixel_type* ,
+            long
+        ) { return 0; }
+
+    // ------------------------------------------------------------------------------------
+
+    }
+}
+
+#ifdef NO_MAKEFILE
+#include "interpolation_kernels.cpp"
+#endif
+
+#endif // DLIB_INTERPOLATION_KERNELS_Hh_
+
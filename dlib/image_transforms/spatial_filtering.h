@@ -11,7 +11,9 @@
 #include "../matrix.h"
 #include "../geometry/border_enumerator.h"
 #include "../simd.h"
+#include "spatial_filtering_kernels.h"
 #include <limits>
+#include <vector>
 
 namespace dlib
 {
@@ -615,10 +617,20 @@ namespace dlib
         image_view<out_image_type> scratch(scratch_);
         scratch.set_size(in_img.nr(), in_img.nc());
 
+        // The runtime dispatched kernels take the filters as plain arrays
+        std::vector<float> row_taps(row_filter.size()), col_taps(col_filter.size());
+        for (long n = 0; n < row_filter.size(); ++n)
+            row_taps[n] = row_filter(n);
+        for (long m = 0; m < col_filter.size(); ++m)
+            col_taps[m] = col_filter(m);
+        std::vector<const float*> col_rows(col_filter.size());
+
         // apply the row filter
         for (long r = 0; r < in_img.nr(); ++r)
         {
             long c = first_col;
+            if (last_col > first_col)
+                c += impl::dispatch_filter_row(&in_img[r][0], &scratch[r][first_col], last_col-first_col, &row_taps[0], row_taps.size());
             for (; c < last_col-7; c+=8)
             {
                 simd8f p,p2,p3, temp = 0, temp2=0, temp3=0;
@@ -660,6 +672,12 @@ namespace dlib
         for (long r = first_row; r < last_row; ++r)
         {
             long c = first_col;
+            if (last_col > first_col)
+            {
+                for (long m = 0; m < col_filter.size(); ++m)
+                    col_rows[m] = &scratch[r-first_row+m][first_col];
+                c += impl::dispatch_filter_column(&col_rows[0], &out_img[r][first_col], last_col-first_col, &col_taps[0], col_taps.size(), add_to);
+            }
             for (; c < last_col-7; c+=8)
             {
                 simd8f p, p2, p3, temp = 0, temp2 = 0, temp3 = 0;
@@ -0,0 +1,188 @@
+// Copyright (C) 2016  Davis E. King (davis@dlib.net)
+// License: Boost Software License   See LICENSE.txt for the full license.
+#ifndef DLIB_SPATIAL_FILTERING_KERNELS_CPP_
+#define DLIB_SPATIAL_FILTERING_KERNELS_CPP_
+
+#include "spatial_filtering_kernels.h"
+
+#ifdef DLIB_HAVE_CPU_DISPATCH
+#include <immintrin.h>
+#endif
+
+namespace dlib
+{
+    namespace impl
+    {
+
+#ifdef DLIB_HAVE_CPU_DISPATCH
+
+    // ------------------------------------------------------------------------------------
+
+        DLIB_TARGET_AVX2_FMA long filter_row_avx2 (
+            const float* in,
+            float* out,
+            long n,
+            const float* filter,
+            long filter_size
+        )
+        {
+            long i = 0;
+            // two vectors of outputs at a time so the FMAs don't wait on each other
+            for (; i+16 <= n; i += 16)
+            {
+                __m256 acc0 = _mm256_setzero_ps();
+                __m256 acc1 = _mm256_setzero_ps();
+                for (long j = 0; j < filter_size; ++j)
+                {
+                    const __m256 tap = _mm256_set1_ps(filter[j]);
+                    acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(in+i+j), tap, acc0);
+                    acc1 = _mm256_fmadd_ps(_mm256_loadu_ps(in+i+j+8), tap, acc1);
+                }
+                _mm256_storeu_ps(out+i, acc0);
+                _mm256_storeu_ps(out+i+8, acc1);
+            }
+            for (; i+8 <= n; i += 8)
+            {
+                __m256 acc = _mm256_setzero_ps();
+                for (long j = 0; j < filter_size; ++j)
+                    acc = _mm256_fmadd_ps(_mm256_loadu_ps(in+i+j), _mm256_set1_ps(filter[j]), acc);
+                _mm256_storeu_ps(out+i, acc);
+            }
+            return i;
+        }
+
+        DLIB_TARGET_AVX2_FMA long filter_column_avx2 (
+            const float* const* rows,
+            float* out,
+            long i,
+            long n,
+            const float* filter,
+            long filter_size,
+            bool add_to
+        )
+        {
+            // starts at output i, so the AVX-512 kernel can hand over the last few
+            for (; i+16 <= n; i += 16)
+            {
+                __m256 acc0 = add_to ? _mm256_loadu_ps(out+i) : _mm256_setzero_ps();
+                __m256 acc1 = add_to ? _mm256_loadu_ps(out+i+8) : _mm256_setzero_ps();
+                for (long j = 0; j < filter_size; ++j)
+                {
+                    const __m256 tap = _mm256_set1_ps(filter[j]);
+                    acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(rows[j]+i), tap, acc0);
+                    acc1 = _mm256_fmadd_ps(_mm256_loadu_ps(rows[j]+i+8), tap, acc1);
+                }
+                _mm256_storeu_ps(out+i, acc0);
+                _mm256_storeu_ps(out+i+8, acc1);
+            }
+            for (; i+8 <= n; i += 8)
+            {
+                __m256 acc = add_to ? _mm256_loadu_ps(out+i) : _mm256_setzero_ps();
+                for (long j = 0; j < filter_size; ++j)
+                    acc = _mm256_fmadd_ps(_mm256_loadu_ps(rows[j]+i), _mm256_set1_ps(filter[j]), acc);
+                _mm256_storeu_ps(out+i, acc);
+            }
+            return i;
+        }
+
+    // ------------------------------------------------------------------------------------
+
+        DLIB_TARGET_AVX512 long filter_row_avx512 (
+            const float* in,
+            float* out,
+            long n,
+            const float* filter,
+            long filter_size
+        )
+        {
+            long i = 0;
+            for (; i+32 <= n; i += 32)
+            {
+                __m512 acc0 = _mm512_setzero_ps();
+                __m512 acc1 = _mm512_setzero_ps();
+                for (long j = 0; j < filter_size; ++j)
+                {
+                    const __m512 tap = _mm512_set1_ps(filter[j]);
+                    acc0 = _mm512_fmadd_ps(_mm512_loadu_ps(in+i+j), tap, acc0);
+                    acc1 = _mm512_fmadd_ps(_mm512_loadu_ps(in+i+j+16), tap, acc1);
+                }
+                _mm512_storeu_ps(out+i, acc0);
+                _mm512_storeu_ps(out+i+16, acc1);
+            }
+            return i + filter_row_avx2(in+i, out+i, n-i, filter, filter_size);
+        }
+
+        DLIB_TARGET_AVX512 long filter_column_avx512 (
+            const float* const* rows,
+            float* out,
+            long n,
+            const float* filter,
+            long filter_size,
+            bool add_to
+        )
+        {
+            long i = 0;
+            for (; i+32 <= n; i += 32)
+            {
+                __m512 acc0 = add_to ? _mm512_loadu_ps(out+i) : _mm512_setzero_ps();
+                __m512 acc1 = add_to ? _mm512_loadu_ps(out+i+16) : _mm512_setzero_ps();
+                for (long j = 0; j < filter_size; ++j)
+                {
+                    const __m512 tap = _mm512_set1_ps(filter[j]);
+                    acc0 = _mm512_fmadd_ps(_mm512_loadu_ps(rows[j]+i), tap, acc0);
+                    acc1 = _mm512_fmadd_ps(_mm512_loadu_ps(rows[j]+i+16), tap, acc1);
+                }
+                _mm512_storeu_ps(out+i, acc0);
+                _mm512_storeu_ps(out+i+16, acc1);
+            }
+            return filter_column_avx2(rows, out, i, n, filter, filter_size, add_to);
+        }
+
+    // ------------------------------------------------------------------------------------
+
+#endif // DLIB_HAVE_CPU_DISPATCH
+
+        long dispatch_filter_row (
+            const float* in,
+            float* out,
+            long n,
+            const float* filter,
+            long filter_size
+        )
+        {
+#ifdef DLIB_HAVE_CPU_DISPATCH
+            switch (get_simd_dispatch_level())
+            {
+                case CPU_SIMD_AVX512: return filter_row_avx512(in, out, n, filter, filter_size);
+                case CPU_SIMD_AVX2: return filter_row_avx2(in, out, n, filter, filter_size);
+                default: break;
+            }
+#endif
+            return 0;
+        }
+
+        long dispatch_filter_column (
+            const float* const* rows,
+            float* out,
+            long n,
+            const float* filter,
+            long filter_size,
+            bool add_to
+        )
+        {
+#ifdef DLIB_HAVE_CPU_DISPATCH
+            switch (get_simd_dispatch_level())
+            {
+                case CPU_SIMD_AVX512: return filter_column_avx512(rows, out, n, filter, filter_size, add_to);
+                case CPU_SIMD_AVX2: return filter_column_avx2(rows, out, 0, n, filter, filter_size, add_to);
+                default: break;
+            }
+#endif
+            return 0;
+        }
+
+    }
+}
+
+#endif // DLIB_SPATIAL_FILTERING_KERNELS_CPP_
+
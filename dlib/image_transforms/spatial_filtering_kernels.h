@@ -0,0 +1,67 @@
+// Copyright (C) 2016  Davis E. King (davis@dlib.net)
+// License: Boost Software License   See LICENSE.txt for the full license.
+#ifndef DLIB_SPATIAL_FILTERING_KERNELS_Hh_
+#define DLIB_SPATIAL_FILTERING_KERNELS_Hh_
+
+#include "../simd/cpu_dispatch.h"
+
+namespace dlib
+{
+    namespace impl
+    {
+
+    // ------------------------------------------------------------------------------------
+
+        /*
+            The two passes of float_spatially_filter_image_separable() have AVX2 (with
+            FMA) and AVX-512 versions, which are picked at runtime based on
+            get_simd_dispatch_level().  Each returns how many of the n outputs it
+            computed, a multiple of its vector width, and 0 when no kernel applies.  The
+            caller computes the rest with its regular code path.
+        */
+
+        long dispatch_filter_row (
+            const float* in,
+            float* out,
+            long n,
+            const float* filter,
+            long filter_size
+        );
+        /*
+            requires
+                - in[0] through in[n+filter_size-2] are readable
+            ensures
+                - for the first k outputs (where k is the returned value):
+                    - out[i] == sum over j of in[i+j]*filter[j]
+        */
+
+        long dispatch_filter_column (
+            const float* const* rows,
+            float* out,
+            long n,
+            const float* filter,
+            long filter_size,
+            bool add_to
+        );
+        /*
+            requires
+                - rows contains filter_size pointers to rows of at least n floats
+            ensures
+                - for the first k outputs (where k is the returned value):
+                    - if (add_to) then
+                        - out[i] += sum over j of rows[j][i]*filter[j]
+                    - else
+                        - out[i] == sum over j of rows[j][i]*filter[j]
+        */
+
+    // ------------------------------------------------------------------------------------
+
+    }
+}
+
+#ifdef NO_MAKEFILE
+#include "spatial_filtering_kernels.cpp"
+#endif
+
+#endif // DLIB_SPATIAL_FILTERING_KERNELS_Hh_
+
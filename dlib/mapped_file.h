@@ -0,0 +1,9 @@
+// Copyright (C) 2016  Davis E. King (davis@dlib.net)
+// License: Boost Software License   See LICENSE.txt for the full license.
+#ifndef DLIB_MAPPED_FiLE_
+#define DLIB_MAPPED_FiLE_
+
+#include "mapped_file/mapped_file.h"
+
+#endif // DLIB_MAPPED_FiLE_
+
@@ -0,0 +1,147 @@
+// Copyright (C) 2016  Davis E. King (davis@dlib.net)
+// License: Boost Software License   See LICENSE.txt for the full license.
+#ifndef DLIB_MAPPED_FILE_CPp_
+#define DLIB_MAPPED_FILE_CPp_
+
+#include "mapped_file.h"
+
+#ifdef WIN32
+#include "../windows_magic.h"
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace dlib
+{
+
+// ----------------------------------------------------------------------------------------
+
+#ifdef WIN32
+
+    void mapped_file::
+    open (
+        const std::string& filename
+    )
+    {
+        close();
+
+        HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL,
+                                  OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+        if (file == INVALID_HANDLE_VALUE)
+            throw mapped_file_error("Unable to open file " + filename);
+
+        LARGE_INTEGER length;
+        if (!GetFileSizeEx(file, &length))
+        {
+            CloseHandle(file);
+            throw mapped_file_error("Unable to get the size of file " + filename);
+        }
+
+        if (length.QuadPart != 0)
+        {
+            // The mapping keeps its own reference to the file, so the file handle isn't
+            // needed once it exists.
+            HANDLE mapping = CreateFileMapping(file, NULL, PAGE_READONLY, 0, 0, NULL);
+            CloseHandle(file);
+            if (mapping == NULL)
+                throw mapped_file_error("Unable to map file " + filename);
+
+            const void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+            if (view == NULL)
+            {
+                CloseHandle(mapping);
+                throw mapped_file_error("Unable to map file " + filename);
+            }
+            mapping_handle = mapping;
+            file_data = static_cast<const unsigned char*>(view);
+        }
+        else
+        {
+            CloseHandle(file);
+        }
+
+        file_size = length.QuadPart;
+        is_mapped = true;
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    void mapped_file::
+    close (
+    )
+    {
+        if (file_data)
+            UnmapViewOfFile(file_data);
+        if (mapping_handle)
+            CloseHandle(mapping_handle);
+
+        file_data = 0;
+        file_size = 0;
+        is_mapped = false;
+        mapping_handle = 0;
+    }
+
+#else // POSIX
+
+    void mapped_file::
+    open (
+        const std::string& filename
+    )
+    {
+        close();
+
+        const int fd = ::open(filename.c_str(), O_RDONLY);
+        if (fd == -1)
+            throw mapped_file_error("Unable to open file " + filename);
+
+        struct stat info;
+        if (fstat(fd, &info) != 0)
+        {
+            ::close(fd);
+            throw mapped_file_error("Unable to get the size of file " + filename);
+        }
+
+        if (info.st_size != 0)
+        {
+            // The mapping stays valid after the descriptor is closed.
+            void* view = mmap(0, info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+            ::close(fd);
+            if (view == MAP_FAILED)
+                throw mapped_file_error("Unable to map file " + filename);
+            file_data = static_cast<const unsigned char*>(view);
+        }
+        else
+        {
+            ::close(fd);
+        }
+
+        file_size = info.st_size;
+        is_mapped = true;
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    void mapped_file::
+    close (
+    )
+    {
+        if (file_data)
+            munmap(const_cast<unsigned char*>(file_data), file_size);
+
+        file_data = 0;
+        file_size = 0;
+        is_mapped = false;
+    }
+
+#endif // WIN32
+
+// ----------------------------------------------------------------------------------------
+
+}
+
+#endif // DLIB_MAPPED_FILE_CPp_
+
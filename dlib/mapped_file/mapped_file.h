@@ -0,0 +1,102 @@
+// Copyright (C) 2016  Davis E. King (davis@dlib.net)
+// License: Boost Software License   See LICENSE.txt for the full license.
+#ifndef DLIB_MAPPED_FILE_Hh_
+#define DLIB_MAPPED_FILE_Hh_
+
+#ifdef DLIB_ISO_CPP_ONLY
+#error "DLIB_ISO_CPP_ONLY is defined so you can't use this OS dependent code.  Turn DLIB_ISO_CPP_ONLY off if you want to use it."
+#endif
+
+#include "mapped_file_abstract.h"
+#include "../platform.h"
+#include "../algs.h"
+#include "../uintn.h"
+#include "../error.h"
+#include <string>
+
+namespace dlib
+{
+
+// ----------------------------------------------------------------------------------------
+
+    class mapped_file_error : public error
+    {
+    public:
+        mapped_file_error(
+            const std::string& message
+        ) : error(message) {}
+    };
+
+// ----------------------------------------------------------------------------------------
+
+    class mapped_file : noncopyable
+    {
+    public:
+
+        mapped_file (
+        ) : file_data(0), file_size(0), is_mapped(false), mapping_handle(0) {}
+
+        explicit mapped_file (
+            const std::string& filename
+        ) : file_data(0), file_size(0), is_mapped(false), mapping_handle(0)
+        {
+            open(filename);
+        }
+
+        ~mapped_file (
+        )
+        {
+            close();
+        }
+
+        void open (
+            const std::string& filename
+        );
+
+        void close (
+        );
+
+        bool is_open (
+        ) const { return is_mapped; }
+
+        const unsigned char* data (
+        ) const { return file_data; }
+
+        uint64 size (
+        ) const { return file_size; }
+
+        void swap (
+            mapped_file& item
+        )
+        {
+            exchange(file_data, item.file_data);
+            exchange(file_size, item.file_size);
+            exchange(is_mapped, item.is_mapped);
+            exchange(mapping_handle, item.mapping_handle);
+        }
+
+    private:
+
+        const unsigned char* file_data;
+        uint64 file_size;
+        bool is_mapped;
+
+        // The file mapping object on windows.  Not used on POSIX systems.
+        void* mapping_handle;
+    };
+
+    inline void swap (
+        mapped_file& a,
+        mapped_file& b
+    ) { a.swap(b); }
+
+// ----------------------------------------------------------------------------------------
+
+}
+
+#ifdef NO_MAKEFILE
+#include "mapped_file.cpp"
+#endif
+
+#endif // DLIB_MAPPED_FILE_Hh_
+
@@ -0,0 +1,136 @@
+// Copyright (C) 2016  Davis E. King (davis@dlib.net)
+// License: Boost Software License   See LICENSE.txt for the full license.
+#undef DLIB_MAPPED_FILE_ABSTRACT_Hh_
+#ifdef DLIB_MAPPED_FILE_ABSTRACT_Hh_
+
+#include <string>
+#include "../uintn.h"
+#include "../error.h"
+
+namespace dlib
+{
+
+// ----------------------------------------------------------------------------------------
+
+    class mapped_file_error : public error
+    {
+        /*!
+            WHAT THIS OBJECT REPRESENTS
+                This is the exception thrown by mapped_file when a file can't be opened
+                or mapped into memory.
+        !*/
+    };
+
+// ----------------------------------------------------------------------------------------
+
+    class mapped_file : noncopyable
+    {
+        /*!
+            INITIAL VALUE
+                - is_open() == false
+
+            WHAT THIS OBJECT REPRESENTS
+                This object maps the contents of a file into memory, read only.  The
+                operating system pages the file in as it is touched and can drop those
+                pages again when memory gets tight, so large files can be read without
+                holding them in RAM.
+        !*/
+
+    public:
+
+        mapped_file (
+        );
+        /*!
+            ensures
+                - this object is properly initialized
+        !*/
+
+        explicit mapped_file (
+            const std::string& filename
+        );
+        /*!
+            ensures
+                - performs: open(filename)
+            throws
+                - mapped_file_error
+        !*/
+
+        ~mapped_file (
+        );
+        /*!
+            ensures
+                - performs: close()
+        !*/
+
+        void open (
+            const std::string& filename
+        );
+        /*!
+            ensures
+                - closes any file currently mapped by this object and then maps the
+                  contents of the given file into memory.
+                - #is_open() == true
+                - #size() == the size of the file in bytes
+                - #data() == a pointer to the contents of the file, or 0 if the file is
+                  empty.
+            throws
+                - mapped_file_error
+                    This exception is thrown if the file can't be opened or mapped.  If
+                    it is thrown then #is_open() == false.
+        !*/
+
+        void close (
+        );
+        /*!
+            ensures
+                - unmaps the file.  Any pointers returned by data() become invalid.
+                - #is_open() == false
+                - #size() == 0
+                - #data() == 0
+        !*/
+
+        bool is_open (
+        ) const;
+        /*!
+            ensures
+                - returns true if this object currently maps a file and false otherwise.
+        !*/
+
+        const unsigned char* data (
+        ) const;
+        /*!
+            ensures
+                - returns a pointer to the first byte of the mapped file, or 0 when no
+                  file, or an empty file, is mapped.
+        !*/
+
+        uint64 size (
+        ) const;
+        /*!
+            ensures
+                - returns the number of bytes in the mapped file.
+        !*/
+
+        void swap (
+            mapped_file& item
+        );
+        /*!
+            ensures
+                - swaps the state of *this and item
+        !*/
+    };
+
+    inline void swap (
+        mapped_file& a,
+        mapped_file& b
+    ) { a.swap(b); }
+    /*!
+        provides a global swap function
+    !*/
+
+// ----------------------------------------------------------------------------------------
+
+}
+
+#endif // DLIB_MAPPED_FILE_ABSTRACT_Hh_
+
@@ -8,6 +8,7 @@
 #include "../matrix.h"
 #include "optimization_solve_qp_using_smo.h"
 #include <vector>
+#include <algorithm>
 #include "../sequence.h"
 
 // ----------------------------------------------------------------------------------------
@@ -49,6 +50,106 @@ namespace dlib
 
     };
 
+// ----------------------------------------------------------------------------------------
+
+    template <typename matrix_type>
+    struct oca_state
+    {
+        typedef typename matrix_type::type scalar_type;
+        typedef typename matrix_type::layout_type layout_type;
+        typedef typename matrix_type::mem_manager_type mem_manager_type;
+
+        oca_state() : cp_obj(0), num_iterations(0) {}
+
+        bool empty (
+        ) const { return planes.size() == 0; }
+
+        void clear (
+        )
+        {
+            oca_state item;
+            swap(item);
+        }
+
+        void swap (
+            oca_state& item
+        )
+        {
+            w.swap(item.w);
+            planes.swap(item.planes);
+            bs.swap(item.bs);
+            miss_count.swap(item.miss_count);
+            alpha.swap(item.alpha);
+            K.swap(item.K);
+            std::swap(cp_obj, item.cp_obj);
+            std::swap(num_iterations, item.num_iterations);
+        }
+
+        matrix_type w;
+        std::vector<matrix_type> planes;
+        std::vector<scalar_type> bs;
+        std::vector<scalar_type> miss_count;
+        matrix_type alpha;
+        matrix<scalar_type,0,0,mem_manager_type,layout_type> K;
+        scalar_type cp_obj;
+        unsigned long num_iterations;
+    };
+
+    template <typename matrix_type>
+    void swap (
+        oca_state<matrix_type>& a,
+        oca_state<matrix_type>& b
+    ) { a.swap(b); }
+
+    template <typename matrix_type>
+    void serialize (
+        const oca_state<matrix_type>& item,
+        std::ostream& out
+    )
+    {
+        int version = 1;
+        serialize(version, out);
+        serialize(item.w, out);
+        serialize(item.planes, out);
+        serialize(item.bs, out);
+        serialize(item.miss_count, out);
+        serialize(item.alpha, out);
+        serialize(item.K, out);
+        serialize(item.cp_obj, out);
+        serialize(item.num_iterations, out);
+    }
+
+    template <typename matrix_type>
+    void deserialize (
+        oca_state<matrix_type>& item,
+        std::istream& in
+    )
+    {
+        int version = 0;
+        deserialize(version, in);
+        if (version != 1)
+            throw serialization_error("Unexpected version encountered while deserializing dlib::oca_state.");
+        deserialize(item.w, in);
+        deserialize(item.planes, in);
+        deserialize(item.bs, in);
+        deserialize(item.miss_count, in);
+        deserialize(item.alpha, in);
+        deserialize(item.K, in);
+        deserialize(item.cp_obj, in);
+        deserialize(item.num_iterations, in);
+
+        const unsigned long num_planes = item.planes.size();
+        if (item.bs.size() != num_planes || item.miss_count.size() != num_planes ||
+            (unsigned long)item.alpha.size() != num_planes ||
+            (unsigned long)item.K.nr() != num_planes || (unsigned long)item.K.nc() != num_planes)
+            throw serialization_error("Inconsistent working set encountered while deserializing dlib::oca_state.");
+        for (unsigned long i = 0; i < num_planes; ++i)
+        {
+            if (item.planes[i].size() != item.w.size())
+                throw serialization_error("Inconsistent working set encountered while deserializing dlib::oca_state.");
+        }
+    }
+
 // ----------------------------------------------------------------------------------------
 
     class oca
@@ -61,6 +162,7 @@ namespace dlib
             sub_max_iter = 50000;
 
             inactive_thresh = 20;
+            max_planes = 0;
         }
 
         void set_subproblem_epsilon (
@@ -106,6 +208,24 @@ namespace dlib
         unsigned long get_inactive_plane_threshold (
         ) const { return inactive_thresh; }
 
+        void set_max_num_planes (
+            unsigned long max_planes_
+        )
+        {
+            // make sure requires clause is not broken
+            DLIB_ASSERT(max_planes_ == 0 || max_planes_ >= 2,
+                "\t void oca::set_max_num_planes"
+                << "\n\t max_planes_ must be 0 or at least 2"
+                << "\n\t max_planes_: " << max_planes_
+                << "\n\t this: " << this
+                );
+
+            max_planes = max_planes_;
+        }
+
+        unsigned long get_max_num_planes (
+        ) const { return max_planes; }
+
         template <
             typename matrix_type
             >
@@ -120,6 +240,32 @@ namespace dlib
             return oca_impl(problem, w, empty_prior, false, num_nonnegative, force_weight_to_1, 0);
         }
 
+        template <
+            typename matrix_type
+            >
+        typename matrix_type::type operator() (
+            const oca_problem<matrix_type>& problem,
+            matrix_type& w,
+            oca_state<matrix_type>& state,
+            unsigned long num_nonnegative = 0,
+            unsigned long force_weight_to_1 = std::numeric_limits<unsigned long>::max()
+        ) const
+        {
+            // make sure requires clause is not broken
+            DLIB_ASSERT(state.empty() ||
+                        (is_col_vector(state.w) && state.w.size() == problem.get_num_dimensions()),
+                "\t scalar_type oca::operator()"
+                << "\n\t The state to resume from does not have the correct dimensions."
+                << "\n\t state.empty():                " << state.empty()
+                << "\n\t state.w.size():               " << state.w.size()
+                << "\n\t problem.get_num_dimensions(): " << problem.get_num_dimensions()
+                << "\n\t this:                         " << this
+                );
+
+            matrix_type empty_prior;
+            return oca_impl(problem, w, empty_prior, false, num_nonnegative, force_weight_to_1, 0, &state);
+        }
+
         template <
             typename matrix_type
             >
@@ -160,6 +306,98 @@ namespace dlib
 
     private:
 
+        template <
+            typename vect_type,
+            typename planes_type,
+            typename scalar_type,
+            typename K_type
+            >
+        static void bound_working_set (
+            planes_type& planes,
+            std::vector<scalar_type>& bs,
+            std::vector<scalar_type>& miss_count,
+            K_type& K,
+            vect_type& alpha,
+            vect_type& temp,
+            const unsigned long num_planes
+        ) 
+        /*!
+            ensures
+                - reduces the set of cutting planes to num_planes planes without changing
+                  the solution of the subproblem.  Inactive planes (alpha == 0, which is
+                  when miss_count > 0) are dropped first, the longest inactive first.  If
+                  that isn't enough, the least active planes are replaced by their alpha
+                  weighted average, with the sum of their alphas as its alpha.  A convex
+                  combination of cutting planes is also a lower bound on the risk and it
+                  gives the same w, so the subproblem keeps its optimal value.
+        !*/
+        {
+            while (planes.size() > num_planes && max(mat(miss_count)) > 0)
+            {
+                const long idx = index_of_max(mat(miss_count));
+                bs.erase(bs.begin()+idx);
+                miss_count.erase(miss_count.begin()+idx);
+                K = removerc(K, idx, idx);
+                alpha = remove_row(alpha,idx);
+                planes.remove(idx, temp);
+            }
+
+            if (planes.size() <= num_planes)
+                return;
+
+            // Merge the planes with the smallest alphas into one.
+            const unsigned long num_merged = planes.size() - num_planes + 1;
+            std::vector<std::pair<scalar_type,long> > order;
+            for (long i = 0; i < alpha.size(); ++i)
+                order.push_back(std::make_pair(alpha(i), i));
+            std::sort(order.begin(), order.end());
+
+            std::vector<long> merged;
+            scalar_type total_alpha = 0;
+            for (unsigned long i = 0; i < num_merged; ++i)
+            {
+                merged.push_back(order[i].second);
+                total_alpha += order[i].first;
+            }
+            std::sort(merged.begin(), merged.end());
+
+            matrix<scalar_type,0,1> weights(alpha.size());
+            weights = 0;
+            for (unsigned long i = 0; i < merged.size(); ++i)
+                weights(merged[i]) = alpha(merged[i])/total_alpha;
+
+            vect_type merged_plane = weights(merged[0])*planes[merged[0]];
+            for (unsigned long i = 1; i < merged.size(); ++i)
+                merged_plane += weights(merged[i])*planes[merged[i]];
+            const scalar_type merged_b = dot(weights, mat(bs));
+            matrix<scalar_type,0,1> merged_K = K*weights;
+            const scalar_type merged_K_self = dot(weights, merged_K);
+
+            for (long i = merged.size()-1; i >= 0; --i)
+            {
+                const long idx = merged[i];
+                bs.erase(bs.begin()+idx);
+                miss_count.erase(miss_count.begin()+idx);
+                K = removerc(K, idx, idx);
+                merged_K = remove_row(merged_K, idx);
+                alpha = remove_row(alpha,idx);
+                planes.remove(idx, temp);
+            }
+
+            bs.push_back(merged_b);
+            miss_count.push_back(0);
+            alpha = join_cols(alpha, uniform_matrix<scalar_type>(1,1,total_alpha));
+            planes.add(planes.size(), merged_plane);
+
+            K_type Ktmp;
+            K.swap(Ktmp);
+            K.set_size(planes.size(), planes.size());
+            set_subm(K, 0,0, Ktmp.nr(), Ktmp.nc()) = Ktmp;
+            set_subm(K, 0,Ktmp.nc(), Ktmp.nr(), 1) = merged_K;
+            set_subm(K, Ktmp.nr(),0, 1, Ktmp.nc()) = trans(merged_K);
+            K(Ktmp.nr(), Ktmp.nc()) = merged_K_self;
+        }
+
         template <
             typename matrix_type
             >
@@ -170,7 +408,8 @@ namespace dlib
             bool have_prior,
             unsigned long num_nonnegative,
             unsigned long force_weight_to_1,
-            const double lasso_lambda
+            const double lasso_lambda,
+            oca_state<matrix_type>* state = 0
         ) const
         {
             const unsigned long num_dims = problem.get_num_dimensions();
@@ -232,8 +471,27 @@ namespace dlib
                 d.set_size(num_nonnegative);
             d = lasso_lambda*ones_matrix(d);
 
+            unsigned long counter = 0;
+
             scalar_type R_lower_bound;
-            if (problem.risk_has_lower_bound(R_lower_bound))
+            if (state && !state->empty())
+            {
+                // Pick up where the run that saved the state left off.  Its lower bounding
+                // plane, if it had one, is already in the working set.
+                w = state->w;
+                for (unsigned long i = 0; i < state->planes.size(); ++i)
+                {
+                    new_plane = state->planes[i];
+                    planes.add(i, new_plane);
+                }
+                bs = state->bs;
+                miss_count = state->miss_count;
+                alpha = state->alpha;
+                K = state->K;
+                cp_obj = state->cp_obj;
+                counter = state->num_iterations;
+            }
+            else if (problem.risk_has_lower_bound(R_lower_bound))
             {
                 // The flat lower bounding plane is always good to have if we know
                 // what it is.
@@ -249,7 +507,6 @@ namespace dlib
 
             const double prior_norm = have_prior ?  0.5*dot(prior,prior) : 0;
 
-            unsigned long counter = 0;
             while (true)
             {
 
@@ -349,10 +606,17 @@ namespace dlib
                     solve_qp_using_smo(K, mat(bs), alpha, eps, sub_max_iter); 
                 }
 
-                // construct the w that minimized the subproblem.
-                w = -alpha(0)*planes[0];
-                for (unsigned long i = 1; i < planes.size(); ++i)
-                    w -= alpha(i)*planes[i];
+                // construct the w that minimized the subproblem.  Only the planes with a
+                // non-zero alpha contribute to it.
+                long first = 0;
+                while (alpha(first) == 0)
+                    ++first;
+                w = -alpha(first)*planes[first];
+                for (unsigned long i = first+1; i < planes.size(); ++i)
+                {
+                    if (alpha(i) != 0)
+                        w -= alpha(i)*planes[i];
+                }
                 if (lasso_lambda != 0)
                     w = (lambda-d+w)/ridge_lambda;
                 else if (num_nonnegative != 0) // threshold the first num_nonnegative w elements if necessary.
@@ -384,7 +648,28 @@ namespace dlib
                     planes.remove(idx, new_plane);
                 }
 
+                // Keep the subproblem from growing past max_planes once the next plane is
+                // added.
+                if (max_planes != 0 && planes.size() >= max_planes)
+                    bound_working_set(planes, bs, miss_count, K, alpha, new_plane, max_planes-1);
+
                 ++counter;
+
+                if (state)
+                {
+                    // Record the working set so a later call can resume from this
+                    // iteration.
+                    state->w = w;
+                    state->planes.resize(planes.size());
+                    for (unsigned long i = 0; i < planes.size(); ++i)
+                        state->planes[i] = planes[i];
+                    state->bs = bs;
+                    state->miss_count = miss_count;
+                    state->alpha = alpha;
+                    state->K = K;
+                    state->cp_obj = cp_obj;
+                    state->num_iterations = counter;
+                }
             }
 
             if (force_weight_to_1 < (unsigned long)w.size())
@@ -398,6 +683,8 @@ namespace dlib
         unsigned long sub_max_iter;
 
         unsigned long inactive_thresh;
+
+        unsigned long max_planes;
     };
 }
 
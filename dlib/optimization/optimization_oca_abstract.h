@@ -122,6 +122,97 @@ namespace dlib
 
     };
 
+// ----------------------------------------------------------------------------------------
+
+    template <typename matrix_type>
+    struct oca_state
+    {
+        /*!
+            REQUIREMENTS ON matrix_type
+                - matrix_type == a dlib::matrix capable of storing column vectors
+
+            WHAT THIS OBJECT REPRESENTS
+                This object is a snapshot of the oca optimizer in the middle of solving an
+                oca_problem.  It holds the current solution, the cutting planes in the
+                quadratic programming subproblem along with their offsets, dual variables
+                and kernel matrix, and the lower bound on the objective they give.  Since
+                it is serializable, a long running optimization can be saved to disk and
+                resumed later, possibly in another process.
+
+                The fields are filled in by oca and are meant to be treated as opaque.
+        !*/
+
+        typedef typename matrix_type::type scalar_type;
+
+        oca_state(
+        );
+        /*!
+            ensures
+                - #empty() == true
+                - #num_iterations == 0
+        !*/
+
+        bool empty (
+        ) const;
+        /*!
+            ensures
+                - returns true if this object holds no cutting planes, in which case oca
+                  starts a fresh optimization when given this object.
+        !*/
+
+        void clear (
+        );
+        /*!
+            ensures
+                - this object has its initial value
+        !*/
+
+        void swap (
+            oca_state& item
+        );
+        /*!
+            ensures
+                - swaps *this and item
+        !*/
+
+        matrix_type w;
+        std::vector<matrix_type> planes;
+        std::vector<scalar_type> bs;
+        std::vector<scalar_type> miss_count;
+        matrix_type alpha;
+        matrix<scalar_type> K;
+        scalar_type cp_obj;
+        unsigned long num_iterations;
+    };
+
+    template <typename matrix_type>
+    void swap (
+        oca_state<matrix_type>& a,
+        oca_state<matrix_type>& b
+    ) { a.swap(b); }
+    /*!
+        provides a global swap function
+    !*/
+
+    template <typename matrix_type>
+    void serialize (
+        const oca_state<matrix_type>& item,
+        std::ostream& out
+    );
+    /*!
+        provides serialization support
+    !*/
+
+    template <typename matrix_type>
+    void deserialize (
+        oca_state<matrix_type>& item,
+        std::istream& in
+    );
+    /*!
+        provides deserialization support.  Throws serialization_error if the stream
+        doesn't hold a consistent oca_state.
+    !*/
+
 // ----------------------------------------------------------------------------------------
 
     class oca
@@ -131,6 +222,7 @@ namespace dlib
                 - get_subproblem_epsilon() == 1e-2
                 - get_subproblem_max_iterations() == 50000
                 - get_inactive_plane_threshold() == 20
+                - get_max_num_planes() == 0
 
             WHAT THIS OBJECT REPRESENTS
                 This object is a tool for solving the optimization problem defined above
@@ -211,6 +303,42 @@ namespace dlib
                           values of 0.
         !*/
 
+        template <
+            typename matrix_type
+            >
+        typename matrix_type::type operator() (
+            const oca_problem<matrix_type>& problem,
+            matrix_type& w,
+            oca_state<matrix_type>& state,
+            unsigned long num_nonnegative = 0,
+            unsigned long force_weight_to_1 = std::numeric_limits<unsigned long>::max()
+        ) const;
+        /*!
+            requires
+                - problem.get_c() > 0
+                - problem.get_num_dimensions() > 0
+                - state.empty() == true, or state was filled in by an earlier call to this
+                  function on a problem with the same dimensions, C, num_nonnegative and
+                  force_weight_to_1.
+            ensures
+                - solves the given oca problem exactly like the operator() above, but also
+                  records the solver's working set in state after every iteration.  That
+                  is, when problem.optimization_status() is called for iteration i, state
+                  holds the solver as it was at the start of iteration i, and
+                  state.num_iterations == i.
+                - if (state.empty() == false) then
+                    - the optimization resumes from state instead of starting at w == 0.
+                      If state was saved from a run of this same problem, and the problem
+                      keeps no state of its own between iterations, the resumed run goes
+                      through exactly the iterations the original run would have gone
+                      through from that point.  If the problem changed in the
+                      meantime (e.g. there is more training data), the saved cutting
+                      planes may no longer be lower bounds on the new risk, so it is a
+                      warm start rather than an exact resume.
+                - #state holds the working set of the last iteration that completed.
+                - returns the objective value at the solution #w
+        !*/
+
         template <
             typename matrix_type
             >
@@ -324,6 +452,33 @@ namespace dlib
                   inactivity required before a cutting plane is removed.
         !*/
 
+        void set_max_num_planes (
+            unsigned long max_planes
+        );
+        /*!
+            requires
+                - max_planes == 0 || max_planes >= 2
+            ensures
+                - #get_max_num_planes() == max_planes
+        !*/
+
+        unsigned long get_max_num_planes (
+        ) const;
+        /*!
+            ensures
+                - returns the largest number of cutting planes OCA keeps in the quadratic
+                  programming subproblem it solves at each iteration.  0 means there is
+                  no limit, so the planes are only removed once they have been inactive
+                  for get_inactive_plane_threshold() iterations.
+                - When there is a limit, OCA first drops the planes that are inactive,
+                  and if there are still too many, replaces the least active planes by
+                  their weighted average.  That average is still a valid cutting plane
+                  and the current solution doesn't change, so OCA still converges to the
+                  same optimum.  But each iteration stays cheap when many iterations are
+                  needed, e.g. for high dimensional problems or small epsilons, in
+                  exchange for possibly needing a few more iterations.
+        !*/
+
     };
 }
 
@@ -0,0 +1,126 @@
+// Copyright (C) 2016  Davis E. King (davis@dlib.net)
+// License: Boost Software License   See LICENSE.txt for the full license.
+#ifndef DLIB_CPU_DISPATCh_CPP_
+#define DLIB_CPU_DISPATCh_CPP_
+
+#include "cpu_dispatch.h"
+#include "simd_check.h"
+#include <atomic>
+
+#if defined(DLIB_HAVE_CPU_DISPATCH) && defined(_MSC_VER)
+#include <intrin.h>
+#include <immintrin.h>
+#endif
+
+namespace dlib
+{
+
+// ----------------------------------------------------------------------------------------
+
+    namespace impl_cpu_dispatch
+    {
+        inline cpu_simd_level query_cpu (
+        )
+        {
+#if defined(DLIB_HAVE_CPU_DISPATCH) && defined(_MSC_VER)
+            int info[4];
+            __cpuid(info, 0);
+            if (info[0] < 7)
+                return CPU_SIMD_BASELINE;
+
+            __cpuid(info, 1);
+            const bool fma = (info[2] & (1<<12)) != 0;
+            const bool osxsave = (info[2] & (1<<27)) != 0;
+            if (!fma || !osxsave)
+                return CPU_SIMD_BASELINE;
+
+            // The OS has to save the ymm (and for AVX-512 the zmm and mask) registers
+            const unsigned long long xcr0 = _xgetbv(0);
+            if ((xcr0 & 0x6) != 0x6)
+                return CPU_SIMD_BASELINE;
+
+            __cpuidex(info, 7, 0);
+            if ((info[1] & (1<<5)) == 0)
+                return CPU_SIMD_BASELINE;
+            if ((info[1] & (1<<16)) != 0 && (xcr0 & 0xe6) == 0xe6)
+                return CPU_SIMD_AVX512;
+            return CPU_SIMD_AVX2;
+#elif defined(DLIB_HAVE_CPU_DISPATCH)
+            // These also check the OS saves the wider registers
+            __builtin_cpu_init();
+            if (!__builtin_cpu_supports("avx2") || !__builtin_cpu_supports("fma"))
+                return CPU_SIMD_BASELINE;
+            if (__builtin_cpu_supports("avx512f"))
+                return CPU_SIMD_AVX512;
+            return CPU_SIMD_AVX2;
+#else
+            return CPU_SIMD_BASELINE;
+#endif
+        }
+
+        inline std::atomic<int>& max_dispatch_level (
+        )
+        {
+            static std::atomic<int> level(CPU_SIMD_AVX512);
+            return level;
+        }
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    cpu_simd_level get_cpu_simd_level (
+    )
+    {
+        static const cpu_simd_level level = impl_cpu_dispatch::query_cpu();
+        return level;
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    cpu_simd_level get_simd_dispatch_level (
+    )
+    {
+        const int cap = impl_cpu_dispatch::max_dispatch_level().load(std::memory_order_relaxed);
+        const cpu_simd_level level = get_cpu_simd_level();
+        return level < cap ? level : static_cast<cpu_simd_level>(cap);
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    void set_max_simd_dispatch_level (
+        cpu_simd_level level
+    )
+    {
+        impl_cpu_dispatch::max_dispatch_level().store(level, std::memory_order_relaxed);
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    const char* simd_level_name (
+        cpu_simd_level level
+    )
+    {
+        switch (level)
+        {
+            case CPU_SIMD_AVX512: return "avx512";
+            case CPU_SIMD_AVX2: return "avx2";
+            default: break;
+        }
+
+#if defined(DLIB_HAVE_AVX)
+        return "avx";
+#elif defined(DLIB_HAVE_SSE41)
+        return "sse4";
+#elif defined(DLIB_HAVE_SSE2)
+        return "sse2";
+#else
+        return "none";
+#endif
+    }
+
+// ----------------------------------------------------------------------------------------
+
+}
+
+#endif // DLIB_CPU_DISPATCh_CPP_
+
@@ -0,0 +1,62 @@
+// Copyright (C) 2016  Davis E. King (davis@dlib.net)
+// License: Boost Software License   See LICENSE.txt for the full license.
+#ifndef DLIB_CPU_DISPATCh_Hh_
+#define DLIB_CPU_DISPATCh_Hh_
+
+#include "cpu_dispatch_abstract.h"
+
+// Kernels that are compiled for a specific instruction set, regardless of the flags the
+// rest of dlib is compiled with, are only possible when the compiler lets us target an
+// instruction set function by function.
+#if !defined(DLIB_DO_NOT_USE_SIMD) && !defined(DLIB_NO_CPU_DISPATCH)
+    #if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+        #define DLIB_HAVE_CPU_DISPATCH
+        #define DLIB_TARGET_AVX2 __attribute__((target("avx2")))
+        #define DLIB_TARGET_AVX2_FMA __attribute__((target("avx2,fma")))
+        #define DLIB_TARGET_AVX512 __attribute__((target("avx2,fma,avx512f")))
+    #elif defined(_MSC_VER) && _MSC_VER >= 1900 && defined(_M_X64)
+        #define DLIB_HAVE_CPU_DISPATCH
+        #define DLIB_TARGET_AVX2
+        #define DLIB_TARGET_AVX2_FMA
+        #define DLIB_TARGET_AVX512
+    #endif
+#endif
+
+namespace dlib
+{
+
+// ----------------------------------------------------------------------------------------
+
+    enum cpu_simd_level
+    {
+        CPU_SIMD_BASELINE = 0,
+        CPU_SIMD_AVX2 = 1,
+        CPU_SIMD_AVX512 = 2
+    };
+
+// ----------------------------------------------------------------------------------------
+
+    cpu_simd_level get_cpu_simd_level (
+    );
+
+    cpu_simd_level get_simd_dispatch_level (
+    );
+
+    void set_max_simd_dispatch_level (
+        cpu_simd_level level
+    );
+
+    const char* simd_level_name (
+        cpu_simd_level level
+    );
+
+// ----------------------------------------------------------------------------------------
+
+}
+
+#ifdef NO_MAKEFILE
+#include "cpu_dispatch.cpp"
+#endif
+
+#endif // DLIB_CPU_DISPATCh_Hh_
+
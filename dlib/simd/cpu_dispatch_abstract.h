@@ -0,0 +1,78 @@
+// Copyright (C) 2016  Davis E. King (davis@dlib.net)
+// License: Boost Software License   See LICENSE.txt for the full license.
+#undef DLIB_CPU_DISPATCh_ABSTRACT_Hh_
+#ifdef DLIB_CPU_DISPATCh_ABSTRACT_Hh_
+
+namespace dlib
+{
+
+// ----------------------------------------------------------------------------------------
+
+    enum cpu_simd_level
+    {
+        /*!
+            WHAT THIS OBJECT REPRESENTS
+                This enum lists the instruction sets dlib has runtime dispatched kernels
+                for.  CPU_SIMD_BASELINE means the regular code paths, i.e. whatever the
+                compiler flags dlib was built with allow (see dlib/simd/simd_check.h).
+                The other levels are kernels compiled for that instruction set no matter
+                what the compiler flags are, and they are only ever run on a CPU that
+                supports them.  This way a single build of dlib uses AVX2 or AVX-512 on
+                the machines that have it while still running everywhere else.
+        !*/
+
+        CPU_SIMD_BASELINE = 0,
+        CPU_SIMD_AVX2 = 1,   // AVX2 and FMA
+        CPU_SIMD_AVX512 = 2  // AVX-512F, AVX2 and FMA
+    };
+
+// ----------------------------------------------------------------------------------------
+
+    cpu_simd_level get_cpu_simd_level (
+    );
+    /*!
+        ensures
+            - returns the best instruction set this CPU and this build of dlib both
+              support.  That is, if dlib was built with a compiler that can't target
+              individual functions at AVX2 or AVX-512 (or on a non-x86 platform, or with
+              DLIB_DO_NOT_USE_SIMD or DLIB_NO_CPU_DISPATCH defined) this function always
+              returns CPU_SIMD_BASELINE.
+            - The CPU is only queried once, so calling this function is cheap.
+    !*/
+
+    cpu_simd_level get_simd_dispatch_level (
+    );
+    /*!
+        ensures
+            - returns the instruction set the runtime dispatched kernels use.  This is
+              get_cpu_simd_level() unless it was capped by set_max_simd_dispatch_level().
+    !*/
+
+    void set_max_simd_dispatch_level (
+        cpu_simd_level level
+    );
+    /*!
+        ensures
+            - #get_simd_dispatch_level() == min(get_cpu_simd_level(), level)
+            - This setting is global to the process.  It is useful for comparing kernels
+              against each other, or for falling back to the baseline code paths.  It is
+              safe to call this function while other threads are running kernels, but
+              those calls might use either setting.
+    !*/
+
+    const char* simd_level_name (
+        cpu_simd_level level
+    );
+    /*!
+        ensures
+            - returns a short name for the given level: "avx2" or "avx512".  For
+              CPU_SIMD_BASELINE it returns the instruction set the baseline code paths
+              were compiled for, i.e. one of "avx", "sse4", "sse2" or "none".
+    !*/
+
+// ----------------------------------------------------------------------------------------
+
+}
+
+#endif // DLIB_CPU_DISPATCh_ABSTRACT_Hh_
+
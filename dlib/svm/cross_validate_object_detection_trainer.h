@@ -15,6 +15,8 @@
 namespace dlib
 {
 
+    template <typename image_scanner_type> class prepared_object_detection_dataset;
+
 // ----------------------------------------------------------------------------------------
 
     namespace impl
@@ -83,6 +85,59 @@ namespace dlib
             return count;
         }
 
+    // ------------------------------------------------------------------------------------
+
+        inline const matrix<double,1,3> detection_accuracy (
+            const double correct_hits,
+            const double total_true_targets,
+            std::vector<std::pair<double,bool> >& all_dets,
+            const unsigned long missing_detections
+        )
+        /*!
+            ensures
+                - returns the precision, recall, and average precision of the detections
+                  gathered by number_of_truth_hits().
+        !*/
+        {
+            std::sort(all_dets.rbegin(), all_dets.rend());
+
+            double precision, recall;
+
+            double total_hits = all_dets.size();
+
+            if (total_hits == 0)
+                precision = 1;
+            else
+                precision = correct_hits / total_hits;
+
+            if (total_true_targets == 0)
+                recall = 1;
+            else
+                recall = correct_hits / total_true_targets;
+
+            matrix<double, 1, 3> res;
+            res = precision, recall, average_precision(all_dets, missing_detections);
+            return res;
+        }
+
+        template <
+            typename object_detector_type,
+            typename image_scanner_type
+            >
+        void detect_in_loaded_scanner (
+            const object_detector_type& detector,
+            const image_scanner_type& loaded_scanner,
+            std::vector<std::pair<double,rectangle> >& hits,
+            const double adjust_threshold
+        )
+        {
+            std::vector<typename object_detector_type::rect_detection> dets;
+            detector.detect(loaded_scanner, dets, adjust_threshold);
+            hits.resize(dets.size());
+            for (unsigned long i = 0; i < dets.size(); ++i)
+                hits[i] = std::make_pair(dets[i].detection_confidence, dets[i].rect);
+        }
+
     // ------------------------------------------------------------------------------------
 
     }
@@ -130,25 +185,7 @@ namespace dlib
             total_true_targets += truth_dets[i].size();
         }
 
-        std::sort(all_dets.rbegin(), all_dets.rend());
-
-        double precision, recall;
-
-        double total_hits = all_dets.size();
-
-        if (total_hits == 0)
-            precision = 1;
-        else
-            precision = correct_hits / total_hits;
-
-        if (total_true_targets == 0)
-            recall = 1;
-        else
-            recall = correct_hits / total_true_targets;
-
-        matrix<double, 1, 3> res;
-        res = precision, recall, average_precision(all_dets, missing_detections);
-        return res;
+        return impl::detection_accuracy(correct_hits, total_true_targets, all_dets, missing_detections);
     }
 
     template <
@@ -209,6 +246,36 @@ namespace dlib
         return test_object_detection_function(detector,images,truth_dets,ignore, overlap_tester, adjust_threshold);
     }
 
+    template <
+        typename object_detector_type,
+        typename image_scanner_type
+        >
+    const matrix<double,1,3> test_object_detection_function (
+        const object_detector_type& detector,
+        const prepared_object_detection_dataset<image_scanner_type>& dataset,
+        const test_box_overlap& overlap_tester = test_box_overlap(),
+        const double adjust_threshold = 0
+    )
+    {
+        double correct_hits = 0;
+        double total_true_targets = 0;
+
+        std::vector<std::pair<double,bool> > all_dets;
+        unsigned long missing_detections = 0;
+
+        for (unsigned long i = 0; i < dataset.size(); ++i)
+        {
+            std::vector<std::pair<double,rectangle> > hits; 
+            impl::detect_in_loaded_scanner(detector, dataset[i], hits, adjust_threshold);
+
+            correct_hits += impl::number_of_truth_hits(dataset.get_truth_object_detections()[i], dataset.get_ignore()[i],
+                                                       hits, overlap_tester, all_dets, missing_detections);
+            total_true_targets += dataset.get_truth_object_detections()[i].size();
+        }
+
+        return impl::detection_accuracy(correct_hits, total_true_targets, all_dets, missing_detections);
+    }
+
 // ----------------------------------------------------------------------------------------
 // ----------------------------------------------------------------------------------------
 // ----------------------------------------------------------------------------------------
@@ -326,26 +393,7 @@ namespace dlib
 
         }
 
-        std::sort(all_dets.rbegin(), all_dets.rend());
-
-
-        double precision, recall;
-
-        double total_hits = all_dets.size();
-
-        if (total_hits == 0)
-            precision = 1;
-        else
-            precision = correct_hits / total_hits;
-
-        if (total_true_targets == 0)
-            recall = 1;
-        else
-            recall = correct_hits / total_true_targets;
-
-        matrix<double, 1, 3> res;
-        res = precision, recall, average_precision(all_dets, missing_detections);
-        return res;
+        return impl::detection_accuracy(correct_hits, total_true_targets, all_dets, missing_detections);
     }
 
     template <
@@ -375,6 +423,66 @@ namespace dlib
         return cross_validate_object_detection_trainer(trainer, images, dets, ignore, folds, overlap_tester, adjust_threshold);
     }
 
+    template <
+        typename trainer_type,
+        typename image_scanner_type
+        >
+    const matrix<double,1,3> cross_validate_object_detection_trainer (
+        const trainer_type& trainer,
+        const prepared_object_detection_dataset<image_scanner_type>& dataset,
+        const long folds,
+        const test_box_overlap& overlap_tester = test_box_overlap(),
+        const double adjust_threshold = 0
+    )
+    {
+        // make sure requires clause is not broken
+        DLIB_CASSERT( 1 < folds && folds <= static_cast<long>(dataset.size()),
+                    "\t matrix cross_validate_object_detection_trainer()"
+                    << "\n\t invalid inputs were given to this function"
+                    << "\n\t folds: "<< folds
+                    << "\n\t dataset.size(): " << dataset.size() 
+                    );
+
+        double correct_hits = 0;
+        double total_true_targets = 0;
+
+        const long test_size = dataset.size()/folds;
+
+        std::vector<std::pair<double,bool> > all_dets;
+        unsigned long missing_detections = 0;
+        unsigned long test_idx = 0;
+        for (long iter = 0; iter < folds; ++iter)
+        {
+            std::vector<unsigned long> train_idx_set;
+            std::vector<unsigned long> test_idx_set;
+
+            for (long i = 0; i < test_size; ++i)
+                test_idx_set.push_back(test_idx++);
+
+            unsigned long train_idx = test_idx%dataset.size();
+            for (unsigned long i = 0; i < dataset.size()-test_size; ++i)
+            {
+                train_idx_set.push_back(train_idx);
+                train_idx = (train_idx+1)%dataset.size();
+            }
+
+            // The folds are views of the dataset, so no image is loaded again.
+            typename trainer_type::trained_function_type detector = trainer.train(dataset.subset(train_idx_set), overlap_tester);
+            for (unsigned long i = 0; i < test_idx_set.size(); ++i)
+            {
+                const unsigned long idx = test_idx_set[i];
+                std::vector<std::pair<double,rectangle> > hits; 
+                impl::detect_in_loaded_scanner(detector, dataset[idx], hits, adjust_threshold);
+
+                correct_hits += impl::number_of_truth_hits(dataset.get_truth_object_detections()[idx], dataset.get_ignore()[idx],
+                                                           hits, overlap_tester, all_dets, missing_detections);
+                total_true_targets += dataset.get_truth_object_detections()[idx].size();
+            }
+        }
+
+        return impl::detection_accuracy(correct_hits, total_true_targets, all_dets, missing_detections);
+    }
+
     template <
         typename trainer_type,
         typename image_array_type
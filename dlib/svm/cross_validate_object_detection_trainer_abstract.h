@@ -7,6 +7,7 @@
 #include "../matrix.h"
 #include "../geometry.h"
 #include "../image_processing/full_object_detection_abstract.h"
+#include "prepared_object_detection_dataset_abstract.h"
 
 namespace dlib
 {
@@ -130,6 +131,27 @@ namespace dlib
               given arguments and an empty set of ignore rectangles and returns the results.
     !*/
 
+    template <
+        typename object_detector_type,
+        typename image_scanner_type
+        >
+    const matrix<double,1,3> test_object_detection_function (
+        const object_detector_type& detector,
+        const prepared_object_detection_dataset<image_scanner_type>& dataset,
+        const test_box_overlap& overlap_tester = test_box_overlap(),
+        const double adjust_threshold = 0
+    );
+    /*!
+        requires
+            - object_detector_type == some kind of object_detector whose scanner has the
+              same configuration as dataset.get_scanner().
+        ensures
+            - This function is identical to the first test_object_detection_function()
+              above, called with the images, truth boxes and ignore boxes the dataset was
+              prepared from, except that it runs the detector over the scanners the
+              dataset already loaded (see object_detector::detect()).
+    !*/
+
 // ----------------------------------------------------------------------------------------
 // ----------------------------------------------------------------------------------------
 // ----------------------------------------------------------------------------------------
@@ -228,6 +250,31 @@ namespace dlib
               the given arguments and an empty set of ignore rectangles and returns the results.
     !*/
 
+    template <
+        typename trainer_type,
+        typename image_scanner_type
+        >
+    const matrix<double,1,3> cross_validate_object_detection_trainer (
+        const trainer_type& trainer,
+        const prepared_object_detection_dataset<image_scanner_type>& dataset,
+        const long folds,
+        const test_box_overlap& overlap_tester = test_box_overlap(),
+        const double adjust_threshold = 0
+    );
+    /*!
+        requires
+            - trainer_type == some kind of structural_object_detection_trainer whose
+              scanner has the same configuration as dataset.get_scanner().
+            - 1 < folds <= dataset.size()
+        ensures
+            - This function is identical to the first cross_validate_object_detection_trainer()
+              above, called with the images, truth boxes and ignore boxes the dataset
+              was prepared from.  However, the folds are made with dataset.subset(), so
+              they share the dataset's loaded scanners and no image is loaded again.
+              Cross validating several trainers, e.g. with different values of C, on
+              one dataset therefore only loads the images once.
+    !*/
+
 // ----------------------------------------------------------------------------------------
 
 }
@@ -0,0 +1,255 @@
+// Copyright (C) 2016  Davis E. King (davis@dlib.net)
+// License: Boost Software License   See LICENSE.txt for the full license.
+#ifndef DLIB_PREPARED_OBJECT_DETECTION_DATASET_Hh_
+#define DLIB_PREPARED_OBJECT_DETECTION_DATASET_Hh_
+
+#include "prepared_object_detection_dataset_abstract.h"
+#include "svm.h"
+#include "../array.h"
+#include "../smart_pointers_thread_safe.h"
+#include "../threads/parallel_for_extension.h"
+#include "../image_processing/full_object_detection.h"
+#include <vector>
+
+namespace dlib
+{
+
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename image_scanner_type
+        >
+    class prepared_object_detection_dataset
+    {
+    public:
+
+        prepared_object_detection_dataset (
+        ) : scanner(new image_scanner_type), scanners(new array<image_scanner_type>) {}
+
+        template <
+            typename image_array_type
+            >
+        prepared_object_detection_dataset (
+            const image_scanner_type& scanner_,
+            const image_array_type& images,
+            const std::vector<std::vector<full_object_detection> >& truth_object_detections_,
+            const std::vector<std::vector<rectangle> >& ignore_,
+            unsigned long num_threads = 2
+        )
+        {
+            load(scanner_, images, truth_object_detections_, ignore_, num_threads);
+        }
+
+        template <
+            typename image_array_type
+            >
+        prepared_object_detection_dataset (
+            const image_scanner_type& scanner_,
+            const image_array_type& images,
+            const std::vector<std::vector<rectangle> >& truth_object_detections_,
+            const std::vector<std::vector<rectangle> >& ignore_,
+            unsigned long num_threads = 2
+        )
+        {
+            load(scanner_, images, to_full_object_detections(truth_object_detections_), ignore_, num_threads);
+        }
+
+        prepared_object_detection_dataset (
+            const image_scanner_type& scanner_,
+            array<image_scanner_type>& loaded_scanners,
+            const std::vector<std::vector<full_object_detection> >& truth_object_detections_,
+            const std::vector<std::vector<rectangle> >& ignore_
+        )
+        {
+            take_scanners(scanner_, loaded_scanners, truth_object_detections_, ignore_);
+        }
+
+        prepared_object_detection_dataset (
+            const image_scanner_type& scanner_,
+            array<image_scanner_type>& loaded_scanners,
+            const std::vector<std::vector<rectangle> >& truth_object_detections_,
+            const std::vector<std::vector<rectangle> >& ignore_
+        )
+        {
+            take_scanners(scanner_, loaded_scanners, to_full_object_detections(truth_object_detections_), ignore_);
+        }
+
+        unsigned long size (
+        ) const { return idx.size(); }
+
+        const image_scanner_type& operator[] (
+            unsigned long i
+        ) const
+        {
+            // make sure requires clause is not broken
+            DLIB_ASSERT(i < size(),
+                "\t const image_scanner_type& prepared_object_detection_dataset::operator[]()"
+                << "\n\t Invalid inputs were given to this function "
+                << "\n\t i:      " << i
+                << "\n\t size(): " << size()
+                << "\n\t this:   " << this
+                );
+
+            return (*scanners)[idx[i]];
+        }
+
+        const image_scanner_type& get_scanner (
+        ) const { return *scanner; }
+
+        const std::vector<std::vector<full_object_detection> >& get_truth_object_detections (
+        ) const { return truth_object_detections; }
+
+        const std::vector<std::vector<rectangle> >& get_ignore (
+        ) const { return ignore; }
+
+        prepared_object_detection_dataset subset (
+            const std::vector<unsigned long>& samples
+        ) const
+        {
+            prepared_object_detection_dataset temp;
+            temp.scanner = scanner;
+            temp.scanners = scanners;
+            for (unsigned long i = 0; i < samples.size(); ++i)
+            {
+                // make sure requires clause is not broken
+                DLIB_ASSERT(samples[i] < size(),
+                    "\t prepared_object_detection_dataset prepared_object_detection_dataset::subset()"
+                    << "\n\t Invalid inputs were given to this function "
+                    << "\n\t samples["<<i<<"]: " << samples[i]
+                    << "\n\t size():      " << size()
+                    << "\n\t this:        " << this
+                    );
+
+                temp.idx.push_back(idx[samples[i]]);
+                temp.truth_object_detections.push_back(truth_object_detections[samples[i]]);
+                temp.ignore.push_back(ignore[samples[i]]);
+            }
+            return temp;
+        }
+
+    private:
+
+        static std::vector<std::vector<full_object_detection> > to_full_object_detections (
+            const std::vector<std::vector<rectangle> >& rects
+        )
+        {
+            std::vector<std::vector<full_object_detection> > truth_dets(rects.size());
+            for (unsigned long i = 0; i < rects.size(); ++i)
+            {
+                for (unsigned long j = 0; j < rects[i].size(); ++j)
+                {
+                    truth_dets[i].push_back(full_object_detection(rects[i][j]));
+                }
+            }
+            return truth_dets;
+        }
+
+        template <
+            typename image_array_type
+            >
+        struct load_scanners_helper
+        {
+            load_scanners_helper (
+                array<image_scanner_type>& scanners_,
+                const image_array_type& images_
+            ) :
+                scanners(scanners_),
+                images(images_)
+            {}
+
+            array<image_scanner_type>& scanners;
+            const image_array_type& images;
+
+            void operator() (long i ) const
+            {
+                scanners[i].load(images[i]);
+            }
+        };
+
+        template <
+            typename image_array_type
+            >
+        void load (
+            const image_scanner_type& scanner_,
+            const image_array_type& images,
+            const std::vector<std::vector<full_object_detection> >& truth_object_detections_,
+            const std::vector<std::vector<rectangle> >& ignore_,
+            unsigned long num_threads
+        )
+        {
+            // make sure requires clause is not broken
+            DLIB_ASSERT(is_learning_problem(images, truth_object_detections_) &&
+                        ignore_.size() == images.size(),
+                "\t prepared_object_detection_dataset::prepared_object_detection_dataset()"
+                << "\n\t Invalid inputs were given to this function "
+                << "\n\t is_learning_problem(images,truth_object_detections): " << is_learning_problem(images,truth_object_detections_)
+                << "\n\t ignore.size(): " << ignore_.size()
+                << "\n\t images.size(): " << images.size()
+                << "\n\t this: " << this
+                );
+
+            scanner.reset(new image_scanner_type);
+            scanner->copy_configuration(scanner_);
+
+            scanners.reset(new array<image_scanner_type>);
+            scanners->set_max_size(images.size());
+            scanners->set_size(images.size());
+            for (unsigned long i = 0; i < scanners->size(); ++i)
+                (*scanners)[i].copy_configuration(scanner_);
+
+            // now load the images into all the scanners
+            parallel_for(num_threads, 0, scanners->size(), load_scanners_helper<image_array_type>(*scanners, images));
+
+            idx.resize(images.size());
+            for (unsigned long i = 0; i < idx.size(); ++i)
+                idx[i] = i;
+            truth_object_detections = truth_object_detections_;
+            ignore = ignore_;
+        }
+
+        void take_scanners (
+            const image_scanner_type& scanner_,
+            array<image_scanner_type>& loaded_scanners,
+            const std::vector<std::vector<full_object_detection> >& truth_object_detections_,
+            const std::vector<std::vector<rectangle> >& ignore_
+        )
+        {
+            // make sure requires clause is not broken
+            DLIB_ASSERT(loaded_scanners.size() == truth_object_detections_.size() &&
+                        ignore_.size() == truth_object_detections_.size(),
+                "\t prepared_object_detection_dataset::prepared_object_detection_dataset()"
+                << "\n\t Invalid inputs were given to this function "
+                << "\n\t loaded_scanners.size(): " << loaded_scanners.size()
+                << "\n\t truth_object_detections.size(): " << truth_object_detections_.size()
+                << "\n\t ignore.size(): " << ignore_.size()
+                << "\n\t this: " << this
+                );
+
+            scanner.reset(new image_scanner_type);
+            scanner->copy_configuration(scanner_);
+
+            scanners.reset(new array<image_scanner_type>);
+            scanners->swap(loaded_scanners);
+            loaded_scanners.clear();
+
+            idx.resize(scanners->size());
+            for (unsigned long i = 0; i < idx.size(); ++i)
+                idx[i] = i;
+            truth_object_detections = truth_object_detections_;
+            ignore = ignore_;
+        }
+
+        // The scanners are never modified once loaded, so copies and subsets share them.
+        shared_ptr_thread_safe<image_scanner_type> scanner;
+        shared_ptr_thread_safe<array<image_scanner_type> > scanners;
+        std::vector<unsigned long> idx;
+        std::vector<std::vector<full_object_detection> > truth_object_detections;
+        std::vector<std::vector<rectangle> > ignore;
+    };
+
+// ----------------------------------------------------------------------------------------
+
+}
+
+#endif // DLIB_PREPARED_OBJECT_DETECTION_DATASET_Hh_
+
@@ -0,0 +1,216 @@
+// Copyright (C) 2016  Davis E. King (davis@dlib.net)
+// License: Boost Software License   See LICENSE.txt for the full license.
+#undef DLIB_PREPARED_OBJECT_DETECTION_DATASET_ABSTRACT_Hh_
+#ifdef DLIB_PREPARED_OBJECT_DETECTION_DATASET_ABSTRACT_Hh_
+
+#include "svm_abstract.h"
+#include "../array/array_kernel_abstract.h"
+#include "../image_processing/full_object_detection_abstract.h"
+#include <vector>
+
+namespace dlib
+{
+
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename image_scanner_type
+        >
+    class prepared_object_detection_dataset
+    {
+        /*!
+            REQUIREMENTS ON image_scanner_type
+                image_scanner_type must be an implementation of
+                dlib/image_processing/scan_fhog_pyramid_abstract.h or
+                dlib/image_processing/scan_image_custom_abstract.h or
+                dlib/image_processing/scan_image_pyramid_abstract.h or
+                dlib/image_processing/scan_image_boxes_abstract.h
+
+            INITIAL VALUE
+                - size() == 0
+
+            WHAT THIS OBJECT REPRESENTS
+                This object holds an object detection training set with every image
+                already loaded into its own image scanner, along with the truth and
+                ignore boxes of each image.  Loading the scanners (e.g. computing the
+                fHOG pyramids) is usually the most expensive part of setting up a
+                structural_svm_object_detection_problem, so preparing the data once and
+                handing it to structural_object_detection_trainer::train(),
+                cross_validate_object_detection_trainer() and
+                test_object_detection_function() avoids repeating that work when the
+                same data is trained on many times, e.g. to try different values of C.
+
+                Copies, and the datasets returned by subset(), share the loaded
+                scanners, so they are cheap to make.
+
+            THREAD SAFETY
+                The loaded scanners are never modified, so any number of threads can use
+                one prepared_object_detection_dataset, or copies of it, at once.
+        !*/
+
+    public:
+
+        prepared_object_detection_dataset (
+        );
+        /*!
+            ensures
+                - this object is properly initialized
+        !*/
+
+        template <
+            typename image_array_type
+            >
+        prepared_object_detection_dataset (
+            const image_scanner_type& scanner,
+            const image_array_type& images,
+            const std::vector<std::vector<full_object_detection> >& truth_object_detections,
+            const std::vector<std::vector<rectangle> >& ignore,
+            unsigned long num_threads = 2
+        );
+        /*!
+            requires
+                - is_learning_problem(images, truth_object_detections)
+                - ignore.size() == images.size()
+                - scanner.load(images[0]) must be a valid expression.
+            ensures
+                - #size() == images.size()
+                - for all valid i:
+                    - (*this)[i] == a scanner with the configuration of scanner that has
+                      been loaded with images[i].
+                - #get_scanner() == a scanner with the configuration of scanner.
+                - #get_truth_object_detections() == truth_object_detections
+                - #get_ignore() == ignore
+                - Uses num_threads threads to load the images.
+        !*/
+
+        template <
+            typename image_array_type
+            >
+        prepared_object_detection_dataset (
+            const image_scanner_type& scanner,
+            const image_array_type& images,
+            const std::vector<std::vector<rectangle> >& truth_object_detections,
+            const std::vector<std::vector<rectangle> >& ignore,
+            unsigned long num_threads = 2
+        );
+        /*!
+            requires
+                - is_learning_problem(images, truth_object_detections)
+                - ignore.size() == images.size()
+                - scanner.load(images[0]) must be a valid expression.
+                - scanner.get_num_movable_components_per_detection_template() == 0
+            ensures
+                - This constructor is identical to the one above except that it takes
+                  rectangles instead of full_object_detections.
+        !*/
+
+        prepared_object_detection_dataset (
+            const image_scanner_type& scanner,
+            array<image_scanner_type>& loaded_scanners,
+            const std::vector<std::vector<full_object_detection> >& truth_object_detections,
+            const std::vector<std::vector<rectangle> >& ignore
+        );
+        /*!
+            requires
+                - loaded_scanners.size() == truth_object_detections.size()
+                - ignore.size() == truth_object_detections.size()
+                - for all valid i:
+                    - loaded_scanners[i] has the configuration of scanner and has been
+                      loaded with the i-th training image.
+            ensures
+                - Builds the dataset out of scanners the caller loaded itself, e.g. to
+                  decode the images on other threads while the scanners are loaded.
+                - #size() == truth_object_detections.size()
+                - for all valid i:
+                    - (*this)[i] == the scanner that was in loaded_scanners[i]
+                - #loaded_scanners.size() == 0
+                  (i.e. the scanners are moved into this object, not copied)
+                - #get_scanner() == a scanner with the configuration of scanner.
+                - #get_truth_object_detections() == truth_object_detections
+                - #get_ignore() == ignore
+        !*/
+
+        prepared_object_detection_dataset (
+            const image_scanner_type& scanner,
+            array<image_scanner_type>& loaded_scanners,
+            const std::vector<std::vector<rectangle> >& truth_object_detections,
+            const std::vector<std::vector<rectangle> >& ignore
+        );
+        /*!
+            requires
+                - loaded_scanners.size() == truth_object_detections.size()
+                - ignore.size() == truth_object_detections.size()
+                - for all valid i:
+                    - loaded_scanners[i] has the configuration of scanner and has been
+                      loaded with the i-th training image.
+                - scanner.get_num_movable_components_per_detection_template() == 0
+            ensures
+                - This constructor is identical to the one above except that it takes
+                  rectangles instead of full_object_detections.
+        !*/
+
+        unsigned long size (
+        ) const;
+        /*!
+            ensures
+                - returns the number of images in this dataset.
+        !*/
+
+        const image_scanner_type& operator[] (
+            unsigned long i
+        ) const;
+        /*!
+            requires
+                - i < size()
+            ensures
+                - returns the scanner loaded with the i-th image of this dataset.
+        !*/
+
+        const image_scanner_type& get_scanner (
+        ) const;
+        /*!
+            ensures
+                - returns an unloaded scanner with the configuration the images were
+                  loaded with.
+        !*/
+
+        const std::vector<std::vector<full_object_detection> >& get_truth_object_detections (
+        ) const;
+        /*!
+            ensures
+                - returns the truth boxes of each image.  The returned vector has size()
+                  elements.
+        !*/
+
+        const std::vector<std::vector<rectangle> >& get_ignore (
+        ) const;
+        /*!
+            ensures
+                - returns the ignore boxes of each image.  The returned vector has size()
+                  elements.
+        !*/
+
+        prepared_object_detection_dataset subset (
+            const std::vector<unsigned long>& samples
+        ) const;
+        /*!
+            requires
+                - for all valid i:
+                    - samples[i] < size()
+            ensures
+                - returns a dataset D, sharing the loaded scanners of this one, such that:
+                    - D.size() == samples.size()
+                    - for all valid i:
+                        - &D[i] == &(*this)[samples[i]]
+                        - D.get_truth_object_detections()[i] == get_truth_object_detections()[samples[i]]
+                        - D.get_ignore()[i] == get_ignore()[samples[i]]
+                - This is how the folds of a cross validation are made.
+        !*/
+    };
+
+// ----------------------------------------------------------------------------------------
+
+}
+
+#endif // DLIB_PREPARED_OBJECT_DETECTION_DATASET_ABSTRACT_Hh_
+
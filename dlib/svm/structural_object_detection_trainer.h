@@ -314,8 +314,55 @@ namespace dlib
             return train_impl(images, truth_dets, ignore, ignore_overlap_tester);
         }
 
+        const trained_function_type train (
+            const prepared_object_detection_dataset<image_scanner_type>& dataset,
+            const test_box_overlap& ignore_overlap_tester = test_box_overlap()
+        ) const
+        {
+            // make sure requires clause is not broken
+            DLIB_ASSERT(dataset.size() > 0 &&
+                        dataset.get_scanner().get_num_dimensions() == get_scanner().get_num_dimensions(),
+                "\t trained_function_type structural_object_detection_trainer::train()"
+                << "\n\t invalid inputs were given to this function"
+                << "\n\t dataset.size(): " << dataset.size()
+                << "\n\t dataset.get_scanner().get_num_dimensions(): " << dataset.get_scanner().get_num_dimensions()
+                << "\n\t get_scanner().get_num_dimensions():         " << get_scanner().get_num_dimensions()
+                );
+
+            structural_svm_object_detection_problem<image_scanner_type,prepared_object_detection_dataset<image_scanner_type> > 
+                svm_prob(overlap_tester, auto_overlap_tester, dataset, ignore_overlap_tester, num_threads);
+
+            return solve(svm_prob);
+        }
+
     private:
 
+        template <
+            typename svm_struct_prob_type
+            >
+        const trained_function_type solve (
+            svm_struct_prob_type& svm_prob
+        ) const
+        {
+            if (verbose)
+                svm_prob.be_verbose();
+
+            svm_prob.set_c(C);
+            svm_prob.set_epsilon(eps);
+            svm_prob.set_max_cache_size(max_cache_size);
+            svm_prob.set_match_eps(match_eps);
+            svm_prob.set_loss_per_missed_target(loss_per_missed_target);
+            svm_prob.set_loss_per_false_alarm(loss_per_false_alarm);
+            configure_nuclear_norm_regularizer(scanner, svm_prob);
+            matrix<double,0,1> w;
+
+            // Run the optimizer to find the optimal w.
+            solver(svm_prob,w);
+
+            // report the results of the training.
+            return object_detector<image_scanner_type>(scanner, svm_prob.get_overlap_tester(), w);
+        }
+
         template <
             typename image_array_type
             >
@@ -358,23 +405,7 @@ namespace dlib
                 svm_prob(scanner, overlap_tester, auto_overlap_tester, images,
                     truth_object_detections, ignore, ignore_overlap_tester, num_threads);
 
-            if (verbose)
-                svm_prob.be_verbose();
-
-            svm_prob.set_c(C);
-            svm_prob.set_epsilon(eps);
-            svm_prob.set_max_cache_size(max_cache_size);
-            svm_prob.set_match_eps(match_eps);
-            svm_prob.set_loss_per_missed_target(loss_per_missed_target);
-            svm_prob.set_loss_per_false_alarm(loss_per_false_alarm);
-            configure_nuclear_norm_regularizer(scanner, svm_prob);
-            matrix<double,0,1> w;
-
-            // Run the optimizer to find the optimal w.
-            solver(svm_prob,w);
-
-            // report the results of the training.
-            return object_detector<image_scanner_type>(scanner, svm_prob.get_overlap_tester(), w);
+            return solve(svm_prob);
         }
 
         image_scanner_type scanner;
@@ -4,6 +4,7 @@
 #ifdef DLIB_STRUCTURAL_OBJECT_DETECTION_TRAiNER_H_ABSTRACTh_
 
 #include "structural_svm_object_detection_problem_abstract.h"
+#include "prepared_object_detection_dataset_abstract.h"
 #include "../image_processing/object_detector_abstract.h"
 #include "../image_processing/box_overlap_testing_abstract.h"
 #include "../image_processing/full_object_detection_abstract.h"
@@ -379,6 +380,26 @@ namespace dlib
                   Therefore, this version of train() is a convenience function for for the 
                   case where you don't have any movable components of the detection templates.
         !*/
+
+        const trained_function_type train (
+            const prepared_object_detection_dataset<image_scanner_type>& dataset,
+            const test_box_overlap& ignore_overlap_tester = test_box_overlap()
+        ) const;
+        /*!
+            requires
+                - dataset.size() > 0
+                - dataset.get_scanner() has the same configuration as get_scanner() (e.g.
+                  it was prepared with get_scanner()).
+                - for all valid i, j:
+                    - dataset.get_truth_object_detections()[i][j].num_parts() == get_scanner().get_num_movable_components_per_detection_template() 
+                    - all_parts_in_rect(dataset.get_truth_object_detections()[i][j]) == true
+            ensures
+                - This function is identical to the first train() above, called with the
+                  images, truth_object_detections and ignore boxes the dataset was
+                  prepared from, except that it uses the scanners the dataset already
+                  loaded.  So training many times on the same dataset, e.g. with
+                  different values of C, only loads the images once.
+        !*/
     }; 
 
 // ----------------------------------------------------------------------------------------
@@ -6,6 +6,8 @@
 #include "structural_svm_object_detection_problem_abstract.h"
 #include "../matrix.h"
 #include "structural_svm_problem_threaded.h"
+#include "prepared_object_detection_dataset.h"
+#include <algorithm>
 #include <sstream>
 #include "../string.h"
 #include "../array.h"
@@ -23,6 +25,57 @@ namespace dlib
         impossible_labeling_error(const std::string& msg) : dlib::error(msg) {};
     };
 
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename Pyramid_type,
+        typename Feature_extractor_type
+        >
+    class scan_fhog_pyramid;
+
+    namespace impl
+    {
+        template <
+            typename image_scanner_type,
+            typename feature_vector_type
+            >
+        bool detect_strongest (
+            const image_scanner_type& scanner,
+            const feature_vector_type& w,
+            std::vector<std::pair<double, rectangle> >& dets,
+            const double thresh,
+            const unsigned long 
+        )
+        /*!
+            ensures
+                - Stores the detections of scanner scoring >= thresh into #dets, sorted in
+                  descending order, the same way scanner.detect(w,dets,thresh) does.  But
+                  scanners that can may leave out all but the max_dets strongest.
+                - returns true if #dets might be missing some detections.
+        !*/
+        {
+            scanner.detect(w, dets, thresh);
+            return false;
+        }
+
+        template <
+            typename Pyramid_type,
+            typename Feature_extractor_type,
+            typename feature_vector_type
+            >
+        bool detect_strongest (
+            const scan_fhog_pyramid<Pyramid_type,Feature_extractor_type>& scanner,
+            const feature_vector_type& w,
+            std::vector<std::pair<double, rectangle> >& dets,
+            const double thresh,
+            const unsigned long max_dets
+        )
+        {
+            scanner.detect(w, dets, thresh, max_dets);
+            return dets.size() == max_dets;
+        }
+    }
+
 // ----------------------------------------------------------------------------------------
 
     template <
@@ -46,9 +99,9 @@ namespace dlib
         ) :
             structural_svm_problem_threaded<matrix<double,0,1> >(num_threads),
             boxes_overlap(overlap_tester),
-            images(images_),
-            truth_object_detections(truth_object_detections_),
-            ignore(ignore_),
+            dataset(scanner, images_, truth_object_detections_, ignore_, num_threads),
+            truth_object_detections(dataset.get_truth_object_detections()),
+            ignore(dataset.get_ignore()),
             ignore_overlap_tester(ignore_overlap_tester_),
             match_eps(0.5),
             loss_per_false_alarm(1),
@@ -64,7 +117,7 @@ namespace dlib
                 << "\n\t scanner.get_num_detection_templates(): " << scanner.get_num_detection_templates()
                 << "\n\t is_learning_problem(images_,truth_object_detections_): " << is_learning_problem(images_,truth_object_detections_)
                 << "\n\t ignore.size(): " << ignore.size() 
-                << "\n\t images.size(): " << images.size() 
+                << "\n\t images_.size(): " << images_.size() 
                 << "\n\t this: " << this
                 );
             for (unsigned long i = 0; i < truth_object_detections.size(); ++i)
@@ -83,28 +136,37 @@ namespace dlib
                 }
             }
 #endif
-            // The purpose of the max_num_dets member variable is to give us a reasonable
-            // upper limit on the number of detections we can expect from a single image.
-            // This is used in the separation_oracle to put a hard limit on the number of
-            // detections we will consider.  We do this purely for computational reasons
-            // since otherwise we can end up wasting large amounts of time on certain
-            // pathological cases during optimization which ultimately do not influence the
-            // result.  Therefore, we force the separation oracle to only consider the
-            // max_num_dets strongest detections.
-            max_num_dets = 0;
-            for (unsigned long i = 0; i < truth_object_detections.size(); ++i)
-            {
-                if (truth_object_detections[i].size() > max_num_dets)
-                    max_num_dets = truth_object_detections[i].size();
-            }
-            max_num_dets = max_num_dets*3 + 10;
+            init(auto_overlap_tester);
+        }
 
-            initialize_scanners(scanner, num_threads);
+        structural_svm_object_detection_problem(
+            const test_box_overlap& overlap_tester,
+            const bool auto_overlap_tester,
+            const prepared_object_detection_dataset<image_scanner_type>& dataset_,
+            const test_box_overlap& ignore_overlap_tester_,
+            unsigned long num_threads = 2
+        ) :
+            structural_svm_problem_threaded<matrix<double,0,1> >(num_threads),
+            boxes_overlap(overlap_tester),
+            dataset(dataset_),
+            truth_object_detections(dataset.get_truth_object_detections()),
+            ignore(dataset.get_ignore()),
+            ignore_overlap_tester(ignore_overlap_tester_),
+            match_eps(0.5),
+            loss_per_false_alarm(1),
+            loss_per_missed_target(1)
+        {
+            // make sure requires clause is not broken
+            DLIB_ASSERT(dataset_.size() > 0 &&
+                         dataset_.get_scanner().get_num_detection_templates() > 0,
+                "\t structural_svm_object_detection_problem::structural_svm_object_detection_problem()"
+                << "\n\t Invalid inputs were given to this function "
+                << "\n\t dataset.get_scanner().get_num_detection_templates(): " << dataset_.get_scanner().get_num_detection_templates()
+                << "\n\t dataset.size(): " << dataset_.size() 
+                << "\n\t this: " << this
+                );
 
-            if (auto_overlap_tester)
-            {
-                auto_configure_overlap_tester();
-            }
+            init(auto_overlap_tester);
         }
 
         test_box_overlap get_overlap_tester (
@@ -178,6 +240,34 @@ namespace dlib
 
     private:
 
+        void init (
+            const bool auto_overlap_tester
+        )
+        {
+            // The purpose of the max_num_dets member variable is to give us a reasonable
+            // upper limit on the number of detections we can expect from a single image.
+            // This is used in the separation_oracle to put a hard limit on the number of
+            // detections we will consider.  We do this purely for computational reasons
+            // since otherwise we can end up wasting large amounts of time on certain
+            // pathological cases during optimization which ultimately do not influence the
+            // result.  Therefore, we force the separation oracle to only consider the
+            // max_num_dets strongest detections.
+            max_num_dets = 0;
+            for (unsigned long i = 0; i < truth_object_detections.size(); ++i)
+            {
+                if (truth_object_detections[i].size() > max_num_dets)
+                    max_num_dets = truth_object_detections[i].size();
+            }
+            max_num_dets = max_num_dets*3 + 10;
+
+            num_dets_needed.assign(dataset.size(), 0);
+
+            if (auto_overlap_tester)
+            {
+                auto_configure_overlap_tester();
+            }
+        }
+
         void auto_configure_overlap_tester(
         )
         {
@@ -187,7 +277,7 @@ namespace dlib
                 mapped_rects[i].resize(truth_object_detections[i].size());
                 for (unsigned long j = 0; j < truth_object_detections[i].size(); ++j)
                 {
-                    mapped_rects[i][j] = scanners[i].get_best_matching_rect(truth_object_detections[i][j].get_rect());
+                    mapped_rects[i][j] = dataset[i].get_best_matching_rect(truth_object_detections[i][j].get_rect());
                 }
             }
 
@@ -198,14 +288,14 @@ namespace dlib
         virtual long get_num_dimensions (
         ) const 
         {
-            return scanners[0].get_num_dimensions() + 
+            return dataset[0].get_num_dimensions() + 
                 1;// for threshold
         }
 
         virtual long get_num_samples (
         ) const 
         {
-            return images.size();
+            return dataset.size();
         }
 
         virtual void get_truth_joint_feature_vector (
@@ -213,7 +303,7 @@ namespace dlib
             feature_vector_type& psi 
         ) const 
         {
-            const image_scanner_type& scanner = scanners[idx];
+            const image_scanner_type& scanner = dataset[idx];
 
             psi.set_size(get_num_dimensions());
             std::vector<rectangle> mapped_rects;
@@ -310,15 +400,83 @@ namespace dlib
             feature_vector_type& psi
         ) const 
         {
-            const image_scanner_type& scanner = scanners[idx];
+            const image_scanner_type& scanner = dataset[idx];
 
             std::vector<std::pair<double, rectangle> > dets;
             const double thresh = current_solution(scanner.get_num_dimensions());
 
+            // When there are more than max_num_dets detections to output we stop after
+            // max_num_dets of them, so only the strongest detections matter.  That's the
+            // common case early in training, when w is still bad and the image is full of
+            // detections that all need sorting.  So if this sample filled up the output
+            // last time we only ask the scanner, if it supports it, for a few more
+            // detections than we used then, and go back for more if that turns out not to
+            // be enough.  Otherwise every detection above the threshold counts and we just
+            // get them all.
+            unsigned long max_dets = num_dets_needed[idx];
+            std::vector<rectangle> final_dets;
+            double total_score;
+            for (;;)
+            {
+                bool truncated = false;
+                if (max_dets == 0)
+                    scanner.detect(current_solution, dets, thresh-loss_per_false_alarm);
+                else
+                    truncated = impl::detect_strongest(scanner, current_solution, dets, thresh-loss_per_false_alarm, max_dets);
+
+                unsigned long num_used;
+                const bool filled = find_loss_augmented_detections(idx, dets, thresh, loss, final_dets, total_score, num_used);
+                if (filled || !truncated)
+                {
+                    num_dets_needed[idx] = filled ? 2*num_used + max_num_dets : 0;
+                    break;
+                }
+                max_dets *= 4;
+            }
 
-            scanner.detect(current_solution, dets, thresh-loss_per_false_alarm);
+            psi.set_size(get_num_dimensions());
+            psi = 0;
+            for (unsigned long i = 0; i < final_dets.size(); ++i)
+                scanner.get_feature_vector(scanner.get_full_object_detection(final_dets[i], current_solution), psi);
+
+#ifdef ENABLE_ASSERTS
+            const double psi_score = dot(psi, current_solution);
+            DLIB_CASSERT(std::abs(psi_score-total_score) <= 1e-4 * std::max(1.0,std::max(std::abs(psi_score),std::abs(total_score))),
+                        "\t The get_feature_vector() and detect() methods of image_scanner_type are not in sync." 
+                        << "\n\t The relative error is too large to be attributed to rounding error."
+                        << "\n\t error:       " << std::abs(psi_score-total_score)
+                        << "\n\t psi_score:   " << psi_score
+                        << "\n\t total_score: " << total_score
+            );
+#endif
 
+            psi(scanner.get_num_dimensions()) = -1.0*final_dets.size();
+        }
 
+        bool find_loss_augmented_detections (
+            const long idx,
+            const std::vector<std::pair<double, rectangle> >& dets,
+            const double thresh,
+            scalar_type& loss,
+            std::vector<rectangle>& final_dets,
+            double& total_score,
+            unsigned long& num_used
+        ) const
+        /*!
+            requires
+                - dets is sorted in descending order of score
+            ensures
+                - #final_dets == the detections out of dets which jointly maximize the loss
+                  and detection score sum.
+                - #loss == the loss of #final_dets.
+                - #total_score == the sum of the scores of #final_dets.
+                - #num_used == the number of detections at the front of dets the outputs
+                  depend on.
+                - returns true if the outputs don't depend on any detections that might
+                  come after dets[#num_used-1].  That is, if we stopped because we hit
+                  max_num_dets rather than because we ran out of detections.
+        !*/
+        {
             // The loss will measure the number of incorrect detections.  A detection is
             // incorrect if it doesn't hit a truth rectangle or if it is a duplicate detection
             // on a truth rectangle.
@@ -330,9 +488,10 @@ namespace dlib
             // keep track of which truth boxes we have hit so far.
             std::vector<bool> hit_truth_table(truth_object_detections[idx].size(), false);
 
-            std::vector<rectangle> final_dets;
+            final_dets.clear();
+            unsigned long i = 0;
             // The point of this loop is to fill out the truth_score_hits array. 
-            for (unsigned long i = 0; i < dets.size() && final_dets.size() < max_num_dets; ++i)
+            for (; i < dets.size() && final_dets.size() < max_num_dets; ++i)
             {
                 if (overlaps_any_box(boxes_overlap, final_dets, dets[i].second))
                     continue;
@@ -358,18 +517,18 @@ namespace dlib
                     }
                 }
             }
+            bool complete = final_dets.size() == max_num_dets;
+            num_used = i;
 
             hit_truth_table.assign(hit_truth_table.size(), false);
 
             final_dets.clear();
-#ifdef ENABLE_ASSERTS
-            double total_score = 0;
-#endif
+            total_score = 0;
             // Now figure out which detections jointly maximize the loss and detection score sum.  We
             // need to take into account the fact that allowing a true detection in the output, while 
             // initially reducing the loss, may allow us to increase the loss later with many duplicate
             // detections.
-            for (unsigned long i = 0; i < dets.size() && final_dets.size() < max_num_dets; ++i)
+            for (i = 0; i < dets.size() && final_dets.size() < max_num_dets; ++i)
             {
                 if (overlaps_any_box(boxes_overlap, final_dets, dets[i].second))
                     continue;
@@ -385,17 +544,13 @@ namespace dlib
                         {
                             hit_truth_table[truth.second] = true;
                             final_dets.push_back(dets[i].second);
-#ifdef ENABLE_ASSERTS
                             total_score += dets[i].first;
-#endif
                             loss -= loss_per_missed_target;
                         }
                         else
                         {
                             final_dets.push_back(dets[i].second);
-#ifdef ENABLE_ASSERTS
                             total_score += dets[i].first;
-#endif
                             loss += loss_per_false_alarm;
                         }
                     }
@@ -404,33 +559,16 @@ namespace dlib
                 {
                     // didn't hit anything
                     final_dets.push_back(dets[i].second);
-#ifdef ENABLE_ASSERTS
                     total_score += dets[i].first;
-#endif
                     loss += loss_per_false_alarm;
                 }
             }
+            complete = complete && final_dets.size() == max_num_dets;
+            num_used = std::max(num_used, i);
 
-            psi.set_size(get_num_dimensions());
-            psi = 0;
-            for (unsigned long i = 0; i < final_dets.size(); ++i)
-                scanner.get_feature_vector(scanner.get_full_object_detection(final_dets[i], current_solution), psi);
-
-#ifdef ENABLE_ASSERTS
-            const double psi_score = dot(psi, current_solution);
-            DLIB_CASSERT(std::abs(psi_score-total_score) <= 1e-4 * std::max(1.0,std::max(std::abs(psi_score),std::abs(total_score))),
-                        "\t The get_feature_vector() and detect() methods of image_scanner_type are not in sync." 
-                        << "\n\t The relative error is too large to be attributed to rounding error."
-                        << "\n\t error:       " << std::abs(psi_score-total_score)
-                        << "\n\t psi_score:   " << psi_score
-                        << "\n\t total_score: " << total_score
-            );
-#endif
-
-            psi(scanner.get_num_dimensions()) = -1.0*final_dets.size();
+            return complete;
         }
 
-
         bool overlaps_ignore_box (
             const long idx,
             const dlib::rectangle& rect
@@ -479,51 +617,17 @@ namespace dlib
             return std::make_pair(match,best_idx);
         }
 
-        struct init_scanners_helper
-        {
-            init_scanners_helper (
-                array<image_scanner_type>& scanners_,
-                const image_array_type& images_
-            ) :
-                scanners(scanners_),
-                images(images_)
-            {}
-
-            array<image_scanner_type>& scanners;
-            const image_array_type& images;
-
-            void operator() (long i ) const
-            {
-                scanners[i].load(images[i]);
-            }
-        };
-
-        void initialize_scanners (
-            const image_scanner_type& scanner,
-            unsigned long num_threads
-        )
-        {
-            scanners.set_max_size(images.size());
-            scanners.set_size(images.size());
-
-            for (unsigned long i = 0; i < scanners.size(); ++i)
-                scanners[i].copy_configuration(scanner);
-
-            // now load the images into all the scanners
-            parallel_for(num_threads, 0, scanners.size(), init_scanners_helper(scanners, images));
-        }
-
-
         test_box_overlap boxes_overlap;
 
-        mutable array<image_scanner_type> scanners;
-
-        const image_array_type& images;
+        const prepared_object_detection_dataset<image_scanner_type> dataset;
         const std::vector<std::vector<full_object_detection> >& truth_object_detections;
         const std::vector<std::vector<rectangle> >& ignore;
         const test_box_overlap ignore_overlap_tester;
 
         unsigned long max_num_dets;
+        // How many of the strongest detections the separation oracle should ask each
+        // image's scanner for next time.  0 means all of them.
+        mutable std::vector<unsigned long> num_dets_needed;
         double match_eps;
         double loss_per_false_alarm;
         double loss_per_missed_target;
@@ -8,6 +8,7 @@
 #include <sstream>
 #include "../image_processing/full_object_detection_abstract.h"
 #include "../image_processing/box_overlap_testing.h"
+#include "prepared_object_detection_dataset_abstract.h"
 
 namespace dlib
 {
@@ -116,6 +117,28 @@ namespace dlib
                       in your dataset that you are unsure you want to detect or otherwise
                       don't care if the detector gets or doesn't then you can mark them
                       with ignore rectangles and the optimizer will simply ignore them. 
+                - The images are loaded into scanners as if by
+                  prepared_object_detection_dataset<image_scanner_type>(scanner,images,truth_object_detections,ignore,num_threads).
+        !*/
+
+        structural_svm_object_detection_problem(
+            const test_box_overlap& overlap_tester,
+            const bool auto_overlap_tester,
+            const prepared_object_detection_dataset<image_scanner_type>& dataset,
+            const test_box_overlap& ignore_overlap_tester,
+            unsigned long num_threads = 2
+        );
+        /*!
+            requires
+                - dataset.size() > 0
+                - dataset.get_scanner().get_num_detection_templates() > 0
+            ensures
+                - This constructor is identical to the one above, with 
+                  scanner == dataset.get_scanner(),
+                  truth_object_detections == dataset.get_truth_object_detections() and
+                  ignore == dataset.get_ignore(), except that it uses the scanners
+                  already loaded by dataset rather than loading the images again.  The
+                  dataset's scanners are shared, not copied.
         !*/
 
         test_box_overlap get_overlap_tester (
@@ -423,6 +423,8 @@ namespace dlib
             return true; 
         }
 
+    protected:
+
         virtual bool optimization_status (
             scalar_type current_objective_value,
             scalar_type current_error_gap,
@@ -505,6 +507,8 @@ namespace dlib
             return false;
         }
 
+    private:
+
         virtual void get_risk (
             matrix_type& w,
             scalar_type& risk,
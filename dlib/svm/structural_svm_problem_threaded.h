@@ -6,6 +6,7 @@
 #include "structural_svm_problem_threaded_abstract.h"
 #include "../algs.h"
 #include <vector>
+#include <algorithm>
 #include "structural_svm_problem.h"
 #include "../matrix.h"
 #include "sparse_vector.h"
@@ -35,7 +36,12 @@ namespace dlib
             unsigned long num_threads
         ) :
             tp(num_threads),
-            num_iterations_executed(0)
+            num_iterations_executed(0),
+            last_status_time(0),
+            last_oracle_time(0),
+            next_schedule_pos(0),
+            total_busy_time(0),
+            last_thread_utilization(1)
         {}
 
         unsigned long get_num_threads (
@@ -55,50 +61,59 @@ namespace dlib
                 buffer_subgradients_locally(buffer_subgradients_locally_){}
 
             void call_oracle (
-                long begin,
-                long end
             ) 
             {
-                // If we are only going to call the separation oracle once then don't run
-                // the slightly more complex for loop version of this code.  Or if we just
-                // don't want to run the complex buffering one.  The code later on decides
-                // if we should do the buffering based on how long it takes to execute.  We
-                // do this because, when the subgradient is really high dimensional it can
-                // take a lot of time to add them together.  So we might want to avoid
-                // doing that.
-                if (end-begin <= 1 || !buffer_subgradients_locally)
+                // Each worker takes the next sample off the schedule until there are none
+                // left, so a thread that got a cheap sample just takes another one instead
+                // of sitting idle until the others finish a fixed block of samples.
+                //
+                // We might not want to buffer the subgradients locally.  The code later on
+                // decides if we should do the buffering based on how long it takes to
+                // execute.  We do this because, when the subgradient is really high
+                // dimensional it can take a lot of time to add them together.  So we might
+                // want to avoid doing that.
+                scalar_type loss = 0;
+                matrix_type faccum;
+                if (buffer_subgradients_locally)
                 {
-                    scalar_type loss;
-                    feature_vector_type ftemp;
-                    for (long i = begin; i < end; ++i)
-                    {
-                        self.separation_oracle_cached(i, w, loss, ftemp);
-
-                        auto_mutex lock(self.accum_mutex);
-                        total_loss += loss;
-                        add_to(subgradient, ftemp);
-                    }
-                }
-                else
-                {
-                    scalar_type loss = 0;
-                    matrix_type faccum(subgradient.size(),1);
+                    faccum.set_size(subgradient.size(),1);
                     faccum = 0;
+                }
 
-                    feature_vector_type ftemp;
+                feature_vector_type ftemp;
+                uint64 busy_time = 0;
+                long i;
+                while (self.next_scheduled_sample(i))
+                {
+                    const uint64 start_time = self.ts.get_timestamp();
 
-                    for (long i = begin; i < end; ++i)
+                    scalar_type loss_temp;
+                    self.separation_oracle_cached(i, w, loss_temp, ftemp);
+                    if (buffer_subgradients_locally)
                     {
-                        scalar_type loss_temp;
-                        self.separation_oracle_cached(i, w, loss_temp, ftemp);
                         loss += loss_temp;
                         add_to(faccum, ftemp);
                     }
+                    else
+                    {
+                        auto_mutex lock(self.accum_mutex);
+                        total_loss += loss_temp;
+                        add_to(subgradient, ftemp);
+                    }
 
-                    auto_mutex lock(self.accum_mutex);
+                    // Only this thread is working on sample i, so no lock is needed.
+                    const uint64 cost = self.ts.get_timestamp() - start_time;
+                    self.sample_cost[i] = cost;
+                    busy_time += cost;
+                }
+
+                auto_mutex lock(self.accum_mutex);
+                if (buffer_subgradients_locally)
+                {
                     total_loss += loss;
                     add_to(subgradient, faccum);
                 }
+                self.total_busy_time += busy_time;
             }
 
             const structural_svm_problem_threaded& self;
@@ -108,6 +123,30 @@ namespace dlib
             bool buffer_subgradients_locally;
         };
 
+        struct compare_sample_cost
+        {
+            compare_sample_cost (
+                const std::vector<uint64>& sample_cost_
+            ) : sample_cost(sample_cost_) {}
+
+            bool operator() (
+                long a,
+                long b
+            ) const { return sample_cost[a] > sample_cost[b]; }
+
+            const std::vector<uint64>& sample_cost;
+        };
+
+        bool next_scheduled_sample (
+            long& idx
+        ) const
+        {
+            auto_mutex lock(schedule_mutex);
+            if (next_schedule_pos == schedule.size())
+                return false;
+            idx = schedule[next_schedule_pos++];
+            return true;
+        }
 
         virtual void call_separation_oracle_on_all_samples (
             const matrix_type& w,
@@ -128,10 +167,32 @@ namespace dlib
                 buffer_subgradients_locally = !buffer_subgradients_locally;
             }
 
+            // Hand out the samples that took the longest on the last iteration first.
+            // The expensive ones (e.g. large images) then all get started right away
+            // and the cheap ones fill in the gaps at the end, rather than one thread
+            // being left with a big sample after the others have run out of work.  With
+            // a single thread the order doesn't matter, so the samples keep their order.
+            const unsigned long num = this->get_num_samples();
+            if (sample_cost.size() != num)
+                sample_cost.assign(num, 0);
+            schedule.resize(num);
+            for (unsigned long i = 0; i < num; ++i)
+                schedule[i] = i;
+            if (tp.num_threads_in_pool() > 1)
+                std::stable_sort(schedule.begin(), schedule.end(), compare_sample_cost(sample_cost));
+            next_schedule_pos = 0;
+            total_busy_time = 0;
+
+            const unsigned long num_workers = std::max<unsigned long>(1, std::min<unsigned long>(tp.num_threads_in_pool(), num));
             binder b(*this, w, subgradient, total_loss, buffer_subgradients_locally);
-            parallel_for_blocked(tp, 0, this->get_num_samples(), b, &binder::call_oracle);
+            for (unsigned long i = 0; i < num_workers; ++i)
+                tp.add_task(b, &binder::call_oracle);
+            tp.wait_for_all_tasks();
 
             const uint64 stop_time = ts.get_timestamp();
+            last_oracle_time = stop_time-start_time;
+            last_thread_utilization = last_oracle_time == 0 ? 1 :
+                std::min(1.0, total_busy_time/((double)last_oracle_time*num_workers));
 
             if (buffer_subgradients_locally)
                 with_buffer_time.add(stop_time-start_time);
@@ -140,12 +201,53 @@ namespace dlib
 
         }
 
+    protected:
+
+        virtual bool optimization_status (
+            scalar_type current_objective_value,
+            scalar_type current_error_gap,
+            scalar_type current_risk_value,
+            scalar_type current_risk_gap,
+            unsigned long num_cutting_planes,
+            unsigned long num_iterations
+        ) const 
+        {
+            // Report where the time of each iteration goes: the rest of the iteration
+            // time is spent by the cutting plane solver itself.
+            const uint64 now = ts.get_timestamp();
+            if (this->verbose && last_status_time != 0)
+            {
+                using namespace std;
+                cout << "iter time:     " << (now-last_status_time)/1000.0 << " ms" << endl;
+                cout << "oracle time:   " << last_oracle_time/1000.0 << " ms" << endl;
+                cout << "thread use:    " << 100*last_thread_utilization << "%" << endl;
+            }
+            last_status_time = now;
+
+            return structural_svm_problem<matrix_type,feature_vector_type>::optimization_status(
+                current_objective_value, current_error_gap, current_risk_value,
+                current_risk_gap, num_cutting_planes, num_iterations);
+        }
+
+    private:
+
         mutable thread_pool tp;
         mutable mutex accum_mutex;
         mutable timestamper ts;
         mutable running_stats<double> with_buffer_time;
         mutable running_stats<double> without_buffer_time;
         mutable unsigned long num_iterations_executed;
+        mutable uint64 last_status_time;
+        mutable uint64 last_oracle_time;
+
+        // The oracle time of each sample on the last iteration, and the order the samples
+        // are handed out in on this one.
+        mutable std::vector<uint64> sample_cost;
+        mutable std::vector<long> schedule;
+        mutable unsigned long next_schedule_pos;
+        mutable mutex schedule_mutex;
+        mutable uint64 total_busy_time;
+        mutable double last_thread_utilization;
     };
 
 // ----------------------------------------------------------------------------------------
@@ -33,6 +33,13 @@ namespace dlib
                 different threads.  However, it is guaranteed that different threads will
                 never make concurrent calls to separation_oracle() using the same idx value
                 (i.e. the first argument).  
+
+                The threads take the samples one at a time, starting with the ones whose
+                separation_oracle() call took the longest on the previous iteration, so
+                samples of very different cost (e.g. images of very different sizes)
+                still keep all the threads busy.  When be_verbose() is set, the time
+                spent in separation_oracle() and how busy the threads were is printed
+                on each iteration.
         !*/
 
         typedef matrix_type_ matrix_type;
@@ -12,6 +12,7 @@
 #include "svm/svm_threaded.h"
 #include "svm/structural_svm_problem_threaded.h"
 #include "svm/structural_svm_distributed.h"
+#include "svm/prepared_object_detection_dataset.h"
 #include "svm/structural_svm_object_detection_problem.h"
 #include "svm/structural_object_detection_trainer.h"
 #include "svm/structural_svm_sequence_labeling_problem.h"
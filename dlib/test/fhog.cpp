@@ -153,11 +153,75 @@ namespace
         }
 
 
+        template <typename pixel_type>
+        void test_dispatched_kernels_on (
+            dlib::rand& rnd,
+            cpu_simd_level level
+        )
+        {
+            array2d<pixel_type> img;
+            dlib::array<array2d<float> > hog, ref_hog;
+            array2d<matrix<float,31,1> > vhog, ref_vhog;
+            for (int iter = 0; iter < 20; ++iter)
+            {
+                print_spinner();
+                img.set_size(rnd.get_random_32bit_number()%150+10, rnd.get_random_32bit_number()%150+10);
+                for (long r = 0; r < img.nr(); ++r)
+                {
+                    for (long c = 0; c < img.nc(); ++c)
+                        assign_pixel(img[r][c], rgb_pixel(rnd.get_random_8bit_number(), rnd.get_random_8bit_number(), rnd.get_random_8bit_number()));
+                }
+                const int cell_size = rnd.get_random_32bit_number()%8+2;
+
+                set_max_simd_dispatch_level(CPU_SIMD_BASELINE);
+                extract_fhog_features(img, ref_hog, cell_size);
+                extract_fhog_features(img, ref_vhog, cell_size);
+                set_max_simd_dispatch_level(level);
+                extract_fhog_features(img, hog, cell_size);
+                extract_fhog_features(img, vhog, cell_size);
+
+                // The gradient kernels must snap to exactly the same orientations, and
+                // only the planar output goes through the normalization kernels.
+                DLIB_TEST(vhog.nr() == ref_vhog.nr() && vhog.nc() == ref_vhog.nc());
+                for (long r = 0; r < vhog.nr(); ++r)
+                {
+                    for (long c = 0; c < vhog.nc(); ++c)
+                        DLIB_TEST(vhog[r][c] == ref_vhog[r][c]);
+                }
+                DLIB_TEST(hog.size() == ref_hog.size());
+                for (unsigned long o = 0; o < hog.size(); ++o)
+                {
+                    DLIB_TEST(hog[o].nr() == ref_hog[o].nr() && hog[o].nc() == ref_hog[o].nc());
+                    for (long r = 0; r < hog[o].nr(); ++r)
+                    {
+                        for (long c = 0; c < hog[o].nc(); ++c)
+                            DLIB_TEST_MSG(std::abs(hog[o][r][c] - ref_hog[o][r][c]) < 1e-6, std::abs(hog[o][r][c] - ref_hog[o][r][c]));
+                    }
+                }
+            }
+        }
+
+        void test_dispatched_kernels()
+        {
+            dlog << LINFO << "cpu simd level: " << simd_level_name(get_cpu_simd_level());
+            dlib::rand rnd;
+            for (int level = CPU_SIMD_AVX2; level <= get_cpu_simd_level(); ++level)
+            {
+                test_dispatched_kernels_on<unsigned char>(rnd, static_cast<cpu_simd_level>(level));
+                test_dispatched_kernels_on<rgb_pixel>(rnd, static_cast<cpu_simd_level>(level));
+                // no dispatched kernels for this one, make sure it still works
+                test_dispatched_kernels_on<float>(rnd, static_cast<cpu_simd_level>(level));
+            }
+            set_max_simd_dispatch_level(CPU_SIMD_AVX512);
+        }
+
+
         void perform_test (
         )
         {
             test_point_transforms();
             test_on_small();
+            test_dispatched_kernels();
 
             print_spinner();
             // load the testing data
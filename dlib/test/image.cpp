@@ -1,6 +1,8 @@
 // Copyright (C) 2008  Davis E. King (davis@dlib.net)
 // License: Boost Software License   See LICENSE.txt for the full license.
 #include <sstream>
+#include <fstream>
+#include <iterator>
 #include <string>
 #include <cstdlib>
 #include <ctime>
@@ -1812,6 +1814,589 @@ namespace
 
     }
 
+// ----------------------------------------------------------------------------------------
+
+    std::vector<unsigned char> read_file_bytes (
+        const std::string& file_name
+    )
+    {
+        std::ifstream fin(file_name.c_str(), std::ios::binary);
+        return std::vector<unsigned char>((std::istreambuf_iterator<char>(fin)), std::istreambuf_iterator<char>());
+    }
+
+    bool same_pixels (
+        const array2d<rgb_pixel>& a,
+        const array2d<rgb_pixel>& b
+    )
+    {
+        if (a.nr() != b.nr() || a.nc() != b.nc())
+            return false;
+        for (long r = 0; r < a.nr(); ++r)
+        {
+            for (long c = 0; c < a.nc(); ++c)
+            {
+                if (a[r][c].red != b[r][c].red || a[r][c].green != b[r][c].green || a[r][c].blue != b[r][c].blue)
+                    return false;
+            }
+        }
+        return true;
+    }
+
+    void test_load_image_from_memory()
+    {
+        dlog << LINFO << "in test_load_image_from_memory";
+        print_spinner();
+
+        dlib::rand rnd;
+        array2d<rgb_pixel> img(33,47);
+        for (long r = 0; r < img.nr(); ++r)
+        {
+            for (long c = 0; c < img.nc(); ++c)
+            {
+                img[r][c].red = rnd.get_random_8bit_number();
+                img[r][c].green = r*5;
+                img[r][c].blue = c*5;
+            }
+        }
+
+        array2d<rgb_pixel> from_file, from_memory;
+        std::vector<unsigned char> bytes;
+
+#ifdef DLIB_PNG_SUPPORT
+        save_png(img, "test_memory.png");
+        bytes = read_file_bytes("test_memory.png");
+        load_image(from_file, "test_memory.png");
+        load_image(from_memory, &bytes[0], bytes.size());
+        DLIB_TEST(same_pixels(from_memory, img));
+        DLIB_TEST(same_pixels(from_memory, from_file));
+
+        bool threw = false;
+        try { load_png(from_memory, &bytes[0], bytes.size()/2); }
+        catch (image_load_error&) { threw = true; }
+        DLIB_TEST(threw);
+#endif
+
+#ifdef DLIB_JPEG_SUPPORT
+        save_jpeg(img, "test_memory.jpg", 90);
+        bytes = read_file_bytes("test_memory.jpg");
+        load_image(from_file, "test_memory.jpg");
+        load_image(from_memory, &bytes[0], bytes.size());
+        DLIB_TEST(from_memory.nr() == img.nr() && from_memory.nc() == img.nc());
+        DLIB_TEST(same_pixels(from_memory, from_file));
+
+        // A truncated stream decodes, just with the missing part of the image left gray.
+        array2d<unsigned char> gray;
+        load_jpeg(gray, &bytes[0], bytes.size()/2);
+        DLIB_TEST(gray.nr() == img.nr() && gray.nc() == img.nc());
+#endif
+
+        bool threw_unknown = false;
+        const unsigned char junk[] = "not an image";
+        try { load_image(from_memory, junk, sizeof(junk)); }
+        catch (image_load_error&) { threw_unknown = true; }
+        DLIB_TEST(threw_unknown);
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    void test_jpeg_decode_options()
+    {
+#ifdef DLIB_JPEG_SUPPORT
+        dlog << LINFO << "in test_jpeg_decode_options";
+        print_spinner();
+
+        // A smooth image, so the JPEG compression doesn't add much noise
+        array2d<rgb_pixel> img(67,93);
+        for (long r = 0; r < img.nr(); ++r)
+        {
+            for (long c = 0; c < img.nc(); ++c)
+            {
+                img[r][c].red = 2*r + c;
+                img[r][c].green = 255 - 2*c;
+                img[r][c].blue = (unsigned char)(128 + 100*std::sin(r/9.0));
+            }
+        }
+        save_jpeg(img, "test_memory.jpg", 95);
+        const std::vector<unsigned char> bytes = read_file_bytes("test_memory.jpg");
+
+        array2d<rgb_pixel> color;
+        load_jpeg(color, "test_memory.jpg");
+
+        // Decoding straight to grayscale gives the luma of the color image
+        jpeg_decode_options options;
+        DLIB_TEST(options.grayscale == false && options.scale_denom == 1);
+        options.grayscale = true;
+        DLIB_TEST(jpeg_loader("test_memory.jpg", options).is_gray());
+        array2d<unsigned char> gray, gray_from_memory;
+        load_jpeg(gray, "test_memory.jpg", options);
+        DLIB_TEST(gray.nr() == img.nr() && gray.nc() == img.nc());
+        double max_error = 0;
+        for (long r = 0; r < gray.nr(); ++r)
+        {
+            for (long c = 0; c < gray.nc(); ++c)
+            {
+                const double luma = 0.299*color[r][c].red + 0.587*color[r][c].green + 0.114*color[r][c].blue;
+                max_error = std::max(max_error, std::abs(gray[r][c] - luma));
+            }
+        }
+        dlog << LINFO << "grayscale decode error: " << max_error;
+        DLIB_TEST(max_error < 2);
+
+        // Scaled decodes are about the block averages of the full size decode
+        const unsigned long denoms[] = {1, 2, 4, 8};
+        for (int i = 0; i < 4; ++i)
+        {
+            const long d = denoms[i];
+            options.scale_denom = d;
+            array2d<unsigned char> scaled;
+            load_jpeg(scaled, "test_memory.jpg", options);
+            load_jpeg(gray_from_memory, &bytes[0], bytes.size(), options);
+            DLIB_TEST(scaled.nr() == (img.nr()+d-1)/d && scaled.nc() == (img.nc()+d-1)/d);
+            DLIB_TEST(mat(scaled) == mat(gray_from_memory));
+
+            running_stats<double> error;
+            for (long r = 0; r+1 < scaled.nr(); ++r)
+            {
+                for (long c = 0; c+1 < scaled.nc(); ++c)
+                {
+                    const double avg = mean(matrix_cast<double>(subm(mat(gray), r*d, c*d, d, d)));
+                    error.add(std::abs(scaled[r][c] - avg));
+                }
+            }
+            dlog << LINFO << "scale 1/" << d << " decode error: " << error.mean();
+            DLIB_TEST(error.mean() < 1);
+
+            jpeg_decode_options color_options;
+            color_options.scale_denom = d;
+            array2d<rgb_pixel> scaled_color;
+            load_jpeg(scaled_color, &bytes[0], bytes.size(), color_options);
+            DLIB_TEST(jpeg_loader(&bytes[0], bytes.size(), color_options).is_rgb());
+            DLIB_TEST(scaled_color.nr() == scaled.nr() && scaled_color.nc() == scaled.nc());
+        }
+#endif
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    template <typename image_type>
+    bool same_pixel_values (
+        const image_type& a_,
+        const image_type& b_
+    )
+    {
+        const_image_view<image_type> a(a_), b(b_);
+        for (long r = 0; r < a.nr(); ++r)
+        {
+            for (long c = 0; c < a.nc(); ++c)
+            {
+                rgb_alpha_pixel pa, pb;
+                assign_pixel(pa, a[r][c]);
+                assign_pixel(pb, b[r][c]);
+                if (pa.red != pb.red || pa.green != pb.green || pa.blue != pb.blue || pa.alpha != pb.alpha)
+                    return false;
+            }
+        }
+        return true;
+    }
+
+    template <typename image_type>
+    void check_load_jpeg_matches_loader (
+        const std::vector<unsigned char>& bytes,
+        const jpeg_decode_options& options
+    )
+    {
+        image_type from_loader, decoded, decoded_from_file;
+        jpeg_loader(&bytes[0], bytes.size(), options).get_image(from_loader);
+        load_jpeg(decoded, &bytes[0], bytes.size(), options);
+        load_jpeg(decoded_from_file, "test_memory.jpg", options);
+        DLIB_TEST(num_rows(decoded) == num_rows(from_loader));
+        DLIB_TEST(num_columns(decoded) == num_columns(from_loader));
+        DLIB_TEST(same_pixel_values(decoded, from_loader));
+        DLIB_TEST(same_pixel_values(decoded_from_file, from_loader));
+    }
+
+    void test_load_jpeg_pixel_types()
+    {
+#ifdef DLIB_JPEG_SUPPORT
+        dlog << LINFO << "in test_load_jpeg_pixel_types";
+        print_spinner();
+
+        dlib::rand rnd;
+        array2d<rgb_pixel> img(45,71);
+        for (long r = 0; r < img.nr(); ++r)
+        {
+            for (long c = 0; c < img.nc(); ++c)
+            {
+                img[r][c].red = rnd.get_random_8bit_number();
+                img[r][c].green = 3*r;
+                img[r][c].blue = 3*c;
+            }
+        }
+        save_jpeg(img, "test_memory.jpg", 90);
+        const std::vector<unsigned char> bytes = read_file_bytes("test_memory.jpg");
+
+        // load_jpeg() writes unsigned char and rgb_pixel images in place and converts
+        // everything else through a small buffer.  Either way it has to give the same
+        // pixels jpeg_loader does.
+        jpeg_decode_options options;
+        for (int i = 0; i < 4; ++i)
+        {
+            options.grayscale = (i%2 == 1);
+            options.scale_denom = (i < 2) ? 1 : 4;
+            check_load_jpeg_matches_loader<array2d<unsigned char> >(bytes, options);
+            check_load_jpeg_matches_loader<array2d<rgb_pixel> >(bytes, options);
+            check_load_jpeg_matches_loader<array2d<rgb_alpha_pixel> >(bytes, options);
+            check_load_jpeg_matches_loader<array2d<float> >(bytes, options);
+            check_load_jpeg_matches_loader<matrix<unsigned char> >(bytes, options);
+            check_load_jpeg_matches_loader<matrix<rgb_pixel> >(bytes, options);
+        }
+
+        // errors are still reported as image_load_error
+        std::vector<unsigned char> junk(bytes.begin(), bytes.begin()+2);
+        junk.resize(64, 0x5a);
+        array2d<rgb_pixel> out;
+        bool threw = false;
+        try { load_jpeg(out, &junk[0], junk.size()); }
+        catch (image_load_error&) { threw = true; }
+        DLIB_TEST(threw);
+
+        threw = false;
+        try { load_jpeg(out, "this_file_does_not_exist.jpg"); }
+        catch (image_load_error&) { threw = true; }
+        DLIB_TEST(threw);
+#endif
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    template <typename row_reader, typename image_type>
+    void read_in_chunks (
+        row_reader& reader,
+        image_type& img,
+        unsigned long chunk
+    )
+    {
+        // Decode the image a few rows at a time through a small strip, the way a caller
+        // that can't hold the whole image would.
+        img.set_size(reader.nr(), reader.nc());
+        image_type strip;
+        strip.set_size(chunk, reader.nc());
+        while (reader.next_row() < reader.nr())
+        {
+            const long first = reader.next_row();
+            const unsigned long count = reader.read_rows(strip, 0, chunk);
+            DLIB_TEST(count == std::min<unsigned long>(chunk, img.nr()-first));
+            for (unsigned long r = 0; r < count; ++r)
+                for (long c = 0; c < img.nc(); ++c)
+                    img[first+r][c] = strip[r][c];
+        }
+        DLIB_TEST(reader.read_rows(strip, 0, chunk) == 0);
+    }
+
+    void test_row_readers()
+    {
+        dlog << LINFO << "in test_row_readers";
+        print_spinner();
+
+        dlib::rand rnd;
+        array2d<rgb_alpha_pixel> img(53,37);
+        for (long r = 0; r < img.nr(); ++r)
+        {
+            for (long c = 0; c < img.nc(); ++c)
+            {
+                img[r][c].red = rnd.get_random_8bit_number();
+                img[r][c].green = 4*r;
+                img[r][c].blue = 4*c;
+                img[r][c].alpha = rnd.get_random_8bit_number();
+            }
+        }
+
+#ifdef DLIB_JPEG_SUPPORT
+        {
+            save_jpeg(img, "test_memory.jpg", 90);
+            const std::vector<unsigned char> bytes = read_file_bytes("test_memory.jpg");
+            array2d<unsigned char> gray, gray_strips;
+            array2d<rgb_pixel> color, color_strips;
+            load_jpeg(gray, "test_memory.jpg");
+            load_jpeg(color, "test_memory.jpg");
+
+            jpeg_row_reader gray_reader("test_memory.jpg");
+            DLIB_TEST(gray_reader.nr() == img.nr() && gray_reader.nc() == img.nc());
+            DLIB_TEST(gray_reader.is_rgb() && gray_reader.next_row() == 0);
+            read_in_chunks(gray_reader, gray_strips, 5);
+            DLIB_TEST(mat(gray_strips) == mat(gray));
+
+            jpeg_row_reader color_reader(&bytes[0], bytes.size());
+            read_in_chunks(color_reader, color_strips, 16);
+            DLIB_TEST(same_pixel_values(color_strips, color));
+
+            jpeg_decode_options options;
+            options.grayscale = true;
+            options.scale_denom = 2;
+            load_jpeg(gray, &bytes[0], bytes.size(), options);
+            jpeg_row_reader scaled_reader(&bytes[0], bytes.size(), options);
+            DLIB_TEST(scaled_reader.is_gray());
+            read_in_chunks(scaled_reader, gray_strips, 3);
+            DLIB_TEST(mat(gray_strips) == mat(gray));
+        }
+#endif
+
+#ifdef DLIB_PNG_SUPPORT
+        {
+            array2d<unsigned char> gray_img;
+            array2d<rgb_pixel> rgb_img;
+            assign_image(gray_img, img);
+            assign_image(rgb_img, img);
+
+            // every color type png_loader reads, checked against png_loader
+            for (int type = 0; type < 3; ++type)
+            {
+                if (type == 0) save_png(gray_img, "test_memory.png");
+                if (type == 1) save_png(rgb_img, "test_memory.png");
+                if (type == 2) save_png(img, "test_memory.png");
+                const std::vector<unsigned char> bytes = read_file_bytes("test_memory.png");
+
+                array2d<rgb_alpha_pixel> loaded, strips;
+                array2d<unsigned char> loaded_gray, strips_gray;
+                load_png(loaded, "test_memory.png");
+                load_png(loaded_gray, &bytes[0], bytes.size());
+
+                png_row_reader reader("test_memory.png");
+                DLIB_TEST(reader.nr() == img.nr() && reader.nc() == img.nc());
+                DLIB_TEST(reader.is_gray() == (type == 0));
+                DLIB_TEST(reader.is_rgb() == (type == 1));
+                DLIB_TEST(reader.is_rgba() == (type == 2));
+                read_in_chunks(reader, strips, 7);
+                DLIB_TEST(same_pixel_values(strips, loaded));
+
+                png_row_reader memory_reader(&bytes[0], bytes.size());
+                read_in_chunks(memory_reader, strips_gray, 1);
+                DLIB_TEST(mat(strips_gray) == mat(loaded_gray));
+            }
+
+            bool threw = false;
+            const unsigned char junk[] = "not a png image";
+            try { png_row_reader reader(junk, sizeof(junk)); }
+            catch (image_load_error&) { threw = true; }
+            DLIB_TEST(threw);
+        }
+#endif
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    int next_file_descriptor (
+        const std::string& file_name
+    )
+    {
+        FILE* fp = fopen(file_name.c_str(), "rb");
+        DLIB_TEST(fp != 0);
+        const int fd = fileno(fp);
+        fclose(fp);
+        return fd;
+    }
+
+    void test_corrupt_image_cleanup()
+    {
+        dlog << LINFO << "in test_corrupt_image_cleanup";
+        print_spinner();
+
+        // The decoders find most errors (e.g. a corrupt header) in their constructors, and
+        // must still close their file and free the decoder's memory then.  A leaked file
+        // shows up as a higher descriptor for the next file opened.
+        array2d<rgb_pixel> img(16,16), loaded;
+        assign_all_pixels(img, rgb_pixel(10,20,30));
+
+#ifdef DLIB_JPEG_SUPPORT
+        {
+            save_jpeg(img, "test_memory.jpg", 90);
+            std::vector<unsigned char> bytes = read_file_bytes("test_memory.jpg");
+            std::fill(bytes.begin() + 20, bytes.end(), 0);
+            {
+                std::ofstream fout("test_memory.jpg", std::ios::binary);
+                fout.write((const char*)&bytes[0], bytes.size());
+            }
+
+            const int fd = next_file_descriptor("test_memory.jpg");
+            int errors = 0;
+            for (int i = 0; i < 200; ++i)
+            {
+                try { load_jpeg(loaded, "test_memory.jpg"); }
+                catch (image_load_error&) { ++errors; }
+                try { load_jpeg(loaded, &bytes[0], bytes.size()); }
+                catch (image_load_error&) { ++errors; }
+                try { jpeg_row_reader reader("test_memory.jpg"); }
+                catch (image_load_error&) { ++errors; }
+            }
+            DLIB_TEST(errors == 600);
+            DLIB_TEST(next_file_descriptor("test_memory.jpg") == fd);
+        }
+#endif
+
+#ifdef DLIB_PNG_SUPPORT
+        {
+            save_png(img, "test_memory.png");
+            std::vector<unsigned char> bytes = read_file_bytes("test_memory.png");
+            // keep the signature, break the header chunk
+            std::fill(bytes.begin() + 12, bytes.end(), 0);
+            {
+                std::ofstream fout("test_memory.png", std::ios::binary);
+                fout.write((const char*)&bytes[0], bytes.size());
+            }
+
+            const int fd = next_file_descriptor("test_memory.png");
+            int errors = 0;
+            for (int i = 0; i < 200; ++i)
+            {
+                try { png_row_reader reader("test_memory.png"); }
+                catch (image_load_error&) { ++errors; }
+                try { png_row_reader reader(&bytes[0], bytes.size()); }
+                catch (image_load_error&) { ++errors; }
+                try { load_png(loaded, "test_memory.png"); }
+                catch (image_load_error&) { ++errors; }
+            }
+            DLIB_TEST(errors == 600);
+            DLIB_TEST(next_file_descriptor("test_memory.png") == fd);
+        }
+#endif
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    void test_load_image_from_file()
+    {
+        dlog << LINFO << "in test_load_image_from_file";
+        print_spinner();
+
+        dlib::rand rnd;
+        array2d<rgb_pixel> img(29,41);
+        for (long r = 0; r < img.nr(); ++r)
+        {
+            for (long c = 0; c < img.nc(); ++c)
+            {
+                img[r][c].red = rnd.get_random_8bit_number();
+                img[r][c].green = 5*r;
+                img[r][c].blue = 5*c;
+            }
+        }
+
+        // load_image() decodes every format from the one mapping of the file, which must
+        // give the same pixels as the format specific loaders
+        array2d<rgb_pixel> loaded, expected;
+        save_bmp(img, "test_memory.bmp");
+        load_image(loaded, "test_memory.bmp");
+        DLIB_TEST(same_pixels(loaded, img));
+
+        save_dng(img, "test_memory.dng");
+        load_image(loaded, "test_memory.dng");
+        DLIB_TEST(same_pixels(loaded, img));
+
+#ifdef DLIB_PNG_SUPPORT
+        save_png(img, "test_memory.png");
+        load_image(loaded, "test_memory.png");
+        DLIB_TEST(same_pixels(loaded, img));
+#endif
+
+#ifdef DLIB_JPEG_SUPPORT
+        save_jpeg(img, "test_memory.jpg", 90);
+        load_image(loaded, "test_memory.jpg");
+        load_jpeg(expected, "test_memory.jpg");
+        DLIB_TEST(same_pixels(loaded, expected));
+
+        // decoding errors still name the file they come from
+        std::vector<unsigned char> bytes = read_file_bytes("test_memory.jpg");
+        bytes.resize(bytes.size()/3);
+        std::fill(bytes.begin() + 20, bytes.end(), 0);
+        {
+            std::ofstream fout("test_memory.jpg", std::ios::binary);
+            fout.write((const char*)&bytes[0], bytes.size());
+        }
+        try
+        {
+            load_image(loaded, "test_memory.jpg");
+            DLIB_TEST_MSG(false, "a corrupt JPEG must not load");
+        }
+        catch (image_load_error& e)
+        {
+            DLIB_TEST_MSG(std::string(e.what()).find("in file test_memory.jpg") != std::string::npos, e.what());
+        }
+#endif
+
+        {
+            std::ofstream fout("test_memory.bmp", std::ios::binary);
+        }
+        try
+        {
+            load_image(loaded, "test_memory.bmp");
+            DLIB_TEST_MSG(false, "an empty file must not load");
+        }
+        catch (image_load_error& e)
+        {
+            DLIB_TEST(std::string(e.what()).find("Unknown image file format") != std::string::npos);
+        }
+
+        try
+        {
+            load_image(loaded, "test_memory_missing.jpg");
+            DLIB_TEST_MSG(false, "a missing file must not load");
+        }
+        catch (image_load_error& e)
+        {
+            DLIB_TEST(std::string(e.what()) == "Unable to open file: test_memory_missing.jpg");
+        }
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    void test_dispatched_kernels (
+        dlib::rand& rnd
+    )
+    {
+        dlog << LINFO << "cpu simd level: " << simd_level_name(get_cpu_simd_level());
+        for (int level = CPU_SIMD_AVX2; level <= get_cpu_simd_level(); ++level)
+        {
+            for (int iter = 0; iter < 20; ++iter)
+            {
+                print_spinner();
+                array2d<float> img(rnd.get_random_32bit_number()%100+1, rnd.get_random_32bit_number()%100+1);
+                for (long r = 0; r < img.nr(); ++r)
+                {
+                    for (long c = 0; c < img.nc(); ++c)
+                        img[r][c] = rnd.get_random_gaussian();
+                }
+                matrix<float,0,1> row_filt = matrix_cast<float>(randm(rnd.get_random_32bit_number()%9+1,1,rnd));
+                matrix<float,0,1> col_filt = matrix_cast<float>(randm(rnd.get_random_32bit_number()%9+1,1,rnd));
+                const bool add_to = rnd.get_random_32bit_number()%2 == 0;
+
+                array2d<float> ref_out(img.nr(), img.nc()), out(img.nr(), img.nc());
+                assign_all_pixels(ref_out, 1);
+                assign_all_pixels(out, 1);
+                set_max_simd_dispatch_level(CPU_SIMD_BASELINE);
+                const rectangle ref_rect = spatially_filter_image_separable(img, ref_out, row_filt, col_filt, 1, false, add_to);
+                set_max_simd_dispatch_level(static_cast<cpu_simd_level>(level));
+                const rectangle rect = spatially_filter_image_separable(img, out, row_filt, col_filt, 1, false, add_to);
+                DLIB_TEST(rect == ref_rect);
+                DLIB_TEST_MSG(max(abs(mat(out)-mat(ref_out))) < 1e-5, max(abs(mat(out)-mat(ref_out))));
+
+                // The resize kernel gives exactly the same pixels
+                array2d<unsigned char> gimg(rnd.get_random_32bit_number()%200+2, rnd.get_random_32bit_number()%200+2);
+                for (long r = 0; r < gimg.nr(); ++r)
+                {
+                    for (long c = 0; c < gimg.nc(); ++c)
+                        gimg[r][c] = rnd.get_random_8bit_number();
+                }
+                array2d<unsigned char> ref_small(rnd.get_random_32bit_number()%200+2, rnd.get_random_32bit_number()%200+2);
+                array2d<unsigned char> small(ref_small.nr(), ref_small.nc());
+                set_max_simd_dispatch_level(CPU_SIMD_BASELINE);
+                resize_image(gimg, ref_small);
+                set_max_simd_dispatch_level(static_cast<cpu_simd_level>(level));
+                resize_image(gimg, small);
+                DLIB_TEST(mat(small) == mat(ref_small));
+            }
+        }
+        set_max_simd_dispatch_level(CPU_SIMD_AVX512);
+    }
+
 // ----------------------------------------------------------------------------------------
 
     class image_tester : public tester
@@ -1864,6 +2449,12 @@ namespace
             test_dng_floats<long double>(1e30);
 
             test_dng_float_int();
+            test_load_image_from_memory();
+            test_jpeg_decode_options();
+            test_load_jpeg_pixel_types();
+            test_row_readers();
+            test_load_image_from_file();
+            test_corrupt_image_cleanup();
 
             dlib::rand rnd;
             for (int i = 0; i < 10; ++i)
@@ -1883,6 +2474,7 @@ namespace
                 test_separable_filtering_center<int>(rnd);
             for (int i = 0; i < 100; ++i)
                 test_separable_filtering_center<float>(rnd);
+            test_dispatched_kernels(rnd);
 
             {
                 print_spinner();
@@ -16,6 +16,9 @@
 #include <dlib/image_keypoint.h>
 #include <dlib/image_processing.h>
 #include <dlib/image_transforms.h>
+#include <dlib/dir_nav.h>
+#include <dlib/misc_api.h>
+#include <cstdio>
 
 namespace  
 {
@@ -430,10 +433,559 @@ namespace
             DLIB_TEST(d1.size() == d2.size());
             DLIB_TEST(set_intersection_size(d1,d2) == d1.size());
         }
+
+        {
+            // Reusing the same scratch space for many images must not change the detections.
+            std::vector<object_detector<image_scanner_type> > detectors;
+            detectors.push_back(detector);
+
+            fhog_scratch_space<unsigned char> scratch;
+            for (int pass = 0; pass < 2; ++pass)
+            {
+                for (unsigned long i = 0; i < images.size(); ++i)
+                {
+                    std::vector<rect_detection> dets1, dets2;
+                    evaluate_detectors(detectors, images[i], dets1, scratch);
+                    evaluate_detectors(detectors, images[i], dets2);
+                    DLIB_TEST(dets1.size() == dets2.size());
+                    for (unsigned long j = 0; j < dets1.size() && j < dets2.size(); ++j)
+                    {
+                        DLIB_TEST(dets1[j].rect == dets2[j].rect);
+                        DLIB_TEST(std::abs(dets1[j].detection_confidence - dets2[j].detection_confidence) < 1e-6);
+                    }
+                }
+            }
+        }
+
+        {
+            // Scanning with several threads must find exactly what a single thread finds.
+            image_scanner_type threaded_scanner;
+            threaded_scanner.copy_configuration(detector.get_scanner());
+            threaded_scanner.set_num_threads(4);
+            DLIB_TEST(threaded_scanner.get_num_threads() == 4);
+            object_detector<image_scanner_type> threaded_detector(threaded_scanner,
+                detector.get_overlap_tester(), detector.get_w());
+            DLIB_TEST(threaded_detector.get_scanner().get_num_threads() == 4);
+
+            for (unsigned long i = 0; i < images.size(); ++i)
+            {
+                // make the image big enough to get a few pyramid levels
+                array2d<unsigned char> big;
+                big.set_size(images[i].nr()*3, images[i].nc()*3);
+                resize_image(images[i], big);
+
+                std::vector<std::pair<double, rectangle> > dets1, dets2;
+                detector(big, dets1, -0.5);
+                threaded_detector(big, dets2, -0.5);
+                DLIB_TEST(dets1.size() > 0);
+                DLIB_TEST(dets1.size() == dets2.size());
+                for (unsigned long j = 0; j < dets1.size() && j < dets2.size(); ++j)
+                {
+                    DLIB_TEST(dets1[j].first == dets2[j].first);
+                    DLIB_TEST(dets1[j].second == dets2[j].second);
+                }
+
+                // evaluate_detectors() streams over the pyramid levels instead of loading
+                // the whole pyramid, but must still find the same objects.
+                std::vector<object_detector<image_scanner_type> > detectors(1, detector);
+                std::vector<rect_detection> dets3;
+                evaluate_detectors(detectors, big, dets3, -0.5);
+                DLIB_TEST(dets1.size() == dets3.size());
+                for (unsigned long j = 0; j < dets1.size() && j < dets3.size(); ++j)
+                {
+                    DLIB_TEST(std::abs(dets1[j].first - dets3[j].detection_confidence) < 1e-6);
+                    DLIB_TEST(dets1[j].second == dets3[j].rect);
+                }
+            }
+        }
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    void test_interleaved_fhog_filtering (
+    )
+    {
+        print_spinner();
+        dlog << LINFO << "test_interleaved_fhog_filtering()";
+
+        typedef scan_fhog_pyramid<pyramid_down<2> > image_scanner_type;
+        dlib::rand rnd;
+
+        image_scanner_type scanner;
+        scanner.set_detection_window_size(40,40);
+        matrix<double,0,1> weights(scanner.get_num_dimensions());
+        for (long i = 0; i < weights.size(); ++i)
+            weights(i) = rnd.get_random_gaussian();
+        image_scanner_type::fhog_filterbank fb = scanner.build_fhog_filterbank(weights);
+
+        for (int iter = 0; iter < 4; ++iter)
+        {
+            // The images include some smaller than the filter
+            dlib::array<array2d<float> > feats(31);
+            const long nr = rnd.get_random_32bit_number()%30 + 3;
+            const long nc = rnd.get_random_32bit_number()%30 + 3;
+            for (unsigned long i = 0; i < feats.size(); ++i)
+            {
+                feats[i].set_size(nr, nc);
+                for (long r = 0; r < nr; ++r)
+                    for (long c = 0; c < nc; ++c)
+                        feats[i][r][c] = rnd.get_random_float();
+            }
+
+            std::vector<float> cells;
+            impl::interleave_fhog_planes(feats, cells);
+            DLIB_TEST(cells.size() == (unsigned long)(nr*nc*32));
+            DLIB_TEST(cells[(2*nc + 1)*32 + 5] == feats[5][2][1]);
+            DLIB_TEST(cells[(2*nc + 1)*32 + 31] == 0);
+
+            // compare with filtering each plane on its own using the full filters
+            array2d<float> planar, temp, interleaved;
+            rectangle area1 = spatially_filter_image(feats[0], planar, fb.filters[0]);
+            for (unsigned long i = 1; i < feats.size(); ++i)
+                spatially_filter_image(feats[i], planar, fb.filters[i], 1, false, true);
+            rectangle area2 = impl::apply_interleaved_filters_to_fhog(fb, feats, cells, interleaved);
+
+            DLIB_TEST(area1 == area2);
+            DLIB_TEST(interleaved.nr() == nr && interleaved.nc() == nc);
+            for (long r = 0; r < nr; ++r)
+            {
+                for (long c = 0; c < nc; ++c)
+                {
+                    if (area1.contains(c,r))
+                        DLIB_TEST_MSG(std::abs(planar[r][c] - interleaved[r][c]) < 1e-3, planar[r][c] - interleaved[r][c]);
+                    else
+                        DLIB_TEST(interleaved[r][c] == 0);
+                }
+            }
+        }
+
+        // An interleaved detector finds the same objects as a planar one.
+        typedef dlib::array<array2d<unsigned char> >  grayscale_image_array_type;
+        grayscale_image_array_type images;
+        std::vector<std::vector<rectangle> > object_locations;
+        make_simple_test_data(images, object_locations);
+
+        scanner.set_detection_window_size(35,35);
+        structural_object_detection_trainer<image_scanner_type> trainer(scanner);
+        trainer.set_num_threads(4);  
+        trainer.set_overlap_tester(test_box_overlap(0,0));
+        object_detector<image_scanner_type> detector = trainer.train(images, object_locations);
+
+        image_scanner_type interleaved_scanner;
+        interleaved_scanner.copy_configuration(detector.get_scanner());
+        interleaved_scanner.set_interleaved_filtering(true);
+        DLIB_TEST(interleaved_scanner.get_interleaved_filtering());
+        object_detector<image_scanner_type> interleaved_detector(interleaved_scanner,
+            detector.get_overlap_tester(), detector.get_w());
+
+        matrix<double> res = test_object_detection_function(interleaved_detector, images, object_locations);
+        dlog << LINFO << "Test interleaved detector (precision,recall): " << res;
+        DLIB_TEST(sum(res) == 3);
+
+        for (unsigned long i = 0; i < images.size(); ++i)
+        {
+            std::vector<rectangle> dets1 = detector(images[i]);
+            std::vector<rectangle> dets2 = interleaved_detector(images[i]);
+            DLIB_TEST(dets1.size() == dets2.size());
+            for (unsigned long j = 0; j < dets1.size() && j < dets2.size(); ++j)
+                DLIB_TEST(dets1[j] == dets2[j]);
+
+            std::vector<object_detector<image_scanner_type> > detectors(1, interleaved_detector);
+            std::vector<rectangle> dets3 = evaluate_detectors(detectors, images[i]);
+            DLIB_TEST(dets2.size() == dets3.size());
+            for (unsigned long j = 0; j < dets2.size() && j < dets3.size(); ++j)
+                DLIB_TEST(dets2[j] == dets3[j]);
+        }
     }
 
 // ----------------------------------------------------------------------------------------
 
+    void test_bounded_fhog_detect (
+    )
+    {
+        print_spinner();
+        dlog << LINFO << "test_bounded_fhog_detect()";
+
+        typedef scan_fhog_pyramid<pyramid_down<2> > image_scanner_type;
+        dlib::rand rnd;
+
+        image_scanner_type scanner;
+        scanner.set_detection_window_size(40,40);
+        matrix<double,0,1> weights(scanner.get_num_dimensions());
+        for (long i = 0; i < weights.size(); ++i)
+            weights(i) = rnd.get_random_gaussian();
+        image_scanner_type::fhog_filterbank fb = scanner.build_fhog_filterbank(weights);
+        const double filter_norm = impl::fhog_filterbank_norm(fb);
+        DLIB_TEST(std::abs(filter_norm - length(rowm(weights,range(0,scanner.get_num_dimensions()-1)))) < 1e-3*filter_norm);
+
+        // The level bound really is an upper bound on the filter outputs
+        for (int iter = 0; iter < 4; ++iter)
+        {
+            dlib::array<array2d<float> > feats(31);
+            const long nr = rnd.get_random_32bit_number()%30 + 3;
+            const long nc = rnd.get_random_32bit_number()%30 + 3;
+            for (unsigned long i = 0; i < feats.size(); ++i)
+            {
+                feats[i].set_size(nr, nc);
+                for (long r = 0; r < nr; ++r)
+                    for (long c = 0; c < nc; ++c)
+                        feats[i][r][c] = rnd.get_random_float();
+            }
+
+            array2d<float> saliency_image;
+            const rectangle area = impl::apply_filters_to_fhog(fb, feats, saliency_image);
+            const double bound = impl::fhog_level_score_bound(feats, fb.filters[0].nr(), fb.filters[0].nc(), filter_norm);
+            if (area.is_empty())
+                DLIB_TEST(bound < 0);
+            for (long r = area.top(); r <= area.bottom(); ++r)
+                for (long c = area.left(); c <= area.right(); ++c)
+                    DLIB_TEST(saliency_image[r][c] <= bound);
+        }
+
+        typedef dlib::array<array2d<unsigned char> >  grayscale_image_array_type;
+        grayscale_image_array_type images;
+        std::vector<std::vector<rectangle> > object_locations;
+        make_simple_test_data(images, object_locations);
+
+        scanner.set_detection_window_size(35,35);
+        structural_object_detection_trainer<image_scanner_type> trainer(scanner);
+        trainer.set_num_threads(4);  
+        trainer.set_overlap_tester(test_box_overlap(0,0));
+        object_detector<image_scanner_type> detector = trainer.train(images, object_locations);
+        matrix<double> res = test_object_detection_function(detector, images, object_locations);
+        DLIB_TEST(sum(res) == 3);
+
+        // The bounded detect gives the strongest detections of the regular one, with and
+        // without threads.
+        for (unsigned long num_threads = 1; num_threads <= 2; ++num_threads)
+        {
+            image_scanner_type test_scanner;
+            test_scanner.copy_configuration(detector.get_scanner());
+            test_scanner.set_num_threads(num_threads);
+            for (unsigned long i = 0; i < images.size(); ++i)
+            {
+                test_scanner.load(images[i]);
+                const double thresh = detector.get_w()(test_scanner.get_num_dimensions()) - 1;
+                std::vector<std::pair<double, rectangle> > dets, bounded_dets;
+                test_scanner.detect(detector.get_w(), dets, thresh);
+                DLIB_TEST(dets.size() > 0);
+
+                const unsigned long max_dets[] = {0, 1, 3, 20, dets.size(), dets.size()+10};
+                for (unsigned long k = 0; k < sizeof(max_dets)/sizeof(max_dets[0]); ++k)
+                {
+                    test_scanner.detect(detector.get_w(), bounded_dets, thresh, max_dets[k]);
+                    DLIB_TEST(bounded_dets.size() == std::min(max_dets[k], (unsigned long)dets.size()));
+                    for (unsigned long j = 0; j < bounded_dets.size() && j < dets.size(); ++j)
+                    {
+                        DLIB_TEST(bounded_dets[j].first == dets[j].first);
+                        if ((j == 0 || dets[j-1].first != dets[j].first) && 
+                            (j+1 == dets.size() || dets[j+1].first != dets[j].first))
+                        {
+                            DLIB_TEST(bounded_dets[j].second == dets[j].second);
+                        }
+                    }
+                }
+
+                // A threshold nothing can reach prunes every level.
+                test_scanner.detect(detector.get_w(), bounded_dets, 1e10, 5);
+                DLIB_TEST(bounded_dets.size() == 0);
+            }
+        }
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    void test_compressed_fhog_storage (
+    )
+    {
+        print_spinner();
+        dlog << LINFO << "test_compressed_fhog_storage()";
+
+        dlib::rand rnd;
+        const cpu_simd_level level = get_simd_dispatch_level();
+        for (int iter = 0; iter < 4; ++iter)
+        {
+            dlib::array<array2d<float> > feats(31);
+            const long nr = rnd.get_random_32bit_number()%30 + 1;
+            const long nc = rnd.get_random_32bit_number()%30 + 1;
+            for (unsigned long i = 0; i < feats.size(); ++i)
+            {
+                feats[i].set_size(nr, nc);
+                for (long r = 0; r < nr; ++r)
+                    for (long c = 0; c < nc; ++c)
+                        feats[i][r][c] = rnd.get_random_float()*(i+1);
+            }
+
+            impl::compressed_fhog_image half, bytes;
+            half.compress(feats, FHOG_STORE_HALF);
+            bytes.compress(feats, FHOG_STORE_UINT8);
+            DLIB_TEST(half.size() == 31 && half.nr() == nr && half.nc() == nc);
+            DLIB_TEST(half.memory_usage() == 31*nr*nc*2);
+            DLIB_TEST(bytes.memory_usage() == 31*nr*nc + 31*2*4);
+
+            dlib::array<array2d<float> > half_feats, byte_feats;
+            half.decompress(half_feats);
+            bytes.decompress(byte_feats);
+            for (unsigned long i = 0; i < feats.size(); ++i)
+            {
+                const float range = max(mat(feats[i])) - min(mat(feats[i]));
+                for (long r = 0; r < nr; ++r)
+                {
+                    for (long c = 0; c < nc; ++c)
+                    {
+                        DLIB_TEST(half_feats[i][r][c] == half(i,r,c));
+                        DLIB_TEST(byte_feats[i][r][c] == bytes(i,r,c));
+                        DLIB_TEST(std::abs(half_feats[i][r][c] - feats[i][r][c]) <= feats[i][r][c]/2048);
+                        DLIB_TEST(std::abs(byte_feats[i][r][c] - feats[i][r][c]) <= range/510*1.001);
+                    }
+                }
+            }
+
+            // the dispatched kernels expand to exactly the same values
+            for (int l = CPU_SIMD_BASELINE; l < level; ++l)
+            {
+                set_max_simd_dispatch_level(static_cast<cpu_simd_level>(l));
+                dlib::array<array2d<float> > half_feats2, byte_feats2;
+                half.decompress(half_feats2);
+                bytes.decompress(byte_feats2);
+                for (unsigned long i = 0; i < feats.size(); ++i)
+                {
+                    DLIB_TEST(mat(half_feats2[i]) == mat(half_feats[i]));
+                    DLIB_TEST(mat(byte_feats2[i]) == mat(byte_feats[i]));
+                }
+            }
+            set_max_simd_dispatch_level(CPU_SIMD_AVX512);
+        }
+
+        DLIB_TEST(impl_fhog::float_to_half(1) == 0x3c00);
+        DLIB_TEST(impl_fhog::float_to_half(-2) == 0xc000);
+        DLIB_TEST(impl_fhog::float_to_half(1e6) == 0x7c00);
+        DLIB_TEST(impl_fhog::half_to_float(0x0001) == std::pow(2.0f,-24));
+        DLIB_TEST(impl_fhog::half_to_float(0x7bff) == 65504);
+
+        // Detectors trained on compressed features work as well as the normal ones
+        typedef scan_fhog_pyramid<pyramid_down<2> > image_scanner_type;
+        typedef dlib::array<array2d<unsigned char> >  grayscale_image_array_type;
+        grayscale_image_array_type images;
+        std::vector<std::vector<rectangle> > object_locations;
+        make_simple_test_data(images, object_locations);
+
+        const fhog_feature_storage storages[] = {FHOG_STORE_HALF, FHOG_STORE_UINT8};
+        for (int k = 0; k < 2; ++k)
+        {
+            image_scanner_type scanner;
+            scanner.set_detection_window_size(35,35);
+            scanner.set_feature_storage(storages[k]);
+            structural_object_detection_trainer<image_scanner_type> trainer(scanner);
+            trainer.set_num_threads(4);  
+            trainer.set_overlap_tester(test_box_overlap(0,0));
+            object_detector<image_scanner_type> detector = trainer.train(images, object_locations);
+
+            // The detector's scanner keeps the storage setting, but the weights work just
+            // as well on normal float features.
+            DLIB_TEST(detector.get_scanner().get_feature_storage() == storages[k]);
+            matrix<double> res = test_object_detection_function(detector, images, object_locations);
+            dlog << LINFO << "Test detector trained on compressed features (precision,recall): " << res;
+            DLIB_TEST(sum(res) == 3);
+
+            image_scanner_type float_scanner;
+            float_scanner.copy_configuration(detector.get_scanner());
+            float_scanner.set_feature_storage(FHOG_STORE_FLOAT);
+            object_detector<image_scanner_type> float_detector(float_scanner,
+                detector.get_overlap_tester(), detector.get_w());
+            res = test_object_detection_function(float_detector, images, object_locations);
+            DLIB_TEST(sum(res) == 3);
+        }
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    void remove_feature_cache (
+        const std::string& dir
+    )
+    {
+        const std::vector<file> files = directory(dir).get_files();
+        for (unsigned long i = 0; i < files.size(); ++i)
+            std::remove(files[i].full_name().c_str());
+        std::remove(dir.c_str());
+    }
+
+    void test_fhog_feature_cache (
+    )
+    {
+        print_spinner();
+        dlog << LINFO << "test_fhog_feature_cache()";
+
+        typedef scan_fhog_pyramid<pyramid_down<2> > image_scanner_type;
+        typedef dlib::array<array2d<unsigned char> >  grayscale_image_array_type;
+        grayscale_image_array_type images;
+        std::vector<std::vector<rectangle> > object_locations;
+        make_simple_test_data(images, object_locations);
+
+        const std::string dir = "fhog_feature_cache_test";
+        create_directory(dir);
+        remove_feature_cache(dir);
+        create_directory(dir);
+
+        dlib::rand rnd;
+        matrix<double,0,1> w(image_scanner_type().get_num_dimensions());
+        for (long i = 0; i < w.size(); ++i)
+            w(i) = rnd.get_random_gaussian();
+
+        const fhog_feature_storage storages[] = {FHOG_STORE_FLOAT, FHOG_STORE_HALF, FHOG_STORE_UINT8};
+        for (int k = 0; k < 3; ++k)
+        {
+            image_scanner_type memory_scanner, cached_scanner, cached_scanner2;
+            memory_scanner.set_feature_storage(storages[k]);
+            cached_scanner.copy_configuration(memory_scanner);
+            cached_scanner.set_feature_cache_directory(dir);
+            cached_scanner2.copy_configuration(cached_scanner);
+            DLIB_TEST(cached_scanner2.get_feature_cache_directory() == dir);
+
+            memory_scanner.load(images[0]);
+            cached_scanner.load(images[0]);
+            DLIB_TEST(directory(dir).get_files().size() == (unsigned long)k+1);
+            // The second scanner maps the file written by the first one
+            cached_scanner2.load(images[0]);
+            DLIB_TEST(directory(dir).get_files().size() == (unsigned long)k+1);
+            DLIB_TEST(cached_scanner2.is_loaded_with_image());
+
+            std::vector<std::pair<double,rectangle> > dets1, dets2, dets3;
+            memory_scanner.detect(w, dets1, -1e10);
+            cached_scanner.detect(w, dets2, -1e10);
+            cached_scanner2.detect(w, dets3, -1e10);
+            DLIB_TEST(dets1.size() != 0);
+            DLIB_TEST(dets1 == dets2);
+            DLIB_TEST(dets1 == dets3);
+
+            matrix<double,0,1> psi1(w.size()), psi2(w.size());
+            psi1 = 0;
+            psi2 = 0;
+            memory_scanner.get_feature_vector(full_object_detection(object_locations[0][0]), psi1);
+            cached_scanner2.get_feature_vector(full_object_detection(object_locations[0][0]), psi2);
+            DLIB_TEST(psi1 == psi2);
+
+            // A loaded scanner serializes the same way wherever its features live
+            ostringstream sout1, sout2;
+            serialize(memory_scanner, sout1);
+            serialize(cached_scanner2, sout2);
+            DLIB_TEST(sout1.str() == sout2.str());
+        }
+
+        // A damaged cache file is replaced rather than used
+        {
+            const std::vector<file> files = directory(dir).get_files();
+            for (unsigned long i = 0; i < files.size(); ++i)
+            {
+                std::ofstream fout(files[i].full_name().c_str(), std::ios::binary);
+                fout << "garbage";
+            }
+
+            image_scanner_type memory_scanner, cached_scanner;
+            cached_scanner.set_feature_cache_directory(dir);
+            memory_scanner.load(images[0]);
+            cached_scanner.load(images[0]);
+            std::vector<std::pair<double,rectangle> > dets1, dets2;
+            memory_scanner.detect(w, dets1, -1e10);
+            cached_scanner.detect(w, dets2, -1e10);
+            DLIB_TEST(dets1 == dets2);
+        }
+
+        // Training through the cache gives the same detector
+        {
+            image_scanner_type scanner;
+            scanner.set_detection_window_size(35,35);
+            structural_object_detection_trainer<image_scanner_type> trainer(scanner);
+            trainer.set_num_threads(4);  
+            trainer.set_overlap_tester(test_box_overlap(0,0));
+            object_detector<image_scanner_type> detector = trainer.train(images, object_locations);
+
+            scanner.set_feature_cache_directory(dir);
+            structural_object_detection_trainer<image_scanner_type> cached_trainer(scanner);
+            cached_trainer.set_num_threads(4);  
+            cached_trainer.set_overlap_tester(test_box_overlap(0,0));
+            object_detector<image_scanner_type> cached_detector = cached_trainer.train(images, object_locations);
+            DLIB_TEST(max(abs(detector.get_w() - cached_detector.get_w())) == 0);
+
+            matrix<double> res = test_object_detection_function(cached_detector, images, object_locations);
+            dlog << LINFO << "Test detector trained from the feature cache (precision,recall): " << res;
+            DLIB_TEST(sum(res) == 3);
+        }
+
+        remove_feature_cache(dir);
+    }
+
+    void test_prepared_dataset (
+    )
+    {
+        print_spinner();
+        dlog << LINFO << "test_prepared_dataset()";
+
+        typedef scan_fhog_pyramid<pyramid_down<2> > image_scanner_type;
+        typedef dlib::array<array2d<unsigned char> >  grayscale_image_array_type;
+        grayscale_image_array_type images;
+        std::vector<std::vector<rectangle> > object_locations;
+        make_simple_test_data(images, object_locations);
+        const std::vector<std::vector<rectangle> > ignore(images.size());
+
+        image_scanner_type scanner;
+        scanner.set_detection_window_size(35,35);
+        const prepared_object_detection_dataset<image_scanner_type> dataset(scanner, images, object_locations, ignore);
+        DLIB_TEST(dataset.size() == images.size());
+        DLIB_TEST(dataset[0].is_loaded_with_image());
+        DLIB_TEST(!dataset.get_scanner().is_loaded_with_image());
+
+        std::vector<unsigned long> samples;
+        samples.push_back(2);
+        samples.push_back(0);
+        const prepared_object_detection_dataset<image_scanner_type> sub = dataset.subset(samples);
+        DLIB_TEST(sub.size() == 2);
+        DLIB_TEST(&sub[0] == &dataset[2]);
+        DLIB_TEST(&sub[1] == &dataset[0]);
+        DLIB_TEST(sub.get_truth_object_detections()[0].size() == object_locations[2].size());
+
+        // Training on the prepared dataset gives the same detectors as training on the
+        // images, for every value of C tried on it.
+        const double Cs[] = {1, 10};
+        for (int k = 0; k < 2; ++k)
+        {
+            structural_object_detection_trainer<image_scanner_type> trainer(scanner);
+            trainer.set_num_threads(4);  
+            trainer.set_overlap_tester(test_box_overlap(0,0));
+            trainer.set_c(Cs[k]);
+            object_detector<image_scanner_type> detector = trainer.train(images, object_locations);
+            object_detector<image_scanner_type> prepared_detector = trainer.train(dataset);
+            DLIB_TEST(max(abs(detector.get_w() - prepared_detector.get_w())) == 0);
+
+            matrix<double> res1 = test_object_detection_function(detector, images, object_locations);
+            matrix<double> res2 = test_object_detection_function(detector, dataset);
+            DLIB_TEST(res1 == res2);
+
+            res1 = cross_validate_object_detection_trainer(trainer, images, object_locations, 3);
+            res2 = cross_validate_object_detection_trainer(trainer, dataset, 3);
+            dlog << LINFO << "cross validation on the prepared dataset (precision,recall): " << res2;
+            DLIB_TEST(res1 == res2);
+        }
+
+        // Scanners loaded by the caller (here in reverse order) make the same dataset
+        dlib::array<image_scanner_type> loaded;
+        loaded.set_max_size(images.size());
+        loaded.set_size(images.size());
+        for (long i = images.size()-1; i >= 0; --i)
+        {
+            loaded[i].copy_configuration(scanner);
+            loaded[i].load(images[i]);
+        }
+        const prepared_object_detection_dataset<image_scanner_type> taken(scanner, loaded, object_locations, ignore);
+        DLIB_TEST(loaded.size() == 0);
+        DLIB_TEST(taken.size() == images.size());
+        DLIB_TEST(taken.get_truth_object_detections().size() == images.size());
+        structural_object_detection_trainer<image_scanner_type> trainer(scanner);
+        trainer.set_num_threads(4);
+        trainer.set_overlap_tester(test_box_overlap(0,0));
+        DLIB_TEST(max(abs(trainer.train(dataset).get_w() - trainer.train(taken).get_w())) == 0);
+    }
+
     void test_1 (
     )
     {        
@@ -1008,6 +1560,11 @@ namespace
         )
         {
             test_fhog_pyramid();
+            test_interleaved_fhog_filtering();
+            test_bounded_fhog_detect();
+            test_compressed_fhog_storage();
+            test_fhog_feature_cache();
+            test_prepared_dataset();
             test_1_boxes();
             test_1_poly_nn_boxes();
             test_3_boxes();
@@ -22,6 +22,73 @@ namespace
 
     logger dlog("test.oca");
 
+// ----------------------------------------------------------------------------------------
+
+    template <typename matrix_type>
+    class hinge_loss_problem : public oca_problem<matrix_type>
+    {
+        /*!
+            A linear SVM without a bias term.  Unlike make_oca_problem_c_svm() it keeps no
+            state between calls to get_risk(), so a resumed oca run follows exactly the
+            same path as an uninterrupted one.
+        !*/
+    public:
+        typedef typename matrix_type::type scalar_type;
+
+        hinge_loss_problem (
+            const std::vector<matrix_type>& x_,
+            const std::vector<scalar_type>& y_,
+            scalar_type C_,
+            unsigned long max_iterations_
+        ) : x(x_), y(y_), C(C_), max_iterations(max_iterations_) {}
+
+        virtual bool risk_has_lower_bound (
+            scalar_type& lower_bound
+        ) const { lower_bound = 0; return true; }
+
+        virtual bool optimization_status (
+            scalar_type ,
+            scalar_type ,
+            scalar_type ,
+            scalar_type risk_gap,
+            unsigned long ,
+            unsigned long num_iterations
+        ) const { return num_iterations >= max_iterations || risk_gap < 1e-6; }
+
+        virtual scalar_type get_c (
+        ) const { return C; }
+
+        virtual long get_num_dimensions (
+        ) const { return x[0].size(); }
+
+        virtual void get_risk (
+            matrix_type& w,
+            scalar_type& risk,
+            matrix_type& subgradient
+        ) const
+        {
+            subgradient = zeros_matrix(w);
+            risk = 0;
+            for (unsigned long i = 0; i < x.size(); ++i)
+            {
+                const scalar_type df_val = y[i]*dot(w, x[i]);
+                if (df_val < 1)
+                {
+                    risk += 1 - df_val;
+                    subgradient -= y[i]*x[i];
+                }
+            }
+            risk /= x.size();
+            subgradient /= x.size();
+        }
+
+    private:
+        const std::vector<matrix_type>& x;
+        const std::vector<scalar_type>& y;
+        const scalar_type C;
+        const unsigned long max_iterations;
+    };
+
 // ----------------------------------------------------------------------------------------
 
     class test_oca : public tester
@@ -234,6 +301,137 @@ namespace
             dlog << LINFO << "error: "<< max(abs(w-true_w));
             DLIB_TEST(max(abs(w-true_w)) < 1e-10);
 
+            test_max_num_planes();
+            test_resume();
+        }
+
+        void test_resume (
+        )
+        {
+            print_spinner();
+            dlog << LINFO << "test_resume()";
+
+            typedef matrix<double,0,1> w_type;
+            std::vector<w_type> x;
+            std::vector<double> y;
+
+            dlib::rand rnd;
+            w_type true_w(30);
+            for (long i = 0; i < true_w.size(); ++i)
+                true_w(i) = rnd.get_random_gaussian();
+            for (int i = 0; i < 200; ++i)
+            {
+                w_type temp(30);
+                for (long j = 0; j < temp.size(); ++j)
+                    temp(j) = rnd.get_random_gaussian();
+                x.push_back(temp);
+                y.push_back(dot(temp,true_w) + rnd.get_random_gaussian() > 0 ? +1 : -1);
+            }
+
+            for (int bounded = 0; bounded < 2; ++bounded)
+            {
+                oca solver;
+                if (bounded)
+                    solver.set_max_num_planes(8);
+
+                // an uninterrupted run
+                w_type w;
+                oca_state<w_type> state;
+                DLIB_TEST(state.empty());
+                const double obj = solver(hinge_loss_problem<w_type>(x, y, 10.0, 300), w, state);
+                DLIB_TEST(!state.empty());
+                DLIB_TEST(state.num_iterations > 12);
+                const unsigned long num_iterations = state.num_iterations;
+
+                w_type w_plain;
+                const double obj_plain = solver(hinge_loss_problem<w_type>(x, y, 10.0, 300), w_plain);
+                DLIB_TEST(obj == obj_plain);
+                DLIB_TEST(w == w_plain);
+
+                // the same run stopped after 6 iterations, saved, and resumed
+                state.clear();
+                DLIB_TEST(state.empty() && state.num_iterations == 0);
+                w_type w_resumed;
+                solver(hinge_loss_problem<w_type>(x, y, 10.0, 6), w_resumed, state);
+                DLIB_TEST(state.num_iterations == 6);
+
+                ostringstream sout;
+                serialize(state, sout);
+                oca_state<w_type> state2;
+                istringstream sin(sout.str());
+                deserialize(state2, sin);
+                DLIB_TEST(state2.num_iterations == 6);
+                DLIB_TEST(state2.planes.size() == state.planes.size());
+
+                const double obj_resumed = solver(hinge_loss_problem<w_type>(x, y, 10.0, 300), w_resumed, state2);
+                dlog << LINFO << "bounded: " << bounded << "  iterations: " << num_iterations << "  objective: " << obj << "  resumed objective: " << obj_resumed;
+                DLIB_TEST(state2.num_iterations == num_iterations);
+                DLIB_TEST(obj_resumed == obj);
+                DLIB_TEST(w_resumed == w);
+
+                // a corrupted state is rejected
+                string bad = sout.str();
+                bad.resize(bad.size()/2);
+                istringstream sin2(bad);
+                bool caught = false;
+                try { deserialize(state2, sin2); }
+                catch (serialization_error&) { caught = true; }
+                DLIB_TEST(caught);
+            }
+        }
+
+        void test_max_num_planes (
+        )
+        {
+            print_spinner();
+            dlog << LINFO << "test_max_num_planes()";
+
+            typedef matrix<double,0,1> w_type;
+            std::vector<w_type> x;
+            std::vector<double> y;
+
+            // a noisy linear problem that takes OCA many iterations to solve
+            dlib::rand rnd;
+            w_type true_w(40);
+            for (long i = 0; i < true_w.size(); ++i)
+                true_w(i) = rnd.get_random_gaussian();
+            for (int i = 0; i < 300; ++i)
+            {
+                w_type temp(40);
+                for (long j = 0; j < temp.size(); ++j)
+                    temp(j) = rnd.get_random_gaussian();
+                x.push_back(temp);
+                y.push_back(dot(temp,true_w) + rnd.get_random_gaussian() > 0 ? +1 : -1);
+            }
+
+            oca solver;
+            DLIB_TEST(solver.get_max_num_planes() == 0);
+            w_type w, w_bounded;
+            const double obj = solver(make_oca_problem_c_svm<w_type>(10.0, 10.0, mat(x), mat(y), false, 1e-9, 10000, max_index_plus_one(x)), w);
+            const double obj_nonneg = solver(make_oca_problem_c_svm<w_type>(10.0, 10.0, mat(x), mat(y), false, 1e-9, 10000, max_index_plus_one(x)), w, 20);
+            const double obj_lasso = solver.solve_with_elastic_net(make_oca_problem_c_svm<w_type>(10.0, 10.0, mat(x), mat(y), false, 1e-9, 10000, max_index_plus_one(x)), w, 0.5);
+            solver(make_oca_problem_c_svm<w_type>(10.0, 10.0, mat(x), mat(y), false, 1e-9, 10000, max_index_plus_one(x)), w);
+
+            // Bounding the number of planes must not change the solution OCA converges to,
+            // although it may take more iterations to get there.
+            const unsigned long max_planes[] = {2, 3, 8};
+            for (int k = 0; k < 3; ++k)
+            {
+                solver.set_max_num_planes(max_planes[k]);
+                DLIB_TEST(solver.get_max_num_planes() == max_planes[k]);
+
+                double obj_bounded = solver(make_oca_problem_c_svm<w_type>(10.0, 10.0, mat(x), mat(y), false, 1e-6, 100000, max_index_plus_one(x)), w_bounded);
+                dlog << LINFO << "max planes: " << max_planes[k] << "  objective: " << obj_bounded << "  unbounded objective: " << obj;
+                DLIB_TEST(std::abs(obj_bounded - obj) < 1e-4*obj);
+                DLIB_TEST(max(abs(w_bounded - w)) < 1e-2);
+
+                obj_bounded = solver(make_oca_problem_c_svm<w_type>(10.0, 10.0, mat(x), mat(y), false, 1e-6, 100000, max_index_plus_one(x)), w_bounded, 20);
+                DLIB_TEST(std::abs(obj_bounded - obj_nonneg) < 1e-4*obj_nonneg);
+                DLIB_TEST(min(rowm(w_bounded,range(0,19))) >= 0);
+
+                obj_bounded = solver.solve_with_elastic_net(make_oca_problem_c_svm<w_type>(10.0, 10.0, mat(x), mat(y), false, 1e-6, 100000, max_index_plus_one(x)), w_bounded, 0.5);
+                DLIB_TEST(std::abs(obj_bounded - obj_lasso) < 1e-4*obj_lasso);
+            }
         }
 
     } a;
@@ -4,6 +4,7 @@
 #include <string>
 #include <cstdlib>
 #include <ctime>
+#include <cstring>
 #include <dlib/image_transforms.h>
 //#include <dlib/gui_widgets.h>
 #include <dlib/rand.h>
@@ -304,6 +305,61 @@ void test_pyramid_down_small_sizes()
     }
 }
 
+// ----------------------------------------------------------------------------------------
+
+template <unsigned int N, typename pixel_type>
+void test_pyramid_down_resampler(dlib::rand& rnd)
+{
+    // pyramid_down<N> for N > 3 resamples 8 bit images in two separable passes.  It
+    // should agree with resize_image() up to rounding and be the same at every dispatch
+    // level.
+    pyramid_down<N> pyr;
+    const cpu_simd_level level = get_simd_dispatch_level();
+
+    for (int iter = 0; iter < 10; ++iter)
+    {
+        array2d<pixel_type> img(rnd.get_random_32bit_number()%200+2, rnd.get_random_32bit_number()%200+2);
+        for (long r = 0; r < img.nr(); ++r)
+        {
+            for (long c = 0; c < img.nc(); ++c)
+            {
+                unsigned char* p = (unsigned char*)&img[r][c];
+                for (unsigned long k = 0; k < sizeof(pixel_type); ++k)
+                    p[k] = rnd.get_random_8bit_number();
+            }
+        }
+
+        array2d<pixel_type> down, expected;
+        pyr(img, down);
+        expected.set_size(down.nr(), down.nc());
+        resize_image(img, expected);
+
+        DLIB_TEST(down.nr() == ((N-1)*img.nr())/N);
+        DLIB_TEST(down.nc() == ((N-1)*img.nc())/N);
+        for (long r = 0; r < down.nr(); ++r)
+        {
+            for (long c = 0; c < down.nc(); ++c)
+            {
+                const unsigned char* a = (const unsigned char*)&down[r][c];
+                const unsigned char* b = (const unsigned char*)&expected[r][c];
+                for (unsigned long k = 0; k < sizeof(pixel_type); ++k)
+                    DLIB_TEST_MSG(std::abs((int)a[k] - (int)b[k]) <= 1, (int)a[k] << "  " << (int)b[k]);
+            }
+        }
+
+        for (int l = CPU_SIMD_BASELINE; l < level; ++l)
+        {
+            set_max_simd_dispatch_level(static_cast<cpu_simd_level>(l));
+            array2d<pixel_type> down2;
+            pyr(img, down2);
+            DLIB_TEST(down2.nr() == down.nr() && down2.nc() == down.nc());
+            for (long r = 0; r < down.nr(); ++r)
+                DLIB_TEST(std::memcmp(&down2[r][0], &down[r][0], down.nc()*sizeof(pixel_type)) == 0);
+        }
+        set_max_simd_dispatch_level(CPU_SIMD_AVX512);
+    }
+}
+
 // ----------------------------------------------------------------------------------------
 
 
@@ -378,6 +434,14 @@ void test_pyramid_down_small_sizes()
             print_spinner();
             dlog << LINFO << "call test_pyramid_down_grayscale2<pyramid_down<6> >();";
             test_pyramid_down_grayscale2<pyramid_down<6> >();
+
+            print_spinner();
+            dlib::rand rnd;
+            test_pyramid_down_resampler<4,unsigned char>(rnd);
+            test_pyramid_down_resampler<5,unsigned char>(rnd);
+            test_pyramid_down_resampler<6,unsigned char>(rnd);
+            test_pyramid_down_resampler<4,rgb_pixel>(rnd);
+            test_pyramid_down_resampler<6,rgb_pixel>(rnd);
         }
     } a;
 
@@ -139,6 +139,116 @@ namespace
         const long dims;
     };
 
+// ----------------------------------------------------------------------------------------
+
+    class test_uneven_svm_problem : public structural_svm_problem_threaded<matrix<double,0,1> >
+    {
+        /*!
+            A binary SVM whose first few samples are much more expensive to run the
+            separation oracle on than the rest.  It counts how often each sample is
+            visited.
+        !*/
+    public:
+        typedef matrix<double,0,1> matrix_type;
+
+        test_uneven_svm_problem (
+            unsigned long num_threads
+        ) :
+            structural_svm_problem_threaded<matrix_type>(num_threads)
+        {
+            dlib::rand rnd;
+            for (int i = 0; i < 200; ++i)
+            {
+                matrix_type temp(5);
+                for (long j = 0; j < temp.size(); ++j)
+                    temp(j) = rnd.get_random_gaussian();
+                samples.push_back(temp);
+                labels.push_back(rnd.get_random_double() < 0.5 ? +1 : -1);
+            }
+            num_calls.assign(samples.size(), 0);
+        }
+
+        virtual long get_num_dimensions (
+        ) const { return 5; }
+
+        virtual long get_num_samples (
+        ) const { return samples.size(); }
+
+        virtual void get_truth_joint_feature_vector (
+            long idx,
+            matrix_type& psi
+        ) const 
+        {
+            psi = 0.5*labels[idx]*samples[idx];
+        }
+
+        virtual void separation_oracle (
+            const long idx,
+            const matrix_type& current_solution,
+            double& loss,
+            matrix_type& psi
+        ) const 
+        {
+            {
+                auto_mutex lock(m);
+                ++num_calls[idx];
+            }
+
+            // make the first samples slow
+            if (idx < 10)
+            {
+                volatile double temp = 0;
+                for (int i = 0; i < 100000; ++i)
+                    temp = temp + i;
+            }
+
+            if (1 - labels[idx]*dot(current_solution, samples[idx]) > 0)
+            {
+                loss = 1;
+                psi = -0.5*labels[idx]*samples[idx];
+            }
+            else
+            {
+                loss = 0;
+                psi = 0.5*labels[idx]*samples[idx];
+            }
+        }
+
+        std::vector<matrix_type> samples;
+        std::vector<double> labels;
+        mutable std::vector<int> num_calls;
+        mutable mutex m;
+    };
+
+    void test_uneven_samples (
+    )
+    {
+        print_spinner();
+        dlog << LINFO << "test_uneven_samples()";
+
+        // The threads hand out the samples by their cost on the last iteration, but every
+        // sample must still be visited exactly once per iteration and the solution
+        // mustn't depend on the number of threads.
+        test_uneven_svm_problem problem1(1), problem4(4);
+        problem1.set_max_cache_size(0);
+        problem4.set_max_cache_size(0);
+        problem1.set_c(100);
+        problem4.set_c(100);
+        problem1.set_epsilon(1e-10);
+        problem4.set_epsilon(1e-10);
+
+        oca solver;
+        matrix<double,0,1> w1, w4;
+        solver(problem1, w1);
+        solver(problem4, w4);
+
+        DLIB_TEST(min(mat(problem1.num_calls)) == max(mat(problem1.num_calls)));
+        DLIB_TEST(min(mat(problem4.num_calls)) == max(mat(problem4.num_calls)));
+        dlog << LINFO << "w1: " << trans(w1);
+        dlog << LINFO << "w4: " << trans(w4);
+        DLIB_TEST(max(abs(w1-w4)) < 1e-6);
+    }
+
 // ----------------------------------------------------------------------------------------
 
     template <
@@ -618,6 +728,8 @@ namespace
 
             dlib::rand rnd;
 
+            test_uneven_samples();
+
             dlog << LINFO << "test with 100 samples per class";
             make_dataset(samples, labels, 100, rnd);
             run_test(samples, labels, 1.155);
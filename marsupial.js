@@ -4,20 +4,92 @@ const marsupial_native = require('./build/Release/marsupial.node')
 const Promise = require('bluebird')
 
 module.exports = {
-    trainObjectDetector: (data, outputDetectorName) => new Promise((resolve, reject) => {
-        return marsupial_native.trainObjectDetector(data, outputDetectorName, (err) => {
+    // 'options' can set { threads, C, eps, targetSize, upsample, cellSize, padding, maxPyramidLevels, featureStorage,
+    // featureCache, decodeThreads, prefetchDepth }. By default training uses one thread per core and keeps the features
+    // in memory as floats ('half' and 'uint8' use less memory, and featureCache names a directory to keep them in memory
+    // mapped files instead). 'decodeThreads' threads decode the images ahead of the feature extraction, keeping at most
+    // 'prefetchDepth' of them in memory.
+    // 'onProgress' is called with { iteration, objective, objectiveGap, risk, riskGap, planes, elapsedMs } after every
+    // iteration of the solver. 'checkpoint' names a file the state of the solver is saved to every 'checkpointInterval'
+    // iterations (default: 10) and when the training is cancelled, and 'resumeFrom' a checkpoint to continue from.
+    // The returned promise (not the ones chained to it) has a cancelTraining() method; a cancelled training rejects
+    // with 'Training cancelled'
+    trainObjectDetector: (data, outputDetectorName, options) => {
+        let job = null
+        const training = new Promise((resolve, reject) => {
+            job = marsupial_native.trainObjectDetector(data, outputDetectorName, (err) => {
+                if (err) return reject(err)
+
+                return resolve(null)
+            }, options)
+        })
+
+        // Not named cancel(), which would shadow bluebird's own Promise#cancel
+        training.cancelTraining = () => {
+            if (job) job.cancel()
+        }
+        return training
+    },
+
+    // Cross validate a detector for every combination of the values in 'grid' ({ C, eps, targetSize }, each a number
+    // or an array of numbers) and save the one trained with the best of them (highest average precision) on all the
+    // records. 'options' takes the trainObjectDetector options plus 'folds' (default: 3). Resolves to
+    // { results: [{ C, eps, targetSize, precision, recall, averagePrecision }, ...], best }
+    tuneObjectDetector: (data, outputDetectorName, grid, options) => new Promise((resolve, reject) => {
+        return marsupial_native.tuneObjectDetector(data, outputDetectorName, grid, (err, results) => {
+            if (err) return reject(err)
+
+            return resolve(results)
+        }, options)
+    }),
+
+    // Load a detector once and get a handle that can be passed to detectObjects instead of the file name
+    loadDetector: (detectorFileName) => new Promise((resolve, reject) => {
+        return marsupial_native.loadDetector(detectorFileName, (err, detector) => {
             if (err) return reject(err)
 
-            return resolve(null)
+            return resolve(detector)
         })
     }),
 
-    detectObjects: (imageFileName, detectorFileName) => new Promise((resolve, reject) => {
-        return marsupial_native.detectObjects(imageFileName, detectorFileName, (err, results) => {
+    // 'image' is either an image file name, a Buffer with an encoded JPEG/PNG image or raw pixels given as
+    // { data: Buffer, width, height, channels }. 'detector' is either a detector file name or a handle returned by
+    // loadDetector. 'options.threads' splits the work on this one image over several threads, at most one per core
+    // (useful for very large images). 'options.minObjectSize' is the size in pixels of the smallest objects to find
+    // (the shorter side of their box); JPEGs are then decoded straight to grayscale, and scaled down as far as objects
+    // that size allow. 'options.upsample' upsamples the image by 2 that many times before scanning it, and must match
+    // the 'upsample' the detector was trained with (it can't be combined with 'options.tileHeight').
+    // 'options.tileHeight' scans very large images in horizontal strips that many rows tall, so memory stays bounded;
+    // 'options.maxObjectSize' is then the height of the tallest objects to find (4 detector windows by default, and never
+    // less than 'options.minObjectSize')
+    detectObjects: (image, detector, options) => new Promise((resolve, reject) => {
+        return marsupial_native.detectObjects(image, detector, (err, results) => {
             if (err) return reject(err)
 
             return resolve(results)
-        })
-    })
+        }, options)
+    }),
+
+    // Scan many images (anything detectObjects accepts) in one native job. Resolves to an Int32Array with 5 values
+    // per detection: [imageIndex, top, left, width, height, imageIndex, top, ...]. 'options.minObjectSize' and
+    // 'options.upsample' work as in detectObjects, and 'options.decodeThreads' and 'options.prefetchDepth' as in
+    // trainObjectDetector
+    detectObjectsBatch: (images, detector, options) => new Promise((resolve, reject) => {
+        return marsupial_native.detectObjectsBatch(images, detector, (err, results) => {
+            if (err) return reject(err)
+
+            return resolve(results)
+        }, options)
+    }),
+
+    // Set the number of native threads used for detections and for training: { detectThreads, trainThreads }.
+    // Must be called before the first job is started
+    configureWorkerPool: (options) => marsupial_native.configureWorkerPool(options),
+
+    // Queue depth, number of completed jobs and wait/run times (in ms) of the detect and train lanes
+    getWorkerPoolStats: () => marsupial_native.getWorkerPoolStats(),
+
+    // Instruction set used by the detection kernels on this host: { level, cpu, baseline }, e.g. 'avx2' or 'sse2'
+    getSimdLevel: () => marsupial_native.getSimdLevel()
 }
 
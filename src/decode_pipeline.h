@@ -0,0 +1,155 @@
+#ifndef MARSUPIAL_DECODE_PIPELINE_H
+#define MARSUPIAL_DECODE_PIPELINE_H
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// How far decoding runs ahead of whatever consumes the decoded images. 0 picks the defaults.
+struct PrefetchOptions {
+    PrefetchOptions() : decodeThreads(0), depth(0) {}
+
+    unsigned long decodeThreads; // Threads decoding images. Defaults to half as many as there are consumer threads
+    unsigned long depth;         // Decoded images waiting to be consumed, at most. Defaults to 2 per consumer thread
+};
+
+// Bounded producer/consumer pipeline: decoder threads decode items 0, 1, 2, ... into a queue at most depth images deep,
+// while consumer threads take them out in whatever order they come and process them (e.g. extract their features).
+// Decoding overlaps with the processing, and at most depth images (plus one per thread) are decoded at any time, so
+// memory doesn't grow with the number of items. Image buffers are recycled from one item to the next.
+//
+// decode(i, image) decodes item i into image and consume(consumer, i, image) processes it; both are called concurrently
+// from several threads. consumer numbers the calling consumer thread from 0 to consumerThreads-1, so that it can keep
+// buffers of its own. The first exception either of them throws stops the pipeline and is rethrown by run().
+template <typename image_type>
+class decode_pipeline {
+public:
+    decode_pipeline(size_t count, unsigned long consumerThreads, const PrefetchOptions& options) :
+        count(count),
+        consumerThreads(std::max(1ul, consumerThreads)),
+        decodeThreads(options.decodeThreads ? options.decodeThreads : std::max(1ul, this->consumerThreads/2)),
+        depth(options.depth ? options.depth : 2*this->consumerThreads),
+        nextItem(0), decoding(0) {}
+
+    template <typename decode_fn, typename consume_fn>
+    void run(decode_fn decode, consume_fn consume) {
+        std::vector<std::thread> threads;
+        for (unsigned long t = 0; t < decodeThreads; ++t)
+            threads.push_back(std::thread([&]() { decode_items(decode); }));
+        for (unsigned long t = 1; t < consumerThreads; ++t)
+            threads.push_back(std::thread([&, t]() { consume_items(t, consume); }));
+        consume_items(0, consume);
+        for (size_t t = 0; t < threads.size(); ++t)
+            threads[t].join();
+
+        if (error)
+            std::rethrow_exception(error);
+    }
+
+private:
+    typedef std::pair<size_t, std::unique_ptr<image_type> > decoded_item;
+
+    template <typename decode_fn>
+    void decode_items(decode_fn& decode) {
+        for (;;) {
+            size_t i;
+            std::unique_ptr<image_type> image;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                not_full.wait(lock, [&]() { return error || nextItem == count || ready.size() + decoding < depth; });
+                if (error || nextItem == count)
+                    break;
+                i = nextItem++;
+                ++decoding;
+                // Decoders waiting for room in the queue have nothing left to claim
+                if (nextItem == count)
+                    not_full.notify_all();
+                if (spare.empty()) {
+                    image.reset(new image_type);
+                }
+                else {
+                    image = std::move(spare.back());
+                    spare.pop_back();
+                }
+            }
+
+            bool decoded = true;
+            try {
+                decode(i, *image);
+            }
+            catch (...) {
+                decoded = false;
+                fail(std::current_exception());
+            }
+
+            std::lock_guard<std::mutex> lock(mutex);
+            --decoding;
+            if (decoded)
+                ready.push_back(decoded_item(i, std::move(image)));
+            else
+                spare.push_back(std::move(image));
+            not_empty.notify_one();
+        }
+
+        // Consumers waiting for more, and decoders waiting for room, may have to find out there won't be any
+        not_full.notify_all();
+        not_empty.notify_all();
+    }
+
+    template <typename consume_fn>
+    void consume_items(unsigned long consumer, consume_fn& consume) {
+        for (;;) {
+            decoded_item item;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                not_empty.wait(lock, [&]() { return error || !ready.empty() || (nextItem == count && decoding == 0); });
+                if (error || ready.empty())
+                    break;
+                item = std::move(ready.front());
+                ready.pop_front();
+            }
+            not_full.notify_one();
+
+            try {
+                consume(consumer, item.first, *item.second);
+            }
+            catch (...) {
+                fail(std::current_exception());
+            }
+
+            std::lock_guard<std::mutex> lock(mutex);
+            spare.push_back(std::move(item.second));
+        }
+    }
+
+    void fail(std::exception_ptr e) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!error)
+                error = e;
+        }
+        not_full.notify_all();
+        not_empty.notify_all();
+    }
+
+    const size_t count;
+    const unsigned long consumerThreads;
+    const unsigned long decodeThreads;
+    const unsigned long depth;
+
+    std::mutex mutex;
+    std::condition_variable not_full, not_empty;
+    size_t nextItem;     // Next item to decode
+    unsigned long decoding; // Items being decoded right now
+    std::deque<decoded_item> ready;
+    std::vector<std::unique_ptr<image_type> > spare;
+    std::exception_ptr error;
+};
+
+#endif // MARSUPIAL_DECODE_PIPELINE_H
@@ -1,4 +1,5 @@
 #define DLIB_JPEG_SUPPORT
+#define DLIB_PNG_SUPPORT
 
 #include <dlib/svm_threaded.h>
 #include <dlib/string.h>
@@ -7,33 +8,589 @@
 #include <dlib/data_io.h>
 #include <dlib/cmd_line_parser.h>
 
+#include <sys/stat.h>
 #include <iostream>
 #include <fstream>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <thread>
 #include <vector>
+#include "raw_image.h"
+#include "decode_pipeline.h"
 
 using namespace std;
 using namespace dlib;
 
-// Detect an object in an image (using the given object detector)
-std::vector<rectangle> detect_objects(std::string imageFileName, std::string svmDetectorFileName) {
-    typedef scan_fhog_pyramid<pyramid_down<6> > image_scanner_type; 
+typedef scan_fhog_pyramid<pyramid_down<6> > image_scanner_type;
+typedef object_detector<image_scanner_type> detector_type;
 
+// Load an object detector from disk
+std::shared_ptr<const detector_type> deserialize_detector(const std::string& svmDetectorFileName) {
     // Load the object detector
     ifstream fin(svmDetectorFileName, ios::binary);
     if (!fin)
-        throw new error("Cannot load svm detector file");
+        throw error("Cannot load svm detector file");
 
     // Deserialize the file
-    object_detector<image_scanner_type> detector;
-    deserialize(detector, fin);
+    std::shared_ptr<detector_type> detector = std::make_shared<detector_type>();
+    deserialize(*detector, fin);
+
+    return detector;
+}
+
+// LRU of deserialized detectors, keyed by file name and modification time. Detectors handed out by the cache are
+// shared between threads, so they must never be modified.
+class detector_cache {
+public:
+    explicit detector_cache(size_t capacity) : capacity(capacity) {}
+
+    std::shared_ptr<const detector_type> get(const std::string& svmDetectorFileName) {
+        struct stat info;
+        if (stat(svmDetectorFileName.c_str(), &info) != 0)
+            throw error("Cannot load svm detector file");
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            for (std::list<entry>::iterator it = entries.begin(); it != entries.end(); ++it) {
+                if (it->fileName != svmDetectorFileName)
+                    continue;
+
+                // A detector file that changed on disk (e.g. retrained) must be loaded again
+                if (it->mtime != info.st_mtime || it->size != info.st_size) {
+                    entries.erase(it);
+                    break;
+                }
+
+                // Most recently used entries live at the front of the list
+                entries.splice(entries.begin(), entries, it);
+                return it->detector;
+            }
+        }
+
+        // Deserialize outside the lock so a slow load doesn't hold up detections using other detectors
+        entry loaded;
+        loaded.fileName = svmDetectorFileName;
+        loaded.mtime = info.st_mtime;
+        loaded.size = info.st_size;
+        loaded.detector = deserialize_detector(svmDetectorFileName);
+
+        std::lock_guard<std::mutex> lock(mutex);
+        entries.push_front(loaded);
+        while (entries.size() > capacity)
+            entries.pop_back();
+
+        return loaded.detector;
+    }
+
+private:
+    struct entry {
+        std::string fileName;
+        time_t mtime;
+        off_t size;
+        std::shared_ptr<const detector_type> detector;
+    };
+
+    const size_t capacity;
+    std::list<entry> entries;
+    std::mutex mutex;
+};
+
+// Detectors loaded by file name (either through loadDetector or detectObjects)
+detector_cache& loaded_detectors() {
+    static detector_cache cache(16);
+    return cache;
+}
+
+// Where the image to scan comes from: a file, an encoded image (JPEG/PNG) in memory or raw pixels in memory
+struct ImageSource {
+    ImageSource() : data(0), size(0), width(0), height(0), channels(0), minObjectSize(0), upsample(0) {}
+
+    std::string fileName;
+    const unsigned char* data; // Not owned. Must stay valid while the detection runs
+    size_t size;
+    long width, height, channels; // Only set for raw pixels (channels is 1, 3 or 4)
+    unsigned long minObjectSize; // If set, JPEGs are decoded to grayscale, scaled down as far as objects this size allow
+    unsigned long upsample; // Times the image is upsampled by 2 before it's scanned, like the training images of a
+                            // detector trained with upsample
+};
+
+// How many times smaller (1, 2, 4 or 8) a JPEG can be decoded while objects minObjectSize pixels across still cover the
+// detection window. The detector can't find objects smaller than its window anyway.
+unsigned long jpeg_scale_denom(const detector_type& detector, unsigned long minObjectSize) {
+    const unsigned long window = std::min(detector.get_scanner().get_detection_window_width(),
+            detector.get_scanner().get_detection_window_height());
+    unsigned long denom = 1;
+    while (denom < 8 && minObjectSize >= 2*denom*window)
+        denom *= 2;
+    return denom;
+}
+
+// The encoded bytes of an image source. Files are memory mapped, so that sniffing their type and decoding them read the
+// same bytes instead of opening the file twice (which costs a round trip per open on network file systems).
+class EncodedImage {
+public:
+    explicit EncodedImage(const ImageSource& source) : data(source.data), size(source.size) {
+        if (data)
+            return;
+        try {
+            file.open(source.fileName);
+        } catch (mapped_file_error&) {
+            throw image_load_error("Unable to open file: " + source.fileName);
+        }
+        data = file.data();
+        size = file.size();
+        fileName = source.fileName;
+        if (type() == image_file_type::UNKNOWN)
+            throw image_load_error("Unknown image file format: Unable to load image in file " + fileName);
+    }
+
+    image_file_type::type type() const { return image_file_type::read_type(data, size); }
+
+    // The in-memory decoders can't name the file their errors come from, so add its name like dlib::load_image(file)
+    // does
+    void rethrow(const image_load_error& e) const {
+        if (fileName.empty())
+            throw e;
+        throw image_load_error(e.info + " in file " + fileName);
+    }
+
+    const unsigned char* data;
+    size_t size;
+
+private:
+    mapped_file file;
+    std::string fileName; // Only set for files
+};
+
+// Decode an encoded image, or convert raw RGBA pixels, into a grayscale image. Returns how many times smaller than the
+// original the image is: with source.minObjectSize, JPEGs are decoded straight to their luma channel and scaled by
+// 1/scaleDenom in the DCT domain, which skips most of the decoding work.
+unsigned long load_source_image(array2d<unsigned char>& image, const ImageSource& source, unsigned long scaleDenom) {
+    if (source.channels == 4) {
+        assign_image(image, raw_image<rgb_alpha_pixel>(source.data, source.height, source.width)); // The image pyramid can't handle alpha channels
+        return 1;
+    }
+
+    if (!source.data && source.minObjectSize == 0) {
+        load_image(image, source.fileName);
+        return 1;
+    }
+
+    const EncodedImage encoded(source);
+    try {
+        if (source.minObjectSize != 0 && encoded.type() == image_file_type::JPG) {
+            jpeg_decode_options options;
+            options.grayscale = true;
+            options.scale_denom = scaleDenom;
+            load_jpeg(image, encoded.data, encoded.size, options);
+            return scaleDenom;
+        }
+
+        load_image(image, encoded.data, encoded.size);
+    } catch (image_load_error& e) {
+        encoded.rethrow(e);
+    }
+    return 1;
+}
+
+// Map a rectangle found in an image decoded 'scale' times smaller back to the original image
+rectangle scale_rect_up(const rectangle& rect, unsigned long scale) {
+    const long s = scale;
+    return rectangle(rect.left()*s, rect.top()*s, (rect.right() + 1)*s - 1, (rect.bottom() + 1)*s - 1);
+}
+
+// Decode (or convert raw pixels into) a grayscale image at full size, then upsample it by 2 source.upsample times, the
+// same way load_training_image prepares the training images
+void load_upsampled_image(array2d<unsigned char>& image, const ImageSource& source) {
+    if (source.channels == 1)
+        assign_image(image, raw_image<unsigned char>(source.data, source.height, source.width));
+    else if (source.channels == 3)
+        assign_image(image, raw_image<rgb_pixel>(source.data, source.height, source.width));
+    else
+        load_source_image(image, source, 1);
+
+    pyramid_down<2> pyr;
+    for (unsigned long i = 0; i < source.upsample; ++i)
+        pyramid_up(image, pyr);
+}
+
+// Map a rectangle found in an image upsampled by 2 'upsample' times back to the original image
+rectangle upsampled_rect_down(rectangle rect, unsigned long upsample) {
+    pyramid_down<2> pyr;
+    for (unsigned long i = 0; i < upsample; ++i)
+        rect = pyr.rect_down(rect);
+    return rect;
+}
+
+// Private copy of a shared detector whose scanner splits the work on each image over numThreads threads
+detector_type copy_detector(const detector_type& sharedDetector, unsigned long numThreads) {
+    if (numThreads <= 1)
+        return sharedDetector;
+
+    image_scanner_type scanner;
+    scanner.copy_configuration(sharedDetector.get_scanner());
+    scanner.set_num_threads(numThreads);
+    return detector_type(scanner, sharedDetector.get_overlap_tester(), sharedDetector.get_w());
+}
+
+// Detect an object in an image (using the given object detector)
+template <typename image_type>
+std::vector<rectangle> detect_objects(const image_type& image, const detector_type& sharedDetector, unsigned long numThreads = 1) {
+    if (numThreads > 1) {
+        // object_detector::operator() loads the image pyramid into its scanner, so work on a private copy.
+        // Copying only duplicates the configuration and the filter bank, not the deserialization work.
+        detector_type detector = copy_detector(sharedDetector, numThreads);
+        return detector(image);
+    }
+
+    // With a single thread, scan the pyramid one level at a time instead of keeping the features of every level
+    // in memory (evaluate_detectors only reads the detectors)
+    const std::vector<detector_type> detectors(1, sharedDetector);
+    std::vector<rect_detection> dets;
+    evaluate_detectors(detectors, image, dets);
+
+    // Get all matches
+    std::vector<rectangle> results;
+    for (size_t i = 0; i < dets.size(); ++i)
+        results.push_back(dets[i].rect);
+
+    return results;
+}
+
+std::vector<rectangle> detect_objects(const ImageSource& source, const detector_type& detector, unsigned long numThreads = 1) {
+    if (source.upsample != 0) {
+        array2d<unsigned char> image;
+        load_upsampled_image(image, source);
+        std::vector<rectangle> results = detect_objects(image, detector, numThreads);
+        for (size_t i = 0; i < results.size(); ++i)
+            results[i] = upsampled_rect_down(results[i], source.upsample);
+        return results;
+    }
+
+    // Raw gray/RGB pixels are scanned in place
+    if (source.channels == 1)
+        return detect_objects(raw_image<unsigned char>(source.data, source.height, source.width), detector, numThreads);
+    if (source.channels == 3)
+        return detect_objects(raw_image<rgb_pixel>(source.data, source.height, source.width), detector, numThreads);
 
     // Load the image
     array2d<unsigned char> image;
-    load_image(image, imageFileName);
+    const unsigned long scale = load_source_image(image, source, jpeg_scale_denom(detector, source.minObjectSize));
 
-    // Get all matches
-    std::vector<rectangle> results = detector(image);
+    std::vector<rectangle> results = detect_objects(image, detector, numThreads);
+    if (scale != 1) {
+        for (size_t i = 0; i < results.size(); ++i)
+            results[i] = scale_rect_up(results[i], scale);
+    }
+    return results;
+}
+
+// How to split a very large image into horizontal strips that are decoded and scanned one after the other, so memory
+// stays bounded by the strip size instead of growing with the image
+struct TileOptions {
+    TileOptions() : tileHeight(0), maxObjectSize(0) {}
+
+    unsigned long tileHeight; // Rows per strip (in the original image). 0 scans the whole image at once
+    unsigned long maxObjectSize; // Height of the tallest objects to find. 0 means 4 times the detection window, and it
+                                 // is never less than the minObjectSize of the image
+};
+
+// Rows two consecutive strips share, counted in rows of the image decoded 'scale' times smaller. Every object at most
+// maxObjectSize tall lies entirely inside at least one strip, and the overlap is never less than a detection window,
+// the smallest object that can be found at any scale.
+long strip_overlap(const detector_type& detector, const TileOptions& tiles, unsigned long minObjectSize,
+        unsigned long scale) {
+    const long window = detector.get_scanner().get_detection_window_height();
+    const unsigned long maxObjectSize = std::max<unsigned long>(tiles.maxObjectSize ? tiles.maxObjectSize : 4*window,
+            minObjectSize);
+    return std::max<long>((maxObjectSize + scale - 1)/scale, window);
+}
+
+// Hands out the rows of an image that is already in memory like dlib's jpeg_row_reader and png_row_reader decode
+// them, so in-memory images can be scanned in strips too
+template <typename image_type>
+class image_row_reader {
+public:
+    explicit image_row_reader(const image_type& image) : image(image), nextRow(0) {}
+
+    long nr() const { return num_rows(image); }
+    long nc() const { return num_columns(image); }
+    long next_row() const { return nextRow; }
+
+    template <typename strip_type>
+    unsigned long read_rows(strip_type& strip_, long firstRow, unsigned long numRows) {
+        image_view<strip_type> strip(strip_);
+        const_image_view<image_type> in(image);
+        numRows = std::min<unsigned long>(numRows, nr() - nextRow);
+        for (unsigned long i = 0; i < numRows; ++i) {
+            for (long c = 0; c < nc(); ++c)
+                assign_pixel(strip[firstRow + i][c], in[nextRow + i][c]);
+        }
+        nextRow += numRows;
+        return numRows;
+    }
+
+private:
+    const image_type& image;
+    long nextRow;
+};
+
+// Scan an image read from top to bottom by a row reader, stripHeight rows at a time. Consecutive strips share overlap
+// rows, and each strip only keeps the detections centered in its own share of the image (which ends halfway through
+// the overlap with the next strip), so an object no taller than the overlap is reported by exactly one strip. Only
+// one strip and its feature pyramid are ever held in memory.
+template <typename pixel_type, typename row_reader>
+std::vector<rect_detection> detect_in_strips(row_reader& reader, const detector_type& sharedDetector, long stripHeight,
+        long overlap, unsigned long numThreads) {
+    std::vector<rect_detection> found;
+    const long nr = reader.nr();
+    const long nc = reader.nc();
+    if (nr == 0 || nc == 0)
+        return found;
+
+    stripHeight = std::min(std::max(stripHeight, 2*overlap), nr);
+    array2d<pixel_type> strip(stripHeight, nc);
+
+    // Same choice as detect_objects: a private threaded copy of the detector, or the shared one scanned level by level
+    const std::vector<detector_type> detectors(1, sharedDetector);
+    detector_type threaded;
+    if (numThreads > 1)
+        threaded = copy_detector(sharedDetector, numThreads);
+    fhog_scratch_space<pixel_type> scratch;
+
+    std::vector<rect_detection> dets;
+    long top = 0;
+    long rows = reader.read_rows(strip, 0, stripHeight);
+    for (;;) {
+        const bool last = top + rows >= nr;
+        const sub_image_proxy<array2d<pixel_type> > view = sub_image(strip, rectangle(0, 0, nc - 1, rows - 1));
+        if (numThreads > 1)
+            threaded(view, dets);
+        else
+            evaluate_detectors(detectors, view, dets, scratch);
+
+        const long shareTop = top == 0 ? 0 : overlap/2;
+        const long shareBottom = last ? rows : rows - overlap + overlap/2;
+        for (size_t i = 0; i < dets.size(); ++i) {
+            const long center = (dets[i].rect.top() + dets[i].rect.bottom())/2;
+            if (center >= shareTop && center < shareBottom) {
+                dets[i].rect = translate_rect(dets[i].rect, 0, top);
+                found.push_back(dets[i]);
+            }
+        }
+        if (last)
+            break;
+
+        // Slide down: the last overlap rows of this strip are the first ones of the next
+        for (long r = 0; r < overlap; ++r)
+            std::copy(&strip[rows - overlap + r][0], &strip[rows - overlap + r][0] + nc, &strip[r][0]);
+        top += rows - overlap;
+        rows = overlap + reader.read_rows(strip, overlap, stripHeight - overlap);
+    }
+
+    return found;
+}
+
+// Objects bigger than a strip's share can still be seen twice (e.g. once whole and once cut off by a strip edge), so
+// the detections of all the strips go through the detector's own non-maximum suppression again
+std::vector<rectangle> suppress_overlapping_detections(std::vector<rect_detection>& dets,
+        const test_box_overlap& overlaps) {
+    std::sort(dets.rbegin(), dets.rend());
+    std::vector<rectangle> results;
+    for (size_t i = 0; i < dets.size(); ++i) {
+        bool overlapsKept = false;
+        for (size_t j = 0; j < results.size() && !overlapsKept; ++j)
+            overlapsKept = overlaps(dets[i].rect, results[j]);
+        if (!overlapsKept)
+            results.push_back(dets[i].rect);
+    }
+    return results;
+}
+
+// Detect objects in an image too large to decode or scan in one go (e.g. aerial imagery tens of thousands of pixels
+// across). JPEGs and PNGs are decoded in strips of tiles.tileHeight rows, other formats are decoded whole but still
+// scanned strip by strip, which bounds the memory the feature pyramid needs.
+std::vector<rectangle> detect_objects_tiled(const ImageSource& source, const detector_type& detector,
+        const TileOptions& tiles, unsigned long numThreads = 1) {
+    // Upsampling needs the rows around each one, which the strips don't have at their edges
+    if (source.upsample != 0)
+        throw error("Images can't be upsampled when they're scanned in strips");
 
+    const long overlap = strip_overlap(detector, tiles, source.minObjectSize, 1);
+    const long stripHeight = tiles.tileHeight;
+    std::vector<rect_detection> dets;
+    unsigned long scale = 1;
+
+    if (source.channels == 1) {
+        const raw_image<unsigned char> image(source.data, source.height, source.width);
+        image_row_reader<raw_image<unsigned char> > reader(image);
+        dets = detect_in_strips<unsigned char>(reader, detector, stripHeight, overlap, numThreads);
+    }
+    else if (source.channels == 3) {
+        const raw_image<rgb_pixel> image(source.data, source.height, source.width);
+        image_row_reader<raw_image<rgb_pixel> > reader(image);
+        dets = detect_in_strips<rgb_pixel>(reader, detector, stripHeight, overlap, numThreads);
+    }
+    else if (source.channels == 4) {
+        const raw_image<rgb_alpha_pixel> image(source.data, source.height, source.width);
+        image_row_reader<raw_image<rgb_alpha_pixel> > reader(image);
+        dets = detect_in_strips<unsigned char>(reader, detector, stripHeight, overlap, numThreads);
+    }
+    else {
+        const EncodedImage encoded(source);
+        const image_file_type::type type = encoded.type();
+        // The rows are decoded while the strips are scanned, so decoding errors can come from either
+        try {
+            if (type == image_file_type::JPG) {
+                // Same decoding shortcuts as load_source_image. The strips are measured in decoded rows.
+                jpeg_decode_options options;
+                if (source.minObjectSize != 0) {
+                    options.grayscale = true;
+                    options.scale_denom = scale = jpeg_scale_denom(detector, source.minObjectSize);
+                }
+                jpeg_row_reader reader(encoded.data, encoded.size, options);
+                dets = detect_in_strips<unsigned char>(reader, detector, (stripHeight + scale - 1)/scale,
+                        strip_overlap(detector, tiles, source.minObjectSize, scale), numThreads);
+            }
+            else if (type == image_file_type::PNG) {
+                png_row_reader reader(encoded.data, encoded.size);
+                dets = detect_in_strips<unsigned char>(reader, detector, stripHeight, overlap, numThreads);
+            }
+            else {
+                array2d<unsigned char> image;
+                load_image(image, encoded.data, encoded.size);
+                image_row_reader<array2d<unsigned char> > reader(image);
+                dets = detect_in_strips<unsigned char>(reader, detector, stripHeight, overlap, numThreads);
+            }
+        } catch (image_load_error& e) {
+            encoded.rethrow(e);
+        }
+    }
+
+    std::vector<rectangle> results = suppress_overlapping_detections(dets, detector.get_overlap_tester());
+    if (scale != 1) {
+        for (size_t i = 0; i < results.size(); ++i)
+            results[i] = scale_rect_up(results[i], scale);
+    }
     return results;
 }
 
+// Detect an object in an image (using the object detector stored in the given file)
+std::vector<rectangle> detect_objects(const ImageSource& source, std::string svmDetectorFileName, unsigned long numThreads = 1) {
+    return detect_objects(source, *loaded_detectors().get(svmDetectorFileName), numThreads);
+}
+
+// Result of a batch detection: the image (index into the batch) the rectangle was found in
+struct BatchDetection {
+    unsigned long imageIndex;
+    rectangle rect;
+};
+
+// An image of a batch, decoded ahead of being scanned
+struct DecodedBatchImage {
+    array2d<unsigned char> pixels;
+    unsigned long scale; // How many times smaller than the original image the pixels are
+};
+
+// Buffers one batch worker thread reuses from image to image
+struct BatchScratch {
+    std::vector<rect_detection> dets;
+    fhog_scratch_space<unsigned char> gray;
+    std::unique_ptr<fhog_scratch_space<rgb_pixel> > rgb; // Only allocated once a raw RGB image shows up
+};
+
+// Decode an image of a batch. Raw gray and RGB images are scanned straight from their pixels, so there's nothing to
+// do for those unless they're upsampled.
+void decode_batch_image(const ImageSource& source, const std::vector<detector_type>& detectors,
+        DecodedBatchImage& decoded) {
+    if (source.upsample != 0) {
+        load_upsampled_image(decoded.pixels, source);
+        decoded.scale = 1;
+        return;
+    }
+    if (source.channels == 1 || source.channels == 3)
+        return;
+
+    // Objects must cover the window of every detector
+    unsigned long scaleDenom = 8;
+    for (size_t i = 0; i < detectors.size(); ++i)
+        scaleDenom = std::min(scaleDenom, jpeg_scale_denom(detectors[i], source.minObjectSize));
+    decoded.scale = load_source_image(decoded.pixels, source, scaleDenom);
+}
+
+void detect_objects(const ImageSource& source, const DecodedBatchImage& decoded,
+        const std::vector<detector_type>& detectors, BatchScratch& scratch) {
+    std::vector<rect_detection>& dets = scratch.dets;
+    if (source.upsample != 0) {
+        evaluate_detectors(detectors, decoded.pixels, dets, scratch.gray);
+        for (size_t i = 0; i < dets.size(); ++i)
+            dets[i].rect = upsampled_rect_down(dets[i].rect, source.upsample);
+        return;
+    }
+    if (source.channels == 1) {
+        evaluate_detectors(detectors, raw_image<unsigned char>(source.data, source.height, source.width), dets, scratch.gray);
+        return;
+    }
+    if (source.channels == 3) {
+        if (!scratch.rgb)
+            scratch.rgb.reset(new fhog_scratch_space<rgb_pixel>());
+        evaluate_detectors(detectors, raw_image<rgb_pixel>(source.data, source.height, source.width), dets, *scratch.rgb);
+        return;
+    }
+
+    evaluate_detectors(detectors, decoded.pixels, dets, scratch.gray);
+    if (decoded.scale != 1) {
+        for (size_t i = 0; i < dets.size(); ++i)
+            dets[i].rect = scale_rect_up(dets[i].rect, decoded.scale);
+    }
+}
+
+// Detect objects in many images with one detector. The images are decoded ahead by the threads of a decode_pipeline
+// (see PrefetchOptions) and scanned by numThreads threads, each reusing its own feature pyramid buffers, and all of
+// them sharing the same (read-only) detector. Results are ordered by image index.
+std::vector<BatchDetection> detect_objects_batch(const std::vector<ImageSource>& sources, const detector_type& detector,
+        unsigned numThreads, const PrefetchOptions& prefetch = PrefetchOptions()) {
+    // evaluate_detectors only reads the detectors, so a single copy can be scanned by all the threads at once
+    const std::vector<detector_type> detectors(1, detector);
+
+    if (numThreads == 0)
+        numThreads = 1;
+    if (numThreads > sources.size())
+        numThreads = std::max<size_t>(sources.size(), 1);
+
+    std::vector<std::vector<rectangle> > found(sources.size());
+    std::vector<BatchScratch> scratch(numThreads);
+
+    decode_pipeline<DecodedBatchImage> pipeline(sources.size(), numThreads, prefetch);
+    pipeline.run(
+        [&](size_t i, DecodedBatchImage& decoded) {
+            try {
+                decode_batch_image(sources[i], detectors, decoded);
+            } catch (std::exception& e) {
+                throw error("Image " + cast_to_string(i) + ": " + e.what());
+            }
+        },
+        [&](unsigned long consumer, size_t i, DecodedBatchImage& decoded) {
+            try {
+                detect_objects(sources[i], decoded, detectors, scratch[consumer]);
+            } catch (std::exception& e) {
+                throw error("Image " + cast_to_string(i) + ": " + e.what());
+            }
+            const std::vector<rect_detection>& dets = scratch[consumer].dets;
+            for (size_t j = 0; j < dets.size(); ++j)
+                found[i].push_back(dets[j].rect);
+        });
+
+    std::vector<BatchDetection> results;
+    for (size_t i = 0; i < found.size(); ++i) {
+        for (size_t j = 0; j < found[i].size(); ++j) {
+            BatchDetection detection;
+            detection.imageIndex = i;
+            detection.rect = found[i][j];
+            results.push_back(detection);
+        }
+    }
+
+    return results;
+}
@@ -0,0 +1,58 @@
+#include <node.h>
+#include <node_object_wrap.h>
+#include <memory>
+#include <string>
+
+using namespace v8;
+
+// Opaque JS handle to a loaded (immutable) object detector, so detections can skip loading the .svm file
+class DetectorHandle : public node::ObjectWrap {
+public:
+    static void Init(Isolate* isolate) {
+        Local<FunctionTemplate> tpl = FunctionTemplate::New(isolate, New);
+        tpl->SetClassName(String::NewFromUtf8(isolate, "DetectorHandle"));
+        tpl->InstanceTemplate()->SetInternalFieldCount(1);
+
+        templ.Reset(isolate, tpl);
+        constructor.Reset(isolate, tpl->GetFunction());
+    }
+
+    // Create a JS handle wrapping the given detector
+    static Local<Object> NewInstance(Isolate* isolate, std::shared_ptr<const detector_type> detector, const std::string& fileName) {
+        Local<Object> instance = Local<Function>::New(isolate, constructor)->NewInstance();
+        DetectorHandle* handle = ObjectWrap::Unwrap<DetectorHandle>(instance);
+        handle->detector = detector;
+
+        instance->Set(String::NewFromUtf8(isolate, "fileName"), String::NewFromUtf8(isolate, fileName.c_str()));
+        instance->Set(String::NewFromUtf8(isolate, "windowWidth"),
+                Number::New(isolate, detector->get_scanner().get_detection_window_width()));
+        instance->Set(String::NewFromUtf8(isolate, "windowHeight"),
+                Number::New(isolate, detector->get_scanner().get_detection_window_height()));
+
+        return instance;
+    }
+
+    static bool HasInstance(Isolate* isolate, Local<Value> value) {
+        return value->IsObject() && Local<FunctionTemplate>::New(isolate, templ)->HasInstance(value);
+    }
+
+    // Get the detector wrapped by a JS handle (the value must pass HasInstance)
+    static std::shared_ptr<const detector_type> Unwrap(Local<Value> value) {
+        return ObjectWrap::Unwrap<DetectorHandle>(value->ToObject())->detector;
+    }
+
+private:
+    static void New(const FunctionCallbackInfo<Value>& args) {
+        DetectorHandle* handle = new DetectorHandle();
+        handle->Wrap(args.This());
+        args.GetReturnValue().Set(args.This());
+    }
+
+    std::shared_ptr<const detector_type> detector;
+
+    static Persistent<FunctionTemplate> templ;
+    static Persistent<Function> constructor;
+};
+
+Persistent<FunctionTemplate> DetectorHandle::templ;
+Persistent<Function> DetectorHandle::constructor;
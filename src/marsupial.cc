@@ -1,4 +1,5 @@
 #include <node.h>
+#include <node_buffer.h>
 #include <dlib/geometry.h>
 #include "data_parser.h"
 #include <v8.h>
@@ -7,8 +8,14 @@
 #include <iostream>
 #include <vector>
 #include <thread>
+#include <deque>
+#include <mutex>
+#include <memory>
 #include "trainer.h"
 #include "detector.h"
+#include "detector_handle.h"
+#include "training_job.h"
+#include "worker_pool.h"
 
 using namespace v8;
 
@@ -66,22 +73,151 @@ std::vector<TrainingRecord> unpack_traning_records(Isolate* isolate, Handle<Arra
     return results;
 }
 
+// --- unpack the decode-ahead options shared by training and batch detection: decodeThreads (threads decoding the
+// images) and prefetchDepth (decoded images waiting to be processed, at most). 0 picks the defaults.
+PrefetchOptions unpack_prefetch_options(Isolate* isolate, Handle<Object> js_options) {
+    PrefetchOptions prefetch;
+    Handle<Value> decodeThreads = js_options->Get(String::NewFromUtf8(isolate, "decodeThreads"));
+    if (decodeThreads->IsNumber() && decodeThreads->IntegerValue() > 0)
+        prefetch.decodeThreads = decodeThreads->IntegerValue();
+    Handle<Value> prefetchDepth = js_options->Get(String::NewFromUtf8(isolate, "prefetchDepth"));
+    if (prefetchDepth->IsNumber() && prefetchDepth->IntegerValue() > 0)
+        prefetch.depth = prefetchDepth->IntegerValue();
+    return prefetch;
+}
+
+// --- unpack options: any property that is missing or of the wrong type keeps its default value
+TrainingOptions unpack_training_options(Isolate* isolate, Handle<Object> js_options) {
+    TrainingOptions options;
+
+    Handle<Value> threads = js_options->Get(String::NewFromUtf8(isolate, "threads"));
+    if (threads->IsNumber())
+        options.threads = std::max<int64_t>(0, threads->IntegerValue());
+
+    Handle<Value> C = js_options->Get(String::NewFromUtf8(isolate, "C"));
+    if (C->IsNumber())
+        options.C = C->NumberValue();
+
+    Handle<Value> eps = js_options->Get(String::NewFromUtf8(isolate, "eps"));
+    if (eps->IsNumber())
+        options.eps = eps->NumberValue();
+
+    Handle<Value> targetSize = js_options->Get(String::NewFromUtf8(isolate, "targetSize"));
+    if (targetSize->IsNumber())
+        options.targetSize = std::max<int64_t>(0, targetSize->IntegerValue());
+
+    Handle<Value> upsample = js_options->Get(String::NewFromUtf8(isolate, "upsample"));
+    if (upsample->IsNumber())
+        options.upsampleAmount = std::max<int64_t>(0, upsample->IntegerValue());
+
+    Handle<Value> cellSize = js_options->Get(String::NewFromUtf8(isolate, "cellSize"));
+    if (cellSize->IsNumber())
+        options.cellSize = std::max<int64_t>(0, cellSize->IntegerValue());
+
+    Handle<Value> padding = js_options->Get(String::NewFromUtf8(isolate, "padding"));
+    if (padding->IsNumber())
+        options.padding = std::max<int64_t>(0, padding->IntegerValue());
+
+    Handle<Value> maxPyramidLevels = js_options->Get(String::NewFromUtf8(isolate, "maxPyramidLevels"));
+    if (maxPyramidLevels->IsNumber())
+        options.maxPyramidLevels = std::max<int64_t>(0, maxPyramidLevels->IntegerValue());
+
+    Handle<Value> featureStorage = js_options->Get(String::NewFromUtf8(isolate, "featureStorage"));
+    if (featureStorage->IsString()) {
+        String::Utf8Value storage(featureStorage);
+        if (std::string(*storage) == "half")
+            options.featureStorage = FHOG_STORE_HALF;
+        else if (std::string(*storage) == "uint8")
+            options.featureStorage = FHOG_STORE_UINT8;
+        else if (std::string(*storage) != "float")
+            options.unknownFeatureStorage = std::string(*storage);
+    }
+
+    Handle<Value> featureCache = js_options->Get(String::NewFromUtf8(isolate, "featureCache"));
+    if (featureCache->IsString()) {
+        String::Utf8Value directory(featureCache);
+        options.featureCacheDirectory = std::string(*directory);
+    }
+
+    Handle<Value> checkpoint = js_options->Get(String::NewFromUtf8(isolate, "checkpoint"));
+    if (checkpoint->IsString()) {
+        String::Utf8Value fileName(checkpoint);
+        options.checkpointFileName = std::string(*fileName);
+    }
+
+    Handle<Value> checkpointInterval = js_options->Get(String::NewFromUtf8(isolate, "checkpointInterval"));
+    if (checkpointInterval->IsNumber())
+        options.checkpointInterval = std::max<int64_t>(0, checkpointInterval->IntegerValue());
+
+    Handle<Value> resumeFrom = js_options->Get(String::NewFromUtf8(isolate, "resumeFrom"));
+    if (resumeFrom->IsString()) {
+        String::Utf8Value fileName(resumeFrom);
+        options.resumeFileName = std::string(*fileName);
+    }
+
+    options.prefetch = unpack_prefetch_options(isolate, js_options);
+
+    return options;
+}
+
 // Struct representing the async job of training an object detector
 struct TrainWork {
     uv_work_t request;
     Persistent<Function> callback;
+    Persistent<Function> onProgress;
 
     std::vector<TrainingRecord> trainingRecords;
     std::string detectorOutputFileName;
+    TrainingOptions options;
+    std::shared_ptr<TrainingMonitor> monitor;
     std::string error;
+
+    // The progress reported on the training thread, waiting to be handed to onProgress on the event loop
+    bool reportsProgress;
+    uv_async_t progressSignal;
+    std::mutex progressMutex;
+    std::deque<TrainingProgress> progress;
 };
 
+// Runs on the event loop thread: call onProgress for everything reported so far (uv_async_send calls can be
+// coalesced)
+static void TrainProgress(uv_async_t* handle) {
+    Isolate* isolate = Isolate::GetCurrent();
+    v8::HandleScope handleScope(isolate);
+
+    TrainWork* work = static_cast<TrainWork*>(handle->data);
+    std::deque<TrainingProgress> progress;
+    {
+        std::lock_guard<std::mutex> lock(work->progressMutex);
+        progress.swap(work->progress);
+    }
+
+    for (size_t i = 0; i < progress.size(); ++i) {
+        Local<Object> js_progress = Object::New(isolate);
+        js_progress->Set(String::NewFromUtf8(isolate, "iteration"), Number::New(isolate, progress[i].iteration));
+        js_progress->Set(String::NewFromUtf8(isolate, "objective"), Number::New(isolate, progress[i].objective));
+        js_progress->Set(String::NewFromUtf8(isolate, "objectiveGap"), Number::New(isolate, progress[i].objectiveGap));
+        js_progress->Set(String::NewFromUtf8(isolate, "risk"), Number::New(isolate, progress[i].risk));
+        js_progress->Set(String::NewFromUtf8(isolate, "riskGap"), Number::New(isolate, progress[i].riskGap));
+        js_progress->Set(String::NewFromUtf8(isolate, "planes"), Number::New(isolate, progress[i].planes));
+        js_progress->Set(String::NewFromUtf8(isolate, "elapsedMs"), Number::New(isolate, progress[i].elapsedMs));
+
+        unsigned const argc = 1;
+        Handle<Value> argv[argc] = { js_progress };
+        Local<Function>::New(isolate, work->onProgress)->Call(isolate->GetCurrentContext()->Global(), argc, argv);
+    }
+}
+
+static void FreeTrainWork(uv_handle_t* handle) {
+    delete static_cast<TrainWork*>(handle->data);
+}
+
 // The actual async job
 static void TrainAsync(uv_work_t* req) {
     TrainWork* work = static_cast<TrainWork*>(req->data);
 
     try {
-        train_object_detector(work->trainingRecords, work->detectorOutputFileName);
+        train_object_detector(work->trainingRecords, work->detectorOutputFileName, work->options, work->monitor.get());
     }
     catch (std::exception& e) {
         work->error = e.what();
@@ -105,14 +241,24 @@ static void TrainComplete(uv_work_t* req, int status) {
 
     TrainWork *work = static_cast<TrainWork *>(req->data);
 
+    // The training thread is done with the monitor, which the JS handle may keep alive; deliver the last progress
+    // reports before the end
+    work->monitor->onProgress = nullptr;
+    if (work->reportsProgress)
+        TrainProgress(&work->progressSignal);
+
     // Fire callback to signal the end. Only one argument: the error parameter. If null or empty, it means it all worked fine.
     unsigned const argc = 1;
     Handle<Value> argv[argc] = { String::NewFromUtf8(isolate, work->error.c_str()) };
     Local<Function>::New(isolate, work->callback)->Call(isolate->GetCurrentContext()->Global(), argc, argv);
 
-    // Free up the callback and work objects
+    // Free up the callbacks and work objects. The progress signal has to be closed before the work can go.
     work->callback.Reset();
-    delete work;
+    work->onProgress.Reset();
+    if (work->reportsProgress)
+        uv_close(reinterpret_cast<uv_handle_t*>(&work->progressSignal), FreeTrainWork);
+    else
+        delete work;
 }
 
 // Function called by the JS code
@@ -138,15 +284,290 @@ static void TrainObjectDetector(const FunctionCallbackInfo<Value>& args) {
     work->trainingRecords = unpack_traning_records(isolate, data);
     work->detectorOutputFileName = std::string(*detectorOutputFileName);
     work->error = "";
+    work->monitor = std::make_shared<TrainingMonitor>();
+    work->reportsProgress = false;
+
+    // Optional 4th argument: { threads, C, eps, targetSize, upsample, cellSize, padding, maxPyramidLevels,
+    // featureStorage, featureCache, checkpoint, checkpointInterval, resumeFrom, onProgress }
+    if (args.Length() > 3 && args[3]->IsObject()) {
+        work->options = unpack_training_options(isolate, args[3]->ToObject());
+
+        Handle<Value> onProgress = args[3]->ToObject()->Get(String::NewFromUtf8(isolate, "onProgress"));
+        if (onProgress->IsFunction()) {
+            work->onProgress.Reset(isolate, Local<Function>::Cast(onProgress));
+            work->reportsProgress = true;
+
+            // The signal shouldn't keep the process alive by itself: the training job does that while it runs
+            work->progressSignal.data = work;
+            uv_async_init(uv_default_loop(), &work->progressSignal, TrainProgress);
+            uv_unref(reinterpret_cast<uv_handle_t*>(&work->progressSignal));
+
+            work->monitor->onProgress = [work](const TrainingProgress& progress) {
+                {
+                    std::lock_guard<std::mutex> lock(work->progressMutex);
+                    work->progress.push_back(progress);
+                }
+                uv_async_send(&work->progressSignal);
+            };
+        }
+    }
 
     // Store the callback
     Local<Function> callback = Local<Function>::Cast(args[2]);
     work->callback.Reset(isolate, callback);
 
     // Start the async process
-    uv_queue_work(uv_default_loop(), &work->request, TrainAsync, TrainComplete);
+    native_workers().queue_work(TRAIN_LANE, &work->request, TrainAsync, TrainComplete);
+
+    // Return a handle the training can be cancelled with
+    args.GetReturnValue().Set(TrainingJob::NewInstance(isolate, work->monitor));
+}
+
+// =======================================================================================
+// Tuning
+//
+
+// --- unpack one value of the grid: a number or an array of numbers
+std::vector<double> unpack_grid_values(Isolate* isolate, Handle<Object> js_grid, const char* name) {
+    std::vector<double> values;
+    Handle<Value> value = js_grid->Get(String::NewFromUtf8(isolate, name));
+    if (value->IsUndefined())
+        return values;
+
+    if (value->IsNumber()) {
+        values.push_back(value->NumberValue());
+        return values;
+    }
+
+    if (value->IsArray()) {
+        Handle<Array> list = Handle<Array>::Cast(value);
+        for (uint32_t i = 0; i < list->Length(); ++i) {
+            Handle<Value> item = list->Get(i);
+            if (!item->IsNumber())
+                break;
+            values.push_back(item->NumberValue());
+        }
+        if (values.size() == list->Length())
+            return values;
+    }
+
+    throw std::invalid_argument(std::string("grid.") + name + " must be a number or an array of numbers");
+}
+
+// --- unpack the grid: { C, eps, targetSize }
+TuningGrid unpack_tuning_grid(Isolate* isolate, Handle<Object> js_grid) {
+    TuningGrid grid;
+    grid.C = unpack_grid_values(isolate, js_grid, "C");
+    grid.eps = unpack_grid_values(isolate, js_grid, "eps");
+
+    const std::vector<double> targetSize = unpack_grid_values(isolate, js_grid, "targetSize");
+    for (unsigned long i = 0; i < targetSize.size(); ++i)
+        grid.targetSize.push_back(std::max<double>(0, targetSize[i]));
+
+    return grid;
+}
+
+// Struct representing the async job of tuning an object detector
+struct TuneWork {
+    uv_work_t request;
+    Persistent<Function> callback;
+
+    std::vector<TrainingRecord> trainingRecords;
+    std::string detectorOutputFileName;
+    TuningGrid grid;
+    unsigned long folds;
+    TrainingOptions options;
+
+    std::vector<TuningResult> results;
+    unsigned long best;
+    std::string error;
+};
+
+static void TuneAsync(uv_work_t* req) {
+    TuneWork* work = static_cast<TuneWork*>(req->data);
+
+    try {
+        work->results = tune_object_detector(work->trainingRecords, work->detectorOutputFileName, work->grid,
+                work->folds, work->best, work->options);
+    }
+    catch (std::exception& e) {
+        work->error = e.what();
+    }
+    catch (dlib::error* e) {
+        work->error = e->what();
+    }
+    catch (std::string& e) {
+        work->error = e;
+    }
+    catch (...) {
+        work->error = "Unknown exception happened";
+    }
+}
+
+// Fire the callback with { results: [{ C, eps, targetSize, precision, recall, averagePrecision }, ...], best }, where
+// best is the result the saved detector was trained with
+static void TuneComplete(uv_work_t* req, int status) {
+    Isolate* isolate = Isolate::GetCurrent();
+
+    v8::HandleScope handleScope(isolate);
+    TuneWork *work = static_cast<TuneWork*>(req->data);
+
+    Local<Value> output = Undefined(isolate);
+    if (work->error.empty()) {
+        Local<Array> result_list = Array::New(isolate);
+        for (unsigned long i = 0; i < work->results.size(); ++i) {
+            const TuningResult& res = work->results[i];
+            Local<Object> result = Object::New(isolate);
+            result->Set(String::NewFromUtf8(isolate, "C"), Number::New(isolate, res.C));
+            result->Set(String::NewFromUtf8(isolate, "eps"), Number::New(isolate, res.eps));
+            result->Set(String::NewFromUtf8(isolate, "targetSize"), Number::New(isolate, res.targetSize));
+            result->Set(String::NewFromUtf8(isolate, "precision"), Number::New(isolate, res.precision));
+            result->Set(String::NewFromUtf8(isolate, "recall"), Number::New(isolate, res.recall));
+            result->Set(String::NewFromUtf8(isolate, "averagePrecision"), Number::New(isolate, res.averagePrecision));
+            result_list->Set(i, result);
+        }
+
+        Local<Object> results = Object::New(isolate);
+        results->Set(String::NewFromUtf8(isolate, "results"), result_list);
+        results->Set(String::NewFromUtf8(isolate, "best"), result_list->Get(work->best));
+        output = results;
+    }
+
+    Local<String> error = String::NewFromUtf8(isolate, work->error.c_str());
+
+    unsigned const argc = 2;
+    Handle<Value> argv[argc] = { error, output };
+    Local<Function>::New(isolate, work->callback)->Call(isolate->GetCurrentContext()->Global(), argc, argv);
+
+    work->callback.Reset();
+    delete work;
+}
+
+// Function called by the JS code: tuneObjectDetector(data, detectorOutputFileName, grid, callback, options)
+static void TuneObjectDetector(const FunctionCallbackInfo<Value>& args) {
+    Isolate* isolate = args.GetIsolate();
+
+    if (args.Length() < 4 || !args[2]->IsObject()) {
+        isolate->ThrowException(Exception::TypeError(
+                    String::NewFromUtf8(isolate, "Wrong number of arguments")
+                    ));
+        return;
+    }
+
+    TuneWork* work = new TuneWork();
+    work->request.data = work;
+
+    Handle<Array> data = Handle<Array>::Cast(args[0]);
+    String::Utf8Value detectorOutputFileName(args[1]->ToString());
+    work->trainingRecords = unpack_traning_records(isolate, data);
+    work->detectorOutputFileName = std::string(*detectorOutputFileName);
+    work->folds = 3;
+    work->best = 0;
+
+    // Optional 5th argument: the training options, plus the number of folds of the cross validation
+    try {
+        work->grid = unpack_tuning_grid(isolate, args[2]->ToObject());
+        if (args.Length() > 4 && args[4]->IsObject()) {
+            work->options = unpack_training_options(isolate, args[4]->ToObject());
+
+            Handle<Value> folds = args[4]->ToObject()->Get(String::NewFromUtf8(isolate, "folds"));
+            if (folds->IsNumber())
+                work->folds = std::max<int64_t>(0, folds->IntegerValue());
+        }
+    }
+    catch (std::exception& e) {
+        isolate->ThrowException(Exception::TypeError(String::NewFromUtf8(isolate, e.what())));
+        delete work;
+        return;
+    }
+
+    Local<Function> callback = Local<Function>::Cast(args[3]);
+    work->callback.Reset(isolate, callback);
+
+    native_workers().queue_work(TRAIN_LANE, &work->request, TuneAsync, TuneComplete);
+
+    args.GetReturnValue().Set(Undefined(isolate));
+}
+
+// =======================================================================================
+// Detector handles
+//
+
+// Work structure for loading a detector file into memory
+struct LoadDetectorWork {
+    uv_work_t request;
+    Persistent<Function> callback;
+
+    std::string svmDetectorFileName;
+
+    std::shared_ptr<const detector_type> detector;
+    std::string error;
+};
+
+// Deserialize the detector (or fetch it from the cache of loaded detectors)
+static void LoadDetectorAsync(uv_work_t* req) {
+    LoadDetectorWork* work = static_cast<LoadDetectorWork*>(req->data);
+
+    try {
+        work->detector = loaded_detectors().get(work->svmDetectorFileName);
+    }
+    catch (std::exception& e) {
+        work->error = e.what();
+    }
+    catch (dlib::error* e) {
+        work->error = e->what();
+    }
+    catch (std::string& e) {
+        work->error = e;
+    }
+    catch (...) {
+        work->error = "Unknown exception happened";
+    }
+}
+
+// Wrap the loaded detector in a JS handle and fire the callback
+static void LoadDetectorComplete(uv_work_t* req, int status) {
+    Isolate* isolate = Isolate::GetCurrent();
+
+    v8::HandleScope handleScope(isolate);
+    LoadDetectorWork *work = static_cast<LoadDetectorWork*>(req->data);
+
+    Local<Value> handle = Undefined(isolate);
+    if (work->error.empty())
+        handle = DetectorHandle::NewInstance(isolate, work->detector, work->svmDetectorFileName);
+
+    Local<String> error = String::NewFromUtf8(isolate, work->error.c_str());
+
+    unsigned const argc = 2;
+    Handle<Value> argv[argc] = { error, handle };
+    Local<Function>::New(isolate, work->callback)->Call(isolate->GetCurrentContext()->Global(), argc, argv);
+
+    work->callback.Reset();
+    delete work;
+}
+
+// Function called by the JavaScript side: loadDetector(svmDetectorFileName, callback)
+static void LoadDetector(const FunctionCallbackInfo<Value>& args) {
+    Isolate* isolate = args.GetIsolate();
+
+    if (args.Length() < 2) {
+        isolate->ThrowException(Exception::TypeError(
+                    String::NewFromUtf8(isolate, "Wrong number of arguments")
+                    ));
+        return;
+    }
+
+    LoadDetectorWork* work = new LoadDetectorWork();
+    work->request.data = work;
+
+    String::Utf8Value svmDetectorFileName(args[0]->ToString());
+    work->svmDetectorFileName = std::string(*svmDetectorFileName);
+
+    Local<Function> callback = Local<Function>::Cast(args[1]);
+    work->callback.Reset(isolate, callback);
+
+    native_workers().queue_work(DETECT_LANE, &work->request, LoadDetectorAsync, LoadDetectorComplete);
 
-    // Return undefined
     args.GetReturnValue().Set(Undefined(isolate));
 }
 
@@ -154,13 +575,87 @@ static void TrainObjectDetector(const FunctionCallbackInfo<Value>& args) {
 // Detector
 //
 
+// --- unpack the image argument: a file name, a Buffer with an encoded (JPEG/PNG) image or raw pixels given as
+// { data: Buffer, width, height, channels }. Buffers are not copied, so the caller has to keep them alive (see
+// DetectWork::imageBuffer). Returns an error message if the value is not a valid image.
+std::string unpack_image_source(Isolate* isolate, Local<Value> value, ImageSource& source, Local<Object>& buffer) {
+    if (node::Buffer::HasInstance(value)) {
+        buffer = value->ToObject();
+        source.data = reinterpret_cast<const unsigned char*>(node::Buffer::Data(buffer));
+        source.size = node::Buffer::Length(buffer);
+        return "";
+    }
+
+    if (value->IsObject() && !value->IsString()) {
+        Local<Object> raw = value->ToObject();
+        Local<Value> data = raw->Get(String::NewFromUtf8(isolate, "data"));
+        if (!node::Buffer::HasInstance(data))
+            return "Raw images need a Buffer in their 'data' property";
+
+        source.width = raw->Get(String::NewFromUtf8(isolate, "width"))->IntegerValue();
+        source.height = raw->Get(String::NewFromUtf8(isolate, "height"))->IntegerValue();
+        source.channels = raw->Get(String::NewFromUtf8(isolate, "channels"))->IntegerValue();
+        if (source.width <= 0 || source.height <= 0)
+            return "Raw images need a positive width and height";
+        if (source.channels != 1 && source.channels != 3 && source.channels != 4)
+            return "Raw images must have 1 (gray), 3 (RGB) or 4 (RGBA) channels";
+
+        buffer = data->ToObject();
+        source.data = reinterpret_cast<const unsigned char*>(node::Buffer::Data(buffer));
+        source.size = node::Buffer::Length(buffer);
+        // Divide instead of multiplying, which could overflow with huge dimensions
+        if (source.size/source.channels/source.height < (size_t)source.width)
+            return "Raw image buffer is smaller than width * height * channels";
+        return "";
+    }
+
+    String::Utf8Value imageFileName(value->ToString());
+    source.fileName = std::string(*imageFileName);
+    return "";
+}
+
+// --- unpack the minObjectSize detection option: the size in pixels of the shorter side of the smallest objects to
+// find. 0 (the default) decodes the images at full resolution.
+unsigned long unpack_min_object_size(Isolate* isolate, Local<Object> js_options) {
+    Local<Value> minObjectSize = js_options->Get(String::NewFromUtf8(isolate, "minObjectSize"));
+    if (minObjectSize->IsNumber() && minObjectSize->IntegerValue() > 0)
+        return minObjectSize->IntegerValue();
+    return 0;
+}
+
+// --- unpack the upsample detection option: how many times the images are upsampled by 2 before they're scanned. It must
+// match the upsample the detector was trained with; 0 (the default) scans the images as they are.
+unsigned long unpack_upsample(Isolate* isolate, Local<Object> js_options) {
+    Local<Value> upsample = js_options->Get(String::NewFromUtf8(isolate, "upsample"));
+    if (upsample->IsNumber() && upsample->IntegerValue() > 0)
+        return upsample->IntegerValue();
+    return 0;
+}
+
+// --- unpack the tiled detection options: tileHeight (rows per strip, 0 scans the whole image at once) and
+// maxObjectSize (height of the tallest objects to find, which sets the overlap between strips)
+TileOptions unpack_tile_options(Isolate* isolate, Local<Object> js_options) {
+    TileOptions tiles;
+    Local<Value> tileHeight = js_options->Get(String::NewFromUtf8(isolate, "tileHeight"));
+    if (tileHeight->IsNumber() && tileHeight->IntegerValue() > 0)
+        tiles.tileHeight = tileHeight->IntegerValue();
+    Local<Value> maxObjectSize = js_options->Get(String::NewFromUtf8(isolate, "maxObjectSize"));
+    if (maxObjectSize->IsNumber() && maxObjectSize->IntegerValue() > 0)
+        tiles.maxObjectSize = maxObjectSize->IntegerValue();
+    return tiles;
+}
+
 // Work structure (needed by libuv)
 struct DetectWork {
     uv_work_t request;
     Persistent<Function> callback;
 
-    std::string imageFileName;
+    ImageSource image;
+    Persistent<Object> imageBuffer; // Keeps an in-memory image alive until the detection is done
     std::string svmDetectorFileName;
+    std::shared_ptr<const detector_type> detector; // Set when called with a handle from loadDetector
+    unsigned long threads; // Threads used to scan this one image
+    TileOptions tiles; // Set to scan a large image in strips
 
     std::vector<rectangle> results;
     std::string error;
@@ -171,7 +666,15 @@ static void DetectAsync(uv_work_t* req) {
     DetectWork* work = static_cast<DetectWork*>(req->data);
 
     try {
-        work->results = detect_objects(work->imageFileName, work->svmDetectorFileName);
+        if (work->tiles.tileHeight != 0) {
+            std::shared_ptr<const detector_type> detector = work->detector ? work->detector :
+                loaded_detectors().get(work->svmDetectorFileName);
+            work->results = detect_objects_tiled(work->image, *detector, work->tiles, work->threads);
+        }
+        else if (work->detector)
+            work->results = detect_objects(work->image, *work->detector, work->threads);
+        else
+            work->results = detect_objects(work->image, work->svmDetectorFileName, work->threads);
     }
     catch (std::exception& e) {
         work->error = e.what();
@@ -210,6 +713,7 @@ static void DetectComplete(uv_work_t* req, int status) {
     Local<Function>::New(isolate, work->callback)->Call(isolate->GetCurrentContext()->Global(), argc, argv);
 
     work->callback.Reset();
+    work->imageBuffer.Reset();
     delete work;
 }
 
@@ -228,31 +732,280 @@ static void DetectObjects(const FunctionCallbackInfo<Value>& args) {
         return;
     }
 
-    // Converting the arguments to String values
-    String::Utf8Value imageFileName(args[0]->ToString());
-    String::Utf8Value svmDetectorFileName(args[1]->ToString());
+    // The image is either a file name or in memory
+    Local<Object> imageBuffer;
+    std::string imageError = unpack_image_source(isolate, args[0], work->image, imageBuffer);
+    if (!imageError.empty()) {
+        delete work;
+        isolate->ThrowException(Exception::TypeError(
+                    String::NewFromUtf8(isolate, imageError.c_str())
+                    ));
+        return;
+    }
+    if (!imageBuffer.IsEmpty())
+        work->imageBuffer.Reset(isolate, imageBuffer);
 
-    work->imageFileName = std::string(*imageFileName);
-    work->svmDetectorFileName = std::string(*svmDetectorFileName);
+    // The detector is either a handle returned by loadDetector or the name of a detector file
+    if (DetectorHandle::HasInstance(isolate, args[1])) {
+        work->detector = DetectorHandle::Unwrap(args[1]);
+    }
+    else {
+        String::Utf8Value svmDetectorFileName(args[1]->ToString());
+        work->svmDetectorFileName = std::string(*svmDetectorFileName);
+    }
 
     // Convert the 3rd argument to a callback function and store it for later usage
     Local<Function> callback = Local<Function>::Cast(args[2]);
     work->callback.Reset(isolate, callback);
 
+    // Optional 4th argument: { threads, minObjectSize, upsample, tileHeight, maxObjectSize }. threads splits the work on
+    // this image over several threads; minObjectSize lets JPEGs be decoded to grayscale at a reduced size; upsample
+    // scans the image the way a detector trained with upsample expects; tileHeight scans large images in strips. threads is capped at the number of cores: each detection starts its own threads, and
+    // more of them than cores only adds overhead
+    work->threads = 1;
+    if (args.Length() > 3 && args[3]->IsObject()) {
+        Local<Value> threads = args[3]->ToObject()->Get(String::NewFromUtf8(isolate, "threads"));
+        if (threads->IsNumber() && threads->IntegerValue() > 1)
+            work->threads = std::min<int64_t>(threads->IntegerValue(), std::max(1u, std::thread::hardware_concurrency()));
+        work->image.minObjectSize = unpack_min_object_size(isolate, args[3]->ToObject());
+        work->image.upsample = unpack_upsample(isolate, args[3]->ToObject());
+        work->tiles = unpack_tile_options(isolate, args[3]->ToObject());
+    }
+
     // Start the async process
-    uv_queue_work(uv_default_loop(), &work->request, DetectAsync, DetectComplete);
+    native_workers().queue_work(DETECT_LANE, &work->request, DetectAsync, DetectComplete);
 
     // Return undefined
     args.GetReturnValue().Set(Undefined(isolate));
 }
 
+// =======================================================================================
+// Batch detector
+//
+
+// Work structure for scanning many images in one native job
+struct DetectBatchWork {
+    uv_work_t request;
+    Persistent<Function> callback;
+
+    std::vector<ImageSource> images;
+    Persistent<Array> imageBuffers; // Keeps the in-memory images alive until the detection is done
+    PrefetchOptions prefetch;
+    std::string svmDetectorFileName;
+    std::shared_ptr<const detector_type> detector; // Set when called with a handle from loadDetector
+
+    std::vector<BatchDetection> results;
+    std::string error;
+};
+
+static void DetectBatchAsync(uv_work_t* req) {
+    DetectBatchWork* work = static_cast<DetectBatchWork*>(req->data);
+
+    try {
+        if (!work->detector)
+            work->detector = loaded_detectors().get(work->svmDetectorFileName);
+        work->results = detect_objects_batch(work->images, *work->detector, std::thread::hardware_concurrency(),
+                work->prefetch);
+    }
+    catch (std::exception& e) {
+        work->error = e.what();
+    }
+    catch (dlib::error* e) {
+        work->error = e->what();
+    }
+    catch (std::string& e) {
+        work->error = e;
+    }
+    catch (...) {
+        work->error = "Unknown exception happened";
+    }
+}
+
+// Pack all the detections into one Int32Array of [imageIndex, top, left, width, height] records instead of creating
+// a JS object per rectangle
+static void DetectBatchComplete(uv_work_t* req, int status) {
+    Isolate* isolate = Isolate::GetCurrent();
+
+    v8::HandleScope handleScope(isolate);
+    DetectBatchWork *work = static_cast<DetectBatchWork*>(req->data);
+
+    const size_t fields = 5;
+    Local<ArrayBuffer> storage = ArrayBuffer::New(isolate, work->results.size()*fields*sizeof(int32_t));
+    int32_t* packed = static_cast<int32_t*>(storage->GetContents().Data());
+    for (size_t i = 0; i < work->results.size(); i++) {
+        const rectangle& rect = work->results[i].rect;
+        packed[i*fields + 0] = work->results[i].imageIndex;
+        packed[i*fields + 1] = rect.top();
+        packed[i*fields + 2] = rect.left();
+        packed[i*fields + 3] = rect.width();
+        packed[i*fields + 4] = rect.height();
+    }
+    Local<Int32Array> result_list = Int32Array::New(storage, 0, work->results.size()*fields);
+
+    Local<String> error = String::NewFromUtf8(isolate, work->error.c_str());
+
+    unsigned const argc = 2;
+    Handle<Value> argv[argc] = { error, result_list };
+    Local<Function>::New(isolate, work->callback)->Call(isolate->GetCurrentContext()->Global(), argc, argv);
+
+    work->callback.Reset();
+    work->imageBuffers.Reset();
+    delete work;
+}
+
+// Function called by the JavaScript side: detectObjectsBatch(images, detector, callback, options). Each image can be
+// anything detectObjects accepts, and options can set { minObjectSize, upsample } for all of them, along with how far decoding
+// runs ahead of the detection ({ decodeThreads, prefetchDepth }).
+static void DetectObjectsBatch(const FunctionCallbackInfo<Value>& args) {
+    Isolate* isolate = args.GetIsolate();
+
+    if (args.Length() < 3 || !args[0]->IsArray()) {
+        isolate->ThrowException(Exception::TypeError(
+                    String::NewFromUtf8(isolate, "Wrong number of arguments")
+                    ));
+        return;
+    }
+
+    DetectBatchWork* work = new DetectBatchWork();
+    work->request.data = work;
+
+    Local<Array> images = Local<Array>::Cast(args[0]);
+    Local<Array> imageBuffers = Array::New(isolate);
+    work->images.resize(images->Length());
+    for (uint32_t i = 0; i < images->Length(); ++i) {
+        Local<Object> imageBuffer;
+        std::string imageError = unpack_image_source(isolate, images->Get(i), work->images[i], imageBuffer);
+        if (!imageError.empty()) {
+            delete work;
+            imageError = "Image " + cast_to_string(i) + ": " + imageError;
+            isolate->ThrowException(Exception::TypeError(
+                        String::NewFromUtf8(isolate, imageError.c_str())
+                        ));
+            return;
+        }
+        if (!imageBuffer.IsEmpty())
+            imageBuffers->Set(imageBuffers->Length(), imageBuffer);
+    }
+    work->imageBuffers.Reset(isolate, imageBuffers);
+
+    if (DetectorHandle::HasInstance(isolate, args[1])) {
+        work->detector = DetectorHandle::Unwrap(args[1]);
+    }
+    else {
+        String::Utf8Value svmDetectorFileName(args[1]->ToString());
+        work->svmDetectorFileName = std::string(*svmDetectorFileName);
+    }
+
+    Local<Function> callback = Local<Function>::Cast(args[2]);
+    work->callback.Reset(isolate, callback);
+
+    if (args.Length() > 3 && args[3]->IsObject()) {
+        const unsigned long minObjectSize = unpack_min_object_size(isolate, args[3]->ToObject());
+        const unsigned long upsample = unpack_upsample(isolate, args[3]->ToObject());
+        for (size_t i = 0; i < work->images.size(); ++i) {
+            work->images[i].minObjectSize = minObjectSize;
+            work->images[i].upsample = upsample;
+        }
+        work->prefetch = unpack_prefetch_options(isolate, args[3]->ToObject());
+    }
+
+    native_workers().queue_work(DETECT_LANE, &work->request, DetectBatchAsync, DetectBatchComplete);
+
+    args.GetReturnValue().Set(Undefined(isolate));
+}
+
+// =======================================================================================
+// Worker pool
+//
+
+// Function called by the JavaScript side: configureWorkerPool({ detectThreads, trainThreads }). Has to be called
+// before the first job is started.
+static void ConfigureWorkerPool(const FunctionCallbackInfo<Value>& args) {
+    Isolate* isolate = args.GetIsolate();
+
+    if (args.Length() < 1 || !args[0]->IsObject()) {
+        isolate->ThrowException(Exception::TypeError(
+                    String::NewFromUtf8(isolate, "Wrong number of arguments")
+                    ));
+        return;
+    }
+
+    Local<Object> options = args[0]->ToObject();
+    WorkerLaneStats detect = native_workers().get_stats(DETECT_LANE);
+    WorkerLaneStats train = native_workers().get_stats(TRAIN_LANE);
+    Local<Value> detectThreads = options->Get(String::NewFromUtf8(isolate, "detectThreads"));
+    Local<Value> trainThreads = options->Get(String::NewFromUtf8(isolate, "trainThreads"));
+
+    try {
+        native_workers().configure(
+                detectThreads->IsUndefined() ? detect.threads : detectThreads->IntegerValue(),
+                trainThreads->IsUndefined() ? train.threads : trainThreads->IntegerValue());
+    }
+    catch (std::exception& e) {
+        isolate->ThrowException(Exception::Error(String::NewFromUtf8(isolate, e.what())));
+        return;
+    }
+
+    args.GetReturnValue().Set(Undefined(isolate));
+}
+
+Local<Object> translate_lane_stats(Isolate* isolate, const WorkerLaneStats& stats) {
+    Local<Object> output = Object::New(isolate);
+    output->Set(String::NewFromUtf8(isolate, "threads"), Number::New(isolate, stats.threads));
+    output->Set(String::NewFromUtf8(isolate, "queued"), Number::New(isolate, stats.queued));
+    output->Set(String::NewFromUtf8(isolate, "running"), Number::New(isolate, stats.running));
+    output->Set(String::NewFromUtf8(isolate, "completed"), Number::New(isolate, stats.completed));
+    output->Set(String::NewFromUtf8(isolate, "averageWaitMs"),
+            Number::New(isolate, stats.completed ? stats.totalWaitMs/stats.completed : 0));
+    output->Set(String::NewFromUtf8(isolate, "maxWaitMs"), Number::New(isolate, stats.maxWaitMs));
+    output->Set(String::NewFromUtf8(isolate, "averageRunMs"),
+            Number::New(isolate, stats.completed ? stats.totalRunMs/stats.completed : 0));
+    output->Set(String::NewFromUtf8(isolate, "maxRunMs"), Number::New(isolate, stats.maxRunMs));
+    return output;
+}
+
+// Function called by the JavaScript side: getWorkerPoolStats() returns { detect: {...}, train: {...} }
+static void GetWorkerPoolStats(const FunctionCallbackInfo<Value>& args) {
+    Isolate* isolate = args.GetIsolate();
+
+    Local<Object> result = Object::New(isolate);
+    result->Set(String::NewFromUtf8(isolate, "detect"),
+            translate_lane_stats(isolate, native_workers().get_stats(DETECT_LANE)));
+    result->Set(String::NewFromUtf8(isolate, "train"),
+            translate_lane_stats(isolate, native_workers().get_stats(TRAIN_LANE)));
+
+    args.GetReturnValue().Set(result);
+}
+
+// Function called by the JavaScript side: getSimdLevel() returns { level, cpu, baseline }, i.e. the instruction set
+// the image kernels picked at load time, the best one the CPU supports and the one the rest of dlib was compiled for
+static void GetSimdLevel(const FunctionCallbackInfo<Value>& args) {
+    Isolate* isolate = args.GetIsolate();
+
+    Local<Object> result = Object::New(isolate);
+    result->Set(String::NewFromUtf8(isolate, "level"), String::NewFromUtf8(isolate, simd_level_name(get_simd_dispatch_level())));
+    result->Set(String::NewFromUtf8(isolate, "cpu"), String::NewFromUtf8(isolate, simd_level_name(get_cpu_simd_level())));
+    result->Set(String::NewFromUtf8(isolate, "baseline"), String::NewFromUtf8(isolate, simd_level_name(CPU_SIMD_BASELINE)));
+
+    args.GetReturnValue().Set(result);
+}
+
 // =======================================================================================
 // This section is the equivalent of module.exports in JS
 //
 
 void init(Local<Object> exports) {
+    DetectorHandle::Init(exports->GetIsolate());
+    TrainingJob::Init(exports->GetIsolate());
+
     NODE_SET_METHOD(exports, "trainObjectDetector", TrainObjectDetector);
+    NODE_SET_METHOD(exports, "tuneObjectDetector", TuneObjectDetector);
+    NODE_SET_METHOD(exports, "loadDetector", LoadDetector);
     NODE_SET_METHOD(exports, "detectObjects", DetectObjects);
+    NODE_SET_METHOD(exports, "detectObjectsBatch", DetectObjectsBatch);
+    NODE_SET_METHOD(exports, "configureWorkerPool", ConfigureWorkerPool);
+    NODE_SET_METHOD(exports, "getWorkerPoolStats", GetWorkerPoolStats);
+    NODE_SET_METHOD(exports, "getSimdLevel", GetSimdLevel);
 }
 
 NODE_MODULE(recognition, init)
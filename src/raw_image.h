@@ -0,0 +1,48 @@
+#include <dlib/pixel.h>
+#include <dlib/error.h>
+#include <dlib/image_processing/generic_image.h>
+#include <algorithm>
+
+// Read-only view over pixels owned by someone else (e.g. a Node Buffer). It implements dlib's generic image
+// interface, so the detector can scan the pixels in place instead of copying them into an array2d first.
+template <typename pixel_type>
+struct raw_image {
+    raw_image() : data(0), rows(0), columns(0) {}
+    raw_image(const unsigned char* data, long rows, long columns) : data(data), rows(rows), columns(columns) {}
+
+    const unsigned char* data;
+    long rows;
+    long columns;
+};
+
+template <typename pixel_type>
+long num_rows(const raw_image<pixel_type>& img) { return img.rows; }
+
+template <typename pixel_type>
+long num_columns(const raw_image<pixel_type>& img) { return img.columns; }
+
+template <typename pixel_type>
+long width_step(const raw_image<pixel_type>& img) { return img.columns*sizeof(pixel_type); }
+
+template <typename pixel_type>
+const void* image_data(const raw_image<pixel_type>& img) { return img.data; }
+
+// Only ever used as an input image, so nothing writes through this pointer
+template <typename pixel_type>
+void* image_data(raw_image<pixel_type>& img) { return const_cast<unsigned char*>(img.data); }
+
+template <typename pixel_type>
+void set_image_size(raw_image<pixel_type>& img, long rows, long columns) {
+    if (rows != img.rows || columns != img.columns)
+        throw dlib::error("raw_image is a view over existing pixels and can't be resized");
+}
+
+template <typename pixel_type>
+void swap(raw_image<pixel_type>& a, raw_image<pixel_type>& b) { std::swap(a, b); }
+
+namespace dlib {
+    template <typename T>
+    struct image_traits<raw_image<T> > {
+        typedef T pixel_type;
+    };
+}
@@ -3,6 +3,7 @@
  */
 
 #define DLIB_JPEG_SUPPORT
+#define DLIB_PNG_SUPPORT
 
 #include <dlib/svm_threaded.h>
 #include <dlib/string.h>
@@ -10,11 +11,18 @@
 #include <dlib/image_processing.h>
 #include <dlib/data_io.h>
 #include <dlib/cmd_line_parser.h>
+#include <dlib/misc_api.h>
 
 #include <iostream>
 #include <fstream>
 #include <string>
 #include <vector>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include "decode_pipeline.h"
 
 using namespace std;
 using namespace dlib;
@@ -25,6 +33,82 @@ struct TrainingRecord {
     std::vector<dlib::rectangle> matchAreas;
 };
 
+// Decode a training image, upsampled the same way as its boxes
+void load_training_image(const TrainingRecord& record, unsigned long upsampleAmount, array2d<unsigned char>& img) {
+    try {
+        load_image(img, record.imageFileName);
+        pyramid_down<2> pyr;
+        for (unsigned long j = 0; j < upsampleAmount; ++j)
+            pyramid_up(img, pyr);
+    }
+    catch (std::exception& e) {
+        throw dlib::error("Unable to load training image " + record.imageFileName + ": " + e.what());
+    }
+}
+
+// Knobs of the training process. The defaults are the values the trainer always used, except for the number of
+// threads, which defaults to one per core
+struct TrainingOptions {
+    unsigned long threads;            // Threads used by the structural SVM solver
+    double C;                         // SVM regularization: larger values fit the training data more closely
+    double eps;                       // Stopping tolerance: larger values train faster but less accurately
+    unsigned long targetSize;         // Area (in pixels) of the detection window
+    unsigned long upsampleAmount;     // How many times the training images are upsampled by 2 before training
+    unsigned long cellSize;           // Size (in pixels) of the fHOG cells
+    unsigned long padding;            // Cells of padding around the detection window
+    unsigned long maxPyramidLevels;   // Maximum number of image pyramid levels scanned
+    fhog_feature_storage featureStorage; // How the feature pyramids of the training images are kept in memory
+    std::string unknownFeatureStorage;   // Name given for featureStorage when it names none of them
+    std::string featureCacheDirectory;   // If set, the feature pyramids are kept in (memory mapped) files there
+    std::string checkpointFileName;   // If set, the state of the solver is saved there while training
+    unsigned long checkpointInterval; // Solver iterations between two checkpoints
+    std::string resumeFileName;       // If set, the training resumes from the checkpoint saved there
+    PrefetchOptions prefetch;         // How far decoding the images runs ahead of loading them into their scanners
+
+    TrainingOptions() :
+        threads(std::max(1u, std::thread::hardware_concurrency())),
+        C(1.0),
+        eps(0.01),
+        targetSize(80*80),
+        upsampleAmount(0),
+        cellSize(8),
+        padding(1),
+        maxPyramidLevels(1000),
+        featureStorage(FHOG_STORE_FLOAT),
+        checkpointInterval(10) {}
+};
+
+// What train_object_detector reports after every iteration of the cutting plane solver
+struct TrainingProgress {
+    unsigned long iteration;  // Iterations done so far, including the ones done before resuming from a checkpoint
+    double objective;         // Current value of the SVM objective
+    double objectiveGap;      // How far the objective can still be from the optimum
+    double risk;              // Current value of the loss part of the objective
+    double riskGap;           // How far the risk can still be from the optimum; training stops once it's below eps
+    unsigned long planes;     // Cutting planes the solver is working with
+    double elapsedMs;         // Time since the training started, loading the images included
+};
+
+// Lets whoever started a training follow it and stop it. onProgress is called on the training thread, cancel() can be
+// called from any thread; the training stops at the end of the solver iteration it is in.
+class TrainingMonitor {
+public:
+    TrainingMonitor() : cancelRequested(false) {}
+
+    void cancel() { cancelRequested = true; }
+    bool cancelled() const { return cancelRequested; }
+
+    std::function<void(const TrainingProgress&)> onProgress;
+
+private:
+    std::atomic<bool> cancelRequested;
+};
+
+void throw_if_cancelled(const TrainingMonitor* monitor) {
+    if (monitor && monitor->cancelled())
+        throw error("Training cancelled");
+}
+
 // Define the best window size based on the rectangles defined for the images
 void pick_best_window_size(
     const std::vector<std::vector<rectangle> >& boxes,
@@ -71,77 +155,435 @@ bool contains_any_boxes(const std::vector<std::vector<rectangle> >& boxes) {
 }
 
 void throw_invalid_box_error_message(
-    const std::vector<std::vector<rectangle> >& removed,
+    const std::string& imageFileName,
     const unsigned long target_size
 ) {
     std::ostringstream sout;
-    sout << "Error!  An impossible set of object boxes was given for training. ";
+    sout << "Error!  An impossible set of object boxes was given for training image " << imageFileName << ". ";
     sout << "All the boxes need to have a similar aspect ratio and also not be ";
     sout << "smaller than about " << target_size << " pixels in area. ";
     throw error("\n"+wrap_string(sout.str()) + "\n");
 }
 
-//===================================================== Actual code comes now ===========
-void train_object_detector(std::vector<TrainingRecord>& trainingRecords, std::string detectorOutputFileName) {
-    typedef scan_fhog_pyramid<pyramid_down<6> > image_scanner_type; 
-    // Get the upsample option from the user but use 0 if it wasn't given.
-    const unsigned long upsample_amount = 0;
+void validate_training_options(const TrainingOptions& options) {
+    // Every one of these threads is started for the training, so a few per core is as far as it makes sense to go
+    const unsigned long maxThreads = 4*std::max(1u, std::thread::hardware_concurrency());
 
-    dlib::array<array2d<unsigned char> > images;
-    std::vector<std::vector<rectangle> > object_locations, ignore;
+    std::ostringstream sout;
+    if (options.threads == 0)
+        sout << "threads must be at least 1. ";
+    if (options.threads > maxThreads)
+        sout << "threads must be at most " << maxThreads << " (4 per core). ";
+    if (options.prefetch.decodeThreads > maxThreads)
+        sout << "decodeThreads must be at most " << maxThreads << " (4 per core). ";
+    if (!(options.C > 0))
+        sout << "C must be greater than 0. ";
+    if (!(options.eps > 0))
+        sout << "eps must be greater than 0. ";
+    if (options.targetSize == 0)
+        sout << "targetSize must be greater than 0. ";
+    if (options.cellSize == 0)
+        sout << "cellSize must be greater than 0. ";
+    if (options.maxPyramidLevels == 0)
+        sout << "maxPyramidLevels must be at least 1. ";
+    if (options.checkpointInterval == 0)
+        sout << "checkpointInterval must be at least 1. ";
+    if (!options.unknownFeatureStorage.empty())
+        sout << "featureStorage must be 'float', 'half' or 'uint8', not '" << options.unknownFeatureStorage << "'. ";
 
-    ignore.clear(); // not used for now. Keep it simple.
-    images.clear();
-    object_locations.clear();
+    if (!sout.str().empty())
+        throw error("Invalid training options: " + sout.str());
+}
+
+typedef scan_fhog_pyramid<pyramid_down<6> > image_scanner_type;
 
-    // Load the images and locations (match areas)
-    std::vector<rectangle> empty;
-    empty.clear();
-    array2d<unsigned char> img;
+// Collect the match areas of the training records, upsampled the same way the images will be, and an empty list of
+// ignored areas for each one. Only the locations are kept in memory; catch missing files before the trainer starts.
+void unpack_training_boxes(
+    const std::vector<TrainingRecord>& trainingRecords,
+    const TrainingOptions& options,
+    std::vector<std::vector<rectangle> >& object_locations,
+    std::vector<std::vector<rectangle> >& ignore
+) {
     for (int i = 0; i < trainingRecords.size(); ++i) {
-        TrainingRecord* rec = &trainingRecords[i];
-        load_image(img, rec->imageFileName);
-        images.push_back(img);
+        const TrainingRecord* rec = &trainingRecords[i];
+        if (!std::ifstream(rec->imageFileName.c_str()))
+            throw error("Unable to open training image " + rec->imageFileName);
         object_locations.push_back(rec->matchAreas);
-        ignore.push_back(empty);
+        ignore.push_back(std::vector<rectangle>());
     }
 
-    // Default values
-    const int threads = 4;
-    const double C   = 1.0;
-    const double eps = 0.01;
-    unsigned int num_folds = 3;
-    const unsigned long target_size = 80*80;
+    // Upsampling lets the detector find objects smaller than the detection window, at the cost of 4 times the work
+    // for each level. The images given to the detector later on have to be upsampled the same way.
+    pyramid_down<2> pyr;
+    for (unsigned long i = 0; i < options.upsampleAmount; ++i) {
+        for (unsigned long j = 0; j < object_locations.size(); ++j)
+            for (unsigned long k = 0; k < object_locations[j].size(); ++k)
+                object_locations[j][k] = pyr.rect_up(object_locations[j][k]);
+    }
 
-    // You can't do more folds than there are images.  
-    if (num_folds > images.size())
-        num_folds = images.size();
+    // The scanners load their feature pyramids from the cache directory, or write them there the first time an image
+    // is seen. They do that on the trainer's pool threads, so make sure the files can be written before it starts.
+    if (!options.featureCacheDirectory.empty()) {
+        create_directory(options.featureCacheDirectory);
+        const std::string probe = options.featureCacheDirectory + "/.marsupial_probe";
+        if (!std::ofstream(probe.c_str()))
+            throw error("Unable to write to the feature cache directory " + options.featureCacheDirectory);
+        std::remove(probe.c_str());
+    }
+}
 
-    image_scanner_type scanner;
+// Set up the scanner the detectors are trained with
+void configure_training_scanner(
+    image_scanner_type& scanner,
+    const std::vector<std::vector<rectangle> >& object_locations,
+    const TrainingOptions& options
+) {
     unsigned long width, height;
 
     // check the window size (size of the object to be detected) based on an average value of the match areas
-    pick_best_window_size(object_locations, width, height, target_size);
+    pick_best_window_size(object_locations, width, height, options.targetSize);
     scanner.set_detection_window_size(width, height); 
+    scanner.set_cell_size(options.cellSize);
+    scanner.set_padding(options.padding);
+    scanner.set_max_pyramid_levels(options.maxPyramidLevels);
+    scanner.set_feature_storage(options.featureStorage);
+    scanner.set_feature_cache_directory(options.featureCacheDirectory);
+}
+
+// One decoded image, seen as an array of images, for dlib functions that take a whole dataset
+struct SingleImageArray {
+    explicit SingleImageArray(const array2d<unsigned char>& image) : image(image) {}
+
+    size_t size() const { return 1; }
+    const array2d<unsigned char>& operator[](size_t) const { return image; }
+
+    const array2d<unsigned char>& image;
+};
+
+// Decode every training image once and load it into its own scanner, which is the slow part of setting up a training.
+// The images go through the decode-ahead pipeline: options.prefetch.decodeThreads threads decode them while
+// options.threads threads extract their features. Each decoded image is also used to make sure its boxes are
+// obtainable by the scanner, which throws an error if they aren't.
+prepared_object_detection_dataset<image_scanner_type> prepare_training_dataset(
+    const image_scanner_type& scanner,
+    const std::vector<TrainingRecord>& trainingRecords,
+    const std::vector<std::vector<rectangle> >& object_locations,
+    const std::vector<std::vector<rectangle> >& ignore,
+    const TrainingOptions& options,
+    const TrainingMonitor* monitor = NULL
+) {
+    dlib::array<image_scanner_type> scanners;
+    scanners.set_max_size(trainingRecords.size());
+    scanners.set_size(trainingRecords.size());
+    for (unsigned long i = 0; i < scanners.size(); ++i)
+        scanners[i].copy_configuration(scanner);
+
+    const structural_object_detection_trainer<image_scanner_type> trainer(scanner);
+    decode_pipeline<array2d<unsigned char> > pipeline(trainingRecords.size(), options.threads, options.prefetch);
+    pipeline.run(
+        [&](size_t i, array2d<unsigned char>& img) {
+            throw_if_cancelled(monitor);
+            load_training_image(trainingRecords[i], options.upsampleAmount, img);
+        },
+        [&](unsigned long, size_t i, array2d<unsigned char>& img) {
+            if (!object_locations[i].empty()) {
+                std::vector<std::vector<rectangle> > locations(1, object_locations[i]);
+                if (contains_any_boxes(remove_unobtainable_rectangles(trainer, SingleImageArray(img), locations))) {
+                    unsigned long scale = options.upsampleAmount+1;
+                    scale = scale*scale;
+                    throw_invalid_box_error_message(trainingRecords[i].imageFileName, options.targetSize/scale);
+                }
+            }
+            scanners[i].load(img);
+        });
+
+    return prepared_object_detection_dataset<image_scanner_type>(scanner, scanners, object_locations, ignore);
+}
+
+//======================================================================================= Checkpoints
+typedef oca_state<matrix<double,0,1> > solver_state_type;
+
+const std::string checkpointFormat = "marsupial_training_checkpoint_1";
+
+// Saves the state of the solver, along with the C it was solving for. The file is written next to the old one and
+// then renamed over it, so an interrupted training never leaves a half written checkpoint behind.
+void save_training_checkpoint(
+    const std::string& fileName,
+    const TrainingOptions& options,
+    const solver_state_type& state
+) {
+    const std::string tempFileName = fileName + ".tmp";
+    {
+        std::ofstream fout(tempFileName.c_str(), std::ios::binary);
+        serialize(checkpointFormat, fout);
+        serialize(options.C, fout);
+        serialize(state, fout);
+        if (!fout)
+            throw error("Unable to write the training checkpoint " + fileName);
+    }
+    if (std::rename(tempFileName.c_str(), fileName.c_str()) != 0) {
+        std::remove(fileName.c_str());
+        if (std::rename(tempFileName.c_str(), fileName.c_str()) != 0)
+            throw error("Unable to write the training checkpoint " + fileName);
+    }
+}
+
+void load_training_checkpoint(
+    const std::string& fileName,
+    const TrainingOptions& options,
+    solver_state_type& state
+) {
+    std::ifstream fin(fileName.c_str(), std::ios::binary);
+    if (!fin)
+        throw error("Unable to open the training checkpoint " + fileName);
+
+    std::string format;
+    double C;
+    try {
+        deserialize(format, fin);
+        if (format != checkpointFormat)
+            throw serialization_error("unknown format");
+        deserialize(C, fin);
+        deserialize(state, fin);
+    }
+    catch (std::exception&) {
+        throw error(fileName + " is not a training checkpoint");
+    }
+
+    // The solver keeps the dual variables of its cutting planes summing to C
+    if (C != options.C)
+        throw error("The training checkpoint " + fileName + " was saved with C = " + cast_to_string(C) +
+                ", it can only be resumed with the same C");
+}
+
+// The structural SVM problem structural_object_detection_trainer solves, which also reports the progress of the
+// solver, saves its state every options.checkpointInterval iterations and stops when the training is cancelled.
+class MonitoredTrainingProblem :
+    public structural_svm_object_detection_problem<image_scanner_type, prepared_object_detection_dataset<image_scanner_type> > {
+public:
+    typedef structural_svm_object_detection_problem<image_scanner_type,
+            prepared_object_detection_dataset<image_scanner_type> > base_type;
+
+    MonitoredTrainingProblem(
+        const prepared_object_detection_dataset<image_scanner_type>& dataset,
+        const TrainingOptions& options,
+        const solver_state_type& state,
+        TrainingMonitor* monitor,
+        std::chrono::steady_clock::time_point startTime
+    ) :
+        base_type(test_box_overlap(), true, dataset, test_box_overlap(), options.threads),
+        options(options), state(state), monitor(monitor), startTime(startTime) {}
+
+protected:
+    virtual bool optimization_status(
+        double objective,
+        double objectiveGap,
+        double risk,
+        double riskGap,
+        unsigned long planes,
+        unsigned long iteration
+    ) const {
+        const bool converged = base_type::optimization_status(objective, objectiveGap, risk, riskGap, planes,
+                iteration);
+
+        if (monitor && monitor->onProgress) {
+            const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - startTime;
+            TrainingProgress progress = { iteration, objective, objectiveGap, risk, riskGap, planes, elapsed.count() };
+            monitor->onProgress(progress);
+        }
+
+        // The state holds the solver as it was at the start of this iteration
+        const bool cancelled = monitor && monitor->cancelled();
+        if (!options.checkpointFileName.empty() && (cancelled || iteration % options.checkpointInterval == 0))
+            save_training_checkpoint(options.checkpointFileName, options, state);
+
+        return converged || cancelled;
+    }
+
+private:
+    const TrainingOptions& options;
+    const solver_state_type& state;
+    TrainingMonitor* const monitor;
+    const std::chrono::steady_clock::time_point startTime;
+};
+
+//===================================================== Actual code comes now ===========
+void train_object_detector(
+    std::vector<TrainingRecord>& trainingRecords,
+    std::string detectorOutputFileName,
+    const TrainingOptions& options = TrainingOptions(),
+    TrainingMonitor* monitor = NULL
+) {
+    const std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+    validate_training_options(options);
+    throw_if_cancelled(monitor);
+
+    std::vector<std::vector<rectangle> > object_locations, ignore;
+    unpack_training_boxes(trainingRecords, options, object_locations, ignore);
+
+    solver_state_type state;
+    if (!options.resumeFileName.empty())
+        load_training_checkpoint(options.resumeFileName, options, state);
+
+    image_scanner_type scanner;
+    configure_training_scanner(scanner, object_locations, options);
 
     // Create the trainer object
     structural_object_detection_trainer<image_scanner_type> trainer(scanner);
-    trainer.set_num_threads(threads);
-    trainer.set_c(C);
-    trainer.set_epsilon(eps);
-
-    // Now make sure all the boxes are obtainable by the scanner.  
-    std::vector<std::vector<rectangle> > removed;
-    removed = remove_unobtainable_rectangles(trainer, images, object_locations);
-    // if we weren't able to get all the boxes to match then throw an error 
-    if (contains_any_boxes(removed)) {
-        unsigned long scale = upsample_amount+1;
-        scale = scale*scale;
-        throw_invalid_box_error_message(removed, target_size/scale);
-    }
+    trainer.set_num_threads(options.threads);
+    trainer.set_c(options.C);
+    trainer.set_epsilon(options.eps);
+
+    // The solver also learns the detection threshold, the last element of w
+    if (!state.empty() && state.w.size() != (long)scanner.get_num_dimensions() + 1)
+        throw error("The training checkpoint " + options.resumeFileName +
+                " was saved for a different detection window or cell size");
+
+    // Load the images into their scanners, then solve the problem the trainer would, only with the solver's state at
+    // hand for the checkpoints
+    const prepared_object_detection_dataset<image_scanner_type> dataset = prepare_training_dataset(scanner,
+            trainingRecords, object_locations, ignore, options, monitor);
+    throw_if_cancelled(monitor);
 
-    // Do the actual training and save the results into the detector object.  
-    object_detector<image_scanner_type> detector = trainer.train(images, object_locations, ignore);
+    MonitoredTrainingProblem problem(dataset, options, state, monitor, startTime);
+    problem.set_c(trainer.get_c());
+    problem.set_epsilon(trainer.get_epsilon());
+    problem.set_max_cache_size(trainer.get_max_cache_size());
+    problem.set_match_eps(trainer.get_match_eps());
+    problem.set_loss_per_missed_target(trainer.get_loss_per_missed_target());
+    problem.set_loss_per_false_alarm(trainer.get_loss_per_false_alarm());
+    configure_nuclear_norm_regularizer(scanner, problem);
+
+    matrix<double,0,1> w;
+    trainer.get_oca()(problem, w, state);
+    throw_if_cancelled(monitor);
+
+    object_detector<image_scanner_type> detector(scanner, problem.get_overlap_tester(), w);
     serialize(detectorOutputFileName) << detector;
 }
 
+//======================================================================================= Tuning
+// The values of C, eps and targetSize tried by tune_object_detector. Every combination of them is a grid point; an
+// empty list means the value in the TrainingOptions.
+struct TuningGrid {
+    std::vector<double> C;
+    std::vector<double> eps;
+    std::vector<unsigned long> targetSize;
+};
+
+// One grid point and how the detectors trained with it did on the held out images of the cross validation
+struct TuningResult {
+    double C;
+    double eps;
+    unsigned long targetSize;
+    double precision;
+    double recall;
+    double averagePrecision;
+};
+
+// Cross validates the detectors trained with every point of the grid and writes the one trained with the best point
+// (the highest average precision; the first one of a tie) on all the records to detectorOutputFileName. Returns the
+// results in grid order (targetSize, then C, then eps) and the index of the best one in 'best'.
+//
+// The features depend on the detection window, so the images are loaded into their scanners once for every
+// targetSize and shared by all the values of C and eps, and by all the folds. Those points are trained at the same
+// time, splitting options.threads between them.
+std::vector<TuningResult> tune_object_detector(
+    std::vector<TrainingRecord>& trainingRecords,
+    std::string detectorOutputFileName,
+    const TuningGrid& grid,
+    unsigned long folds,
+    unsigned long& best,
+    const TrainingOptions& options = TrainingOptions()
+) {
+    validate_training_options(options);
+
+    const std::vector<double> Cs = grid.C.empty() ? std::vector<double>(1, options.C) : grid.C;
+    const std::vector<double> epss = grid.eps.empty() ? std::vector<double>(1, options.eps) : grid.eps;
+    const std::vector<unsigned long> targetSizes = grid.targetSize.empty() ?
+        std::vector<unsigned long>(1, options.targetSize) : grid.targetSize;
+
+    std::vector<TuningResult> results;
+    for (unsigned long t = 0; t < targetSizes.size(); ++t) {
+        for (unsigned long c = 0; c < Cs.size(); ++c) {
+            for (unsigned long e = 0; e < epss.size(); ++e) {
+                TrainingOptions point(options);
+                point.C = Cs[c];
+                point.eps = epss[e];
+                point.targetSize = targetSizes[t];
+                validate_training_options(point);
+
+                TuningResult result = { Cs[c], epss[e], targetSizes[t], 0, 0, 0 };
+                results.push_back(result);
+            }
+        }
+    }
+    if (folds < 2 || folds > trainingRecords.size())
+        throw error("folds must be between 2 and the number of training records (" +
+                cast_to_string(trainingRecords.size()) + ")");
+
+    std::vector<std::vector<rectangle> > object_locations, ignore;
+    unpack_training_boxes(trainingRecords, options, object_locations, ignore);
+
+    const unsigned long pointsPerSize = Cs.size()*epss.size();
+    const unsigned long concurrent = std::min(options.threads, pointsPerSize);
+    const unsigned long threadsPerPoint = std::max(1ul, options.threads/concurrent);
+
+    object_detector<image_scanner_type> detector;
+    best = 0;
+    for (unsigned long t = 0; t < targetSizes.size(); ++t) {
+        TrainingOptions sizeOptions(options);
+        sizeOptions.targetSize = targetSizes[t];
+
+        image_scanner_type scanner;
+        configure_training_scanner(scanner, object_locations, sizeOptions);
+
+        // The slow part: every image is loaded into its own scanner, for all the points of this size at once
+        const prepared_object_detection_dataset<image_scanner_type> dataset = prepare_training_dataset(scanner,
+                trainingRecords, object_locations, ignore, sizeOptions);
+
+        // An exception can't leave one of dlib's pool threads, so each point keeps its own error
+        std::vector<std::string> errors(pointsPerSize);
+        TuningResult* sizeResults = &results[t*pointsPerSize];
+        parallel_for(concurrent, 0, pointsPerSize, [&](long i) {
+            try {
+                structural_object_detection_trainer<image_scanner_type> trainer(scanner);
+                trainer.set_num_threads(threadsPerPoint);
+                trainer.set_c(sizeResults[i].C);
+                trainer.set_epsilon(sizeResults[i].eps);
+
+                const matrix<double,1,3> res = cross_validate_object_detection_trainer(trainer, dataset, folds);
+                sizeResults[i].precision = res(0);
+                sizeResults[i].recall = res(1);
+                sizeResults[i].averagePrecision = res(2);
+            }
+            catch (std::exception& e) {
+                errors[i] = e.what();
+            }
+        });
+        for (unsigned long i = 0; i < errors.size(); ++i) {
+            if (!errors[i].empty())
+                throw error(errors[i]);
+        }
+
+        // Train the detector on all the records while the dataset of this size is still around, if one of its points
+        // is the best so far
+        unsigned long sizeBest = t*pointsPerSize;
+        for (unsigned long i = sizeBest + 1; i < (t + 1)*pointsPerSize; ++i) {
+            if (results[i].averagePrecision > results[sizeBest].averagePrecision)
+                sizeBest = i;
+        }
+        if (t == 0 || results[sizeBest].averagePrecision > results[best].averagePrecision) {
+            best = sizeBest;
+            structural_object_detection_trainer<image_scanner_type> trainer(scanner);
+            trainer.set_num_threads(options.threads);
+            trainer.set_c(results[best].C);
+            trainer.set_epsilon(results[best].eps);
+            detector = trainer.train(dataset);
+        }
+    }
+
+    serialize(detectorOutputFileName) << detector;
+    return results;
+}
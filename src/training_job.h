@@ -0,0 +1,47 @@
+#include <node.h>
+#include <node_object_wrap.h>
+#include <memory>
+
+using namespace v8;
+
+// JS handle to a training started by trainObjectDetector, so it can be cancelled while it runs
+class TrainingJob : public node::ObjectWrap {
+public:
+    static void Init(Isolate* isolate) {
+        Local<FunctionTemplate> tpl = FunctionTemplate::New(isolate, New);
+        tpl->SetClassName(String::NewFromUtf8(isolate, "TrainingJob"));
+        tpl->InstanceTemplate()->SetInternalFieldCount(1);
+        NODE_SET_PROTOTYPE_METHOD(tpl, "cancel", Cancel);
+
+        constructor.Reset(isolate, tpl->GetFunction());
+    }
+
+    // Create a JS handle controlling the training followed by the given monitor
+    static Local<Object> NewInstance(Isolate* isolate, std::shared_ptr<TrainingMonitor> monitor) {
+        Local<Object> instance = Local<Function>::New(isolate, constructor)->NewInstance();
+        TrainingJob* job = ObjectWrap::Unwrap<TrainingJob>(instance);
+        job->monitor = monitor;
+        return instance;
+    }
+
+private:
+    static void New(const FunctionCallbackInfo<Value>& args) {
+        TrainingJob* job = new TrainingJob();
+        job->Wrap(args.This());
+        args.GetReturnValue().Set(args.This());
+    }
+
+    // Ask the training to stop. Harmless once it has finished.
+    static void Cancel(const FunctionCallbackInfo<Value>& args) {
+        TrainingJob* job = ObjectWrap::Unwrap<TrainingJob>(args.Holder());
+        if (job->monitor)
+            job->monitor->cancel();
+        args.GetReturnValue().Set(Undefined(args.GetIsolate()));
+    }
+
+    std::shared_ptr<TrainingMonitor> monitor;
+
+    static Persistent<Function> constructor;
+};
+
+Persistent<Function> TrainingJob::constructor;
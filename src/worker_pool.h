@@ -0,0 +1,191 @@
+#include <uv.h>
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Kinds of jobs run by the worker pool. Each lane has its own queue and its own threads, so a long training job can
+// never hold up detections (or node's own fs/crypto work, which stays on libuv's threadpool).
+enum worker_lane {
+    DETECT_LANE = 0,
+    TRAIN_LANE = 1,
+    NUM_LANES = 2
+};
+
+struct WorkerLaneStats {
+    size_t threads;
+    size_t queued;
+    size_t running;
+    size_t completed;
+    double totalWaitMs, maxWaitMs; // Time spent in the queue
+    double totalRunMs, maxRunMs;   // Time spent running
+};
+
+// Pool of native threads running uv_work_t jobs, used instead of uv_queue_work. Jobs are queued and completed on the
+// event loop thread; the work callback runs on one of the pool threads. Completions are handed back to the event
+// loop through a uv_async_t.
+//
+// Workers take jobs from their own lane first. Once it's empty they steal detections from the detect lane, but never
+// training jobs, so the detect lane always has its own threads available.
+class worker_pool {
+public:
+    worker_pool() : started(false), outstanding(0) {
+        threads[DETECT_LANE] = std::max(std::thread::hardware_concurrency(), 1u);
+        threads[TRAIN_LANE] = 1;
+        for (int lane = 0; lane < NUM_LANES; ++lane)
+            stats[lane] = WorkerLaneStats();
+    }
+
+    // Set the number of threads of each lane. Only possible before the first job is queued.
+    void configure(long detectThreads, long trainThreads) {
+        if (started)
+            throw std::runtime_error("The worker pool is already running");
+        if (detectThreads <= 0 || trainThreads <= 0)
+            throw std::runtime_error("Each worker lane needs at least one thread");
+
+        threads[DETECT_LANE] = detectThreads;
+        threads[TRAIN_LANE] = trainThreads;
+    }
+
+    // Same contract as uv_queue_work: 'work' runs on a pool thread, then 'after' runs on the event loop thread
+    void queue_work(worker_lane lane, uv_work_t* req, uv_work_cb work, uv_after_work_cb after) {
+        start();
+
+        job queued;
+        queued.req = req;
+        queued.work = work;
+        queued.after = after;
+        queued.lane = lane;
+        queued.queuedAt = clock::now();
+
+        // Keep node running while jobs are in flight
+        if (outstanding++ == 0)
+            uv_ref(reinterpret_cast<uv_handle_t*>(&completed_signal));
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            pending[lane].push_back(queued);
+            stats[lane].queued++;
+        }
+        job_available.notify_all();
+    }
+
+    WorkerLaneStats get_stats(worker_lane lane) {
+        std::lock_guard<std::mutex> lock(mutex);
+        WorkerLaneStats result = stats[lane];
+        result.threads = threads[lane];
+        return result;
+    }
+
+private:
+    typedef std::chrono::steady_clock clock;
+
+    struct job {
+        uv_work_t* req;
+        uv_work_cb work;
+        uv_after_work_cb after;
+        worker_lane lane;
+        clock::time_point queuedAt;
+    };
+
+    void start() {
+        if (started)
+            return;
+        started = true;
+
+        uv_async_init(uv_default_loop(), &completed_signal, on_completed);
+        completed_signal.data = this;
+        uv_unref(reinterpret_cast<uv_handle_t*>(&completed_signal));
+
+        for (int lane = 0; lane < NUM_LANES; ++lane) {
+            for (size_t t = 0; t < threads[lane]; ++t)
+                workers.push_back(std::thread(&worker_pool::run, this, static_cast<worker_lane>(lane)));
+        }
+    }
+
+    // Pop the next job for a worker of the given lane. Must be called with the mutex held.
+    bool take(worker_lane lane, job& next) {
+        worker_lane from = lane;
+        if (pending[from].empty())
+            from = DETECT_LANE;
+        if (pending[from].empty())
+            return false;
+
+        next = pending[from].front();
+        pending[from].pop_front();
+        stats[from].queued--;
+        stats[from].running++;
+        return true;
+    }
+
+    // Worker threads live as long as the process
+    void run(worker_lane lane) {
+        for (;;) {
+            job next;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                job_available.wait(lock, [&]() { return take(lane, next); });
+            }
+
+            clock::time_point startedAt = clock::now();
+            next.work(next.req);
+            clock::time_point finishedAt = clock::now();
+
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                WorkerLaneStats& laneStats = stats[next.lane];
+                double waitMs = std::chrono::duration<double, std::milli>(startedAt - next.queuedAt).count();
+                double runMs = std::chrono::duration<double, std::milli>(finishedAt - startedAt).count();
+                laneStats.running--;
+                laneStats.completed++;
+                laneStats.totalWaitMs += waitMs;
+                laneStats.totalRunMs += runMs;
+                laneStats.maxWaitMs = std::max(laneStats.maxWaitMs, waitMs);
+                laneStats.maxRunMs = std::max(laneStats.maxRunMs, runMs);
+                done.push_back(next);
+            }
+            uv_async_send(&completed_signal);
+        }
+    }
+
+    // Runs on the event loop thread. uv_async_send calls can be coalesced, so drain everything that is done.
+    static void on_completed(uv_async_t* handle) {
+        worker_pool* pool = static_cast<worker_pool*>(handle->data);
+
+        std::deque<job> finished;
+        {
+            std::lock_guard<std::mutex> lock(pool->mutex);
+            finished.swap(pool->done);
+        }
+
+        for (size_t i = 0; i < finished.size(); ++i) {
+            finished[i].after(finished[i].req, 0);
+            if (--pool->outstanding == 0)
+                uv_unref(reinterpret_cast<uv_handle_t*>(&pool->completed_signal));
+        }
+    }
+
+    bool started;
+    size_t outstanding; // Only touched on the event loop thread
+    size_t threads[NUM_LANES];
+
+    std::mutex mutex;
+    std::condition_variable job_available;
+    std::deque<job> pending[NUM_LANES];
+    std::deque<job> done;
+    WorkerLaneStats stats[NUM_LANES];
+
+    std::vector<std::thread> workers;
+    uv_async_t completed_signal;
+};
+
+// The pool is never destroyed: its threads may still be running a job when node exits
+worker_pool& native_workers() {
+    static worker_pool* pool = new worker_pool();
+    return *pool;
+}
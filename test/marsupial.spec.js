@@ -9,6 +9,7 @@ const marsupial = require('../marsupial')
 const outputPath = path.resolve(__dirname, 'output')
 const objectDetectorName = path.resolve(outputPath, 'object_detector.svm')
 const testImageName = path.resolve(__dirname, 'fixtures', 'to_test.jpg')
+const testBitmapName = path.resolve(__dirname, 'fixtures', 'to_test.bmp')
 const trainingData = require('./fixtures/trainingData.json').map((record) => {
     record.imageFileName = path.resolve(__dirname, record.imageFileName)
     return record
@@ -16,6 +17,34 @@ const trainingData = require('./fixtures/trainingData.json').map((record) => {
 
 require('mocha-sinon');
 
+// Pixels of an uncompressed 24 bit BMP file as a raw RGB image (BMP rows are stored bottom up, in BGR order)
+const readBitmap = (fileName) => {
+    const bmp = fs.readFileSync(fileName)
+    const offset = bmp.readUInt32LE(10)
+    const width = bmp.readInt32LE(18)
+    const height = bmp.readInt32LE(22)
+    const stride = (width*3 + 3) & ~3
+    const data = Buffer.alloc(width*height*3)
+    for (let row = 0; row < height; ++row) {
+        for (let col = 0; col < width; ++col) {
+            const from = offset + (height - 1 - row)*stride + col*3
+            const to = (row*width + col)*3
+            data[to] = bmp[from + 2]
+            data[to + 1] = bmp[from + 1]
+            data[to + 2] = bmp[from]
+        }
+    }
+    return { data, width, height, channels: 3 }
+}
+
+// Same image with one gray channel, converted the way dlib does it
+const toGray = (image) => {
+    const data = Buffer.alloc(image.width*image.height)
+    for (let i = 0; i < data.length; ++i)
+        data[i] = Math.floor((image.data[i*3] + image.data[i*3 + 1] + image.data[i*3 + 2])/3)
+    return { data, width: image.width, height: image.height, channels: 1 }
+}
+
 describe('Marsupial', () => {
     before(() => {
         if (!fs.existsSync(outputPath))
@@ -35,6 +64,297 @@ describe('Marsupial', () => {
             .catch(done)
     })
 
+    it('should train an object detector with options', function (done) {
+        this.enableTimeouts(false)
+
+        const detectorName = path.resolve(outputPath, 'object_detector_options.svm')
+        marsupial.trainObjectDetector(trainingData, detectorName, { threads: 2, C: 0.5, eps: 0.05, maxPyramidLevels: 4 })
+            .then(() => {
+                fs.existsSync(detectorName).should.be.true()
+                done()
+            })
+            .catch(done)
+    })
+
+    it('should train an object detector with 8 bit feature storage', function (done) {
+        this.enableTimeouts(false)
+
+        const detectorName = path.resolve(outputPath, 'object_detector_uint8.svm')
+        marsupial.trainObjectDetector(trainingData, detectorName, { featureStorage: 'uint8' })
+            .then(() => marsupial.detectObjects(testImageName, detectorName))
+            .then((detected) => {
+                detected.length.should.equal(1)
+                detected[0].top.should.be.within(120, 140)
+                detected[0].left.should.be.within(390, 405)
+                detected[0].width.should.be.within(210, 225)
+                detected[0].height.should.be.within(210, 225)
+                done()
+            })
+            .catch(done)
+    })
+
+    it('should train an object detector from a feature cache', function (done) {
+        this.enableTimeouts(false)
+
+        const cacheDir = path.resolve(outputPath, 'fhog_cache')
+        const detectorName = path.resolve(outputPath, 'object_detector_cached.svm')
+        marsupial.trainObjectDetector(trainingData, detectorName, { featureCache: cacheDir })
+            .then(() => {
+                const cached = fs.readdirSync(cacheDir)
+                cached.length.should.be.above(0)
+                // The second run reuses the cached features instead of writing new ones
+                return marsupial.trainObjectDetector(trainingData, detectorName, { featureCache: cacheDir })
+                    .then(() => fs.readdirSync(cacheDir).should.eql(cached))
+            })
+            .then(() => marsupial.detectObjects(testImageName, detectorName))
+            .then((detected) => {
+                detected.length.should.equal(1)
+                detected[0].top.should.be.within(120, 140)
+                detected[0].left.should.be.within(390, 405)
+                detected[0].width.should.be.within(210, 225)
+                detected[0].height.should.be.within(210, 225)
+                done()
+            })
+            .catch(done)
+    })
+
+    it('should detect with a detector trained on upsampled images', function () {
+        this.enableTimeouts(false)
+
+        const detectorName = path.resolve(outputPath, 'object_detector_upsample.svm')
+        // Trained on upsampled boxes, the detector's window is a little tighter around the sign
+        const checkDetected = (detected) => {
+            detected.length.should.equal(1)
+            detected[0].top.should.be.within(120, 145)
+            detected[0].left.should.be.within(390, 435)
+            detected[0].width.should.be.within(175, 225)
+            detected[0].height.should.be.within(175, 225)
+        }
+        return marsupial.trainObjectDetector(trainingData, detectorName, { upsample: 1 })
+            .then(() => marsupial.detectObjects(testImageName, detectorName, { upsample: 1 }))
+            .then(checkDetected)
+            .then(() => marsupial.detectObjectsBatch([testImageName], detectorName, { upsample: 1 }))
+            .then((detected) => {
+                detected.length.should.equal(5)
+                checkDetected([{ top: detected[1], left: detected[2], width: detected[3], height: detected[4] }])
+            })
+            .then(() => marsupial.detectObjects(testImageName, detectorName, { upsample: 1, tileHeight: 100 }))
+            .then(() => { throw new Error('Detection should have failed') }, (err) => {
+                err.should.match(/can't be upsampled when they're scanned in strips/)
+            })
+    })
+
+    it('should reject an unknown feature storage', (done) => {
+        marsupial.trainObjectDetector(trainingData, path.resolve(outputPath, 'invalid.svm'), { featureStorage: 'int4' })
+            .then(() => done(new Error('Training should have failed')))
+            .catch((err) => {
+                err.should.match(/Invalid training options: featureStorage must be 'float', 'half' or 'uint8', not 'int4'/)
+                done()
+            })
+    })
+
+    it('should reject invalid training options', (done) => {
+        marsupial.trainObjectDetector(trainingData, path.resolve(outputPath, 'invalid.svm'), { C: 0, cellSize: 0 })
+            .then(() => done(new Error('Training should have failed')))
+            .catch((err) => {
+                err.should.match(/C must be greater than 0/)
+                err.should.match(/cellSize must be greater than 0/)
+                done()
+            })
+    })
+
+    it('should reject more training threads than a few per core', (done) => {
+        marsupial.trainObjectDetector(trainingData, path.resolve(outputPath, 'invalid.svm'), { threads: 1000000, decodeThreads: 1000000 })
+            .then(() => done(new Error('Training should have failed')))
+            .catch((err) => {
+                err.should.match(/Invalid training options/)
+                err.should.match(/threads must be at most \d+/)
+                err.should.match(/decodeThreads must be at most \d+/)
+                done()
+            })
+    })
+
+    it('should reject a missing training image', (done) => {
+        const records = trainingData.concat([{ imageFileName: path.resolve(__dirname, 'fixtures', 'missing.jpg'), matchAreas: [] }])
+        marsupial.trainObjectDetector(records, path.resolve(outputPath, 'missing.svm'))
+            .then(() => done(new Error('Training should have failed')))
+            .catch((err) => {
+                err.should.match(/Unable to open training image .*missing\.jpg/)
+                done()
+            })
+    })
+
+    it('should reject training boxes the scanner cannot obtain', function (done) {
+        this.enableTimeouts(false)
+
+        const records = trainingData.concat([{
+            imageFileName: trainingData[0].imageFileName,
+            matchAreas: [{ top: 10, left: 10, width: 150, height: 8 }]
+        }])
+        marsupial.trainObjectDetector(records, path.resolve(outputPath, 'impossible.svm'), { decodeThreads: 4, prefetchDepth: 1 })
+            .then(() => done(new Error('Training should have failed')))
+            .catch((err) => {
+                err.should.match(/impossible set of object boxes was given for training image\s+\S*60-speedsign1\.jpg/)
+                done()
+            })
+    })
+
+    it('should report training progress', function (done) {
+        this.enableTimeouts(false)
+
+        const progress = []
+        const detectorName = path.resolve(outputPath, 'object_detector_progress.svm')
+        marsupial.trainObjectDetector(trainingData, detectorName, { onProgress: (p) => progress.push(p) })
+            .then(() => {
+                progress.length.should.be.above(1)
+                progress.forEach((p, i) => {
+                    p.iteration.should.equal(i + 1)
+                    p.objective.should.be.a.Number()
+                    p.objectiveGap.should.be.a.Number()
+                    p.risk.should.be.a.Number()
+                    p.riskGap.should.be.a.Number()
+                    p.planes.should.be.above(0)
+                    p.elapsedMs.should.be.above(0)
+                })
+                progress[progress.length - 1].riskGap.should.be.below(progress[0].riskGap)
+                done()
+            })
+            .catch(done)
+    })
+
+    it('should cancel a training', function (done) {
+        this.enableTimeouts(false)
+
+        const detectorName = path.resolve(outputPath, 'object_detector_cancelled.svm')
+        if (fs.existsSync(detectorName))
+            fs.unlinkSync(detectorName)
+
+        const training = marsupial.trainObjectDetector(trainingData, detectorName, {
+            onProgress: () => training.cancelTraining()
+        })
+        training
+            .then(() => done(new Error('Training should have been cancelled')))
+            .catch((err) => {
+                err.should.match(/Training cancelled/)
+                fs.existsSync(detectorName).should.be.false()
+                done()
+            })
+    })
+
+    it('should resume a training from a checkpoint', function (done) {
+        this.enableTimeouts(false)
+
+        const checkpointName = path.resolve(outputPath, 'training.checkpoint')
+        const detectorName = path.resolve(outputPath, 'object_detector_resumed.svm')
+        if (fs.existsSync(checkpointName))
+            fs.unlinkSync(checkpointName)
+
+        const training = marsupial.trainObjectDetector(trainingData, detectorName, {
+            checkpoint: checkpointName,
+            checkpointInterval: 2,
+            onProgress: (p) => {
+                if (p.iteration === 3)
+                    training.cancelTraining()
+            }
+        })
+        training
+            .then(() => done(new Error('Training should have been cancelled')))
+            .catch((err) => {
+                err.should.match(/Training cancelled/)
+                fs.existsSync(checkpointName).should.be.true()
+
+                const progress = []
+                return marsupial.trainObjectDetector(trainingData, detectorName, {
+                    resumeFrom: checkpointName,
+                    onProgress: (p) => progress.push(p)
+                })
+                    .then(() => progress[0].iteration.should.equal(3))
+            })
+            .then(() => marsupial.detectObjects(testImageName, detectorName))
+            .then((detected) => {
+                detected.length.should.equal(1)
+                detected[0].top.should.be.within(120, 140)
+                detected[0].left.should.be.within(390, 405)
+                done()
+            })
+            .catch(done)
+    })
+
+    it('should reject a checkpoint saved with another C', function (done) {
+        this.enableTimeouts(false)
+
+        // A cancelled training saves its checkpoint
+        const checkpointName = path.resolve(outputPath, 'training_c1.checkpoint')
+        if (fs.existsSync(checkpointName))
+            fs.unlinkSync(checkpointName)
+
+        const training = marsupial.trainObjectDetector(trainingData, path.resolve(outputPath, 'invalid.svm'), {
+            C: 1,
+            checkpoint: checkpointName,
+            onProgress: () => training.cancelTraining()
+        })
+        training
+            .then(() => { throw new Error('Training should have been cancelled') }, (err) => {
+                err.should.match(/Training cancelled/)
+                fs.existsSync(checkpointName).should.be.true()
+
+                return marsupial.trainObjectDetector(trainingData, path.resolve(outputPath, 'invalid.svm'), {
+                    C: 2,
+                    resumeFrom: checkpointName
+                })
+            })
+            .then(() => { throw new Error('Training should have failed') }, (err) => {
+                err.should.match(/can only be resumed with the same C/)
+            })
+            .then(() => done())
+            .catch(done)
+    })
+
+    it('should tune an object detector', function (done) {
+        this.enableTimeouts(false)
+
+        const detectorName = path.resolve(outputPath, 'object_detector_tuned.svm')
+        marsupial.tuneObjectDetector(trainingData, detectorName, { C: [1, 5], eps: 0.05 }, { folds: 3 })
+            .then((tuning) => {
+                tuning.results.length.should.equal(2)
+                tuning.results.map((res) => res.C).should.eql([1, 5])
+                tuning.results.forEach((res) => {
+                    res.eps.should.equal(0.05)
+                    res.targetSize.should.equal(6400)
+                    res.precision.should.be.within(0, 1)
+                    res.recall.should.be.within(0, 1)
+                    res.averagePrecision.should.be.within(0, 1)
+                })
+                tuning.results.should.containEql(tuning.best)
+                return marsupial.detectObjects(testImageName, detectorName)
+            })
+            .then((detected) => {
+                detected.length.should.equal(1)
+                detected[0].top.should.be.within(120, 140)
+                detected[0].left.should.be.within(390, 405)
+                done()
+            })
+            .catch(done)
+    })
+
+    it('should reject an invalid tuning grid', (done) => {
+        marsupial.tuneObjectDetector(trainingData, path.resolve(outputPath, 'invalid.svm'), { C: [1, 'a'] })
+            .then(() => done(new Error('Tuning should have failed')))
+            .catch((err) => {
+                err.message.should.match(/grid.C must be/)
+                done()
+            })
+    })
+
+    it('should reject more folds than training records', (done) => {
+        marsupial.tuneObjectDetector(trainingData, path.resolve(outputPath, 'invalid.svm'), { C: 1 }, { folds: 100 })
+            .then(() => done(new Error('Tuning should have failed')))
+            .catch((err) => {
+                err.should.match(/folds must be between 2 and the number of training records/)
+                done()
+            })
+    })
+
     it('should detect the test image', (done) => {
         marsupial.detectObjects(testImageName, objectDetectorName)
             .then((detected) => {
@@ -49,6 +369,231 @@ describe('Marsupial', () => {
             .catch(done)
     })
 
+    it('should detect the test image using a loaded detector', (done) => {
+        marsupial.loadDetector(objectDetectorName)
+            .then((detector) => {
+                detector.fileName.should.equal(objectDetectorName)
+                return marsupial.detectObjects(testImageName, detector)
+            })
+            .then((detected) => {
+                detected.length.should.equal(1)
+                detected[0].top.should.be.within(120, 140)
+                detected[0].left.should.be.within(390, 405)
+                done()
+            })
+            .catch(done)
+    })
+
+    it('should detect the test image from an in-memory buffer', (done) => {
+        marsupial.detectObjects(fs.readFileSync(testImageName), objectDetectorName)
+            .then((detected) => {
+                detected.length.should.equal(1)
+                detected[0].top.should.be.within(120, 140)
+                detected[0].left.should.be.within(390, 405)
+                done()
+            })
+            .catch(done)
+    })
+
+    it('should detect the test image using several threads', (done) => {
+        marsupial.detectObjects(testImageName, objectDetectorName, { threads: 4 })
+            .then((detected) => {
+                detected.length.should.equal(1)
+                detected[0].top.should.be.within(120, 140)
+                detected[0].left.should.be.within(390, 405)
+                done()
+            })
+            .catch(done)
+    })
+
+    it('should cap the threads of a detection at the number of cores', () => {
+        // Without the cap, every one of these calls would try to start a million threads
+        const options = { threads: 1000000 }
+        return Promise.all([options, Object.assign({ tileHeight: 100 }, options)].map((options) =>
+            marsupial.detectObjects(testImageName, objectDetectorName, options).then((detected) => {
+                detected.length.should.equal(1)
+                detected[0].top.should.be.within(120, 140)
+                detected[0].left.should.be.within(390, 405)
+            })
+        ))
+    })
+
+    it('should detect the test image decoded at a reduced size', (done) => {
+        // Objects at least 170 pixels across still cover the 80x80 window of the detector at half size
+        marsupial.detectObjects(testImageName, objectDetectorName, { minObjectSize: 170 })
+            .then((detected) => {
+                detected.length.should.equal(1)
+                detected[0].top.should.be.within(120, 140)
+                detected[0].left.should.be.within(390, 415)
+                detected[0].width.should.be.within(200, 225)
+                detected[0].height.should.be.within(200, 225)
+                return marsupial.detectObjectsBatch([fs.readFileSync(testImageName)], objectDetectorName, { minObjectSize: 170 })
+            })
+            .then((detected) => {
+                detected.length.should.equal(5)
+                detected[1].should.be.within(120, 140)
+                detected[2].should.be.within(390, 415)
+                done()
+            })
+            .catch(done)
+    })
+
+    it('should detect the test image in strips', (done) => {
+        // 480 rows scanned as two 460 row strips overlapping by 230 rows
+        const options = { tileHeight: 100, maxObjectSize: 230 }
+        marsupial.detectObjects(testImageName, objectDetectorName, options)
+            .then((detected) => {
+                detected.length.should.equal(1)
+                detected[0].top.should.be.within(120, 140)
+                detected[0].left.should.be.within(390, 405)
+                detected[0].width.should.be.within(210, 225)
+                detected[0].height.should.be.within(210, 225)
+                return marsupial.detectObjects(fs.readFileSync(testImageName), objectDetectorName, options)
+            })
+            .then((detected) => {
+                detected.length.should.equal(1)
+                detected[0].top.should.be.within(120, 140)
+                done()
+            })
+            .catch(done)
+    })
+
+    it('should detect the test image in strips decoded at a reduced size', (done) => {
+        // The strips overlap by at least minObjectSize, even with a smaller maxObjectSize, so the object found in the
+        // whole image is found in one piece
+        marsupial.detectObjects(testImageName, objectDetectorName, { minObjectSize: 170 })
+            .then((whole) => {
+                const options = { tileHeight: 100, maxObjectSize: 100, minObjectSize: 170 }
+                return marsupial.detectObjects(testImageName, objectDetectorName, options).then((detected) => {
+                    detected.should.eql(whole)
+                    done()
+                })
+            })
+            .catch(done)
+    })
+
+    it('should name the file a decoding error comes from', () => {
+        const corruptImageName = path.resolve(outputPath, 'corrupt.jpg')
+        const bytes = fs.readFileSync(testImageName)
+        bytes.fill(0, 20)
+        fs.writeFileSync(corruptImageName, bytes)
+
+        return Promise.all([{}, { minObjectSize: 170 }, { tileHeight: 100 }].map((options) =>
+            marsupial.detectObjects(corruptImageName, objectDetectorName, options)
+                .then(() => { throw new Error('Detection should have failed') })
+                .catch((err) => err.should.match(/in file .*corrupt\.jpg/))
+        ))
+    })
+
+    it('should detect a batch of images', (done) => {
+        marsupial.detectObjectsBatch([testImageName, fs.readFileSync(testImageName)], objectDetectorName)
+            .then((detected) => {
+                detected.should.be.instanceof(Int32Array)
+                detected.length.should.equal(10)
+                for (let i = 0; i < 2; ++i) {
+                    detected[i*5].should.equal(i)
+                    detected[i*5 + 1].should.be.within(120, 140)
+                    detected[i*5 + 2].should.be.within(390, 405)
+                    detected[i*5 + 3].should.be.within(210, 225)
+                    detected[i*5 + 4].should.be.within(210, 225)
+                }
+                done()
+            })
+            .catch(done)
+    })
+
+    it('should detect a batch of images decoded ahead', (done) => {
+        const images = [testImageName, testImageName, fs.readFileSync(testImageName)]
+        marsupial.detectObjectsBatch(images, objectDetectorName, { decodeThreads: 2, prefetchDepth: 1 })
+            .then((detected) => {
+                detected.length.should.equal(15)
+                for (let i = 0; i < 3; ++i) {
+                    detected[i*5].should.equal(i)
+                    detected[i*5 + 1].should.be.within(120, 140)
+                    detected[i*5 + 2].should.be.within(390, 405)
+                }
+                done()
+            })
+            .catch(done)
+    })
+
+    it('should detect batches of any size with more decode threads than prefetched images', () => {
+        const options = { decodeThreads: 4, prefetchDepth: 1 }
+        return Promise.all([0, 1, 2, 3].map((count) => {
+            const images = Array(count).fill(testImageName)
+            return marsupial.detectObjectsBatch(images, objectDetectorName, options).then((detected) => {
+                detected.length.should.equal(count*5)
+            })
+        }))
+    })
+
+    it('should reject a batch with an image that fails to decode', (done) => {
+        const images = [testImageName, path.resolve(__dirname, 'fixtures', 'missing.jpg'), testImageName]
+        marsupial.detectObjectsBatch(images, objectDetectorName, { decodeThreads: 4, prefetchDepth: 1 })
+            .then(() => done(new Error('Detection should have failed')))
+            .catch((err) => {
+                err.should.match(/^Image 1: .*missing\.jpg/)
+                done()
+            })
+    })
+
+    it('should detect raw gray and RGB images like the image file they come from', () => {
+        const rgb = readBitmap(testBitmapName)
+        return Promise.all([testBitmapName, toGray(rgb), rgb].map((image) =>
+            marsupial.detectObjects(image, objectDetectorName)
+        )).then((detected) => {
+            detected[0].length.should.equal(1)
+            // Gray pixels are exactly what decoding the file gives; RGB ones are scanned on all three channels
+            detected[1].should.eql(detected[0])
+            detected[2].length.should.equal(1)
+            detected[2][0].top.should.be.within(detected[0][0].top - 5, detected[0][0].top + 5)
+            detected[2][0].left.should.be.within(detected[0][0].left - 5, detected[0][0].left + 5)
+            detected[2][0].width.should.be.within(detected[0][0].width - 10, detected[0][0].width + 10)
+            detected[2][0].height.should.be.within(detected[0][0].height - 10, detected[0][0].height + 10)
+        })
+    })
+
+    it('should reject raw images with a buffer that is too small', () => {
+        // The second width * height * channels doesn't even fit in 64 bits
+        const sizes = [{ width: 10, height: 10 }, { width: Math.pow(2, 32), height: Math.pow(2, 32) }]
+        sizes.forEach((size) => {
+            (() => marsupial_native.detectObjects({ data: Buffer.alloc(10), width: size.width, height: size.height, channels: 1 },
+                objectDetectorName, () => {})).should.throw(/smaller than/)
+        })
+    })
+
+    it('should report worker pool stats', () => {
+        const stats = marsupial.getWorkerPoolStats()
+        stats.train.completed.should.be.above(0)
+        stats.detect.completed.should.be.above(0)
+        stats.detect.threads.should.be.above(0)
+        stats.detect.queued.should.equal(0)
+        stats.detect.averageRunMs.should.be.above(0)
+    })
+
+    it('should report the simd level', () => {
+        const simd = marsupial.getSimdLevel()
+        simd.level.should.be.a.String()
+        simd.cpu.should.be.a.String()
+        simd.baseline.should.be.a.String()
+    })
+
+    it('should not reconfigure a running worker pool', () => {
+        // Queuing a job starts the pool, whichever specs ran before this one
+        return marsupial.detectObjects(testImageName, objectDetectorName).then(() => {
+            (() => marsupial.configureWorkerPool({ detectThreads: 2 })).should.throw(/already running/)
+        })
+    })
+
+    it('should fail to load a missing detector', (done) => {
+        marsupial.loadDetector(path.resolve(outputPath, 'missing.svm'))
+            .then(() => done('Oops. Did not throw'))
+            .catch((err) => {
+                err.should.be.ok()
+                done()
+            })
+    })
+
     it('should handle errors', function (done) {
         this.sinon.stub(marsupial_native, 'trainObjectDetector', (a, b, c) => c('error'))
         this.sinon.stub(marsupial_native, 'detectObjects', (a, b, c) => c('error'))